@@ -33,11 +33,44 @@ public:
   std::unique_ptr<BoundStatement> BindSelect(const SelectStatement &);
   std::unique_ptr<BoundStatement> BindCreateTable(const CreateTableStatement &);
   std::unique_ptr<BoundStatement> BindCreateIndex(const CreateIndexStatement &);
+  std::unique_ptr<BoundStatement> BindTransaction(const TransactionStatement &);
+  std::unique_ptr<BoundStatement> BindAnalyze(const AnalyzeStatement &);
+  std::unique_ptr<BoundStatement> BindExplain(const ExplainStatement &);
+  std::unique_ptr<BoundStatement> BindPrepare(const PrepareStatement &);
+  std::unique_ptr<BoundStatement> BindExecute(const ExecuteStatement &);
 
   bool HasError() const { return error_.has_value(); }
   BindError GetError() const { return error_.value(); }
 
 private:
+  std::unique_ptr<BoundSelectStatement> BindJoin(const SelectStatement &);
+  // 单表的 SELECT，WHERE 列上有索引时走索引
+  std::unique_ptr<BoundSelectStatement>
+  BindScan(TableInfo *table, bool has_where, const std::string &where_column,
+           const Value *where_value, bool is_count_star);
+  // 连接的两张表里 column 属于哪一张：0 是左表，1 是右表，出错时返回 -1
+  int ResolveSide(const ColumnRef &column, TableInfo *left, TableInfo *right);
+  // 列在表（单表查询时 right 为空）或连接输出的 schema 里的下标
+  bool ResolveColumn(const ColumnRef &ref, TableInfo *left, TableInfo *right,
+                     uint32_t *column);
+  // 把 ORDER BY 的列解析成输出 schema 里的下标
+  bool BindOrderBy(const SelectStatement &statement, TableInfo *left,
+                   TableInfo *right, BoundSelectStatement *bound);
+  // SELECT 列表有 GROUP BY 或聚合函数时：GROUP BY、聚合函数，以及按
+  // 聚合输出的 ORDER BY
+  bool BindAggregation(const SelectStatement &statement, TableInfo *left,
+                       TableInfo *right, BoundSelectStatement *bound);
+  // SELECT 列表是普通的列时：输出这些列，扫描只取用到的列
+  bool BindProjection(const SelectStatement &statement, TableInfo *left,
+                      TableInfo *right, BoundSelectStatement *bound);
+  // column 在扫描要取的列里的位置，还没有时加在最后
+  static uint32_t ScanIndex(std::vector<uint32_t> *columns, uint32_t column);
+  // 扫描只取 columns 这些列（加上 WHERE 的列）
+  void BindScanColumns(BoundSelectStatement *bound,
+                       std::vector<uint32_t> columns);
+  // column 上的 B+Tree 索引，没有时返回空
+  IndexInfo *BPlusTreeIndexOn(TableInfo *table, const std::string &column);
+
   Catalog &catalog_;
   std::optional<BindError> error_;
 };
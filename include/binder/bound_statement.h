@@ -2,6 +2,7 @@
 #include "binder/value.h"
 #include "catalog/catalog.h"
 #include "catalog/schema.h"
+#include "parser/statement.h"
 #include "type/data_type.h"
 #include <memory>
 #include <string>
@@ -14,6 +15,11 @@ enum class BoundStatementType {
   BOUND_SELECT,
   BOUND_CREATE_TABLE,
   BOUND_CREATE_INDEX,
+  BOUND_TRANSACTION,
+  BOUND_ANALYZE,
+  BOUND_EXPLAIN,
+  BOUND_PREPARE,
+  BOUND_EXECUTE,
 };
 
 class BoundStatement {
@@ -27,38 +33,94 @@ private:
 
 class BoundInsertStatement : public BoundStatement {
 public:
-  BoundInsertStatement(TableInfo *table,
-                       std::vector<std::unique_ptr<Value>> values)
-      : table_(table), values_(std::move(values)) {}
+  using Row = std::vector<std::unique_ptr<Value>>;
+
+  BoundInsertStatement(TableInfo *table, Row values) : table_(table) {
+    rows_.push_back(std::move(values));
+  }
+  BoundInsertStatement(TableInfo *table, std::vector<Row> rows)
+      : table_(table), rows_(std::move(rows)) {}
   ~BoundInsertStatement() override = default;
 
   BoundStatementType Type() const override {
     return BoundStatementType::BOUND_INSERT;
   }
   TableInfo *Table() const { return table_; }
-  const std::vector<std::unique_ptr<Value>> &Values() const { return values_; }
+  // 第一行
+  const Row &Values() const { return rows_.front(); }
 
-  const Value *ValueAt(size_t i) const { return values_[i].get(); }
-  size_t ValueCount() const { return values_.size(); }
+  size_t RowCount() const { return rows_.size(); }
+  const Value *ValueAt(size_t row, size_t i) const {
+    return rows_[row][i].get();
+  }
+  size_t ValueCount(size_t row) const { return rows_[row].size(); }
 
 private:
   TableInfo *table_;
-  std::vector<std::unique_ptr<Value>> values_;
+  std::vector<Row> rows_;
+};
+
+class BoundSelectStatement;
+
+// ORDER BY 的一列，column 是输出 schema 里的下标
+struct SortKey {
+  uint32_t column;
+  bool desc{false};
+};
+
+// FROM a JOIN b ON a.x = b.y。两边各是一个单表的 SELECT *，WHERE 已经
+// 下推到所属的那一边；按 left 的第 left_column 列等于 right 的
+// 第 right_column 列连接
+struct BoundJoin {
+  std::unique_ptr<BoundSelectStatement> left;
+  std::unique_ptr<BoundSelectStatement> right;
+  uint32_t left_column;
+  uint32_t right_column;
+  // 连接列上的 B+Tree 索引，有的话这一边可以做索引嵌套循环连接的内表
+  IndexInfo *left_index{nullptr};
+  IndexInfo *right_index{nullptr};
+};
+
+// SELECT 列表里的一项。aggregate 为 NONE 时是一个 GROUP BY 列；
+// column 是扫描出来的行里的下标，COUNT(*) 时不用
+struct BoundSelectItem {
+  AggregateType aggregate;
+  uint32_t column;
+};
+
+// GROUP BY 和聚合函数。输出的列按 SELECT 列表的顺序
+struct BoundAggregation {
+  std::vector<uint32_t> group_by; // 扫描出来的行里的下标
+  std::vector<BoundSelectItem> items;
+  std::shared_ptr<Schema> schema;
 };
 
 class BoundSelectStatement : public BoundStatement {
 public:
   BoundSelectStatement(TableInfo *table, IndexInfo *index_info = nullptr,
                        bool has_where = false, std::string where_column = "",
-                       std::unique_ptr<Value> where_value = nullptr)
+                       std::unique_ptr<Value> where_value = nullptr,
+                       bool is_count_star = false, bool index_only = false)
       : table_(table), index_info_(index_info), has_where_(has_where),
-        where_column_(where_column), where_value_(std::move(where_value)) {}
+        where_column_(where_column), where_value_(std::move(where_value)),
+        is_count_star_(is_count_star), index_only_(index_only) {}
+  // 连接查询，schema 是左表的列接上右表的列
+  BoundSelectStatement(std::unique_ptr<BoundJoin> join,
+                       std::shared_ptr<Schema> schema,
+                       bool is_count_star = false)
+      : table_(nullptr), index_info_(nullptr), has_where_(false),
+        is_count_star_(is_count_star), index_only_(false),
+        join_(std::move(join)), join_schema_(std::move(schema)) {}
   ~BoundSelectStatement() override = default;
   BoundStatementType Type() const override {
     return BoundStatementType::BOUND_SELECT;
   }
+  // 连接查询时为空
   TableInfo *Table() const { return table_; }
-  std::shared_ptr<Schema> GetSchema() const { return table_->schema; }
+  std::shared_ptr<Schema> GetSchema() const {
+    return join_ != nullptr ? join_schema_ : table_->schema;
+  }
+  BoundJoin *Join() const { return join_.get(); }
   IndexInfo *Index() const { return index_info_; }
   bool HasWhere() const { return has_where_; }
   const std::string &WhereColumn() const { return where_column_; }
@@ -71,6 +133,47 @@ public:
     throw std::runtime_error("Where column not found in schema");
   }
   const Value *WhereValue() const { return where_value_.get(); }
+  bool IsCountStar() const { return is_count_star_; }
+  // 查询只需要索引键，可以只读索引叶子不回表
+  bool IsIndexOnly() const { return index_only_; }
+  void SetIndexOnly(bool index_only) { index_only_ = index_only; }
+  // ORDER BY 的列有聚合时是聚合输出里的下标，否则是扫描出来的行里的
+  const std::vector<SortKey> &OrderBy() const { return order_by_; }
+  void SetOrderBy(std::vector<SortKey> order_by) {
+    order_by_ = std::move(order_by);
+  }
+  // 没有 GROUP BY 和聚合函数时为空
+  const BoundAggregation *Aggregation() const { return aggregation_.get(); }
+  void SetAggregation(std::unique_ptr<BoundAggregation> aggregation) {
+    aggregation_ = std::move(aggregation);
+  }
+  // 扫描（连接查询时是连接的输出）只取这些列，按这个顺序紧挨着放，
+  // 为空时取整行。聚合和 ORDER BY 的下标都指向扫描出来的行
+  const std::vector<uint32_t> &ScanColumns() const { return scan_columns_; }
+  // 扫描出来的行的 schema
+  std::shared_ptr<Schema> GetScanSchema() const {
+    return scan_schema_ != nullptr ? scan_schema_ : GetSchema();
+  }
+  void SetScanColumns(std::vector<uint32_t> columns,
+                      std::shared_ptr<Schema> schema) {
+    scan_columns_ = std::move(columns);
+    scan_schema_ = std::move(schema);
+  }
+  // SELECT 列表是普通的列时输出的 schema，是扫描出来的行开头的几列，
+  // 后面的列只给 ORDER BY 和 WHERE 用；SELECT * 和聚合时为空
+  std::shared_ptr<Schema> Projection() const { return projection_; }
+  void SetProjection(std::shared_ptr<Schema> schema) {
+    projection_ = std::move(schema);
+  }
+  // LIMIT / OFFSET 作用在最终的输出上
+  bool HasLimit() const { return has_limit_; }
+  size_t Limit() const { return limit_; }
+  size_t Offset() const { return offset_; }
+  void SetLimit(size_t limit, size_t offset) {
+    has_limit_ = true;
+    limit_ = limit;
+    offset_ = offset;
+  }
 
 private:
   TableInfo *table_;
@@ -79,14 +182,30 @@ private:
   bool has_where_;
   std::string where_column_;
   std::unique_ptr<Value> where_value_;
+
+  bool is_count_star_;
+  bool index_only_;
+
+  std::unique_ptr<BoundJoin> join_;
+  std::shared_ptr<Schema> join_schema_;
+  std::vector<SortKey> order_by_;
+  std::unique_ptr<BoundAggregation> aggregation_;
+  std::vector<uint32_t> scan_columns_;
+  std::shared_ptr<Schema> scan_schema_;
+  std::shared_ptr<Schema> projection_;
+  bool has_limit_{false};
+  size_t limit_{0};
+  size_t offset_{0};
 };
 
 class BoundCreateTableStatement : public BoundStatement {
 public:
   BoundCreateTableStatement(
       std::string table_name,
-      std::vector<std::pair<std::string, ColumnType>> columns)
-      : table_name_(std::move(table_name)), columns_(std::move(columns)) {}
+      std::vector<std::pair<std::string, ColumnType>> columns,
+      std::vector<uint32_t> primary_key = {})
+      : table_name_(std::move(table_name)), columns_(std::move(columns)),
+        primary_key_(std::move(primary_key)) {}
   ~BoundCreateTableStatement() override = default;
   BoundStatementType Type() const override {
     return BoundStatementType::BOUND_CREATE_TABLE;
@@ -95,18 +214,25 @@ public:
   const std::vector<std::pair<std::string, ColumnType>> &Columns() const {
     return columns_;
   }
+  bool HasPrimaryKey() const { return !primary_key_.empty(); }
+  // 主键列在 columns_ 中的下标
+  const std::vector<uint32_t> &PrimaryKey() const { return primary_key_; }
 
 private:
   std::string table_name_;
   std::vector<std::pair<std::string, ColumnType>> columns_;
+  std::vector<uint32_t> primary_key_;
 };
 
 class BoundCreateIndexStatement : public BoundStatement {
 public:
   BoundCreateIndexStatement(std::string index_name, std::string table_name,
-                            std::vector<uint32_t> column_names)
+                            std::vector<uint32_t> column_names,
+                            bool is_unique = false,
+                            IndexType index_type = IndexType::BPLUS_TREE)
       : index_name_(std::move(index_name)), table_name_(std::move(table_name)),
-        column_names_(std::move(column_names)) {}
+        column_names_(std::move(column_names)), is_unique_(is_unique),
+        index_type_(index_type) {}
   ~BoundCreateIndexStatement() override = default;
   BoundStatementType Type() const override {
     return BoundStatementType::BOUND_CREATE_INDEX;
@@ -114,6 +240,8 @@ public:
   const std::string &IndexName() const { return index_name_; }
   const std::string &TableName() const { return table_name_; }
   const std::vector<uint32_t> &ColumnIds() const { return column_names_; }
+  bool IsUnique() const { return is_unique_; }
+  IndexType GetIndexType() const { return index_type_; }
 
 private:
   std::string index_name_;
@@ -121,6 +249,92 @@ private:
   // 目前只支持单列索引，所以 column_names_ 里只有一个元素，且是列的 id（在
   // schema 中的索引）
   std::vector<uint32_t> column_names_;
+  bool is_unique_;
+  IndexType index_type_;
+};
+
+class BoundTransactionStatement : public BoundStatement {
+public:
+  explicit BoundTransactionStatement(TransactionCommand command)
+      : command_(command) {}
+  ~BoundTransactionStatement() override = default;
+
+  BoundStatementType Type() const override {
+    return BoundStatementType::BOUND_TRANSACTION;
+  }
+  TransactionCommand Command() const { return command_; }
+
+private:
+  TransactionCommand command_;
+};
+
+class BoundAnalyzeStatement : public BoundStatement {
+public:
+  explicit BoundAnalyzeStatement(TableInfo *table) : table_(table) {}
+  ~BoundAnalyzeStatement() override = default;
+
+  BoundStatementType Type() const override {
+    return BoundStatementType::BOUND_ANALYZE;
+  }
+  TableInfo *Table() const { return table_; }
+
+private:
+  TableInfo *table_;
+};
+
+class BoundExplainStatement : public BoundStatement {
+public:
+  BoundExplainStatement(std::unique_ptr<BoundSelectStatement> select,
+                        bool analyze)
+      : select_(std::move(select)), analyze_(analyze) {}
+  ~BoundExplainStatement() override = default;
+
+  BoundStatementType Type() const override {
+    return BoundStatementType::BOUND_EXPLAIN;
+  }
+  std::unique_ptr<BoundSelectStatement> &Select() { return select_; }
+  bool IsAnalyze() const { return analyze_; }
+
+private:
+  std::unique_ptr<BoundSelectStatement> select_;
+  bool analyze_;
+};
+
+class BoundPrepareStatement : public BoundStatement {
+public:
+  BoundPrepareStatement(std::string name, std::string sql)
+      : name_(std::move(name)), sql_(std::move(sql)) {}
+  ~BoundPrepareStatement() override = default;
+
+  BoundStatementType Type() const override {
+    return BoundStatementType::BOUND_PREPARE;
+  }
+  const std::string &Name() const { return name_; }
+  const std::string &Sql() const { return sql_; }
+
+private:
+  std::string name_;
+  std::string sql_;
+};
+
+class BoundExecuteStatement : public BoundStatement {
+public:
+  BoundExecuteStatement(std::string name,
+                        std::vector<std::unique_ptr<Value>> parameters)
+      : name_(std::move(name)), parameters_(std::move(parameters)) {}
+  ~BoundExecuteStatement() override = default;
+
+  BoundStatementType Type() const override {
+    return BoundStatementType::BOUND_EXECUTE;
+  }
+  const std::string &Name() const { return name_; }
+  const std::vector<std::unique_ptr<Value>> &Parameters() const {
+    return parameters_;
+  }
+
+private:
+  std::string name_;
+  std::vector<std::unique_ptr<Value>> parameters_;
 };
 
 } // namespace mini
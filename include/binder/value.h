@@ -1,5 +1,6 @@
 #pragma once
 #include "type/data_type.h"
+#include <cstddef>
 #include <cstdint>
 #include <cstdlib>
 #include <memory>
@@ -15,6 +16,7 @@ public:
   virtual ~Value() = default;
   virtual DataType Type() const = 0;
   virtual std::string ToString() const = 0;
+  virtual std::unique_ptr<Value> Clone() const = 0;
 };
 
 class IntValue : public Value {
@@ -28,6 +30,9 @@ public:
   DataType Type() const override { return DataType::INTEGER; }
   int32_t GetValue() const { return value_; }
   std::string ToString() const override { return std::to_string(value_); }
+  std::unique_ptr<Value> Clone() const override {
+    return std::make_unique<IntValue>(value_);
+  }
 
 private:
   int32_t value_;
@@ -41,9 +46,30 @@ public:
   DataType Type() const override { return DataType::VARCHAR; }
   const std::string &GetValue() const { return value_; }
   std::string ToString() const override { return value_; }
+  std::unique_ptr<Value> Clone() const override {
+    return std::make_unique<StringValue>(value_);
+  }
 
 private:
   std::string value_;
 };
 
+// PREPARE 里的 ?，EXECUTE 时换成第 index 个参数（从 0 开始）。
+// type 是这个位置要求的类型
+class ParameterValue : public Value {
+public:
+  ParameterValue(size_t index, DataType type) : index_(index), type_(type) {}
+  ~ParameterValue() override = default;
+  DataType Type() const override { return type_; }
+  size_t Index() const { return index_; }
+  std::string ToString() const override { return "?"; }
+  std::unique_ptr<Value> Clone() const override {
+    return std::make_unique<ParameterValue>(index_, type_);
+  }
+
+private:
+  size_t index_;
+  DataType type_;
+};
+
 } // namespace mini
@@ -1,7 +1,10 @@
 #pragma once
 #include "catalog/schema.h"
+#include "catalog/statistics.h"
+#include "concurrency/transaction_manager.h"
 #include "index/index.h"
 #include "storage/table_heap.h"
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -14,6 +17,9 @@ struct TableInfo {
   std::shared_ptr<Schema> schema;
   std::shared_ptr<TableHeap> table; // 或 shared_ptr，看你是否多处持有
   int32_t table_id;                 // 可选
+  // ANALYZE 之后才有，再 ANALYZE 时整个换掉，读写都用 std::atomic_load /
+  // std::atomic_store
+  std::shared_ptr<TableStatistics> statistics;
 };
 
 struct IndexInfo {
@@ -22,19 +28,46 @@ struct IndexInfo {
   std::unique_ptr<Schema> key_schema; // 索引键的 schema
   std::unique_ptr<Index> index;       // 索引结构
   int32_t index_id;                   // 可选
+  bool is_unique{false};              // UNIQUE / PRIMARY KEY
+  IndexType index_type{IndexType::BPLUS_TREE};
 };
 
 class Catalog {
 public:
-  Catalog(BufferPool *bpm) : bpm_(bpm) {}
+  // 目录页固定是数据文件的第 0 页，放不下时接着写链上的下一页
+  static constexpr page_id_t CATALOG_PAGE_ID = 0;
+
+  // log_manager 不为空时，新建的表和索引都写日志
+  Catalog(BufferPool *bpm, LogManager *log_manager = nullptr)
+      : bpm_(bpm), log_manager_(log_manager) {}
+
+  // 打开数据文件后、恢复完成之后调用，要在分配任何页之前。文件里已经
+  // 有目录页时读回所有的表和索引，返回 true；新文件时分配第 0 页作为
+  // 空的目录页并立即刷盘，返回 false。不调用时目录只在内存里
+  bool Load();
+  // 把表和索引的元数据写进目录页，建表、建索引成功之后调用。
+  // txn_manager 不为空时在自己的事务里写成一条 INDEX_SMO，新表的首页和
+  // 新索引的头页（建的时候都没写日志）的整页一起记下，只重做不撤销；
+  // 否则只改缓冲池里的页，由调用者刷盘。没有 Load 过时什么也不做
+  void Persist(TransactionManager *txn_manager = nullptr);
+
+  LogManager *GetLogManager() { return log_manager_; }
+  // 执行器溢出的临时页也从这里分配
+  BufferPool *GetBufferPool() { return bpm_; }
 
   TableInfo *CreateTable(const std::string &name,
                          std::shared_ptr<Schema> schema);
   TableInfo *GetTable(const std::string &name);
+  // 删掉一张还没 Persist、也没有索引的空表，建表失败时撤销用，
+  // 堆的第一页还给磁盘
+  bool DropTable(const std::string &name);
   void ListTables();
 
   IndexInfo *CreateIndex(const std::string &index_name,
-                         const std::string &table_name, uint32_t key_col_id);
+                         const std::string &table_name, uint32_t key_col_id,
+                         bool is_unique = false,
+                         IndexType index_type = IndexType::BPLUS_TREE);
+  bool DropIndex(const std::string &index_name);
   IndexInfo *GetIndex(const std::string &table_name,
                       const std::string &col_name);
 
@@ -42,12 +75,23 @@ public:
   GetIndexes(const std::string &table_name);
   void ListIndexes();
 
+  // 每次建表、建索引、删索引后加一，缓存了绑定结果的地方用它判断是否过时
+  uint64_t GetVersion() const { return version_; }
+
+  // 回收所有表里 horizon 之前删除的旧版本，连同指向它们的索引项，
+  // 修改记入 txn 的日志，返回回收的版本数。不能和读写这些表的语句并发
+  size_t CollectGarbage(txn_id_t horizon, Transaction *txn = nullptr);
+
 private:
   std::vector<IndexInfo *> &GetIndexInternal(const std::string &table_name);
+  // 目录的内容按字节排好，Load 时反过来解析
+  std::vector<char> Serialize() const;
+  void Deserialize(const std::vector<char> &data);
 
   std::unordered_map<std::string, std::unique_ptr<TableInfo>> tables_;
   int32_t next_table_id_{0};
   BufferPool *bpm_; // 需要创建 TableHeap 时用（或你传 disk/bpm）
+  LogManager *log_manager_;
 
   // 方便根据表名找索引
   std::unordered_map<std::string, std::vector<std::shared_ptr<IndexInfo>>>
@@ -55,6 +99,12 @@ private:
   // TODO:???
   std::unordered_map<std::string, std::shared_ptr<IndexInfo>> indexes_;
   int32_t next_index_id_{0};
+  uint64_t version_{0};
+
+  // 目录页链，Load 之前为空
+  std::vector<page_id_t> catalog_page_ids_;
+  // 新表的首页、新索引的头页，下次 Persist 时把整页一起写进日志
+  std::vector<page_id_t> unlogged_pages_;
 };
 
 } // namespace mini
@@ -0,0 +1,83 @@
+#pragma once
+#include "catalog/schema.h"
+#include "concurrency/snapshot.h"
+#include "storage/table_heap.h"
+#include "storage/tuple.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace mini {
+
+// HyperLogLog：把每个值的哈希按前 PRECISION 位分到一个寄存器，寄存器
+// 记下剩下的位里最长的前导零。用 1KB 估计任意多个值里有多少个不同的，
+// 误差约 3%，重复加同一个值不改变结果
+class HyperLogLog {
+public:
+  static constexpr uint32_t PRECISION = 10;
+
+  HyperLogLog() : registers_(1u << PRECISION, 0) {}
+
+  static uint64_t Hash(const char *data, size_t size);
+  void Add(uint64_t hash);
+  double Estimate() const;
+
+private:
+  std::vector<uint8_t> registers_;
+};
+
+// 一列的统计信息。最小最大值和直方图只对 INT 列有
+struct ColumnStatistics {
+  HyperLogLog distinct;
+  bool has_range{false};
+  int32_t min{0};
+  int32_t max{0};
+  // 等深直方图每个桶的上界，桶按样本的行数平分
+  std::vector<int32_t> bounds;
+  // 抽样时推算出的、样本里没见到的不同值个数，加在 distinct 的估计上
+  double unseen_distinct{0};
+};
+
+// ANALYZE 收集的一张表的统计信息，存在 TableInfo 里。之后提交的插入由
+// InsertExecutor 记进来，行数、不同值个数、最小最大值跟着更新，直方图
+// 只按比例用，不会过时太多
+class TableStatistics {
+public:
+  // 最多读这么多页，页数不超过它的表整张读
+  static constexpr size_t SAMPLE_PAGES = 300;
+  // 直方图用的样本最多这么多行
+  static constexpr size_t SAMPLE_SIZE = 30000;
+  static constexpr size_t HISTOGRAM_BUCKETS = 32;
+
+  // 从页号里抽 SAMPLE_PAGES 页，只读这些页上 snapshot 看得到的行。
+  // 行数按页数的比例放大；不同值个数用 Haas-Stokes 的 Duj1 估计，只出现
+  // 一次的值越多，推算出的没见到的值越多；最小最大值只看样本；直方图用
+  // 蓄水池从样本里再抽出最多 SAMPLE_SIZE 行
+  static std::unique_ptr<TableStatistics>
+  Collect(TableHeap *heap, const Schema &schema, const Snapshot *snapshot);
+
+  // 一条 INSERT 写入的行
+  void RecordInsert(const Schema &schema, const std::vector<Tuple> &tuples);
+
+  double RowCount() const;
+  size_t PageCount() const { return page_count_; }
+  // ANALYZE 之后插入了多少行
+  size_t InsertCount() const;
+  double Distinct(uint32_t column) const;
+  bool Range(uint32_t column, int32_t *min, int32_t *max) const;
+  // INT 列上 column = value 的行占多少比例
+  double EqualSelectivity(uint32_t column, int32_t value) const;
+
+private:
+  void AddRow(const Schema &schema, const Tuple &tuple);
+
+  mutable std::mutex latch_;
+  size_t row_count_{0};
+  size_t page_count_{0};
+  size_t insert_count_{0};
+  std::vector<ColumnStatistics> columns_;
+};
+
+} // namespace mini
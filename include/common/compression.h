@@ -0,0 +1,15 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+namespace mini {
+
+// LZ4 块格式的压缩，日志里的大块内容（整页后像、成批的元组）用。
+// 每个序列是 token(高 4 位字面量长度，低 4 位匹配长度 - 4)、
+// 字面量、2 字节小端偏移；长度到 15 时后面跟若干字节累加，255 表示继续。
+// 最后一个序列只有字面量
+std::vector<char> Compress(const char *data, size_t size);
+// 解出恰好 out_size 字节，输入损坏或长度不符时返回 false
+bool Decompress(const char *data, size_t size, char *out, size_t out_size);
+
+} // namespace mini
@@ -1,12 +1,17 @@
 #pragma once
 #include <array>
 #include <cstdint>
+#include <cstring>
 
 namespace mini {
 
 using page_id_t = int32_t;
 constexpr std::size_t PAGE_SIZE = 4096;
 
+// LSN 就是记录在日志文件中的字节偏移，单调递增，也能直接用来定位记录
+using lsn_t = int64_t;
+constexpr lsn_t INVALID_LSN = -1;
+
 class Page {
 public:
   template <typename T> T *As() {
@@ -20,6 +25,15 @@ public:
     return reinterpret_cast<const char *>(data_.data());
   }
 
+  // 每种页的头部都以 page LSN 开头：最后一条修改过这页的日志
+  // 缓冲池写回前按它刷日志，恢复时按它判断日志是否已经反映在页上
+  lsn_t GetLSN() const {
+    lsn_t lsn;
+    std::memcpy(&lsn, data_.data(), sizeof(lsn));
+    return lsn;
+  }
+  void SetLSN(lsn_t lsn) { std::memcpy(data_.data(), &lsn, sizeof(lsn)); }
+
 private:
   std::array<std::uint8_t, PAGE_SIZE> data_{};
 };
@@ -13,10 +13,13 @@ public:
   PageGuard &operator=(const PageGuard &) = delete;
 
   PageGuard(PageGuard &&other) noexcept;
+  // 先 unpin 自己持有的页，再接管 other 的
+  PageGuard &operator=(PageGuard &&other) noexcept;
 
   ~PageGuard();
 
   Page *GetPage() { return page_; }
+  page_id_t GetPageId() const { return pid_; }
 
   void SetDirty() { dirty_ = true; }
 
@@ -24,7 +27,7 @@ private:
   BufferPool *bpm_;
   page_id_t pid_;
   Page *page_;
-  bool dirty_;
+  bool dirty_{false};
 };
 
 } // namespace mini
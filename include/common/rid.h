@@ -1,11 +1,26 @@
 #pragma once
+#include <cstddef>
 #include <cstdint>
+#include <functional>
 
 namespace mini {
 
 struct RID {
   int32_t page_id;
   uint16_t slot_id;
+
+  bool operator==(const RID &other) const {
+    return page_id == other.page_id && slot_id == other.slot_id;
+  }
+  bool operator!=(const RID &other) const { return !(*this == other); }
 };
 
 } // namespace mini
+
+template <> struct std::hash<mini::RID> {
+  size_t operator()(const mini::RID &rid) const {
+    return std::hash<uint64_t>()(
+        (static_cast<uint64_t>(static_cast<uint32_t>(rid.page_id)) << 16) |
+        rid.slot_id);
+  }
+};
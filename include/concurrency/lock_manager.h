@@ -0,0 +1,137 @@
+#pragma once
+#include "common/rid.h"
+#include "concurrency/transaction.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace mini {
+
+// 加锁失败：被选为死锁的牺牲者，或者同一资源上已经有别的事务在升级。
+// 事务必须回滚
+class TransactionAbortException : public std::runtime_error {
+public:
+  TransactionAbortException(txn_id_t txn_id, const std::string &reason)
+      : std::runtime_error("transaction " + std::to_string(txn_id) +
+                           " aborted: " + reason),
+        txn_id_(txn_id) {}
+
+  txn_id_t GetTxnId() const { return txn_id_; }
+
+private:
+  txn_id_t txn_id_;
+};
+
+// 锁等待的统计，已经持有的锁不算请求
+struct LockStats {
+  size_t requests{0};
+  size_t waits{0};
+  double wait_millis{0};
+  double max_wait_millis{0};
+  size_t deadlocks{0};
+};
+
+// 表锁和行锁，两阶段：事务提交或回滚时由 TransactionManager 一次放掉。
+// 锁表按资源哈希分成若干分区，每个分区一把 mutex，不同分区上的加锁互不影响。
+// 同一资源上的请求按到达顺序排队，和前面所有请求兼容才授予，升级排在
+// 所有等待者前面。后台线程定期从各分区收集等待图（等待者 -> 挡住它的事务），
+// 发现环时选环上最年轻（事务号最大）的事务，唤醒它抛出
+// TransactionAbortException
+class LockManager {
+public:
+  static constexpr size_t DEFAULT_PARTITIONS = 16;
+
+  // detection_interval 为 0 时不启动后台线程，由调用者调 DetectDeadlocks
+  explicit LockManager(std::chrono::milliseconds detection_interval =
+                           std::chrono::milliseconds(50),
+                       size_t partitions = DEFAULT_PARTITIONS);
+  ~LockManager();
+
+  LockManager(const LockManager &) = delete;
+  LockManager &operator=(const LockManager &) = delete;
+
+  // 已经持有不弱于 mode 的锁时直接返回，否则升级到两者都覆盖的锁
+  void LockTable(Transaction *txn, LockMode mode, int32_t table_id);
+  // 行锁只能是 SHARED / EXCLUSIVE，表上要先有相应的意向锁或更强的锁
+  void LockRow(Transaction *txn, LockMode mode, int32_t table_id,
+               const RID &rid);
+  // 放掉事务持有的所有锁，先行后表
+  void ReleaseAll(Transaction *txn);
+
+  // 找出并打破当前所有的死锁，返回选出的牺牲者数
+  size_t DetectDeadlocks();
+  LockStats GetStats() const;
+
+  static bool Compatible(LockMode a, LockMode b);
+  // 同时覆盖 a 和 b 的最弱的锁
+  static LockMode Combine(LockMode a, LockMode b);
+
+private:
+  struct LockRequest {
+    txn_id_t txn_id;
+    LockMode mode;
+    bool granted{false};
+    bool aborted{false}; // 被死锁检测选为牺牲者
+  };
+
+  struct LockQueue {
+    std::list<LockRequest> requests;
+    std::condition_variable cv;
+    txn_id_t upgrading{INVALID_TXN_ID};
+  };
+
+  struct Partition {
+    std::mutex latch;
+    std::unordered_map<int32_t, LockQueue> tables;
+    std::unordered_map<RID, LockQueue> rows;
+  };
+
+  // 一个等待中的请求在哪里，死锁检测找牺牲者用
+  struct WaitPoint {
+    size_t partition;
+    bool is_row;
+    int32_t table_id;
+    RID rid;
+  };
+
+  Partition &PartitionOf(int32_t table_id);
+  Partition &PartitionOf(const RID &rid);
+  // 在 queue 上把 txn 的锁加到 mode，held 是已经持有的锁（没有时为空）
+  void Acquire(std::unique_lock<std::mutex> &guard, LockQueue &queue,
+               Transaction *txn, LockMode mode, const LockMode *held);
+  static bool Grantable(const LockQueue &queue,
+                        std::list<LockRequest>::const_iterator it);
+  static void Release(LockQueue &queue, txn_id_t txn_id);
+  void CollectEdges(const LockQueue &queue, const WaitPoint &point,
+                    std::unordered_map<txn_id_t, std::vector<txn_id_t>> *graph,
+                    std::unordered_map<txn_id_t, WaitPoint> *waiting);
+  void AbortWaiter(txn_id_t txn_id, const WaitPoint &point);
+  void RecordWait(std::chrono::steady_clock::duration waited);
+  void DetectionThread(std::chrono::milliseconds interval);
+
+  std::vector<std::unique_ptr<Partition>> partitions_;
+
+  std::atomic<size_t> requests_{0};
+  std::atomic<size_t> deadlocks_{0};
+  mutable std::mutex stats_latch_; // 保护等待的统计
+  size_t waits_{0};
+  double wait_millis_{0};
+  double max_wait_millis_{0};
+
+  std::mutex detection_latch_;
+  std::condition_variable detection_cv_;
+  bool running_{true};
+  std::thread detection_thread_;
+};
+
+} // namespace mini
@@ -0,0 +1,32 @@
+#pragma once
+#include "recovery/log_record.h"
+#include <algorithm>
+#include <vector>
+
+namespace mini {
+
+// 快照：拍下时已经结束的事务的修改可见，之后的都不可见。
+// 回滚的事务在结束前已经撤销了自己的修改，所以"已结束"等同于"已提交"
+struct Snapshot {
+  txn_id_t xmin{0}; // 比它小的事务拍快照时都已结束
+  txn_id_t xmax{0}; // 拍快照时下一个事务号，不小于它的事务都不可见
+  std::vector<txn_id_t> active; // [xmin, xmax) 里还没结束的事务，有序
+  txn_id_t own{INVALID_TXN_ID}; // 自己的修改总是可见
+
+  // txn_id 的修改在快照里是否可见，INVALID_TXN_ID 表示不属于任何事务
+  bool Sees(txn_id_t txn_id) const {
+    if (txn_id == INVALID_TXN_ID || txn_id == own || txn_id < xmin) {
+      return true;
+    }
+    return txn_id < xmax &&
+           !std::binary_search(active.begin(), active.end(), txn_id);
+  }
+
+  // 由 xmin 插入、xmax 删除（INVALID_TXN_ID 表示没删除）的版本是否可见
+  bool IsVisible(txn_id_t version_xmin, txn_id_t version_xmax) const {
+    return Sees(version_xmin) &&
+           (version_xmax == INVALID_TXN_ID || !Sees(version_xmax));
+  }
+};
+
+} // namespace mini
@@ -0,0 +1,105 @@
+#pragma once
+#include "common/rid.h"
+#include "concurrency/snapshot.h"
+#include "recovery/log_record.h"
+#include "storage/tuple.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace mini {
+
+class Index;
+class TableHeap;
+
+enum class TransactionState { RUNNING, COMMITTED, ABORTED };
+
+enum class WriteType { INSERT, DELETE };
+
+// LOCKING：写之前加锁，冲突时等待；
+// OPTIMISTIC：不加锁，记下读写过的版本，提交时检查有没有被别的事务改过
+enum class ConcurrencyMode { LOCKING, OPTIMISTIC };
+
+// 表上可以加全部五种锁，行上只加 SHARED / EXCLUSIVE。
+// 意向锁表示要在表里的行上加对应的锁
+enum class LockMode {
+  INTENTION_SHARED,
+  INTENTION_EXCLUSIVE,
+  SHARED,
+  SHARED_INTENTION_EXCLUSIVE,
+  EXCLUSIVE
+};
+
+// 事务的一次修改，回滚时按相反顺序撤销。index 为空时是堆上的修改，
+// 否则是 index 上 (tuple 的 key, rid) 这一项的修改
+struct WriteRecord {
+  WriteType type;
+  TableHeap *table;
+  Index *index;
+  RID rid;
+  Tuple tuple;
+  // 修改之前事务的最后一条日志，撤销后写的 CLR 指向它
+  lsn_t undo_next;
+};
+
+// 一个事务在日志里的身份：事务号和它写的上一条日志，
+// 同一事务的日志通过 prev_lsn 串成链表，撤销时沿链表往回走
+class Transaction {
+public:
+  explicit Transaction(txn_id_t txn_id,
+                       ConcurrencyMode mode = ConcurrencyMode::LOCKING)
+      : txn_id_(txn_id), mode_(mode) {}
+  ~Transaction() = default;
+
+  txn_id_t GetTxnId() const { return txn_id_; }
+  lsn_t GetPrevLSN() const { return prev_lsn_; }
+  void SetPrevLSN(lsn_t prev_lsn) { prev_lsn_ = prev_lsn; }
+
+  ConcurrencyMode GetMode() const { return mode_; }
+  TransactionState GetState() const { return state_; }
+  void SetState(TransactionState state) { state_ = state; }
+
+  // 开始时拍下的快照，事务里的读都用它
+  const Snapshot &GetSnapshot() const { return snapshot_; }
+  void SetSnapshot(Snapshot snapshot) { snapshot_ = std::move(snapshot); }
+
+  // 修改完成后由执行器记下，TransactionManager 回滚时用
+  void AppendWrite(WriteRecord write) { write_set_.push_back(std::move(write)); }
+  std::vector<WriteRecord> &GetWriteSet() { return write_set_; }
+
+  // 持有的锁，由 LockManager 在事务自己的线程里维护
+  std::unordered_map<int32_t, LockMode> &GetTableLocks() {
+    return table_locks_;
+  }
+  std::unordered_map<RID, LockMode> &GetRowLocks() { return row_locks_; }
+
+  // 乐观模式下读到的版本，提交时验证
+  void AddRead(const RID &rid) { read_set_.insert(rid); }
+  const std::unordered_set<RID> &GetReadSet() const { return read_set_; }
+
+  // 提交成功后才做的事，比如把插入的行记进统计信息；回滚时丢掉
+  void OnCommit(std::function<void()> action) {
+    commit_actions_.push_back(std::move(action));
+  }
+  std::vector<std::function<void()>> &GetCommitActions() {
+    return commit_actions_;
+  }
+
+private:
+  txn_id_t txn_id_;
+  ConcurrencyMode mode_;
+  lsn_t prev_lsn_{INVALID_LSN};
+  TransactionState state_{TransactionState::RUNNING};
+  Snapshot snapshot_;
+  std::vector<WriteRecord> write_set_;
+  std::unordered_map<int32_t, LockMode> table_locks_;
+  std::unordered_map<RID, LockMode> row_locks_;
+  std::unordered_set<RID> read_set_;
+  std::vector<std::function<void()>> commit_actions_;
+};
+
+} // namespace mini
@@ -0,0 +1,71 @@
+#pragma once
+#include "concurrency/lock_manager.h"
+#include "concurrency/transaction.h"
+#include "recovery/log_manager.h"
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace mini {
+
+// 事务的开始、提交和回滚。log_manager 为空时只在内存里回滚，不写日志
+// 提交时才等 COMMIT 落盘，事务里的多条语句共享一次 fsync
+// 回滚按写集合倒序做补偿操作，每撤销一项写一条 CLR，和恢复时的撤销一致
+// 事务号从日志里用到的最大事务号之后继续，页上的 xmin / xmax 不会撞号
+// lock_manager 不为空时，事务结束（COMMIT 落盘或回滚完成）后放掉所有锁
+// 乐观事务提交前做验证：快照里看不到的已提交事务写过它读过或写过的版本时，
+// 回滚并抛出 TransactionAbortException。为此每个提交的事务都记下写过的版本，
+// 直到所有活跃事务都能看到它
+class TransactionManager {
+public:
+  explicit TransactionManager(LogManager *log_manager = nullptr,
+                              LockManager *lock_manager = nullptr)
+      : log_manager_(log_manager), lock_manager_(lock_manager),
+        next_txn_id_(log_manager ? log_manager->GetNextTxnId() : 0) {}
+
+  // 返回的事务归 TransactionManager 所有，提交或回滚后失效
+  // 开始时拍下快照：之后提交的事务对它不可见
+  Transaction *Begin(ConcurrencyMode mode = ConcurrencyMode::LOCKING);
+  void Commit(Transaction *txn);
+  void Abort(Transaction *txn);
+  // 撤销写集合里第 savepoint 项之后的修改，事务继续运行，语句失败时用
+  void RollbackTo(Transaction *txn, size_t savepoint);
+
+  // 给不在事务里的语句用的快照，own 为空
+  Snapshot GetSnapshot();
+  // 事务号小于它的删除对所有活跃事务的快照都可见，对应的旧版本可以回收。
+  // 不在事务里的语句的快照不算，调用者保证回收时没有这样的语句在跑
+  txn_id_t GetGcHorizon();
+
+  size_t GetActiveCount();
+  LogManager *GetLogManager() { return log_manager_; }
+  // 为空时不加锁
+  LockManager *GetLockManager() { return lock_manager_; }
+
+private:
+  lsn_t AppendTxnRecord(Transaction *txn, LogRecordType type);
+  void Undo(Transaction *txn, const WriteRecord &write);
+  void Release(Transaction *txn);
+  Snapshot TakeSnapshot(txn_id_t own); // 调用者持有 latch_
+  // 验证乐观事务并记下这次提交写过的版本，验证失败时返回 false
+  bool Validate(Transaction *txn);
+
+  struct CommittedWrites {
+    txn_id_t txn_id;
+    std::vector<RID> rids;
+  };
+
+  LogManager *log_manager_;
+  LockManager *lock_manager_;
+
+  std::mutex latch_; // 保护 next_txn_id_ 和 txns_
+  txn_id_t next_txn_id_;
+  std::unordered_map<txn_id_t, std::unique_ptr<Transaction>> txns_;
+
+  std::mutex validation_latch_; // 验证和追加 committed_writes_ 是一步
+  std::vector<CommittedWrites> committed_writes_;
+};
+
+} // namespace mini
@@ -1,17 +1,67 @@
 #pragma once
 #include "catalog/catalog.h"
+#include "concurrency/transaction.h"
+#include "concurrency/transaction_manager.h"
+#include "planner/plan_cache.h"
+#include "recovery/log_manager.h"
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <unordered_map>
 
 namespace mini {
 
+// 一个会话的执行状态。没有传入 txn_manager 时用自己的，
+// 日志和 catalog 写的是同一个
 class ExecutionContext {
 public:
-  ExecutionContext(Catalog &catalog) : catalog_(catalog) {}
+  ExecutionContext(Catalog &catalog, TransactionManager *txn_manager = nullptr)
+      : catalog_(catalog), txn_manager_(txn_manager), plan_cache_(catalog) {
+    if (txn_manager_ == nullptr) {
+      own_txn_manager_ =
+          std::make_unique<TransactionManager>(catalog_.GetLogManager());
+      txn_manager_ = own_txn_manager_.get();
+    }
+  }
   ~ExecutionContext() = default;
 
   Catalog &GetCatalog() { return catalog_; }
+  // 为空时不写日志
+  LogManager *GetLogManager() { return catalog_.GetLogManager(); }
+  TransactionManager &GetTransactionManager() { return *txn_manager_; }
+
+  // BEGIN 开始的显式事务，为空时每条语句自动提交
+  Transaction *GetTransaction() { return txn_; }
+  void SetTransaction(Transaction *txn) { txn_ = txn; }
+
+  // 这个会话之后开始的事务用哪种并发控制
+  ConcurrencyMode GetConcurrencyMode() const { return mode_; }
+  void SetConcurrencyMode(ConcurrencyMode mode) { mode_ = mode; }
+
+  // 连接、排序这类算子每个能在内存里放多少字节，超过时溢出到临时页
+  size_t GetWorkMemory() const { return work_memory_; }
+  void SetWorkMemory(size_t bytes) { work_memory_ = bytes; }
+
+  // PREPARE 过的语句：名字 -> 规范化的 SQL，模板在 PlanCache 里
+  PlanCache &GetPlanCache() { return plan_cache_; }
+  void Prepare(const std::string &name, std::string sql) {
+    prepared_[name] = std::move(sql);
+  }
+  // 没有 PREPARE 过时返回空
+  const std::string *GetPrepared(const std::string &name) const {
+    auto it = prepared_.find(name);
+    return it != prepared_.end() ? &it->second : nullptr;
+  }
 
 private:
   Catalog &catalog_;
+  TransactionManager *txn_manager_;
+  std::unique_ptr<TransactionManager> own_txn_manager_;
+  Transaction *txn_{nullptr};
+  ConcurrencyMode mode_{ConcurrencyMode::LOCKING};
+  size_t work_memory_{4 * 1024 * 1024};
+  PlanCache plan_cache_;
+  std::unordered_map<std::string, std::string> prepared_;
 };
 
 } // namespace mini
@@ -3,11 +3,17 @@
 #include "binder/bound_statement.h"
 #include "catalog/schema.h"
 #include "common/rid.h"
+#include "concurrency/snapshot.h"
 #include "execution/execution_context.h"
+#include "execution/loser_tree.h"
+#include "planner/plan_node.h"
+#include "storage/spill_file.h"
 #include "storage/table_iterator.h"
 #include "storage/tuple.h"
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace mini {
 
@@ -17,6 +23,8 @@ public:
   virtual ~Executor() = default;
   virtual void Init() = 0;
   virtual bool Next(Tuple *) = 0;
+  // 输出行的 schema，不产生行的执行器返回空
+  virtual std::shared_ptr<Schema> GetSchema() const { return nullptr; }
 
 protected:
   ExecutionContext &Context() { return context_; }
@@ -38,32 +46,388 @@ public:
   bool Next(Tuple *) override;
 
 private:
+  // 按表的 schema 把第 row 行的值拼成 tuple
+  Tuple BuildTuple(size_t row) const;
+
   std::unique_ptr<BoundInsertStatement> bound_insert_stmt_;
   bool done_{false};
 };
 
+class HashAggregateExecutor;
+class IndexNestedLoopJoinExecutor;
+class SortExecutor;
+class TopNExecutor;
+
+// 在事务里时读事务开始时的快照，否则读语句开始时的快照，
+// 别的事务没提交的修改看不到
 class SelectExecutor : public Executor {
 public:
-  explicit SelectExecutor(ExecutionContext &context,
-                          std::unique_ptr<BoundSelectStatement> bstat)
-      : Executor(context), bound_select_stmt_(std::move(bstat)) {}
+  // 按 plan 组装算子，plan 为空时自己调用 Planner 建一棵。analyze 时
+  // 把每个算子实际的行数、时间和缓冲池的命中缺页记到计划节点上
+  SelectExecutor(ExecutionContext &context,
+                 std::unique_ptr<BoundSelectStatement> bstat,
+                 PlanNode *plan = nullptr, bool analyze = false);
 
   ~SelectExecutor() override = default;
 
   void Init() override;
   bool Next(Tuple *tuple) override;
-  std::shared_ptr<Schema> GetSchema() const {
-    return bound_select_stmt_->GetSchema();
-  }
+  // 输出的 schema，COUNT(*) 时只有一列 count
+  std::shared_ptr<Schema> GetSchema() const override { return output_schema_; }
+  // Init 之前调用，连接的两边用同一个语句快照
+  void SetSnapshot(const Snapshot &snapshot);
+  const PlanNode *GetPlan() const { return plan_; }
+  // 连接查询选用的执行器，不是连接时为空
+  Executor *GetJoin() const { return join_.get(); }
+  // ORDER BY 用的排序，没有 ORDER BY 或连接的输出已经有序时为空
+  SortExecutor *GetSort() const { return sort_; }
+  // GROUP BY 和聚合函数用的哈希聚合，没有时为空
+  HashAggregateExecutor *GetAggregate() const { return aggregate_; }
+  // ORDER BY ... LIMIT 要留的行放得进工作内存时代替排序，否则为空
+  TopNExecutor *GetTopN() const { return top_n_; }
 
 private:
+  // 把自己产生的行交给上面的聚合或排序
+  class RowSource;
+
+  // 按计划里的连接节点建连接算子，两边的扫描用它的子节点
+  void BuildJoin(BoundJoin *join, PlanNode *node);
+  // analyze 时在算子外面包一层，记下 node 的实际执行情况
+  std::unique_ptr<Executor> Instrument(std::unique_ptr<Executor> executor,
+                                       PlanNode *node);
+
+  // LIMIT / OFFSET 之前的下一行输出
+  bool NextOutput(Tuple *tuple);
+  // 产生下一条满足 WHERE 的表记录，乐观事务把它记进读集合
+  bool NextRow(Tuple *tuple);
+  bool ScanRow(Tuple *tuple);
+
   std::unique_ptr<BoundSelectStatement> bound_select_stmt_;
+  std::unique_ptr<PlanNode> own_plan_;
+  PlanNode *plan_;
+  bool analyze_;
+  // 计划里产生行的扫描或连接节点，和由 SelectExecutor 自己做的节点
+  PlanNode *input_{nullptr};
+  PlanNode *count_node_{nullptr};
+  PlanNode *limit_node_{nullptr};
+  // 索引嵌套循环连接的内表
+  PlanNode *inner_node_{nullptr};
+  std::shared_ptr<Schema> output_schema_;
+  Snapshot snapshot_;
+  Transaction *optimistic_txn_{nullptr};
   TableIterator table_iter_;
   TableIterator end_;
-  bool inited_;
+  bool inited_{false};
 
+  bool use_index_{false};
   std::vector<RID> index_scan_result_;
   size_t index_scan_pos_{0};
+  // 扫描只取这些列（表或连接输出里的位置），为空时取整行
+  std::vector<Column> scan_columns_;
+  // WHERE 的列在扫描出来的行里的偏移
+  uint32_t where_offset_{0};
+  Tuple join_row_;
+  // 表上所有版本都可见时 COUNT(*) 直接数索引项
+  bool count_by_key_{false};
+  bool count_done_{false};
+
+  bool has_snapshot_{false};
+  // 连接查询由它产生行，两边的扫描是单表的 SelectExecutor，
+  // 索引嵌套循环连接的内表由它自己读
+  std::unique_ptr<Executor> join_;
+  SelectExecutor *left_scan_{nullptr};
+  SelectExecutor *right_scan_{nullptr};
+  IndexNestedLoopJoinExecutor *index_join_{nullptr};
+  // 行从 RowSource 往上经过聚合、排序，top_ 是最上面的一个
+  std::unique_ptr<Executor> top_;
+  HashAggregateExecutor *aggregate_{nullptr};
+  SortExecutor *sort_{nullptr};
+  TopNExecutor *top_n_{nullptr};
+  // 已经跳过的 OFFSET 行数和已经输出的行数，输出够 LIMIT 行后不再往下读
+  size_t skipped_{0};
+  size_t returned_{0};
+};
+
+// 等值连接。小的一边（build）先整个读进内存建哈希表，再逐行读另一边
+// （probe）去探测。build 超过会话的工作内存时改用 grace hash join：两边
+// 都按连接键的哈希分区写到临时页上，再逐个分区在内存里连接，分区还是
+// 放不下时换一个哈希再分。输出的行总是左边的行接上右边的行
+class HashJoinExecutor : public Executor {
+public:
+  // 一次最多分这么多区，每个分区写的时候占一页内存
+  static constexpr size_t MAX_FANOUT = 64;
+  // 再分区的层数上限，键大量重复时分不开，到上限后直接在内存里做
+  static constexpr size_t MAX_LEVEL = 3;
+
+  HashJoinExecutor(ExecutionContext &context, std::unique_ptr<Executor> left,
+                   std::unique_ptr<Executor> right, uint32_t left_column,
+                   uint32_t right_column, bool build_left);
+  ~HashJoinExecutor() override = default;
+
+  void Init() override;
+  bool Next(Tuple *tuple) override;
+  std::shared_ptr<Schema> GetSchema() const override { return schema_; }
+
+  bool IsBuildLeft() const { return build_left_; }
+  // 是否溢出到了临时页，以及一共建过多少个分区（含再分区）
+  bool HasSpilled() const { return spilled_; }
+  size_t GetPartitionCount() const { return partition_count_; }
+
+private:
+  // 一对分区，两边的行按同一个哈希分到这里
+  struct Partition {
+    std::unique_ptr<SpillFile> build;
+    std::unique_ptr<SpillFile> probe;
+    size_t level;
+  };
+
+  static int32_t KeyOf(const Tuple &tuple, uint32_t offset);
+  static size_t PartitionOf(int32_t key, size_t level, size_t fanout);
+  size_t Fanout();
+  // 新建一层 fanout 个分区，放到 pending_ 里，返回第一个的下标
+  size_t AddPartitions(size_t level);
+  // 内存里的哈希表超过预算，把它和之后的 build 行都写进分区
+  void SpillBuildTable();
+  // 取下一对分区装进哈希表，没有了返回 false
+  bool LoadNextPartition();
+  bool NextProbe(Tuple *tuple);
+  void Emit(const Tuple &build, const Tuple &probe, Tuple *out) const;
+
+  std::unique_ptr<Executor> left_;
+  std::unique_ptr<Executor> right_;
+  bool build_left_;
+  Executor *build_;
+  Executor *probe_;
+  uint32_t build_offset_; // 连接键在 build 行里的偏移
+  uint32_t probe_offset_;
+  std::shared_ptr<Schema> schema_;
+
+  std::unordered_multimap<int32_t, Tuple> table_;
+  size_t table_bytes_{0};
+  Tuple probe_tuple_;
+  std::unordered_multimap<int32_t, Tuple>::iterator match_;
+  std::unordered_multimap<int32_t, Tuple>::iterator match_end_;
+
+  bool spilled_{false};
+  size_t partition_count_{0};
+  std::vector<Partition> pending_;
+  Partition current_;
+};
+
+// 外部归并排序。子执行器的行先攒在内存里，超过会话的工作内存时排好序
+// 写成一段（run）溢出到临时页；读完后用败者树把所有段归并起来，段太多
+// 时先分几次归并成较少的段。全部放得进内存时不写临时页。
+// 排序只移动 (键前缀, 行的位置) 这样的小项，前缀不同时不用去读行
+class SortExecutor : public Executor {
+public:
+  // 一次最多归并这么多段，每段读的时候占一页内存
+  static constexpr size_t MAX_FAN_IN = 64;
+
+  SortExecutor(ExecutionContext &context, std::unique_ptr<Executor> child,
+               std::vector<SortKey> keys);
+  ~SortExecutor() override = default;
+
+  void Init() override;
+  bool Next(Tuple *tuple) override;
+  std::shared_ptr<Schema> GetSchema() const override { return schema_; }
+
+  // 溢出的段数，全在内存里排时为 0
+  size_t GetRunCount() const { return run_count_; }
+  // 最后一次归并之前的中间归并次数
+  size_t GetMergeCount() const { return merge_count_; }
+
+private:
+  struct SortEntry {
+    uint64_t prefix; // 第一个排序键规范化成无符号数，直接比大小
+    size_t offset;   // 行在 buffer_ 里的位置
+    uint32_t size;
+  };
+  // 一次 k 路归并，heads 是每一路当前的行
+  struct Merge {
+    std::vector<SpillFile *> inputs;
+    std::vector<Tuple> heads;
+    std::vector<bool> live;
+    LoserTree tree;
+  };
+
+  uint64_t PrefixOf(const char *row) const;
+  // 从第 first 个排序键开始比较两行
+  int Compare(const char *a, const char *b, size_t first) const;
+  void SortBuffer();
+  // 内存里的行排好序写成一段
+  void SpillBuffer();
+  // 第 i 路的头是否排在第 j 路前面，读完的一路排在最后
+  bool HeadLess(const Merge &merge, size_t i, size_t j) const;
+  void StartMerge(Merge *merge, std::vector<SpillFile *> inputs);
+  bool PopMerge(Merge *merge, Tuple *tuple);
+  // 把 runs_ 里从 first 开始的 count 段归并成一段
+  std::unique_ptr<SpillFile> MergeRuns(size_t first, size_t count);
+
+  std::unique_ptr<Executor> child_;
+  std::vector<SortKey> keys_;
+  std::vector<Column> key_columns_;
+  std::shared_ptr<Schema> schema_;
+  // 前缀已经决定了第一个键的顺序，前缀相同时从第二个键比起
+  bool prefix_exact_{false};
+
+  std::vector<char> buffer_;
+  std::vector<SortEntry> entries_;
+  size_t output_pos_{0};
+
+  std::vector<std::unique_ptr<SpillFile>> runs_;
+  size_t run_count_{0};
+  size_t merge_count_{0};
+  Merge merge_;
+};
+
+// 从子执行器的行里取出几列，按给定的顺序紧挨着放
+class ProjectionExecutor : public Executor {
+public:
+  ProjectionExecutor(ExecutionContext &context,
+                     std::unique_ptr<Executor> child,
+                     const std::vector<uint32_t> &columns);
+  ~ProjectionExecutor() override = default;
+
+  void Init() override { child_->Init(); }
+  bool Next(Tuple *tuple) override;
+  std::shared_ptr<Schema> GetSchema() const override { return schema_; }
+
+private:
+  std::unique_ptr<Executor> child_;
+  std::vector<Column> columns_; // 在子执行器的行里的位置
+  std::shared_ptr<Schema> schema_;
+  Tuple row_;
+};
+
+// ORDER BY ... LIMIT n：只留排在最前面的 n 行。内存里是按排序顺序的
+// 大顶堆，堆顶是留下的行里排在最后的一行，新来的行排在它前面时替换掉
+// 它。读完后把堆排好序输出，内存只和 n 有关，也不写临时页
+class TopNExecutor : public Executor {
+public:
+  TopNExecutor(ExecutionContext &context, std::unique_ptr<Executor> child,
+               std::vector<SortKey> keys, size_t n);
+  ~TopNExecutor() override = default;
+
+  void Init() override;
+  bool Next(Tuple *tuple) override;
+  std::shared_ptr<Schema> GetSchema() const override { return schema_; }
+
+private:
+  bool Less(const Tuple &a, const Tuple &b) const;
+
+  std::unique_ptr<Executor> child_;
+  std::vector<SortKey> keys_;
+  std::vector<Column> key_columns_;
+  std::shared_ptr<Schema> schema_;
+  size_t n_;
+
+  std::vector<Tuple> heap_;
+  size_t output_pos_{0};
+};
+
+// 排序归并连接：两边先按连接键排序，再一起往前走。右边同一个键的行留在
+// 内存里，和左边这个键的每一行配对。输出按连接键升序，左边的行接上右边
+// 的行
+class SortMergeJoinExecutor : public Executor {
+public:
+  SortMergeJoinExecutor(ExecutionContext &context,
+                        std::unique_ptr<Executor> left,
+                        std::unique_ptr<Executor> right, uint32_t left_column,
+                        uint32_t right_column);
+  ~SortMergeJoinExecutor() override = default;
+
+  void Init() override;
+  bool Next(Tuple *tuple) override;
+  std::shared_ptr<Schema> GetSchema() const override { return schema_; }
+
+private:
+  std::unique_ptr<SortExecutor> left_;
+  std::unique_ptr<SortExecutor> right_;
+  uint32_t left_offset_; // 连接键在左边行里的偏移
+  uint32_t right_offset_;
+  std::shared_ptr<Schema> schema_;
+
+  Tuple left_row_;
+  Tuple right_row_; // 右边下一行，has_right_ 为 false 时已经读完
+  bool has_right_{false};
+  // 右边键等于 group_key_ 的所有行
+  std::vector<Tuple> group_;
+  int32_t group_key_{0};
+  size_t group_pos_{0};
+};
+
+// 哈希聚合。每一组在内存里是一条定长记录：GROUP BY 列的值接上每个
+// 聚合函数的中间状态，放在一块连续内存里，用开放地址（线性探测）的
+// 哈希表找组。表超过会话的工作内存时，把已经聚合过的部分结果按组键的
+// 哈希分区写到临时页上，清空后继续读；读完后逐个分区把同一组的部分
+// 结果合并起来，分区还是放不下时换一个哈希再分。
+// 没有 GROUP BY 时输入为空也输出一行，聚合的值都是 0
+class HashAggregateExecutor : public Executor {
+public:
+  // 一次最多分这么多区，每个分区写的时候占一页内存
+  static constexpr size_t MAX_FANOUT = 64;
+  // 再分区的层数上限，到上限后直接在内存里合并
+  static constexpr size_t MAX_LEVEL = 3;
+
+  HashAggregateExecutor(ExecutionContext &context,
+                        std::unique_ptr<Executor> child,
+                        const BoundAggregation &aggregation);
+  ~HashAggregateExecutor() override = default;
+
+  void Init() override;
+  bool Next(Tuple *tuple) override;
+  std::shared_ptr<Schema> GetSchema() const override { return schema_; }
+
+  // 是否溢出到了临时页，以及一共建过多少个分区（含再分区）
+  bool HasSpilled() const { return spilled_; }
+  size_t GetPartitionCount() const { return partition_count_; }
+
+private:
+  struct Partition {
+    std::unique_ptr<SpillFile> file; // 部分聚合过的组记录
+    size_t level;
+  };
+
+  uint64_t HashKey(const char *key) const;
+  static size_t PartitionOf(uint64_t hash, size_t level, size_t fanout);
+  size_t Fanout();
+  // 新建一层 fanout 个分区，放到 pending_ 里，返回第一个的下标
+  size_t AddPartitions(size_t level);
+  size_t MemoryUsage() const;
+  char *Group(size_t i) { return groups_.data() + i * record_size_; }
+  // 找 key 所在的组，没有时新建一组并拷进 key，状态由调用者初始化
+  char *FindOrInsert(const char *key, uint64_t hash, bool *inserted);
+  void ClearTable();
+  // 用输入的一行初始化一组的状态
+  void InitState(char *record, const char *row) const;
+  // 把同一组的另一份部分结果合并进来
+  void CombineState(char *record, const char *other) const;
+  // 内存里的组超过预算，写进第 0 层的分区后清空
+  void SpillTable();
+  // 取下一个分区合并进哈希表，没有了返回 false
+  bool LoadNextPartition();
+  void Emit(const char *record, Tuple *out) const;
+
+  std::unique_ptr<Executor> child_;
+  std::vector<uint32_t> group_by_;
+  std::vector<BoundSelectItem> items_;
+  std::shared_ptr<Schema> schema_;
+  std::vector<Column> key_columns_;  // GROUP BY 列在输入行里的位置
+  std::vector<Column> item_columns_; // 每一项的输入列，COUNT(*) 时不用
+  // 每一项的状态在记录里的偏移，GROUP BY 列就是它在组键里的偏移
+  std::vector<uint32_t> state_offsets_;
+  uint32_t key_size_{0};
+  uint32_t record_size_{0};
+
+  std::vector<char> groups_;
+  std::vector<uint64_t> hashes_;
+  std::vector<uint32_t> slots_; // 组的下标加一，0 表示空槽
+  size_t group_count_{0};
+  size_t output_pos_{0};
+
+  bool spilled_{false};
+  size_t partition_count_{0};
+  std::vector<Partition> pending_;
 };
 
 class CreateTableExecutor : public Executor {
@@ -102,4 +466,152 @@ private:
   bool done_{false};
 };
 
+// BEGIN 开始一个显式事务，COMMIT / ROLLBACK 结束它
+// 已经在事务里时 BEGIN 报错，不在事务里时 COMMIT / ROLLBACK 报错
+class TransactionExecutor : public Executor {
+public:
+  explicit TransactionExecutor(
+      ExecutionContext &context,
+      std::unique_ptr<BoundTransactionStatement> bound_txn_stmt)
+      : Executor(context), bound_txn_stmt_(std::move(bound_txn_stmt)) {}
+
+  ~TransactionExecutor() override = default;
+
+  void Init() override;
+  bool Next(Tuple *) override;
+
+private:
+  std::unique_ptr<BoundTransactionStatement> bound_txn_stmt_;
+  bool done_{false};
+};
+
+// ANALYZE t：按语句的快照扫描整张表收集统计信息，换掉 catalog 里旧的
+class AnalyzeExecutor : public Executor {
+public:
+  explicit AnalyzeExecutor(
+      ExecutionContext &context,
+      std::unique_ptr<BoundAnalyzeStatement> bound_analyze_stmt)
+      : Executor(context), bound_analyze_stmt_(std::move(bound_analyze_stmt)) {
+  }
+
+  ~AnalyzeExecutor() override = default;
+
+  void Init() override;
+  bool Next(Tuple *) override;
+
+private:
+  std::unique_ptr<BoundAnalyzeStatement> bound_analyze_stmt_;
+  bool done_{false};
+};
+
+// EXPLAIN 输出 Planner 给 SELECT 建的计划树，每个节点一行。EXPLAIN ANALYZE
+// 先把查询执行完，每行再接上实际的行数、时间和缓冲池的命中缺页
+class ExplainExecutor : public Executor {
+public:
+  // 一行最长这么多字节，再长的截断
+  static constexpr uint32_t LINE_WIDTH = 256;
+
+  ExplainExecutor(ExecutionContext &context,
+                  std::unique_ptr<BoundExplainStatement> bound_explain_stmt);
+  ~ExplainExecutor() override = default;
+
+  void Init() override;
+  bool Next(Tuple *tuple) override;
+  std::shared_ptr<Schema> GetSchema() const override { return schema_; }
+
+private:
+  std::unique_ptr<BoundExplainStatement> bound_explain_stmt_;
+  std::shared_ptr<Schema> schema_;
+  std::vector<std::string> lines_;
+  size_t pos_{0};
+};
+
+// PREPARE name AS ...：正文规范化后在 PlanCache 里解析、绑定，名字记在
+// 会话里。同名的语句被替换
+class PrepareExecutor : public Executor {
+public:
+  PrepareExecutor(ExecutionContext &context,
+                  std::unique_ptr<BoundPrepareStatement> bound_prepare_stmt)
+      : Executor(context), bound_prepare_stmt_(std::move(bound_prepare_stmt)) {
+  }
+  ~PrepareExecutor() override = default;
+
+  void Init() override;
+  bool Next(Tuple *) override;
+
+private:
+  std::unique_ptr<BoundPrepareStatement> bound_prepare_stmt_;
+  bool done_{false};
+};
+
+// EXECUTE name(...)：从 PlanCache 取出模板，代入参数后建计划和执行器，
+// 输出就是这条语句的输出。构造时就建好，catalog 变过时在这里重新绑定
+class ExecuteExecutor : public Executor {
+public:
+  ExecuteExecutor(ExecutionContext &context,
+                  std::unique_ptr<BoundExecuteStatement> bound_execute_stmt);
+  ~ExecuteExecutor() override = default;
+
+  void Init() override { executor_->Init(); }
+  bool Next(Tuple *tuple) override { return executor_->Next(tuple); }
+  std::shared_ptr<Schema> GetSchema() const override {
+    return executor_->GetSchema();
+  }
+  // 实际执行的语句是什么，SELECT 还是 INSERT
+  BoundStatementType GetStatementType() const { return type_; }
+  Executor *GetExecutor() const { return executor_.get(); }
+
+private:
+  BoundStatementType type_;
+  std::unique_ptr<Executor> executor_;
+};
+
+// 索引嵌套循环连接：内表的连接列上有 B+Tree 索引时不建哈希表，拿外表的
+// 每一行去索引里查。外表的行攒成一批按键排序，每个键只查一次，相邻的键
+// 落在同一个叶子上时不用再从根下降。内表的 WHERE 在取回行之后判断
+class IndexNestedLoopJoinExecutor : public Executor {
+public:
+  static constexpr size_t BATCH_SIZE = 1024;
+
+  IndexNestedLoopJoinExecutor(ExecutionContext &context,
+                              std::unique_ptr<Executor> outer,
+                              uint32_t outer_column,
+                              std::unique_ptr<BoundSelectStatement> inner,
+                              IndexInfo *inner_index, bool outer_left);
+  ~IndexNestedLoopJoinExecutor() override = default;
+
+  void Init() override;
+  bool Next(Tuple *tuple) override;
+  std::shared_ptr<Schema> GetSchema() const override { return schema_; }
+  // Init 之前调用，和外表用同一个语句快照
+  void SetSnapshot(const Snapshot &snapshot);
+
+  // 查过的不同的键数
+  size_t GetProbeCount() const { return probe_count_; }
+
+private:
+  // 读下一批外表的行，按键排序后一起查索引，外表读完时返回 false
+  bool LoadBatch();
+  // 内表的行是否满足内表上的 WHERE
+  bool InnerMatches(const Tuple &tuple) const;
+
+  std::unique_ptr<Executor> outer_;
+  uint32_t outer_offset_; // 连接键在外表行里的偏移
+  std::unique_ptr<BoundSelectStatement> inner_;
+  IndexInfo *inner_index_;
+  bool outer_left_;
+  std::shared_ptr<Schema> schema_;
+  Snapshot snapshot_;
+  bool has_snapshot_{false};
+  Transaction *optimistic_txn_{nullptr};
+
+  // 当前一批按键排好的外表行，以及每个不同的键在内表里连上的行
+  std::vector<std::pair<int32_t, Tuple>> batch_;
+  std::vector<std::vector<Tuple>> inner_rows_;
+  size_t outer_pos_{0}; // batch_ 里正在输出的外表行
+  size_t key_pos_{0};   // 它的键在 inner_rows_ 里的下标
+  size_t inner_pos_{0};
+  size_t probe_count_{0};
+};
+
 } // namespace mini
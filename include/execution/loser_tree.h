@@ -0,0 +1,55 @@
+#pragma once
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace mini {
+
+// k 路归并用的败者树。叶子是 k 路输入，内部节点记下那一场比赛的败者，
+// 胜者单独记着。胜者那一路换了新的头之后只沿它到根的路径重赛一遍，
+// 每层比一次，堆的下沉每层要比两次。
+// less(i, j) 比较第 i 路和第 j 路当前的头，读完的一路要比谁都大
+class LoserTree {
+public:
+  template <typename Less> void Build(size_t k, Less less) {
+    k_ = k;
+    losers_.assign(k, 0);
+    winner_ = k == 0 ? 0 : Play(1, less);
+  }
+
+  // 当前最小的一路，k 为 0 时没有意义
+  size_t Winner() const { return winner_; }
+
+  // 胜者那一路的头变了，重新比出胜者
+  template <typename Less> void Replay(Less less) {
+    size_t winner = winner_;
+    for (size_t node = (winner + k_) / 2; node >= 1; node /= 2) {
+      if (less(losers_[node], winner)) {
+        std::swap(losers_[node], winner);
+      }
+    }
+    winner_ = winner;
+  }
+
+private:
+  // 节点 1..k-1 是内部节点，k..2k-1 是叶子，返回子树的胜者
+  template <typename Less> size_t Play(size_t node, Less &less) {
+    if (node >= k_) {
+      return node - k_;
+    }
+    size_t left = Play(2 * node, less);
+    size_t right = Play(2 * node + 1, less);
+    if (less(right, left)) {
+      losers_[node] = left;
+      return right;
+    }
+    losers_[node] = right;
+    return left;
+  }
+
+  size_t k_{0};
+  std::vector<size_t> losers_;
+  size_t winner_{0};
+};
+
+} // namespace mini
@@ -10,24 +10,90 @@ namespace mini {
 template <typename KeyType, typename ValueType, typename Comparator>
 class BPlusTree {
 public:
-  explicit BPlusTree(BufferPool *buffer_pool) : buffer_pool_(buffer_pool) {}
+  // 新建一棵空树，同时分配它的头页
+  // log_manager 不为空时，带事务的修改会先写日志
+  explicit BPlusTree(BufferPool *buffer_pool, bool unique = false,
+                     LogManager *log_manager = nullptr);
+  // 从已有的头页打开一棵树
+  BPlusTree(BufferPool *buffer_pool, page_id_t header_page_id,
+            LogManager *log_manager = nullptr);
   ~BPlusTree() = default;
 
-  bool Insert(const KeyType &key, const ValueType &value);
+  // 唯一树中 key 已存在时不插入，返回 false
+  bool Insert(const KeyType &key, const ValueType &value,
+              Transaction *txn = nullptr);
   bool GetValue(const KeyType &key, std::vector<ValueType> *value);
-  bool Remove(const KeyType &key);
+  // 一批升序且不重复的 key，各自的 value 放进 (*values)[i]。
+  // 下一个 key 还落在上一个 key 停下的叶子里时不再从根下降
+  void GetValues(const std::vector<KeyType> &keys,
+                 std::vector<std::vector<ValueType>> *values);
+  // 只数叶子里等于 key 的项，不拷贝 value
+  size_t CountValue(const KeyType &key);
+  // 只从叶子中删除这一对 kv，不做合并
+  bool Remove(const KeyType &key, const ValueType &value,
+              Transaction *txn = nullptr);
+
+  // 删掉头页和树上所有的页，之后树不能再用
+  void Destroy();
+
+  bool IsUnique() const { return unique_; }
+  page_id_t GetHeaderPageId() const { return header_page_id_; }
+  page_id_t GetRootPageId() const { return root_page_id_; }
+  uint32_t GetHeight() const { return height_; }
+  uint64_t GetEntryCount() const { return entry_count_; }
 
   void Print(std::ostream &os) const; // for debug
 
 private:
-  bool InsertDown(page_id_t page_id, const KeyType &key, const ValueType &value,
-                  page_id_t *new_page_id, KeyType *new_key);
+  // 下降到 key 应插入的叶子，同一时刻只 pin 一页
+  // 经过的内部页按从根到叶的顺序记入 path，返回时只有叶子被 pin 着。
+  // 路上遇到满的节点（之前的分裂没取到页）时停在那里，返回这个节点
+  PageGuard DescendToLeaf(const KeyType &key, std::vector<page_id_t> *path);
+
+  // 找到可能包含 key 的最左边的叶子，返回时叶子仍被 pin 着
+  PageGuard FindLeftmostLeaf(const KeyType &key);
+
+  // 把满的节点分成两半，分隔键插入 path 末尾的父节点，父节点满了就
+  // 继续向上，根分裂时换新根。每一层先取到要用的页再修改，取不到时
+  // 返回 false，下面分好的层照常写日志，这一层留着满的节点，树仍然
+  // 完整。撤销时越过这次结构修改，回到 undo_next
+  bool SplitFullNode(PageGuard pageguard, std::vector<page_id_t> *path,
+                     Transaction *txn, lsn_t undo_next);
+
+  // 在已经取到的新页里填好两个孩子，成为新根，不再取回左右两页
+  void NewRoot(PageGuard *pageguard, const KeyType &left_key,
+               page_id_t left_page_id, const KeyType &right_key,
+               page_id_t right_page_id);
+
+  // 把根和高度写进已经 pin 住的头页，根变化时立即调用
+  void UpdateHeader(PageGuard *header_guard);
+
+  // 取一页，缓冲池没有空闲的帧时抛异常，不返回空的 guard
+  PageGuard FetchPage(page_id_t page_id);
 
-  void MergeNewPages(page_id_t left_page_id, page_id_t right_page_id,
-                     page_id_t parent_page_id);
+  // 追加一条属于 txn 的日志，并把被修改的页的 page LSN 设为它
+  // 没有日志或事务时什么也不做
+  void AppendLog(Transaction *txn, LogRecord *record, Page *page);
+  // 叶子上的单个 kv 修改，撤销时按 key 和 value 反做。头页里的项数
+  // 跟着加减，由同一条记录重做。头页要在写日志之前取到，它的
+  // recLSN 才不会晚于这条记录
+  void LogEntry(Transaction *txn, LogRecordType type, PageGuard *pageguard,
+                PageGuard *header_guard, const KeyType &key,
+                const ValueType &value);
+  // 分裂和换根涉及多页，修改完之前这些页一直 pin 着，最后一起写成
+  // 一条 INDEX_SMO，记下修改后的整页，然后放掉所有页。
+  // 撤销时从这条记录直接跳到 undo_next，结构修改本身不撤销
+  void LogStructureModification(Transaction *txn, lsn_t undo_next,
+                                std::vector<PageGuard> *modified);
 
   BufferPool *buffer_pool_;
+  LogManager *log_manager_;
+  page_id_t header_page_id_{INVALID_PAGE_ID};
+  // 以下都是头页内容在内存里的副本
   page_id_t root_page_id_{INVALID_PAGE_ID};
+  uint32_t height_{0};
+  uint64_t entry_count_{0};
+  bool unique_{false};
 };
 
 } // namespace mini
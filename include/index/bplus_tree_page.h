@@ -2,6 +2,7 @@
 
 #include "common/page.h"
 #include "storage/table_heap.h"
+#include "type/data_type.h"
 #include <cstddef>
 #include <cstdint>
 #include <vector>
@@ -9,7 +10,28 @@ namespace mini {
 
 // 无法支持string的key类型，因为string的长度不固定，无法直接存储在page中
 
+template <typename KeyType> constexpr DataType KeyTypeOf();
+template <> constexpr DataType KeyTypeOf<int32_t>() {
+  return DataType::INTEGER;
+}
+
+// 每棵树一页，记录打开索引需要的全部元数据，重启后从这里找回根
+struct BPlusTreeHeaderPage {
+  lsn_t lsn;              // page LSN，必须在页首
+  page_id_t root_page_id; // 空树为 INVALID_PAGE_ID
+  uint32_t height;        // 空树为 0，只有一个叶子时为 1
+  DataType key_type;
+  uint32_t key_size;
+  uint64_t entry_count;
+  bool unique;
+
+  static BPlusTreeHeaderPage *From(Page *page) {
+    return reinterpret_cast<BPlusTreeHeaderPage *>(page->GetData());
+  }
+};
+
 struct BPlusTreePageHeader {
+  lsn_t lsn; // page LSN，必须在页首
   page_id_t parent_page_id;
   uint16_t key_count;
   uint16_t max_key_count;
@@ -68,10 +90,16 @@ public:
   bool Insert(const KeyType &key, const ValueType &value);
   bool Remove(const KeyType &key) = delete; //暂不实现删除功能
 
+  // 第一个 >= key 的下标，没有则返回 key_count
+  uint16_t KeyIndex(const KeyType &key) const;
+  // 删除下标处的键值对，不做合并
+  void RemoveAt(uint16_t index);
+
   bool IsFull() const { return this->GetKeyCount() >= MAX_KEY_COUNT; }
   bool Split(BPlusTreeLeafPage *new_page);
 
   void Init(page_id_t page_id) {
+    this->header_.lsn = INVALID_LSN;
     this->SetParentPageId(INVALID_PAGE_ID);
     this->SetKeyCount(0);
     this->SetMaxKeyCount(MAX_KEY_COUNT);
@@ -122,6 +150,7 @@ public:
   bool Split(BPlusTreeInternalPage *new_page);
 
   void Init(page_id_t page_id) {
+    this->header_.lsn = INVALID_LSN;
     this->SetParentPageId(INVALID_PAGE_ID);
     this->SetKeyCount(0);
     this->SetMaxKeyCount(MAX_KEY_COUNT);
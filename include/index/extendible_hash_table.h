@@ -0,0 +1,99 @@
+#pragma once
+#include "common/page.h"
+#include "common/rid.h"
+#include "index/hash_table_page.h"
+#include "storage/buffer_pool.h"
+#include "storage/table_heap.h"
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace mini {
+
+// 磁盘上的可扩展哈希表：一个头页 + 若干目录页 + 若干桶页，都通过
+// BufferPool 访问。头页的内容在内存里有副本，点查只需要一个目录页和
+// 一个桶页，不随数据量增长。
+// 桶满了先分裂，带溢出页的桶连同整条链一起分；分裂不开（目录到了最大
+// 深度，或者整条链上全是同一个 key）时在桶后面接溢出页。溢出链只用来放
+// 同一个 key 的大量重复项
+template <typename KeyType, typename ValueType, typename Comparator>
+class ExtendibleHashTable {
+  using BucketPage = HashTableBucketPage<KeyType, ValueType, Comparator>;
+
+public:
+  // 新建一个空表，同时分配它的头页
+  // log_manager 不为空时，带事务的修改会先写日志。bucket_max_size
+  // 是每个桶页最多放的项数，默认放满一页，测试里用小的桶
+  explicit ExtendibleHashTable(BufferPool *buffer_pool, bool unique = false,
+                               LogManager *log_manager = nullptr,
+                               uint16_t bucket_max_size = BucketPage::MAX_SIZE);
+  // 从已有的头页打开一个表
+  ExtendibleHashTable(BufferPool *buffer_pool, page_id_t header_page_id,
+                      LogManager *log_manager = nullptr);
+  ~ExtendibleHashTable() = default;
+
+  // 唯一表中 key 已存在时不插入，返回 false
+  bool Insert(const KeyType &key, const ValueType &value,
+              Transaction *txn = nullptr);
+  bool GetValue(const KeyType &key, std::vector<ValueType> *value);
+  // 只删除桶里的项，不合并桶也不收缩目录
+  bool Remove(const KeyType &key, const ValueType &value,
+              Transaction *txn = nullptr);
+
+  // 删掉头页、目录页和所有的桶页，之后表不能再用
+  void Destroy();
+
+  bool IsUnique() const { return unique_; }
+  page_id_t GetHeaderPageId() const { return header_page_id_; }
+  uint32_t GetGlobalDepth() const { return global_depth_; }
+
+private:
+  // 一次结构修改里改过的页的副本，按页号排列
+  using StagedPages = std::map<page_id_t, std::vector<char>>;
+  using Entry = std::pair<KeyType, ValueType>;
+
+  static uint32_t Hash(const KeyType &key);
+
+  // 槽位 slot 指向的桶的第一页，和这个桶的 local depth
+  page_id_t BucketPageIdOf(uint32_t slot);
+  uint32_t LocalDepthOf(uint32_t slot);
+
+  // 第一次插入时建第一个目录页和第一个桶
+  void CreateDirectory(Transaction *txn);
+  // 分裂 slot 指向的桶，必要时目录翻倍
+  void SplitBucket(uint32_t slot, Transaction *txn);
+  // 把 entries 按顺序写成一条桶链，返回第一页。先用 spare 里的页
+  // （从后往前取），不够再分配新页
+  page_id_t WriteChain(StagedPages *staged, const std::vector<Entry> &entries,
+                       std::vector<page_id_t> *spare);
+  // 在 tail_page_id 后面接一个溢出页
+  void AppendOverflowPage(page_id_t tail_page_id, Transaction *txn);
+
+  // 结构修改先改页的副本，不 pin 住页：目录翻倍要改所有目录页，
+  // 页数可能比缓冲池还多。第一次取时从缓冲池拷一份
+  char *Stage(StagedPages *staged, page_id_t page_id);
+  // 分配一个新页，副本全为 0
+  char *StageNewPage(StagedPages *staged, page_id_t *page_id);
+  // 把副本一起写成一条 INDEX_SMO，再一页一页拷回缓冲池。
+  // 撤销时从这条记录直接跳到 undo_next，结构修改本身不撤销
+  void ApplyStructureModification(Transaction *txn, lsn_t undo_next,
+                                  StagedPages *staged);
+  // 头页内容在内存里的副本写进 staged 里的头页
+  void StageHeader(StagedPages *staged);
+
+  // 桶页上的单个 kv 修改，撤销时按 key 和 value 反做
+  // 没有日志或事务时什么也不做
+  void LogEntry(Transaction *txn, LogRecordType type, PageGuard *pageguard,
+                const KeyType &key, const ValueType &value);
+
+  BufferPool *buffer_pool_;
+  LogManager *log_manager_;
+  page_id_t header_page_id_{INVALID_PAGE_ID};
+  // 以下都是头页内容在内存里的副本
+  uint32_t global_depth_{0};
+  std::vector<page_id_t> directory_page_ids_;
+  bool unique_{false};
+  uint16_t bucket_max_size_{BucketPage::MAX_SIZE};
+};
+
+} // namespace mini
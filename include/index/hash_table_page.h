@@ -0,0 +1,144 @@
+#pragma once
+
+#include "common/page.h"
+#include "storage/table_heap.h"
+#include "type/data_type.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace mini {
+
+// 目录页：一段槽位的 local depth 和桶页号，global depth 记在头页里。
+// 槽位 i 在第 i / SLOTS_PER_PAGE 个目录页的第 i % SLOTS_PER_PAGE 项
+class HashTableDirectoryPage {
+public:
+  static constexpr uint32_t DIRECTORY_PAGE_DEPTH = 9;
+  static constexpr uint32_t SLOTS_PER_PAGE = 1 << DIRECTORY_PAGE_DEPTH;
+
+  static HashTableDirectoryPage *From(Page *page) {
+    return From(page->GetData());
+  }
+  static HashTableDirectoryPage *From(char *data) {
+    return reinterpret_cast<HashTableDirectoryPage *>(data);
+  }
+
+  void Init();
+
+  page_id_t GetBucketPageId(uint32_t offset) const {
+    return bucket_page_ids_[offset];
+  }
+  void SetBucketPageId(uint32_t offset, page_id_t bucket_page_id) {
+    bucket_page_ids_[offset] = bucket_page_id;
+  }
+  uint32_t GetLocalDepth(uint32_t offset) const {
+    return local_depths_[offset];
+  }
+  void SetLocalDepth(uint32_t offset, uint32_t local_depth) {
+    local_depths_[offset] = static_cast<uint8_t>(local_depth);
+  }
+
+private:
+  lsn_t lsn_; // page LSN，必须在页首
+  uint8_t local_depths_[SLOTS_PER_PAGE];
+  page_id_t bucket_page_ids_[SLOTS_PER_PAGE];
+};
+
+static_assert(sizeof(HashTableDirectoryPage) <= PAGE_SIZE,
+              "directory page must fit in a page");
+
+// 每个哈希表一页，记录 global depth 和各目录页的页号，重启后从这里打开。
+// global depth 不超过 9 时只有一个目录页，之后每翻倍一次目录页数也翻倍
+struct HashTableHeaderPage {
+  static constexpr uint32_t MAX_DIRECTORY_PAGES = 512;
+  static constexpr uint32_t MAX_GLOBAL_DEPTH =
+      HashTableDirectoryPage::DIRECTORY_PAGE_DEPTH + 9;
+
+  lsn_t lsn; // page LSN，必须在页首
+  uint32_t global_depth;
+  DataType key_type;
+  uint32_t key_size;
+  bool unique;
+  // 每个桶页最多放几项，新建的桶都用这个值
+  uint16_t bucket_max_size;
+  // 还没有插入过时一个目录页都没有
+  uint32_t directory_page_count;
+  page_id_t directory_page_ids[MAX_DIRECTORY_PAGES];
+
+  static HashTableHeaderPage *From(Page *page) {
+    return From(page->GetData());
+  }
+  static HashTableHeaderPage *From(char *data) {
+    return reinterpret_cast<HashTableHeaderPage *>(data);
+  }
+};
+
+static_assert(sizeof(HashTableHeaderPage) <= PAGE_SIZE,
+              "header page must fit in a page");
+
+struct HashTableBucketHeader {
+  lsn_t lsn; // page LSN，必须在页首
+  uint16_t size;
+  uint16_t max_size;
+  // 同一个桶的溢出页，桶满了又不能分裂时接在后面
+  page_id_t next_page_id;
+};
+
+// 桶页：按 key 有序的 kv 数组，查找用二分
+template <typename KeyType, typename ValueType, typename Comparator>
+class HashTableBucketPage {
+public:
+  using MappingType = struct {
+    KeyType key;
+    ValueType value;
+  };
+
+  static HashTableBucketPage *From(Page *page) {
+    return From(page->GetData());
+  }
+  static HashTableBucketPage *From(char *data) {
+    return reinterpret_cast<HashTableBucketPage *>(data);
+  }
+
+  // 一页最多能放的项数
+  static constexpr uint16_t MAX_SIZE =
+      (PAGE_SIZE - sizeof(HashTableBucketHeader)) / sizeof(MappingType);
+
+  // max_size 记在页里，测试可以用更小的桶
+  void Init(uint16_t max_size = MAX_SIZE) {
+    header_.lsn = INVALID_LSN;
+    header_.size = 0;
+    header_.max_size = max_size;
+    header_.next_page_id = INVALID_PAGE_ID;
+  }
+
+  KeyType KeyAt(uint16_t index) const { return array_[index].key; }
+  ValueType ValueAt(uint16_t index) const { return array_[index].value; }
+  void SetKeyAt(uint16_t index, const KeyType &key) { array_[index].key = key; }
+  void SetValueAt(uint16_t index, const ValueType &value) {
+    array_[index].value = value;
+  }
+  uint16_t Size() const { return header_.size; }
+  page_id_t GetNextPageId() const { return header_.next_page_id; }
+  void SetNextPageId(page_id_t next_page_id) {
+    header_.next_page_id = next_page_id;
+  }
+  void SetSize(uint16_t size) { header_.size = size; }
+  uint16_t MaxSize() const { return header_.max_size; }
+  bool IsFull() const { return header_.size >= header_.max_size; }
+  bool IsEmpty() const { return header_.size == 0; }
+
+  // 第一个 >= key 的下标
+  uint16_t KeyIndex(const KeyType &key) const;
+  bool Contains(const KeyType &key) const;
+  bool Lookup(const KeyType &key, std::vector<ValueType> *value) const;
+  bool Insert(const KeyType &key, const ValueType &value);
+  bool Remove(const KeyType &key, const ValueType &value);
+  void RemoveAt(uint16_t index);
+
+private:
+  HashTableBucketHeader header_;
+  MappingType array_[1];
+};
+
+} // namespace mini
@@ -2,6 +2,7 @@
 #include "catalog/schema.h"
 #include "common/comparator.h"
 #include "index/bplus_tree.h"
+#include "index/extendible_hash_table.h"
 #include "storage/buffer_pool.h"
 #include "storage/tuple.h"
 #include <cassert>
@@ -9,13 +10,37 @@
 
 namespace mini {
 
+enum class IndexType { BPLUS_TREE, HASH };
+
 class Index {
 public:
   virtual ~Index() = default;
-  virtual void InsertEntry(const Tuple &tuple, const RID &rid) = 0;
-  virtual void DeleteEntry(const Tuple &tuple,
-                           const RID &rid) = 0; // 可先不实现
+  // 唯一索引上 key 已存在时返回 false，索引不变
+  // txn 不为空时修改记入该事务的日志
+  virtual bool InsertEntry(const Tuple &tuple, const RID &rid,
+                           Transaction *txn = nullptr) = 0;
+  virtual void DeleteEntry(const Tuple &tuple, const RID &rid,
+                           Transaction *txn = nullptr) = 0;
   virtual bool ScanKey(const Value &key, std::vector<RID> *result) = 0;
+  // 一批升序且不重复的 INT key，各自的 RID 放进 (*result)[i]
+  virtual void ScanKeys(const std::vector<int32_t> &keys,
+                        std::vector<std::vector<RID>> *result) {
+    result->assign(keys.size(), {});
+    for (size_t i = 0; i < keys.size(); ++i) {
+      ScanKey(IntValue(keys[i]), &(*result)[i]);
+    }
+  }
+  // 等于 key 的项数，只读索引不回表
+  virtual size_t CountKey(const Value &key) {
+    std::vector<RID> result;
+    ScanKey(key, &result);
+    return result.size();
+  }
+  virtual bool IsUnique() const = 0;
+  // 把索引用到的页都还给缓冲池，之后索引不能再用。建索引失败时调用
+  virtual void Destroy() = 0;
+  // 记录打开索引需要的元数据的页，目录里存的就是它
+  virtual page_id_t GetHeaderPageId() const = 0;
 
 private:
 };
@@ -24,36 +49,126 @@ class BPlusTreeIndex : public Index {
 public:
   BPlusTreeIndex(BufferPool *bpm, std::string index_name,
                  std::string table_name, std::shared_ptr<Schema> table_schema,
-                 uint32_t key_col_id)
+                 uint32_t key_col_id, bool is_unique = false,
+                 LogManager *log_manager = nullptr)
+      : bp_(bpm), index_name_(std::move(index_name)),
+        table_name_(std::move(table_name)), key_col_id_(key_col_id),
+        table_schema_(table_schema), tree_(bp_, is_unique, log_manager) {}
+  // 从已有的头页打开，重启后读回目录时用
+  BPlusTreeIndex(BufferPool *bpm, std::string index_name,
+                 std::string table_name, std::shared_ptr<Schema> table_schema,
+                 uint32_t key_col_id, page_id_t header_page_id,
+                 LogManager *log_manager = nullptr)
       : bp_(bpm), index_name_(std::move(index_name)),
         table_name_(std::move(table_name)), key_col_id_(key_col_id),
-        table_schema_(table_schema), tree_(bp_) {}
+        table_schema_(table_schema), tree_(bp_, header_page_id, log_manager) {}
 
   ~BPlusTreeIndex() override = default;
 
-  void InsertEntry(const Tuple &tuple, const RID &rid) override {
+  bool InsertEntry(const Tuple &tuple, const RID &rid,
+                   Transaction *txn = nullptr) override {
+    return tree_.Insert(KeyOf(tuple), rid, txn);
+  }
+
+  void DeleteEntry(const Tuple &tuple, const RID &rid,
+                   Transaction *txn = nullptr) override {
+    tree_.Remove(KeyOf(tuple), rid, txn);
+  }
+
+  bool ScanKey(const Value &key, std::vector<RID> *result) override {
+    assert(key.Type() == DataType::INTEGER);
+    auto &k = static_cast<const IntValue &>(key);
+    return tree_.GetValue(k.GetValue(), result);
+  }
+
+  size_t CountKey(const Value &key) override {
+    assert(key.Type() == DataType::INTEGER);
+    auto &k = static_cast<const IntValue &>(key);
+    return tree_.CountValue(k.GetValue());
+  }
+
+  // 相邻的 key 在同一个叶子上时不用再从根下降
+  void ScanKeys(const std::vector<int32_t> &keys,
+                std::vector<std::vector<RID>> *result) override {
+    tree_.GetValues(keys, result);
+  }
+
+  bool IsUnique() const override { return tree_.IsUnique(); }
+  void Destroy() override { tree_.Destroy(); }
+  page_id_t GetHeaderPageId() const override {
+    return tree_.GetHeaderPageId();
+  }
+
+private:
+  int32_t KeyOf(const Tuple &tuple) const {
     // 从 tuple 里抽 key（按 schema 解码）
     auto key_val = tuple.GetValue(table_schema_, key_col_id_);
     // 只支持 INT
-    int32_t k = static_cast<IntValue *>(key_val.get())->GetValue();
-    tree_.Insert(k, rid);
+    return static_cast<IntValue *>(key_val.get())->GetValue();
   }
 
-  void DeleteEntry(const Tuple &, const RID &) override {}
+
+  BufferPool *bp_;
+  std::string index_name_;
+  std::string table_name_;
+  uint32_t key_col_id_;
+  std::shared_ptr<Schema> table_schema_;
+  BPlusTree<int32_t, RID, IntComparator> tree_;
+};
+
+// 只支持等值查询，点查不需要逐层下降
+class HashIndex : public Index {
+public:
+  HashIndex(BufferPool *bpm, std::string index_name, std::string table_name,
+            std::shared_ptr<Schema> table_schema, uint32_t key_col_id,
+            bool is_unique = false, LogManager *log_manager = nullptr)
+      : bp_(bpm), index_name_(std::move(index_name)),
+        table_name_(std::move(table_name)), key_col_id_(key_col_id),
+        table_schema_(table_schema), table_(bp_, is_unique, log_manager) {}
+  HashIndex(BufferPool *bpm, std::string index_name, std::string table_name,
+            std::shared_ptr<Schema> table_schema, uint32_t key_col_id,
+            page_id_t header_page_id, LogManager *log_manager = nullptr)
+      : bp_(bpm), index_name_(std::move(index_name)),
+        table_name_(std::move(table_name)), key_col_id_(key_col_id),
+        table_schema_(table_schema),
+        table_(bp_, header_page_id, log_manager) {}
+
+  ~HashIndex() override = default;
+
+  bool InsertEntry(const Tuple &tuple, const RID &rid,
+                   Transaction *txn = nullptr) override {
+    return table_.Insert(KeyOf(tuple), rid, txn);
+  }
+
+  void DeleteEntry(const Tuple &tuple, const RID &rid,
+                   Transaction *txn = nullptr) override {
+    table_.Remove(KeyOf(tuple), rid, txn);
+  }
 
   bool ScanKey(const Value &key, std::vector<RID> *result) override {
     assert(key.Type() == DataType::INTEGER);
     auto &k = static_cast<const IntValue &>(key);
-    return tree_.GetValue(k.GetValue(), result);
+    return table_.GetValue(k.GetValue(), result);
+  }
+
+  bool IsUnique() const override { return table_.IsUnique(); }
+  void Destroy() override { table_.Destroy(); }
+  page_id_t GetHeaderPageId() const override {
+    return table_.GetHeaderPageId();
   }
 
 private:
+  int32_t KeyOf(const Tuple &tuple) const {
+    auto key_val = tuple.GetValue(table_schema_, key_col_id_);
+    return static_cast<IntValue *>(key_val.get())->GetValue();
+  }
+
   BufferPool *bp_;
   std::string index_name_;
   std::string table_name_;
   uint32_t key_col_id_;
   std::shared_ptr<Schema> table_schema_;
-  BPlusTree<int32_t, RID, IntComparator> tree_;
+  ExtendibleHashTable<int32_t, RID, IntComparator> table_;
 };
 
 } // namespace mini
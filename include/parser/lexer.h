@@ -23,6 +23,31 @@ enum class TokenType {
   TOKEN_TABLE,
   TOKEN_INDEX,
   TOKEN_ON,
+  TOKEN_UNIQUE,
+  TOKEN_PRIMARY,
+  TOKEN_KEY,
+  TOKEN_USING,
+  TOKEN_COUNT,
+  TOKEN_BEGIN,
+  TOKEN_COMMIT,
+  TOKEN_ROLLBACK,
+  TOKEN_JOIN,
+  TOKEN_ORDER,
+  TOKEN_BY,
+  TOKEN_ASC,
+  TOKEN_DESC,
+  TOKEN_GROUP,
+  TOKEN_SUM,
+  TOKEN_MIN,
+  TOKEN_MAX,
+  TOKEN_AVG,
+  TOKEN_LIMIT,
+  TOKEN_OFFSET,
+  TOKEN_ANALYZE,
+  TOKEN_EXPLAIN,
+  TOKEN_PREPARE,
+  TOKEN_EXECUTE,
+  TOKEN_AS,
 
   // Literals
   TOKEN_IDENTIFIER,
@@ -36,8 +61,9 @@ enum class TokenType {
   TOKEN_LEFT_PAREN,  //(
   TOKEN_RIGHT_PAREN, //)
   // not in v1
-  TOKEN_DOT,   //.
-  TOKEN_EQUAL, //=
+  TOKEN_DOT,       //.
+  TOKEN_EQUAL,     //=
+  TOKEN_PARAMETER, //?
 
   // Special tokens
   TOKEN_EOF,
@@ -107,6 +133,7 @@ public:
 
   std::vector<Token> Tokenize(); //将整个输入标记化为token序列
   size_t GetPosition() const { return position_; }
+  std::string_view GetInput() const { return input_; }
 
   bool HasError() const { return error_.has_value(); }
   LexerError GetError() const { return error_.value(); }
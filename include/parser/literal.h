@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <string>
 #include <string_view>
 namespace mini {
@@ -23,6 +24,18 @@ private:
   std::string_view value_;
 };
 
+// INSERT 的 VALUES 里的 ?，第 index 个参数
+class ParameterLiteral : public Literal {
+public:
+  explicit ParameterLiteral(size_t index) : index_(index) {}
+  ~ParameterLiteral() override = default;
+
+  size_t index() const { return index_; }
+
+private:
+  size_t index_;
+};
+
 class IntLiteral : public Literal {
 public:
   explicit IntLiteral(std::string_view value) : value_(value) {}
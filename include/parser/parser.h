@@ -2,6 +2,7 @@
 #include "parser/lexer.h"
 #include "parser/literal.h"
 #include "parser/statement.h"
+#include <cstddef>
 #include <memory>
 #include <optional>
 #include <string>
@@ -25,7 +26,9 @@ private:
 
 class Parser {
 public:
-  explicit Parser(std::unique_ptr<Lexer> lexer) : lexer_(std::move(lexer)) {}
+  // allow_parameters 时语句里可以有 ? 参数，解析预编译语句的正文时用
+  explicit Parser(std::unique_ptr<Lexer> lexer, bool allow_parameters = false)
+      : lexer_(std::move(lexer)), allow_parameters_(allow_parameters) {}
   ~Parser() = default;
 
   // 解析入口函数
@@ -33,17 +36,36 @@ public:
   std::unique_ptr<Statement> ParseInsertStatement();
   std::unique_ptr<Statement> ParseSelectStatement();
   std::unique_ptr<Statement> ParseCreateTableStatement();
-  std::unique_ptr<Statement> ParseCreateIndexStatement();
+  std::unique_ptr<Statement> ParseCreateIndexStatement(bool is_unique = false);
+  std::unique_ptr<Statement> ParseTransactionStatement();
+  std::unique_ptr<Statement> ParseAnalyzeStatement();
+  std::unique_ptr<Statement> ParseExplainStatement();
+  std::unique_ptr<Statement> ParsePrepareStatement();
+  std::unique_ptr<Statement> ParseExecuteStatement();
 
   bool HasError() const { return error_.has_value(); }
   ParserError GetError() const { return error_.value(); }
+  // 解析到的 ? 参数个数
+  size_t ParameterCount() const { return parameter_count_; }
 
 private:
   //如果下一个token类型匹配expected则消费它并返回，否则记录错误
   Token Expect(TokenType expected);
+  // INSERT 的一行 (value, ...)，出错时返回空
+  std::optional<InsertStatement::Row> ParseInsertRow();
+  // col 或 t.col
+  ColumnRef ParseColumnRef();
+  // SELECT 列表里的一项：col，COUNT(*)，或者 COUNT/SUM/MIN/MAX/AVG(col)
+  SelectItem ParseSelectItem();
+  // ORDER BY 后面的 col [ASC|DESC], ...，col 也可以是聚合函数
+  std::vector<OrderByItem> ParseOrderBy();
+  // 下一个 token 是 ?，不允许参数时记录错误并返回 false
+  bool ParseParameter();
 
   std::unique_ptr<Lexer> lexer_;
   std::optional<ParserError> error_;
+  bool allow_parameters_;
+  size_t parameter_count_{0};
 };
 
 } // namespace mini
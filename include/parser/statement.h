@@ -3,12 +3,25 @@
 #include "parser/literal.h"
 #include "type/data_type.h"
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
 namespace mini {
 
-enum class StatementType { INSERT, SELECT, CREATE_TABLE, CREATE_INDEX };
+enum class StatementType {
+  INSERT,
+  SELECT,
+  CREATE_TABLE,
+  CREATE_INDEX,
+  TRANSACTION,
+  ANALYZE,
+  EXPLAIN,
+  PREPARE,
+  EXECUTE
+};
+
+enum class TransactionCommand { BEGIN, COMMIT, ROLLBACK };
 
 class Statement {
 public:
@@ -19,36 +32,73 @@ public:
 private:
 };
 
+// INSERT INTO t VALUES (...)[, (...)]，一条语句可以插入多行
 class InsertStatement : public Statement {
 public:
-  InsertStatement(std::string table_name,
-                  std::vector<std::unique_ptr<Literal>> values)
-      : table_name_(std::move(table_name)), values_(std::move(values)) {}
+  using Row = std::vector<std::unique_ptr<Literal>>;
+
+  InsertStatement(std::string table_name, Row values)
+      : table_name_(std::move(table_name)) {
+    rows_.push_back(std::move(values));
+  }
+  InsertStatement(std::string table_name, std::vector<Row> rows)
+      : table_name_(std::move(table_name)), rows_(std::move(rows)) {}
   ~InsertStatement() override = default;
 
   StatementType Type() const override { return StatementType::INSERT; }
   std::string Table_name() const { return table_name_; }
-  const std::vector<std::unique_ptr<Literal>> &Values() const {
-    return values_;
-  } // TODO: ???
+  // 第一行
+  const Row &Values() const { return rows_.front(); }
+  const std::vector<Row> &Rows() const { return rows_; }
 
 private:
   std::string table_name_;
   // TODO: not supported in v1
   // std::vector<std::string> columns_;
-  std::vector<std::unique_ptr<Literal>> values_;
+  std::vector<Row> rows_;
+};
+
+// t.col，不带表名时 table 为空
+struct ColumnRef {
+  std::string table;
+  std::string column;
+};
+
+// FROM a JOIN b ON a.x = b.y 里 JOIN 后面的部分
+struct JoinClause {
+  std::string table_name;
+  ColumnRef left;
+  ColumnRef right;
+};
+
+enum class AggregateType { NONE, COUNT_STAR, COUNT, SUM, MIN, MAX, AVG };
+
+// SELECT 列表里的一项：一列，或者一列上的聚合函数。COUNT(*) 没有列
+struct SelectItem {
+  AggregateType aggregate{AggregateType::NONE};
+  ColumnRef column;
+};
+
+// ORDER BY 里的一列或一个聚合函数，默认升序
+struct OrderByItem {
+  ColumnRef column;
+  bool desc{false};
+  AggregateType aggregate{AggregateType::NONE};
 };
 
 class SelectStatement : public Statement {
 public:
-  // SelectStatement(std::string table_name, std::vector<std::string> columns)
-  //     : table_name_(std::move(table_name)), columns_(std::move(columns)) {}
   SelectStatement(std::string table_name, bool is_select_all = true,
                   bool has_where = false, std::string where_column = "",
-                  std::unique_ptr<Value> where_value = nullptr)
+                  std::unique_ptr<Value> where_value = nullptr,
+                  bool is_count_star = false, std::string where_table = "",
+                  std::optional<JoinClause> join = std::nullopt,
+                  std::vector<OrderByItem> order_by = {})
       : table_name_(std::move(table_name)), is_select_all_(is_select_all),
         has_where_(has_where), where_column_(where_column),
-        where_value_(std::move(where_value)) {}
+        where_value_(std::move(where_value)), is_count_star_(is_count_star),
+        where_table_(std::move(where_table)), join_(std::move(join)),
+        order_by_(std::move(order_by)) {}
   ~SelectStatement() override = default;
 
   StatementType Type() const override { return StatementType::SELECT; }
@@ -57,23 +107,59 @@ public:
   bool Has_where() const { return has_where_; }
   std::string Where_column() const { return where_column_; }
   const Value *Where_value() const { return where_value_.get(); }
+  bool Count_star() const { return is_count_star_; }
+  // WHERE t.col = ... 里的表名，没写表名时为空
+  std::string Where_table() const { return where_table_; }
+  const JoinClause *Join() const { return join_ ? &*join_ : nullptr; }
+  const std::vector<OrderByItem> &Order_by() const { return order_by_; }
+  // 不是 SELECT * 时的列表，只有 COUNT(*) 一项且没有 GROUP BY 时为空，
+  // 由 Count_star 表示
+  const std::vector<SelectItem> &Select_list() const { return select_list_; }
+  void Set_select_list(std::vector<SelectItem> items) {
+    select_list_ = std::move(items);
+  }
+  const std::vector<ColumnRef> &Group_by() const { return group_by_; }
+  void Set_group_by(std::vector<ColumnRef> columns) {
+    group_by_ = std::move(columns);
+  }
+  // LIMIT n [OFFSET m]，没有 LIMIT 时 Has_limit 为 false
+  bool Has_limit() const { return has_limit_; }
+  size_t Limit() const { return limit_; }
+  size_t Offset() const { return offset_; }
+  void Set_limit(size_t limit, size_t offset) {
+    has_limit_ = true;
+    limit_ = limit;
+    offset_ = offset;
+  }
 
 private:
   std::string table_name_;
-  // TODO: support * in v1
-  // std::vector<std::string> columns_;
   bool is_select_all_;
 
   bool has_where_{false};
   std::string where_column_;
   std::unique_ptr<Value> where_value_;
+
+  // SELECT COUNT(*) ...
+  bool is_count_star_{false};
+
+  std::string where_table_;
+  std::optional<JoinClause> join_;
+  std::vector<OrderByItem> order_by_;
+  std::vector<SelectItem> select_list_;
+  std::vector<ColumnRef> group_by_;
+  bool has_limit_{false};
+  size_t limit_{0};
+  size_t offset_{0};
 };
 
 class CreateTableStatement : public Statement {
 public:
   CreateTableStatement(std::string table_name,
-                       std::vector<std::pair<std::string, ColumnType>> columns)
-      : table_name_(std::move(table_name)), columns_(std::move(columns)) {}
+                       std::vector<std::pair<std::string, ColumnType>> columns,
+                       std::vector<std::string> primary_key = {})
+      : table_name_(std::move(table_name)), columns_(std::move(columns)),
+        primary_key_(std::move(primary_key)) {}
   ~CreateTableStatement() override = default;
 
   StatementType Type() const override { return StatementType::CREATE_TABLE; }
@@ -81,29 +167,119 @@ public:
   const std::vector<std::pair<std::string, ColumnType>> &Columns() const {
     return columns_;
   }
+  const std::vector<std::string> &Primary_key() const { return primary_key_; }
 
 private:
   std::string table_name_;
   std::vector<std::pair<std::string, ColumnType>> columns_;
+  // 主键列名，为空表示没有主键
+  std::vector<std::string> primary_key_;
 };
 
 class CreateIndexStatement : public Statement {
 public:
   CreateIndexStatement(std::string index_name, std::string table_name,
-                       std::vector<std::string> column_names)
+                       std::vector<std::string> column_names,
+                       bool is_unique = false, std::string index_method = "")
       : index_name_(std::move(index_name)), table_name_(std::move(table_name)),
-        column_names_(std::move(column_names)) {}
+        column_names_(std::move(column_names)), is_unique_(is_unique),
+        index_method_(std::move(index_method)) {}
   ~CreateIndexStatement() override = default;
 
   StatementType Type() const override { return StatementType::CREATE_INDEX; }
   std::string Index_name() const { return index_name_; }
   std::string Table_name() const { return table_name_; }
   const std::vector<std::string> &Column_names() const { return column_names_; }
+  bool Is_unique() const { return is_unique_; }
+  std::string Index_method() const { return index_method_; }
 
 private:
   std::string index_name_;
   std::string table_name_;
   std::vector<std::string> column_names_;
+  bool is_unique_;
+  // USING 后面的索引方法名，为空表示默认的 B+Tree
+  std::string index_method_;
+};
+
+// BEGIN; / COMMIT; / ROLLBACK;
+class TransactionStatement : public Statement {
+public:
+  explicit TransactionStatement(TransactionCommand command)
+      : command_(command) {}
+  ~TransactionStatement() override = default;
+
+  StatementType Type() const override { return StatementType::TRANSACTION; }
+  TransactionCommand Command() const { return command_; }
+
+private:
+  TransactionCommand command_;
+};
+
+// ANALYZE t;
+class AnalyzeStatement : public Statement {
+public:
+  explicit AnalyzeStatement(std::string table_name)
+      : table_name_(std::move(table_name)) {}
+  ~AnalyzeStatement() override = default;
+
+  StatementType Type() const override { return StatementType::ANALYZE; }
+  std::string Table_name() const { return table_name_; }
+
+private:
+  std::string table_name_;
+};
+
+// EXPLAIN [ANALYZE] SELECT ...;
+class ExplainStatement : public Statement {
+public:
+  ExplainStatement(std::unique_ptr<SelectStatement> select, bool analyze)
+      : select_(std::move(select)), analyze_(analyze) {}
+  ~ExplainStatement() override = default;
+
+  StatementType Type() const override { return StatementType::EXPLAIN; }
+  const SelectStatement &Select() const { return *select_; }
+  bool IsAnalyze() const { return analyze_; }
+
+private:
+  std::unique_ptr<SelectStatement> select_;
+  bool analyze_;
+};
+
+// PREPARE name AS SELECT ... / INSERT ...;  sql 是 AS 后面的语句原文，
+// 里面可以有 ? 参数
+class PrepareStatement : public Statement {
+public:
+  PrepareStatement(std::string name, std::string sql)
+      : name_(std::move(name)), sql_(std::move(sql)) {}
+  ~PrepareStatement() override = default;
+
+  StatementType Type() const override { return StatementType::PREPARE; }
+  const std::string &Name() const { return name_; }
+  const std::string &Sql() const { return sql_; }
+
+private:
+  std::string name_;
+  std::string sql_;
+};
+
+// EXECUTE name [(value, ...)];
+class ExecuteStatement : public Statement {
+public:
+  ExecuteStatement(std::string name,
+                   std::vector<std::unique_ptr<Value>> parameters)
+      : name_(std::move(name)), parameters_(std::move(parameters)) {}
+  ~ExecuteStatement() override = default;
+
+  StatementType Type() const override { return StatementType::EXECUTE; }
+  const std::string &Name() const { return name_; }
+  const std::vector<std::unique_ptr<Value>> &Parameters() const {
+    return parameters_;
+  }
+
+private:
+  std::string name_;
+  std::vector<std::unique_ptr<Value>> parameters_;
 };
 
 } // namespace mini
@@ -0,0 +1,62 @@
+#pragma once
+#include "binder/bound_statement.h"
+#include "binder/value.h"
+#include "catalog/catalog.h"
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace mini {
+
+// 缓存里的一条预编译语句：绑定好的模板，? 处是 ParameterValue
+struct CachedStatement {
+  std::unique_ptr<BoundStatement> bound;
+  size_t parameter_count{0};
+  // 绑定时 catalog 的版本，不一样了说明模板里的表和索引可能已经失效
+  uint64_t catalog_version{0};
+
+  // 复制一份模板，把参数换成 parameters 里的值，类型不对时抛异常
+  std::unique_ptr<BoundStatement>
+  Instantiate(const std::vector<std::unique_ptr<Value>> &parameters) const;
+};
+
+// 预编译语句的缓存，键是规范化的 SQL 文本，同样的语句只解析、绑定一次。
+// catalog 变了（建表、建索引、删索引）之后再取时按原文重新解析、绑定。
+// 最多留 CAPACITY 条，满了换出最久没用的。计划和参数的值有关（走不走
+// 索引），每次 EXECUTE 时再建
+class PlanCache {
+public:
+  static constexpr size_t CAPACITY = 128;
+
+  explicit PlanCache(Catalog &catalog) : catalog_(catalog) {}
+
+  // 按 token 重新拼一遍：token 之间只留一个空格，字符串加回引号
+  static std::string Normalize(const std::string &sql);
+
+  // 取规范化的 sql 的模板，没有或者过时了就解析、绑定，出错时抛异常
+  std::shared_ptr<const CachedStatement> Get(const std::string &sql);
+
+  size_t Size() const;
+  size_t GetHitCount() const { return hit_count_; }
+  size_t GetMissCount() const { return miss_count_; }
+
+private:
+  std::shared_ptr<const CachedStatement> Bind(const std::string &sql);
+
+  Catalog &catalog_;
+  mutable std::mutex latch_;
+  // 最近用过的在前面
+  std::list<std::pair<std::string, std::shared_ptr<const CachedStatement>>>
+      lru_;
+  std::unordered_map<std::string, decltype(lru_)::iterator> entries_;
+  size_t hit_count_{0};
+  size_t miss_count_{0};
+};
+
+} // namespace mini
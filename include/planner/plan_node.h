@@ -0,0 +1,74 @@
+#pragma once
+#include "catalog/catalog.h"
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace mini {
+
+enum class PlanType {
+  SEQ_SCAN,
+  INDEX_SCAN,
+  INDEX_ONLY_SCAN,
+  HASH_JOIN,
+  INDEX_NESTED_LOOP_JOIN,
+  SORT_MERGE_JOIN,
+  COUNT,
+  HASH_AGGREGATE,
+  SORT,
+  TOP_N,
+  PROJECTION,
+  LIMIT,
+};
+
+// EXPLAIN ANALYZE 时记下的实际执行情况。时间和缓冲池的计数都包含
+// 下面的节点，loops 是 Init 的次数，索引嵌套循环连接的内表是查索引的次数
+struct PlanActual {
+  size_t loops{0};
+  size_t rows{0};
+  double ms{0};
+  size_t hits{0};
+  size_t misses{0};
+};
+
+// 物理计划树的一个节点：用哪个算子，估计输出多少行，到这个节点为止
+// 一共要花多少代价。连接的 children[0] 是 FROM 左边的表，[1] 是右边的，
+// 其余节点只有一个输入
+struct PlanNode {
+  explicit PlanNode(PlanType type) : type(type) {}
+
+  bool IsScan() const {
+    return type == PlanType::SEQ_SCAN || type == PlanType::INDEX_SCAN ||
+           type == PlanType::INDEX_ONLY_SCAN;
+  }
+  bool IsJoin() const {
+    return type == PlanType::HASH_JOIN ||
+           type == PlanType::INDEX_NESTED_LOOP_JOIN ||
+           type == PlanType::SORT_MERGE_JOIN;
+  }
+  const PlanNode *Child(size_t i = 0) const { return children[i].get(); }
+  PlanNode *Child(size_t i = 0) { return children[i].get(); }
+
+  // 一行描述，例如 "Index Scan on t using idx_id (rows=3 cost=16.03)"，
+  // analyze 时接上实际的执行情况
+  std::string Describe(bool analyze = false) const;
+  // 整棵树，每个节点一行，子节点多缩进两格
+  std::string ToString(bool analyze = false) const;
+
+  PlanType type;
+  double rows{0};
+  double cost{0};
+  std::vector<std::unique_ptr<PlanNode>> children;
+  // 扫描读的表和用的索引，索引嵌套循环连接时是内表和它的索引
+  TableInfo *table{nullptr};
+  IndexInfo *index{nullptr};
+  // 哈希连接在左边建表，索引嵌套循环连接左边是外表
+  bool left_first{false};
+  // TOP_N 留的行数；LIMIT 的行数和跳过的行数
+  size_t limit{0};
+  size_t offset{0};
+  PlanActual actual;
+};
+
+} // namespace mini
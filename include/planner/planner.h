@@ -0,0 +1,59 @@
+#pragma once
+#include "binder/bound_statement.h"
+#include "execution/execution_context.h"
+#include "execution/executor.h"
+#include "planner/plan_node.h"
+#include <memory>
+
+namespace mini {
+
+// 绑定之后、执行之前为 SELECT 建物理计划树。按表的统计信息估计每个节点
+// 输出的行数，在顺序扫描和索引扫描、连接的两种顺序和三种连接算法之间
+// 选代价最小的。代价以顺序读一页为单位
+class Planner {
+public:
+  static constexpr double SEQ_PAGE_COST = 1.0;
+  // 随机读一页，索引下降和回表时用
+  static constexpr double RANDOM_PAGE_COST = 4.0;
+  // 处理一行和做一次比较或哈希
+  static constexpr double CPU_TUPLE_COST = 0.01;
+  static constexpr double CPU_OPERATOR_COST = 0.0025;
+  // 不知道一列有多少个不同的值时，最多按这么多估计
+  static constexpr double DEFAULT_DISTINCT = 200;
+
+  explicit Planner(ExecutionContext &context) : context_(context) {}
+
+  std::unique_ptr<PlanNode> PlanSelect(const BoundSelectStatement &stmt);
+  // 为绑定好的语句建执行器，SELECT 按计划树组装
+  std::unique_ptr<Executor>
+  CreateExecutor(std::unique_ptr<BoundStatement> stmt);
+
+private:
+  // 单表扫描，有 WHERE 且有索引时比较走不走索引
+  std::unique_ptr<PlanNode> PlanScan(const BoundSelectStatement &stmt);
+  // 两边各自的扫描之上，枚举哈希连接（两边建表）、索引嵌套循环连接
+  // （两边做外表）和排序归并连接。sorted_output 为真时排序归并连接的
+  // 输出已经满足 ORDER BY，省下的排序算在它头上
+  std::unique_ptr<PlanNode> PlanJoin(const BoundSelectStatement &stmt,
+                                     bool sorted_output);
+
+  // ORDER BY 只有一个升序的连接列，排序归并连接的输出已经按它排好
+  static bool OrderedByJoinColumn(const BoundSelectStatement &stmt);
+
+  double TableRows(const TableInfo *table) const;
+  double TablePages(const TableInfo *table) const;
+  // 表里 column 这一列估计有多少个不同的值
+  double Distinct(const TableInfo *table, uint32_t column);
+  // WHERE column = value 的选择率，有直方图时能看出频繁的值
+  double Selectivity(const TableInfo *table, uint32_t column,
+                     const Value &value);
+  // 扫描出来的行里第 column 列在原表里的不同值个数
+  double ColumnDistinct(const BoundSelectStatement &stmt, uint32_t column);
+  // rows 行、每行 width 字节排序的代价，放不下工作内存时加上写出再读回
+  double SortCost(double rows, double width) const;
+  double Pages(double rows, double width) const;
+
+  ExecutionContext &context_;
+};
+
+} // namespace mini
@@ -0,0 +1,73 @@
+#pragma once
+#include "recovery/log_manager.h"
+#include "recovery/log_record.h"
+#include "storage/buffer_pool.h"
+#include "storage/disk_manager.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+
+namespace mini {
+
+// 模糊检查点：写 CHECKPOINT_BEGIN，拷贝活跃事务表和缓冲池的脏页表，
+// 写 CHECKPOINT_END 并落盘，fsync 数据文件，最后把 BEGIN 的 LSN 写进
+// master 记录。
+// 拷贝期间前台照常执行，不等事务结束，也不把脏页全部写回；
+// 恢复时分析从 BEGIN 开始，重做从脏页表里最早的 recLSN 开始。
+// 上一个检查点之前就脏了的页在这次检查点时写回，所以重做的起点
+// 最多落后一个检查点间隔。
+class CheckpointManager {
+public:
+  static constexpr std::chrono::milliseconds DEFAULT_INTERVAL{30000};
+  static constexpr size_t DEFAULT_LOG_SIZE = 16 << 20;
+  // 恢复速度的估计值，来自 LogRecoveryTest.DISABLED_RecoveryTimeBenchmark
+  static constexpr double DEFAULT_RECOVERY_MS_PER_MB = 15.0;
+
+  // 距上次检查点超过 interval，或者日志增长超过 log_size 字节时，
+  // 后台线程做一次检查点；两者为 0 时表示不按这个条件触发
+  CheckpointManager(DiskManager *disk, BufferPool *buffer_pool,
+                    LogManager *log_manager,
+                    std::chrono::milliseconds interval = DEFAULT_INTERVAL,
+                    size_t log_size = DEFAULT_LOG_SIZE);
+  ~CheckpointManager();
+
+  CheckpointManager(const CheckpointManager &) = delete;
+  CheckpointManager &operator=(const CheckpointManager &) = delete;
+
+  // 立即做一次检查点，返回 CHECKPOINT_BEGIN 的 LSN
+  lsn_t Checkpoint();
+
+  lsn_t GetLastCheckpointLSN() const;
+  size_t GetCheckpointCount() const;
+  // 现在崩溃的话恢复要读的日志字节数：从上个检查点和最早的 recLSN
+  // 里较早的一个到日志末尾
+  size_t GetRecoveryLogSize() const;
+  // 按 DEFAULT_RECOVERY_MS_PER_MB 估计的恢复时间
+  double EstimateRecoveryMillis() const;
+
+private:
+  static constexpr std::chrono::milliseconds POLL_INTERVAL{10};
+
+  void CheckpointThread();
+
+  DiskManager *disk_;
+  BufferPool *buffer_pool_;
+  LogManager *log_manager_;
+  std::chrono::milliseconds interval_;
+  size_t log_size_;
+
+  mutable std::mutex latch_;     // 保护下面的状态
+  std::mutex checkpoint_latch_;  // 同一时刻只做一个检查点
+  std::condition_variable cv_;
+  lsn_t last_checkpoint_lsn_;
+  lsn_t last_checkpoint_end_; // 上次检查点 END 记录之后的日志末尾
+  std::chrono::steady_clock::time_point last_checkpoint_time_;
+  size_t checkpoint_count_{0};
+
+  bool running_{true};
+  std::thread checkpoint_thread_;
+};
+
+} // namespace mini
@@ -0,0 +1,96 @@
+#pragma once
+#include "recovery/log_record.h"
+#include "storage/disk_manager.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace mini {
+
+// 追加过的日志记录的统计
+struct LogStats {
+  size_t records{0};
+  size_t bytes{0};              // 实际写进日志的字节数
+  size_t uncompressed_bytes{0}; // 不压缩时的字节数
+};
+
+// 预写日志：记录先追加到内存缓冲区，由后台线程批量写入日志文件
+// 两块缓冲区轮换，落盘期间新的记录写进另一块，
+// 所以同一时间等待提交的事务会被下一次 fsync 一起带走（group commit）
+class LogManager {
+public:
+  static constexpr size_t DEFAULT_BUFFER_SIZE = 64 * 1024;
+  static constexpr std::chrono::milliseconds FLUSH_INTERVAL{10};
+
+  explicit LogManager(DiskManager *disk,
+                      size_t buffer_size = DEFAULT_BUFFER_SIZE);
+  // 停止后台线程，并把缓冲区里剩下的日志落盘
+  ~LogManager();
+
+  LogManager(const LogManager &) = delete;
+  LogManager &operator=(const LogManager &) = delete;
+
+  // 分配 LSN 并把记录写进缓冲区，返回记录的 LSN
+  // 缓冲区满时等待后台线程腾出空间，比整个缓冲区还大的记录直接写盘
+  lsn_t AppendLogRecord(LogRecord *record);
+  // 阻塞到 lsn 这条记录已经落盘，lsn 还没分配出去时直接返回
+  void Flush(lsn_t lsn);
+  // 阻塞到目前为止追加的所有记录都已落盘
+  void FlushAll();
+
+  // 打开后 INDEX_SMO / INSERT_TUPLES 这类大记录的内容压缩后再写，
+  // 只影响之后追加的记录，读日志时两种都认
+  void SetCompression(bool enable) { compression_ = enable; }
+
+  // 恢复发现日志尾部有写了一半的记录时，从 lsn 处截断，之后从这里追加
+  // 只能在还没有追加任何记录时调用
+  void TruncateTo(lsn_t lsn);
+
+  // 下一条记录的 LSN，也就是日志的逻辑末尾，不加锁
+  lsn_t GetNextLSN() const { return next_lsn_.load(); }
+  // 已落盘日志的末尾，LSN 小于它的记录都已持久化
+  lsn_t GetFlushedLSN() const;
+  // 落盘（fsync）次数，和提交数一比就是 group commit 的效果
+  size_t GetFlushCount() const;
+  LogStats GetStats() const;
+  // 还没有 COMMIT / ABORT 的事务和它们的最后一条日志，检查点用
+  std::vector<std::pair<txn_id_t, lsn_t>> GetActiveTxns() const;
+  // 比日志里出现过的事务号都大，检查点记下来，重启后事务号从这里继续
+  txn_id_t GetNextTxnId() const;
+  // 恢复时告诉日志之前已经用到了哪个事务号
+  void AdvanceNextTxnId(txn_id_t next_txn_id);
+
+private:
+  void FlushThread();
+
+  DiskManager *disk_;
+  size_t buffer_size_;
+
+  mutable std::mutex latch_;
+  std::condition_variable flush_cv_; // 唤醒后台线程
+  std::condition_variable done_cv_;  // 一次落盘完成，唤醒等待者
+
+  std::vector<char> log_buffer_;   // 正在追加的缓冲区
+  std::vector<char> flush_buffer_; // 正在写盘的缓冲区
+  size_t log_buffer_offset_{0};
+
+  std::atomic<lsn_t> next_lsn_;
+  lsn_t flushed_lsn_;
+  std::unordered_map<txn_id_t, lsn_t> active_txns_;
+  txn_id_t next_txn_id_{0};
+  bool flush_requested_{false};
+  size_t flush_count_{0};
+  std::atomic<bool> compression_{false};
+  LogStats stats_;
+
+  bool running_{true};
+  std::thread flush_thread_;
+};
+
+} // namespace mini
@@ -0,0 +1,150 @@
+#pragma once
+#include "common/page.h"
+#include "common/rid.h"
+#include "storage/tuple.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace mini {
+
+using txn_id_t = int32_t;
+constexpr txn_id_t INVALID_TXN_ID = -1;
+
+enum class LogRecordType : int32_t {
+  INVALID = 0,
+  BEGIN,
+  COMMIT,
+  ABORT,
+  INSERT_TUPLE,   // rid + tuple，插入的版本 xmin 为记录的事务
+  // 第一个 rid + 若干 tuple，同一页上连续槽位的一批插入，一页一条
+  INSERT_TUPLES,
+  MARK_DELETE,    // rid + tuple，把版本的 xmax 设为记录的事务
+  NEW_TABLE_PAGE, // 上一页 + 新页，表的页链表变长
+  INDEX_INSERT,   // 索引头页 + 叶子页 + rid + key
+  INDEX_DELETE,
+  // undo_next_lsn + 若干 (页号, 整页后像)，索引分裂、换根这类结构修改。
+  // 一条记录要么完整要么不存在；只重做不撤销，撤销时像 CLR 一样跳到
+  // undo_next_lsn（嵌套顶层动作）
+  INDEX_SMO,
+  ROLLBACK_DELETE, // rid + tuple，撤销 MARK_DELETE 时清掉 xmax
+  APPLY_DELETE,    // rid + tuple，物理删除，撤销 INSERT_TUPLE 时用
+  CLR, // undo_next_lsn，前面的补偿操作已经撤销了一条记录，下一条从这里撤销
+  CHECKPOINT_BEGIN,
+  CHECKPOINT_END, // 活跃事务表 + 脏页表 + 下一个事务号，
+                  // 内容取自 BEGIN 之后的某个时刻
+  HASH_INSERT,    // 哈希表头页 + 桶页 + rid + key，结构修改也用 INDEX_SMO
+  HASH_DELETE,
+};
+
+// 所有记录共有的头部，记录按 头部 + 各类型自己的内容 连续写入日志
+struct LogRecordHeader {
+  uint32_t size; // 整条记录的字节数，包括头部
+  lsn_t lsn;
+  txn_id_t txn_id;
+  lsn_t prev_lsn; // 同一事务的上一条记录
+  LogRecordType type;
+};
+
+class LogRecord {
+public:
+  LogRecord() = default;
+  // BEGIN / COMMIT / ABORT
+  LogRecord(txn_id_t txn_id, lsn_t prev_lsn, LogRecordType type);
+  // INSERT_TUPLE / MARK_DELETE / ROLLBACK_DELETE / APPLY_DELETE
+  LogRecord(txn_id_t txn_id, lsn_t prev_lsn, LogRecordType type,
+            const RID &rid, const Tuple &tuple);
+  // NEW_TABLE_PAGE
+  LogRecord(txn_id_t txn_id, lsn_t prev_lsn, page_id_t prev_page_id,
+            page_id_t page_id);
+  // INDEX_INSERT / INDEX_DELETE / HASH_INSERT / HASH_DELETE，
+  // key 按字节保存，由索引自己解释
+  LogRecord(txn_id_t txn_id, lsn_t prev_lsn, LogRecordType type,
+            page_id_t index_id, page_id_t page_id, const RID &rid,
+            const char *key, uint32_t key_size);
+  // INSERT_TUPLES，tuples 依次落在 first_rid 开始的连续槽位上
+  LogRecord(txn_id_t txn_id, lsn_t prev_lsn, const RID &first_rid,
+            const Tuple *tuples, size_t count);
+  // INDEX_SMO，每页一个 (页号, 页内容)
+  LogRecord(txn_id_t txn_id, lsn_t prev_lsn, lsn_t undo_next_lsn,
+            const std::vector<std::pair<page_id_t, const char *>> &pages);
+  // CLR
+  LogRecord(txn_id_t txn_id, lsn_t prev_lsn, lsn_t undo_next_lsn);
+  // CHECKPOINT_END，不属于任何事务
+  LogRecord(std::vector<std::pair<txn_id_t, lsn_t>> active_txns,
+            std::vector<std::pair<page_id_t, lsn_t>> dirty_pages,
+            txn_id_t next_txn_id);
+
+  uint32_t GetSize() const { return header_.size; }
+  lsn_t GetLSN() const { return header_.lsn; }
+  void SetLSN(lsn_t lsn) { header_.lsn = lsn; }
+  txn_id_t GetTxnId() const { return header_.txn_id; }
+  lsn_t GetPrevLSN() const { return header_.prev_lsn; }
+  LogRecordType GetType() const { return header_.type; }
+
+  const RID &GetRID() const { return rid_; }
+  const Tuple &GetTuple() const { return tuple_; }
+  // INSERT_TUPLES 的各个 tuple，第 i 个在 GetRID() 之后第 i 个槽位
+  const std::vector<Tuple> &GetTuples() const { return tuples_; }
+  page_id_t GetPageId() const { return page_id_; }
+  page_id_t GetPrevPageId() const { return prev_page_id_; }
+  page_id_t GetIndexId() const { return index_id_; }
+  lsn_t GetUndoNextLSN() const { return undo_next_lsn_; }
+  // INDEX_SMO 修改的页，第 i 页的后像是 GetPageImage(i)
+  const std::vector<page_id_t> &GetPageIds() const { return page_ids_; }
+  const char *GetPageImage(size_t i) const {
+    return payload_.data() + i * PAGE_SIZE;
+  }
+  // CHECKPOINT_END：事务号 -> 最后一条日志，页号 -> recLSN
+  const std::vector<std::pair<txn_id_t, lsn_t>> &GetActiveTxns() const {
+    return active_txns_;
+  }
+  const std::vector<std::pair<page_id_t, lsn_t>> &GetDirtyPages() const {
+    return dirty_pages_;
+  }
+  // CHECKPOINT_END：不小于日志里出现过的所有事务号
+  txn_id_t GetNextTxnId() const { return next_txn_id_; }
+  // INDEX_INSERT / INDEX_DELETE / HASH_* 的 key 字节，或 INDEX_SMO 的各页内容，
+  // 或 INSERT_TUPLES 的各个 (长度, tuple)，总是解压之后的
+  const std::vector<char> &GetPayload() const { return payload_; }
+
+  // INDEX_SMO / INSERT_TUPLES 的内容按块压缩后写进日志，压不小时保持原样。
+  // 要在追加之前调用，记录的大小随之变化
+  void CompressPayload();
+  // 内容不压缩时这条记录的字节数
+  uint32_t GetUncompressedSize() const {
+    return compressed_size_ == 0 ? header_.size
+                                 : header_.size - compressed_size_ +
+                                       static_cast<uint32_t>(payload_.size());
+  }
+
+  void SerializeTo(char *buf) const;
+  // 从 buf 解析一条记录，剩余字节不够一条完整记录时返回 false
+  bool DeserializeFrom(const char *buf, size_t len);
+
+  std::string ToString() const; // for debug
+
+private:
+  LogRecordHeader header_{0, INVALID_LSN, INVALID_TXN_ID, INVALID_LSN,
+                          LogRecordType::INVALID};
+
+  RID rid_{};
+  Tuple tuple_;
+  page_id_t page_id_{-1};
+  page_id_t prev_page_id_{-1};
+  page_id_t index_id_{-1};
+  lsn_t undo_next_lsn_{INVALID_LSN};
+  std::vector<Tuple> tuples_;
+  std::vector<char> payload_;
+  // 压缩后的内容，为 0 表示日志里是原样的 payload_
+  uint32_t compressed_size_{0};
+  std::vector<char> compressed_;
+  std::vector<page_id_t> page_ids_;
+  std::vector<std::pair<txn_id_t, lsn_t>> active_txns_;
+  std::vector<std::pair<page_id_t, lsn_t>> dirty_pages_;
+  txn_id_t next_txn_id_{0};
+};
+
+} // namespace mini
@@ -0,0 +1,88 @@
+#pragma once
+#include "common/comparator.h"
+#include "common/page.h"
+#include "common/rid.h"
+#include "concurrency/transaction.h"
+#include "index/bplus_tree.h"
+#include "index/extendible_hash_table.h"
+#include "recovery/log_manager.h"
+#include "recovery/log_record.h"
+#include "storage/buffer_pool.h"
+#include "storage/disk_manager.h"
+#include <cstddef>
+#include <memory>
+#include <unordered_map>
+
+namespace mini {
+
+// 启动时的崩溃恢复，按 ARIES 分三遍处理日志：
+// 分析：从最近的检查点（没有时从头）扫到日志末尾，
+//       找出没有结束的事务（失败者）和可能没写回的脏页
+// 重做：从脏页里最早的 recLSN 开始重放所有修改，包括失败者的，
+//       page LSN 不小于记录 LSN 的页已经包含这条修改，跳过。
+//       每条修改只涉及一页，按页号分给多个线程，同一页的修改
+//       落在同一个线程上，保持日志顺序
+// 撤销：按 LSN 从大到小撤销失败者的修改，每撤销一条先写补偿操作再写 CLR，
+//       恢复中途再次崩溃时，下一次恢复沿 CLR 跳过已经撤销的部分。
+//       索引的结构修改只重做不撤销，失败者的 key 按逻辑从索引里删掉
+// 必须在任何新事务开始之前运行，结束后缓冲池里就是恢复好的页
+class LogRecovery {
+public:
+  // redo_threads 为 0 时按 CPU 核数，不超过缓冲池的帧数
+  LogRecovery(DiskManager *disk, BufferPool *buffer_pool,
+              LogManager *log_manager, size_t redo_threads = 0);
+
+  void Recover();
+
+  // 有效日志的末尾，之后写了一半的记录已经被截掉
+  lsn_t GetLogEnd() const { return log_end_; }
+  // 分析和重做开始的位置，两者之后的日志才需要读
+  lsn_t GetAnalysisStart() const { return analysis_start_; }
+  lsn_t GetRedoStart() const { return redo_start_; }
+  size_t GetRedoCount() const { return redo_count_; }
+  size_t GetUndoCount() const { return undo_count_; }
+  size_t GetLoserCount() const { return loser_count_; }
+  size_t GetRedoThreads() const { return redo_threads_; }
+
+private:
+  using Tree = BPlusTree<int32_t, RID, IntComparator>;
+  using HashTable = ExtendibleHashTable<int32_t, RID, IntComparator>;
+
+  void Analyze();
+  void Redo();
+  void Undo();
+
+  // 按 LSN 随机读一条记录，撤销时用
+  bool ReadRecord(lsn_t lsn, LogRecord *record);
+
+  // page 在脏页表里且 page LSN 小于 lsn 时才需要重做
+  bool NeedsRedo(page_id_t page_id, lsn_t lsn) const;
+  // 把记录对 page_id 的修改重放到页上，页已经包含这条修改时返回 false
+  // 不同页可以在不同线程里同时重放
+  bool RedoPage(const LogRecord &record, page_id_t page_id);
+  // 写补偿操作的日志并修改页面，没有需要撤销的内容时返回 false
+  bool UndoRecord(const LogRecord &record, Transaction *txn);
+  void CompensateTuple(const RID &rid, const Tuple &tuple, LogRecordType type,
+                       Transaction *txn);
+  Tree *GetTree(page_id_t header_page_id);
+  HashTable *GetHashTable(page_id_t header_page_id);
+
+  DiskManager *disk_;
+  BufferPool *buffer_pool_;
+  LogManager *log_manager_;
+  size_t redo_threads_;
+
+  lsn_t log_end_{0};
+  lsn_t analysis_start_{0};
+  lsn_t redo_start_{0};
+  std::unordered_map<txn_id_t, lsn_t> active_txns_; // 事务号 -> 最后一条日志
+  std::unordered_map<page_id_t, lsn_t> dirty_pages_; // 页号 -> recLSN
+  std::unordered_map<page_id_t, std::unique_ptr<Tree>> trees_; // 按头页号
+  std::unordered_map<page_id_t, std::unique_ptr<HashTable>> hash_tables_;
+
+  size_t redo_count_{0};
+  size_t undo_count_{0};
+  size_t loser_count_{0};
+};
+
+} // namespace mini
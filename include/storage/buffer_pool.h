@@ -4,32 +4,60 @@
 #include "storage/disk_manager.h"
 #include <cstddef>
 #include <deque>
+#include <mutex>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace mini {
 
 using frame_id_t = int32_t;
 
+class LogManager;
+
 class BufferPool {
 public:
-  explicit BufferPool(std::size_t pool_size, DiskManager *disk);
+  // log_manager 不为空时，脏页写回前先把日志刷到它的 page LSN（WAL）
+  explicit BufferPool(std::size_t pool_size, DiskManager *disk,
+                      LogManager *log_manager = nullptr);
   ~BufferPool();
 
   Page *FetchPage(page_id_t pid);
   Page *NewPage(page_id_t *pid);
   bool UnpinPage(page_id_t pid, bool is_dirty);
+  // 丢掉一页（不写回）并回收页号，只用于不写日志的临时页和没建成的
+  // 表和索引的页。页还被 pin 着时返回 false
+  bool DeletePage(page_id_t pid);
+  // 写回并 fsync 数据文件；淘汰时的写回不 fsync，持久性由日志保证
   bool FlushPage(page_id_t pid);
   void FlushAllPages();
+  // 写回 recLSN 早于 lsn 且没有被 pin 的脏页，检查点用来推进重做的起点
+  void FlushPagesBefore(lsn_t lsn);
+  // 先写日志再改页时用：页可能在日志写好之后才读进来，这时记下的
+  // recLSN 比那条日志还晚，要提前到 lsn。页必须被 pin 着
+  void LowerRecLSN(page_id_t pid, lsn_t lsn);
+
+  // 脏页表：页号 -> recLSN，只包含有日志可以重做的页
+  // 检查点在后台线程里调用，只在拷贝元数据时持有 latch
+  std::vector<std::pair<page_id_t, lsn_t>> GetDirtyPages();
 
   PageGuard FetchPageGuarded(page_id_t pid);
   PageGuard NewPageGuarded(page_id_t *pid);
 
+  // FetchPage 被调用的次数（NewPage 也会走 FetchPage），用于统计访问路径的开销
+  std::size_t GetFetchCount() const { return fetch_count_; }
+  // 其中不在池里、要从磁盘读的次数，其余的都命中
+  std::size_t GetMissCount() const { return miss_count_; }
+  std::size_t GetPoolSize() const { return pool_size_; }
+
 private:
   struct FrameMeta {
     page_id_t page_id = -1;
     int pin_count = 0;
     bool is_dirty = false;
+    // 这页自上次写回以来第一条修改日志的 LSN 下界，干净的页被 pin 时记下
+    // 当时的日志末尾，之后的修改 LSN 都不会更小
+    lsn_t rec_lsn = INVALID_LSN;
   };
 
   std::vector<Page> pages_;     // 所有的槽位
@@ -40,11 +68,20 @@ private:
   std::deque<int> free_list_; // 空闲页的下标链表
 
   DiskManager *disk_; // 用于写内存和写文件
+  LogManager *log_manager_;
 
   int hand_; // 为实现基本替换策略，用循环枚举的方式，hand_为寻找的起点
   std::size_t pool_size_;
+  std::size_t fetch_count_{0};
+  std::size_t miss_count_{0};
+
+  // 保护 page_table_ 和 meta_，页内容由 pin 保护
+  std::mutex latch_;
 
+  Page *FetchPageLocked(page_id_t pid);
   int FindVictimFrame();
+  // 把一个脏帧写回磁盘，写之前保证日志已经落盘到它的 page LSN
+  void WriteBack(frame_id_t fid);
 };
 
 } // namespace mini
@@ -1,6 +1,8 @@
 #pragma once
 #include "common/page.h"
+#include <cstddef>
 #include <string>
+#include <vector>
 
 namespace mini {
 
@@ -9,16 +11,45 @@ public:
   explicit DiskManager(const std::string &file_path);
   ~DiskManager();
 
+  // 只写进操作系统缓存，需要持久化时调用 Sync
   void WritePage(page_id_t page_id, const Page &page);
   void ReadPage(page_id_t page_id, Page &page);
+  void Sync();
   page_id_t AllocatePage();
-  // TODO: 实现这个函数，回收页号
-  void DeallocatePage(page_id_t page_id) = delete;
+  // 恢复时日志里出现过的页号可能还没写进数据文件，保证它们不会被再次分配
+  void ReservePage(page_id_t page_id);
+  // 回收页号，之后 AllocatePage 优先复用。回收只记在内存里，只用于
+  // 不写日志的临时页、没建成的表和索引的页、没取到帧的新页，重启后这些
+  // 页号就不再复用了
+  void DeallocatePage(page_id_t page_id);
+
+  // 日志文件和数据文件同名，扩展名为 .log，第一次用到时才打开
+  // 追加写入并 fsync，返回时这些日志已经持久化
+  void WriteLog(const char *data, size_t size);
+  // 从 offset 处读最多 size 字节，返回实际读到的字节数
+  size_t ReadLog(char *data, size_t size, size_t offset);
+  size_t GetLogSize();
+  // 截掉 size 之后的日志，恢复时丢弃写了一半的尾部记录
+  void TruncateLog(size_t size);
+  const std::string &GetLogPath() const { return log_path_; }
+
+  // 最近一次完成的检查点的 BEGIN 记录 LSN，存在同名的 .master 文件里
+  // 没有做过检查点时返回 INVALID_LSN
+  void WriteMasterRecord(lsn_t checkpoint_lsn);
+  lsn_t ReadMasterRecord();
+  const std::string &GetMasterPath() const { return master_path_; }
 
 private:
+  void OpenLog();
+
   std::string file_path_;
   int fd_{-1};
   page_id_t next_page_id_{0};
+  std::vector<page_id_t> free_pages_;
+
+  std::string log_path_;
+  int log_fd_{-1};
+  std::string master_path_;
 
   static long long OffsetOf(page_id_t page_id);
 };
@@ -0,0 +1,52 @@
+#pragma once
+#include "common/page.h"
+#include "storage/buffer_pool.h"
+#include "storage/tuple.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace mini {
+
+struct SpillPageHeader {
+  lsn_t lsn;     // 不写日志，始终是 INVALID_LSN
+  uint32_t size; // 页里已用的字节数，含页头
+};
+
+// 执行器内存不够时把 tuple 溢出到临时页上，之后按写入顺序读回来。
+// 临时页从缓冲池分配，不写日志，析构时还给缓冲池。写的时候先在内存里
+// 攒满一页再交给缓冲池，读的时候每次只 pin 一页
+class SpillFile {
+public:
+  explicit SpillFile(BufferPool *buffer_pool) : buffer_pool_(buffer_pool) {}
+  ~SpillFile();
+
+  SpillFile(const SpillFile &) = delete;
+  SpillFile &operator=(const SpillFile &) = delete;
+
+  // tuple 加上长度要放得进一页，放不下时抛异常
+  void Append(const Tuple &tuple);
+  // 写完了，从头开始读。之后不能再 Append
+  void Rewind();
+  bool Next(Tuple *out);
+
+  size_t GetTupleCount() const { return tuple_count_; }
+  size_t GetPageCount() const { return pages_.size(); }
+
+private:
+  // 把攒在内存里的一页写进缓冲池
+  void WritePage();
+
+  BufferPool *buffer_pool_;
+  std::vector<page_id_t> pages_;
+  size_t tuple_count_{0};
+
+  std::vector<char> write_buf_;
+  bool finished_{false};
+
+  std::vector<char> read_buf_;
+  size_t read_page_{0};
+  size_t read_offset_{0};
+};
+
+} // namespace mini
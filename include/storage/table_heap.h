@@ -1,35 +1,44 @@
 #pragma once
 #include "common/rid.h"
+#include "concurrency/snapshot.h"
+#include "concurrency/transaction.h"
+#include "recovery/log_manager.h"
 #include "storage/buffer_pool.h"
 #include "storage/tuple.h"
+#include <atomic>
 #include <cstdint>
 #include <cstring>
 #include <functional>
 #include <mutex>
 #include <stdexcept>
+#include <unordered_set>
+#include <vector>
 
 // v0 assumptions:
 // - single table
 // - page ids are contiguous starting from 0
 // - no page reuse
-// - no crash recovery
-// - single-threaded
 
 namespace mini {
 
 constexpr page_id_t INVALID_PAGE_ID = -1;
 
 struct TablePageHeader {
+  lsn_t lsn; // page LSN，必须在页首
   int32_t next_page_id;
   uint16_t num_slots;      // 0 means no rows
   uint16_t free_space_ptr; // PAGE_SIZE - free_space_ptr = free space left
 };
 
+// 每个槽是一个版本：xmin 插入，xmax 删除（INVALID_TXN_ID 表示还没删）。
+// is_deleted 是物理删除，回收旧版本或撤销插入后任何快照都看不到
 struct Slot {
   uint16_t offset;     // record bytes 的起始偏移（相对页首）
   uint16_t size;       // record 长度
-  uint8_t is_deleted;  // v1 先做逻辑删除
+  uint8_t is_deleted;  // 物理删除
   uint8_t reserved[3]; // 对齐
+  txn_id_t xmin;
+  txn_id_t xmax;
 };
 
 class TablePage {
@@ -52,13 +61,20 @@ public:
   void Init(); // 初始化 header
 
   bool InsertTuple(const char *tuple_data, uint16_t tuple_size,
-                   uint16_t *out_slot_id);
+                   uint16_t *out_slot_id, txn_id_t xmin = INVALID_TXN_ID);
 
+  // 物理删除的槽取不到，xmax 不影响
   bool GetTuple(uint16_t slot_id, const char **out_data,
                 uint16_t *out_size) const;
 
-  bool MarkDelete(uint16_t slot_id); // 逻辑删除
-  bool IsDeleted(uint16_t slot_id) const;
+  bool MarkDelete(uint16_t slot_id, txn_id_t xmax); // 逻辑删除，记下 xmax
+  bool RollbackDelete(uint16_t slot_id); // 清掉 xmax，撤销删除时用
+  bool ApplyDelete(uint16_t slot_id);    // 物理删除
+  bool IsDeleted(uint16_t slot_id) const; // 是否物理删除
+  // 版本的 xmin / xmax，槽不存在或已物理删除时返回 false
+  bool GetVersion(uint16_t slot_id, txn_id_t *xmin, txn_id_t *xmax) const;
+  // snapshot 为空时看最新版本
+  bool IsVisible(uint16_t slot_id, const Snapshot *snapshot) const;
 
   uint16_t GetFreeSpace() const;
   uint16_t GetSlotCount() const;
@@ -74,28 +90,92 @@ private:
 
 class TableIterator;
 
+// 多版本的表。带事务的插入写下 xmin，删除只写 xmax，旧版本留给
+// 还看得到它的快照，等 CollectGarbage 确认没有快照需要时再物理删除。
+// 不带快照的读取看最新版本：没有物理删除且 xmax 为空
 class TableHeap {
 public:
-  explicit TableHeap(BufferPool *buffer_pool);
-
-  RID InsertTuple(const Tuple &tuple);
-  bool GetTuple(const RID &rid, Tuple *out);
-  bool DeleteTuple(const RID &rid);
-  TableIterator Begin();
+  // log_manager 不为空时，带事务的修改会先写日志
+  explicit TableHeap(BufferPool *buffer_pool,
+                     LogManager *log_manager = nullptr);
+  // 打开已有的表，沿页链表找到最后一页
+  TableHeap(BufferPool *buffer_pool, page_id_t first_page_id,
+            LogManager *log_manager = nullptr);
+
+  RID InsertTuple(const Tuple &tuple, Transaction *txn = nullptr);
+  // 依次插入一批 tuple，同一页上的插入合成一条日志。undo_next 不为空时
+  // 按顺序给出每一行撤销后写的 CLR 该指向哪里：一页里的第一行指向这条日志
+  // 之前，其余的指向这条日志本身，恢复时会把整条日志再撤销一遍
+  std::vector<RID> InsertTuples(const std::vector<Tuple> &tuples,
+                                Transaction *txn = nullptr,
+                                std::vector<lsn_t> *undo_next = nullptr);
+  // snapshot 为空时取最新版本
+  bool GetTuple(const RID &rid, Tuple *out,
+                const Snapshot *snapshot = nullptr);
+  // 只把 columns 这些列按顺序紧挨着拷出来，不拷整行
+  bool GetTuple(const RID &rid, const std::vector<Column> &columns,
+                Tuple *out, const Snapshot *snapshot = nullptr);
+  bool IsVisible(const RID &rid, const Snapshot &snapshot);
+  // 一页上 snapshot 看得到的所有行，抽样时用
+  std::vector<Tuple> GetPageTuples(page_id_t page_id,
+                                   const Snapshot *snapshot = nullptr);
+  // 带事务时只写 xmax，已经被删过的返回 false；不带事务时直接物理删除
+  bool DeleteTuple(const RID &rid, Transaction *txn = nullptr);
+  // 清掉 xmax，回滚删除时用
+  bool RollbackDelete(const RID &rid, Transaction *txn = nullptr);
+  // 物理删除，回滚插入时用
+  bool ApplyDelete(const RID &rid, Transaction *txn = nullptr);
+  TableIterator Begin(const Snapshot *snapshot = nullptr);
   TableIterator End();
 
+  // 物理删除 xmax 小于 horizon 的版本，horizon 之前的事务都已结束，
+  // 也没有快照还能看到这些版本。删除记入 txn 的日志，每删一个版本调用
+  // 一次 on_reclaim，由调用者清理索引。返回回收的版本数
+  size_t CollectGarbage(
+      txn_id_t horizon, Transaction *txn,
+      const std::function<void(const RID &, const Tuple &)> &on_reclaim);
+  // 页上的版本是否对所有快照都可见（可见性映射），
+  // 是的话按索引只读时不用回表判断可见性
+  bool IsAllVisible(page_id_t page_id);
+  // 整张表是否都对所有快照可见
+  bool IsAllVisible();
+
   BufferPool *GetBufferPool() { return buffer_pool_; }
   page_id_t GetFirstPageId() const { return first_page_id_; }
+  // 页链表的长度，估计扫描代价用
+  size_t GetPageCount() const { return page_count_; }
+  // 页链表上按顺序的所有页号，不用读页
+  std::vector<page_id_t> GetPageIds();
+  // 用过的槽数，含已删除的版本，估计行数用
+  size_t GetSlotCount() const { return slot_count_; }
 
 private:
+  void ClearAllVisible(page_id_t page_id);
+
+  // 追加一条属于 txn 的日志，并把被修改的页的 page LSN 设为它
+  // 没有日志或事务时什么也不做
+  void AppendLog(Transaction *txn, LogRecord *record, Page *page,
+                 Page *other_page = nullptr);
+
   BufferPool *buffer_pool_;
+  LogManager *log_manager_;
 
   // 表的页链表
   int32_t first_page_id_;
   int32_t last_page_id_;
+  std::atomic<size_t> page_count_{1};
+  std::atomic<size_t> slot_count_{0};
+  // 页链表上的页号，只在内存里，打开表时沿页链表建好
+  std::vector<page_id_t> page_ids_;
 
-  // （可选）保护插入和扩容
+  // 保护页链表和页内容，单条元组的读写在多个线程里可以并发调用；
+  // TableIterator 的遍历不加这把锁
   std::mutex latch_;
+
+  // 可见性映射只在内存里，记下不是全部可见的页；重新打开的表所有页
+  // 都先算不可见，下一次 CollectGarbage 再确认
+  std::mutex visibility_latch_;
+  std::unordered_set<page_id_t> not_all_visible_;
 };
 
 } // namespace mini
@@ -1,18 +1,24 @@
 #pragma once
 #include "common/rid.h"
+#include "concurrency/snapshot.h"
 #include "storage/buffer_pool.h"
 #include "storage/table_heap.h"
 #include "storage/tuple.h"
 
 namespace mini {
 
+// 按槽位顺序遍历表，只停在对 snapshot 可见的版本上，
+// snapshot 为空时遍历最新版本。snapshot 要比迭代器活得久
 class TableIterator {
 public:
   TableIterator() = default;
-  TableIterator(TableHeap *table_heap, const RID &rid, bool end = true);
+  TableIterator(TableHeap *table_heap, const RID &rid, bool end = true,
+                const Snapshot *snapshot = nullptr);
 
   // TODO: copy?
   Tuple operator*() const;
+  // 只取当前记录的 columns 这些列
+  void Read(const std::vector<Column> &columns, Tuple *out) const;
   TableIterator &operator++();
   bool operator==(const TableIterator &other) const;
   bool operator!=(const TableIterator &other) const;
@@ -25,6 +31,7 @@ private:
   TableHeap *table_heap_{nullptr};
   RID rid_{};
   bool end_{true};
+  const Snapshot *snapshot_{nullptr};
 };
 
 } // namespace mini
@@ -1,4 +1,5 @@
 #include "binder/binder.h"
+#include <algorithm>
 #include "binder/bound_statement.h"
 #include "binder/value.h"
 #include "catalog/catalog.h"
@@ -23,6 +24,17 @@ Binder::BindStatement(const Statement &statement) {
   case StatementType::CREATE_INDEX:
     return BindCreateIndex(
         static_cast<const CreateIndexStatement &>(statement));
+  case StatementType::TRANSACTION:
+    return BindTransaction(
+        static_cast<const TransactionStatement &>(statement));
+  case StatementType::ANALYZE:
+    return BindAnalyze(static_cast<const AnalyzeStatement &>(statement));
+  case StatementType::EXPLAIN:
+    return BindExplain(static_cast<const ExplainStatement &>(statement));
+  case StatementType::PREPARE:
+    return BindPrepare(static_cast<const PrepareStatement &>(statement));
+  case StatementType::EXECUTE:
+    return BindExecute(static_cast<const ExecuteStatement &>(statement));
 
   default:
     return nullptr;
@@ -38,39 +50,352 @@ Binder::BindInsert(const InsertStatement &statement) {
         BindError("Table not found: " + table_name, SourceSpan{0, 0, 0, 0});
     return nullptr;
   }
-  std::vector<std::unique_ptr<Value>> values;
-  for (const auto &literal_ptr : statement.Values()) {
-    const Literal *literal = literal_ptr.get();
-    if (const StringLiteral *str_lit =
-            dynamic_cast<const StringLiteral *>(literal)) {
-      values.emplace_back(std::make_unique<StringValue>(str_lit->value()));
-    } else if (const IntLiteral *int_lit =
-                   dynamic_cast<const IntLiteral *>(literal)) {
-      values.emplace_back(std::make_unique<IntValue>(int_lit->value()));
-    } else {
-      error_ = BindError("Unsupported literal type", SourceSpan{0, 0, 0, 0});
+  const Schema &schema = *table->schema;
+  std::vector<BoundInsertStatement::Row> rows;
+  for (const auto &row : statement.Rows()) {
+    // 每一行都要给出所有列的值
+    if (row.size() != schema.GetColumnCount()) {
+      error_ = BindError("INSERT has " + std::to_string(row.size()) +
+                             " values but table " + table_name + " has " +
+                             std::to_string(schema.GetColumnCount()) +
+                             " columns",
+                         SourceSpan{0, 0, 0, 0});
       return nullptr;
     }
+    BoundInsertStatement::Row values;
+    for (const auto &literal_ptr : row) {
+      const Literal *literal = literal_ptr.get();
+      const Column &column = schema.GetColumn(values.size());
+      if (const ParameterLiteral *param =
+              dynamic_cast<const ParameterLiteral *>(literal)) {
+        // 参数的类型按它所在的列，EXECUTE 时检查
+        values.emplace_back(
+            std::make_unique<ParameterValue>(param->index(), column.type));
+      } else if (const StringLiteral *str_lit =
+                     dynamic_cast<const StringLiteral *>(literal)) {
+        values.emplace_back(std::make_unique<StringValue>(str_lit->value()));
+      } else if (const IntLiteral *int_lit =
+                     dynamic_cast<const IntLiteral *>(literal)) {
+        values.emplace_back(std::make_unique<IntValue>(int_lit->value()));
+      } else {
+        error_ = BindError("Unsupported literal type", SourceSpan{0, 0, 0, 0});
+        return nullptr;
+      }
+      if (values.back()->Type() != column.type) {
+        error_ = BindError("Type mismatch for column " + column.name +
+                               ": expected " +
+                               (column.type == DataType::INTEGER ? "INT"
+                                                                 : "VARCHAR"),
+                           SourceSpan{0, 0, 0, 0});
+        return nullptr;
+      }
+    }
+    rows.push_back(std::move(values));
   }
-  return std::make_unique<BoundInsertStatement>(table, std::move(values));
+  return std::make_unique<BoundInsertStatement>(table, std::move(rows));
+}
+
+static bool HasColumn(const Schema &schema, const std::string &name) {
+  for (const auto &column : schema.GetColumns()) {
+    if (column.name == name) {
+      return true;
+    }
+  }
+  return false;
 }
 
 std::unique_ptr<BoundStatement>
 Binder::BindSelect(const SelectStatement &statement) {
-  std::string table_name = statement.Table_name();
-  TableInfo *table = catalog_.GetTable(table_name);
-  if (table == nullptr) {
-    error_ =
-        BindError("Table not found: " + table_name, SourceSpan{0, 0, 0, 0});
+  if (statement.Count_star() && !statement.Order_by().empty()) {
+    error_ = BindError("ORDER BY is not supported with COUNT(*)",
+                       SourceSpan{0, 0, 0, 0});
+    return nullptr;
+  }
+  if (statement.Select_all() && !statement.Group_by().empty()) {
+    error_ = BindError("SELECT * is not supported with GROUP BY",
+                       SourceSpan{0, 0, 0, 0});
     return nullptr;
   }
+  std::unique_ptr<BoundSelectStatement> bound;
+  TableInfo *left = catalog_.GetTable(statement.Table_name());
+  TableInfo *right = nullptr;
+  if (statement.Join() != nullptr) {
+    bound = BindJoin(statement);
+    right = catalog_.GetTable(statement.Join()->table_name);
+  } else {
+    std::string table_name = statement.Table_name();
+    if (left == nullptr) {
+      error_ =
+          BindError("Table not found: " + table_name, SourceSpan{0, 0, 0, 0});
+      return nullptr;
+    }
+    if (!statement.Where_table().empty() &&
+        statement.Where_table() != table_name) {
+      error_ = BindError("Unknown table in WHERE clause: " +
+                             statement.Where_table(),
+                         SourceSpan{0, 0, 0, 0});
+      return nullptr;
+    }
+    bound = BindScan(left, statement.Has_where(), statement.Where_column(),
+                     statement.Where_value(), statement.Count_star());
+  }
+  if (bound == nullptr) {
+    return nullptr;
+  }
+  const auto &list = statement.Select_list();
+  bool has_aggregate =
+      std::any_of(list.begin(), list.end(), [](const SelectItem &item) {
+        return item.aggregate != AggregateType::NONE;
+      });
+  bool ok;
+  if (list.empty()) {
+    ok = BindOrderBy(statement, left, right, bound.get());
+  } else if (!has_aggregate && statement.Group_by().empty()) {
+    ok = BindProjection(statement, left, right, bound.get());
+  } else {
+    ok = BindAggregation(statement, left, right, bound.get());
+  }
+  if (!ok) {
+    return nullptr;
+  }
+  if (statement.Has_limit()) {
+    bound->SetLimit(statement.Limit(), statement.Offset());
+  }
+  return bound;
+}
+
+bool Binder::ResolveColumn(const ColumnRef &ref, TableInfo *left,
+                           TableInfo *right, uint32_t *column) {
+  if (right == nullptr) {
+    if (!ref.table.empty() && ref.table != left->name) {
+      error_ = BindError("Unknown table: " + ref.table, SourceSpan{0, 0, 0, 0});
+      return false;
+    }
+    if (!HasColumn(*left->schema, ref.column)) {
+      error_ =
+          BindError("Column not found: " + ref.column, SourceSpan{0, 0, 0, 0});
+      return false;
+    }
+    *column = left->schema->GetColumnIndex(ref.column);
+    return true;
+  }
+  // 连接的输出是左表的列接上右表的列
+  int side = ResolveSide(ref, left, right);
+  if (side < 0) {
+    return false;
+  }
+  *column = side == 0 ? left->schema->GetColumnIndex(ref.column)
+                      : left->schema->GetColumnCount() +
+                            right->schema->GetColumnIndex(ref.column);
+  return true;
+}
+
+bool Binder::BindOrderBy(const SelectStatement &statement, TableInfo *left,
+                         TableInfo *right, BoundSelectStatement *bound) {
+  std::vector<SortKey> keys;
+  for (const auto &item : statement.Order_by()) {
+    if (item.aggregate != AggregateType::NONE) {
+      error_ = BindError("Aggregate in ORDER BY must be in the select list",
+                         SourceSpan{0, 0, 0, 0});
+      return false;
+    }
+    uint32_t column;
+    if (!ResolveColumn(item.column, left, right, &column)) {
+      return false;
+    }
+    keys.push_back({column, item.desc});
+  }
+  bound->SetOrderBy(std::move(keys));
+  return true;
+}
+
+static std::string AggregateName(AggregateType aggregate) {
+  switch (aggregate) {
+  case AggregateType::COUNT_STAR:
+  case AggregateType::COUNT:
+    return "COUNT";
+  case AggregateType::SUM:
+    return "SUM";
+  case AggregateType::MIN:
+    return "MIN";
+  case AggregateType::MAX:
+    return "MAX";
+  case AggregateType::AVG:
+    return "AVG";
+  default:
+    return "";
+  }
+}
+
+bool Binder::BindAggregation(const SelectStatement &statement,
+                             TableInfo *left, TableInfo *right,
+                             BoundSelectStatement *bound) {
+  const auto &list = statement.Select_list();
+  auto aggregation = std::make_unique<BoundAggregation>();
+  for (const auto &ref : statement.Group_by()) {
+    uint32_t column;
+    if (!ResolveColumn(ref, left, right, &column)) {
+      return false;
+    }
+    aggregation->group_by.push_back(column);
+  }
+
+  auto input = bound->GetSchema();
+  auto schema = std::make_shared<Schema>();
+  for (const auto &item : list) {
+    if (item.aggregate == AggregateType::COUNT_STAR) {
+      aggregation->items.push_back({item.aggregate, 0});
+      schema->AddColumn("COUNT(*)", DataType::INTEGER);
+      continue;
+    }
+    uint32_t column;
+    if (!ResolveColumn(item.column, left, right, &column)) {
+      return false;
+    }
+    const Column &col = input->GetColumn(column);
+    const auto &group_by = aggregation->group_by;
+    if (item.aggregate == AggregateType::NONE) {
+      // 没有聚合的列每组只有一个值，必须是 GROUP BY 的列
+      if (std::find(group_by.begin(), group_by.end(), column) ==
+          group_by.end()) {
+        error_ = BindError("Column must appear in GROUP BY: " + col.name,
+                           SourceSpan{0, 0, 0, 0});
+        return false;
+      }
+      schema->AddColumn(col.name, col.type, col.length);
+    } else if (item.aggregate == AggregateType::MIN ||
+               item.aggregate == AggregateType::MAX) {
+      schema->AddColumn(AggregateName(item.aggregate) + "(" + col.name + ")",
+                        col.type, col.length);
+    } else {
+      if (item.aggregate != AggregateType::COUNT &&
+          col.type != DataType::INTEGER) {
+        error_ = BindError(AggregateName(item.aggregate) +
+                               " requires an INT column: " + col.name,
+                           SourceSpan{0, 0, 0, 0});
+        return false;
+      }
+      schema->AddColumn(AggregateName(item.aggregate) + "(" + col.name + ")",
+                        DataType::INTEGER);
+    }
+    aggregation->items.push_back({item.aggregate, column});
+  }
+
+  // ORDER BY 只能按 SELECT 列表里的项排序
+  std::vector<SortKey> keys;
+  for (const auto &item : statement.Order_by()) {
+    uint32_t column = 0;
+    if (item.aggregate != AggregateType::COUNT_STAR &&
+        !ResolveColumn(item.column, left, right, &column)) {
+      return false;
+    }
+    const auto &items = aggregation->items;
+    auto it = std::find_if(items.begin(), items.end(), [&](const auto &x) {
+      return x.aggregate == item.aggregate &&
+             (x.aggregate == AggregateType::COUNT_STAR || x.column == column);
+    });
+    if (it == items.end()) {
+      error_ = BindError("ORDER BY must refer to an item in the select list",
+                         SourceSpan{0, 0, 0, 0});
+      return false;
+    }
+    keys.push_back({static_cast<uint32_t>(it - items.begin()), item.desc});
+  }
+  // 扫描只取聚合用到的列，只有 COUNT(*) 时取整行
+  std::vector<uint32_t> columns;
+  for (uint32_t &column : aggregation->group_by) {
+    column = ScanIndex(&columns, column);
+  }
+  for (BoundSelectItem &item : aggregation->items) {
+    if (item.aggregate != AggregateType::COUNT_STAR) {
+      item.column = ScanIndex(&columns, item.column);
+    }
+  }
+  if (!columns.empty()) {
+    BindScanColumns(bound, std::move(columns));
+  }
+  aggregation->schema = std::move(schema);
+  bound->SetAggregation(std::move(aggregation));
+  bound->SetOrderBy(std::move(keys));
+  return true;
+}
+
+bool Binder::BindProjection(const SelectStatement &statement, TableInfo *left,
+                            TableInfo *right, BoundSelectStatement *bound) {
+  if (!BindOrderBy(statement, left, right, bound)) {
+    return false;
+  }
+  auto input = bound->GetSchema();
+  auto projection = std::make_shared<Schema>();
+  std::vector<uint32_t> columns;
+  for (const auto &item : statement.Select_list()) {
+    uint32_t column;
+    if (!ResolveColumn(item.column, left, right, &column)) {
+      return false;
+    }
+    columns.push_back(column);
+    const Column &col = input->GetColumn(column);
+    projection->AddColumn(col.name, col.type, col.length);
+  }
+  // 不在 SELECT 列表里的排序列接在后面，排完序再去掉
+  std::vector<SortKey> keys = bound->OrderBy();
+  for (SortKey &key : keys) {
+    key.column = ScanIndex(&columns, key.column);
+  }
+  bound->SetOrderBy(std::move(keys));
+  bound->SetProjection(std::move(projection));
+  BindScanColumns(bound, std::move(columns));
+  return true;
+}
+
+uint32_t Binder::ScanIndex(std::vector<uint32_t> *columns, uint32_t column) {
+  auto it = std::find(columns->begin(), columns->end(), column);
+  if (it != columns->end()) {
+    return static_cast<uint32_t>(it - columns->begin());
+  }
+  columns->push_back(column);
+  return static_cast<uint32_t>(columns->size() - 1);
+}
+
+void Binder::BindScanColumns(BoundSelectStatement *bound,
+                             std::vector<uint32_t> columns) {
+  // 单表的顺序扫描要判断 WHERE，WHERE 的列也要取出来
+  if (bound->Table() != nullptr && bound->HasWhere()) {
+    ScanIndex(&columns, bound->WhereColumnId());
+  }
+  auto input = bound->GetSchema();
+  auto schema = std::make_shared<Schema>();
+  for (uint32_t column : columns) {
+    const Column &col = input->GetColumn(column);
+    schema->AddColumn(col.name, col.type, col.length);
+  }
+  // 覆盖查询：要取的列只有 WHERE 上有索引的那一列时，值就是索引键，
+  // 不用回表
+  if (bound->Index() != nullptr && !columns.empty() &&
+      std::all_of(columns.begin(), columns.end(), [&](uint32_t column) {
+        return column == bound->WhereColumnId();
+      })) {
+    bound->SetIndexOnly(true);
+  }
+  bound->SetScanColumns(std::move(columns), std::move(schema));
+}
+
+std::unique_ptr<BoundSelectStatement>
+Binder::BindScan(TableInfo *table, bool has_where,
+                 const std::string &where_column, const Value *where_value,
+                 bool is_count_star) {
   IndexInfo *index_info = nullptr;
-  std::unique_ptr<Value> where_value = nullptr;
-  if (statement.Has_where()) {
-    index_info = catalog_.GetIndex(table_name, statement.Where_column());
-    auto value = statement.Where_value();
-    if (const IntValue *int_val = dynamic_cast<const IntValue *>(value)) {
-      where_value = std::make_unique<IntValue>(int_val->GetValue());
+  std::unique_ptr<Value> value = nullptr;
+  if (has_where) {
+    if (!HasColumn(*table->schema, where_column)) {
+      error_ = BindError("Column not found: " + where_column,
+                         SourceSpan{0, 0, 0, 0});
+      return nullptr;
+    }
+    index_info = catalog_.GetIndex(table->name, where_column);
+    if (where_value != nullptr && where_value->Type() == DataType::INTEGER) {
+      // INT 或者 INT 参数
+      value = where_value->Clone();
     } else {
       // unsupported literal type in where clause
       error_ = BindError("Unsupported literal type in WHERE clause",
@@ -78,16 +403,166 @@ Binder::BindSelect(const SelectStatement &statement) {
       return nullptr;
     }
   }
+  // 覆盖查询：COUNT(*) 或者表里只有索引键这一列时，等值索引查询不用回表。
+  // 只取索引键这一列的投影在 BindScanColumns 里判断
+  bool index_only =
+      index_info != nullptr &&
+      (is_count_star || table->schema->GetColumnCount() == 1);
   return std::make_unique<BoundSelectStatement>(
-      table, index_info, statement.Has_where(), statement.Where_column(),
-      std::move(where_value));
+      table, index_info, has_where, has_where ? where_column : "",
+      std::move(value), is_count_star, index_only);
+}
+
+IndexInfo *Binder::BPlusTreeIndexOn(TableInfo *table,
+                                    const std::string &column) {
+  for (const auto &index : catalog_.GetIndexes(table->name)) {
+    if (index->index_type == IndexType::BPLUS_TREE &&
+        index->key_schema->GetColumn(0).name == column) {
+      return index.get();
+    }
+  }
+  return nullptr;
+}
+
+int Binder::ResolveSide(const ColumnRef &column, TableInfo *left,
+                        TableInfo *right) {
+  if (!column.table.empty()) {
+    TableInfo *table = column.table == left->name    ? left
+                       : column.table == right->name ? right
+                                                     : nullptr;
+    if (table == nullptr) {
+      error_ = BindError("Unknown table: " + column.table,
+                         SourceSpan{0, 0, 0, 0});
+      return -1;
+    }
+    if (!HasColumn(*table->schema, column.column)) {
+      error_ = BindError("Column not found: " + column.table + "." +
+                             column.column,
+                         SourceSpan{0, 0, 0, 0});
+      return -1;
+    }
+    return table == left ? 0 : 1;
+  }
+  bool in_left = HasColumn(*left->schema, column.column);
+  bool in_right = HasColumn(*right->schema, column.column);
+  if (in_left && in_right) {
+    error_ = BindError("Ambiguous column: " + column.column,
+                       SourceSpan{0, 0, 0, 0});
+    return -1;
+  }
+  if (!in_left && !in_right) {
+    error_ =
+        BindError("Column not found: " + column.column, SourceSpan{0, 0, 0, 0});
+    return -1;
+  }
+  return in_left ? 0 : 1;
+}
+
+std::unique_ptr<BoundSelectStatement>
+Binder::BindJoin(const SelectStatement &statement) {
+  const JoinClause *join = statement.Join();
+  TableInfo *left = catalog_.GetTable(statement.Table_name());
+  TableInfo *right = catalog_.GetTable(join->table_name);
+  if (left == nullptr || right == nullptr) {
+    error_ = BindError("Table not found: " + (left == nullptr
+                                                  ? statement.Table_name()
+                                                  : join->table_name),
+                       SourceSpan{0, 0, 0, 0});
+    return nullptr;
+  }
+  if (left == right) {
+    // 没有表别名，分不清两边的列
+    error_ = BindError("Self join is not supported", SourceSpan{0, 0, 0, 0});
+    return nullptr;
+  }
+
+  // ON 两边的列各属于一张表，左右写反了也可以
+  int first_side = ResolveSide(join->left, left, right);
+  int second_side = ResolveSide(join->right, left, right);
+  if (first_side < 0 || second_side < 0) {
+    return nullptr;
+  }
+  if (first_side == second_side) {
+    error_ = BindError("JOIN condition must compare columns of both tables",
+                       SourceSpan{0, 0, 0, 0});
+    return nullptr;
+  }
+  const ColumnRef &left_ref = first_side == 0 ? join->left : join->right;
+  const ColumnRef &right_ref = first_side == 0 ? join->right : join->left;
+  uint32_t left_column = left->schema->GetColumnIndex(left_ref.column);
+  uint32_t right_column = right->schema->GetColumnIndex(right_ref.column);
+  if (left->schema->GetColumn(left_column).type != DataType::INTEGER ||
+      right->schema->GetColumn(right_column).type != DataType::INTEGER) {
+    error_ =
+        BindError("JOIN only supports INT columns", SourceSpan{0, 0, 0, 0});
+    return nullptr;
+  }
+
+  // WHERE 只涉及一张表，下推到那一边的扫描
+  int where_side = -1;
+  if (statement.Has_where()) {
+    where_side = ResolveSide(
+        ColumnRef{statement.Where_table(), statement.Where_column()}, left,
+        right);
+    if (where_side < 0) {
+      return nullptr;
+    }
+  }
+  auto bound_join = std::make_unique<BoundJoin>();
+  bound_join->left =
+      BindScan(left, where_side == 0, statement.Where_column(),
+               statement.Where_value(), false);
+  bound_join->right =
+      BindScan(right, where_side == 1, statement.Where_column(),
+               statement.Where_value(), false);
+  if (bound_join->left == nullptr || bound_join->right == nullptr) {
+    return nullptr;
+  }
+  bound_join->left_column = left_column;
+  bound_join->right_column = right_column;
+  bound_join->left_index = BPlusTreeIndexOn(left, left_ref.column);
+  bound_join->right_index = BPlusTreeIndexOn(right, right_ref.column);
+
+  // 输出的列名带上表名
+  std::vector<Column> columns;
+  uint32_t offset = 0;
+  for (TableInfo *table : {left, right}) {
+    for (const auto &column : table->schema->GetColumns()) {
+      columns.push_back({table->name + "." + column.name, column.type,
+                         offset + column.offset, column.length});
+    }
+    offset += table->schema->GetTupleLength();
+  }
+  return std::make_unique<BoundSelectStatement>(
+      std::move(bound_join), std::make_shared<Schema>(std::move(columns)),
+      statement.Count_star());
 }
 
 std::unique_ptr<BoundStatement>
 Binder::BindCreateTable(const CreateTableStatement &statement) {
   std::string table_name = statement.Table_name();
   std::vector<std::pair<std::string, ColumnType>> columns = statement.Columns();
-  return std::make_unique<BoundCreateTableStatement>(table_name, columns);
+  std::vector<uint32_t> primary_key;
+  for (const auto &pk_name : statement.Primary_key()) {
+    uint32_t column_id = 0;
+    while (column_id < columns.size() && columns[column_id].first != pk_name) {
+      column_id++;
+    }
+    if (column_id == columns.size()) {
+      error_ = BindError("Primary key column not found: " + pk_name,
+                         SourceSpan{0, 0, 0, 0});
+      return nullptr;
+    }
+    // 主键依赖 B+Tree 唯一索引，目前只支持 INT
+    if (columns[column_id].second.type != DataType::INTEGER) {
+      error_ = BindError("Primary key must be an INT column: " + pk_name,
+                         SourceSpan{0, 0, 0, 0});
+      return nullptr;
+    }
+    primary_key.push_back(column_id);
+  }
+  return std::make_unique<BoundCreateTableStatement>(table_name, columns,
+                                                     std::move(primary_key));
 }
 
 std::unique_ptr<BoundStatement>
@@ -95,13 +570,74 @@ Binder::BindCreateIndex(const CreateIndexStatement &statement) {
   std::string index_name = statement.Index_name();
   std::string table_name = statement.Table_name();
   TableInfo *table = catalog_.GetTable(table_name);
+  if (table == nullptr) {
+    error_ =
+        BindError("Table not found: " + table_name, SourceSpan{0, 0, 0, 0});
+    return nullptr;
+  }
 
   uint32_t column_id =
       table->schema->GetColumnIndex(statement.Column_names()[0]);
   std::vector<uint32_t> column_ids{column_id};
 
-  return std::make_unique<BoundCreateIndexStatement>(index_name, table_name,
-                                                     column_ids);
+  IndexType index_type = IndexType::BPLUS_TREE;
+  std::string method = statement.Index_method();
+  if (method == "HASH") {
+    index_type = IndexType::HASH;
+  } else if (!method.empty() && method != "BTREE") {
+    error_ = BindError("Unsupported index method: " + method,
+                       SourceSpan{0, 0, 0, 0});
+    return nullptr;
+  }
+
+  return std::make_unique<BoundCreateIndexStatement>(
+      index_name, table_name, column_ids, statement.Is_unique(), index_type);
+}
+
+std::unique_ptr<BoundStatement>
+Binder::BindTransaction(const TransactionStatement &statement) {
+  return std::make_unique<BoundTransactionStatement>(statement.Command());
+}
+
+std::unique_ptr<BoundStatement>
+Binder::BindAnalyze(const AnalyzeStatement &statement) {
+  std::string table_name = statement.Table_name();
+  TableInfo *table = catalog_.GetTable(table_name);
+  if (table == nullptr) {
+    error_ =
+        BindError("Table not found: " + table_name, SourceSpan{0, 0, 0, 0});
+    return nullptr;
+  }
+  return std::make_unique<BoundAnalyzeStatement>(table);
+}
+
+std::unique_ptr<BoundStatement>
+Binder::BindExplain(const ExplainStatement &statement) {
+  auto select = BindSelect(statement.Select());
+  if (select == nullptr) {
+    return nullptr;
+  }
+  return std::make_unique<BoundExplainStatement>(
+      std::unique_ptr<BoundSelectStatement>(
+          static_cast<BoundSelectStatement *>(select.release())),
+      statement.IsAnalyze());
+}
+
+std::unique_ptr<BoundStatement>
+Binder::BindPrepare(const PrepareStatement &statement) {
+  // 正文在执行 PREPARE 时由 PlanCache 绑定
+  return std::make_unique<BoundPrepareStatement>(statement.Name(),
+                                                 statement.Sql());
+}
+
+std::unique_ptr<BoundStatement>
+Binder::BindExecute(const ExecuteStatement &statement) {
+  std::vector<std::unique_ptr<Value>> parameters;
+  for (const auto &value : statement.Parameters()) {
+    parameters.push_back(value->Clone());
+  }
+  return std::make_unique<BoundExecuteStatement>(statement.Name(),
+                                                 std::move(parameters));
 }
 
 } // namespace mini
@@ -6,20 +6,61 @@
 #include "storage/buffer_pool.h"
 #include "storage/disk_manager.h"
 #include "storage/table_heap.h"
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <memory>
+#include <stdexcept>
 
 namespace mini {
 
+// 每个目录页的页首，后面接着 size 字节的内容
+struct CatalogPageHeader {
+  lsn_t lsn; // page LSN，必须在页首
+  uint32_t magic;
+  page_id_t next_page_id;
+  uint32_t size;
+};
+
+static constexpr uint32_t CATALOG_MAGIC = 0x4d444231; // "MDB1"
+static constexpr size_t CATALOG_PAGE_CAPACITY =
+    PAGE_SIZE - sizeof(CatalogPageHeader);
+
+template <typename T> static void Put(std::vector<char> *data, const T &value) {
+  const char *bytes = reinterpret_cast<const char *>(&value);
+  data->insert(data->end(), bytes, bytes + sizeof(T));
+}
+
+static void PutString(std::vector<char> *data, const std::string &value) {
+  Put(data, static_cast<uint32_t>(value.size()));
+  data->insert(data->end(), value.begin(), value.end());
+}
+
+template <typename T> static T Get(const char **pos) {
+  T value;
+  std::memcpy(&value, *pos, sizeof(T));
+  *pos += sizeof(T);
+  return value;
+}
+
+static std::string GetString(const char **pos) {
+  auto size = Get<uint32_t>(pos);
+  std::string value(*pos, size);
+  *pos += size;
+  return value;
+}
+
 TableInfo *Catalog::CreateTable(const std::string &name,
                                 std::shared_ptr<Schema> schema) {
   std::unique_ptr<TableInfo> table_info = std::make_unique<TableInfo>();
   table_info->name = name;
   table_info->schema = schema;
   table_info->table_id = next_table_id_++;
-  table_info->table = std::make_shared<TableHeap>(bpm_);
+  table_info->table = std::make_shared<TableHeap>(bpm_, log_manager_);
+  unlogged_pages_.push_back(table_info->table->GetFirstPageId());
   tables_[name] = std::move(table_info);
+  version_++;
   return tables_[name].get();
 }
 
@@ -31,6 +72,21 @@ TableInfo *Catalog::GetTable(const std::string &name) {
   return nullptr;
 }
 
+bool Catalog::DropTable(const std::string &name) {
+  auto it = tables_.find(name);
+  if (it == tables_.end()) {
+    return false;
+  }
+  page_id_t first_page_id = it->second->table->GetFirstPageId();
+  unlogged_pages_.erase(std::remove(unlogged_pages_.begin(),
+                                    unlogged_pages_.end(), first_page_id),
+                        unlogged_pages_.end());
+  tables_.erase(it);
+  bpm_->DeletePage(first_page_id);
+  version_++;
+  return true;
+}
+
 void Catalog::ListTables() {
   for (const auto &pair : tables_) {
     const TableInfo *table_info = pair.second.get();
@@ -41,13 +97,18 @@ void Catalog::ListTables() {
 
 IndexInfo *Catalog::CreateIndex(const std::string &index_name,
                                 const std::string &table_name,
-                                uint32_t key_col_id) {
+                                uint32_t key_col_id, bool is_unique,
+                                IndexType index_type) {
   auto table_it = tables_.find(table_name);
   if (table_it == tables_.end()) {
     std::cerr << "Table " << table_name << " does not exist." << std::endl;
     return nullptr;
   }
   auto &table_info = table_it->second;
+  if (indexes_.count(index_name) != 0) {
+    std::cerr << "Index " << index_name << " already exists." << std::endl;
+    return nullptr;
+  }
 
   // 目前只支持 INTEGER 类型的索引键
   if (table_info->schema->GetColumn(key_col_id).type != DataType::INTEGER) {
@@ -66,13 +127,24 @@ IndexInfo *Catalog::CreateIndex(const std::string &index_name,
       table_info->schema->GetColumn(key_col_id).name,
       table_info->schema->GetColumn(key_col_id).type);
 
-  index_info->index = std::make_unique<BPlusTreeIndex>(
-      bpm_, index_name, table_name, table_info->schema, key_col_id);
+  if (index_type == IndexType::HASH) {
+    index_info->index = std::make_unique<HashIndex>(
+        bpm_, index_name, table_name, table_info->schema, key_col_id,
+        is_unique, log_manager_);
+  } else {
+    index_info->index = std::make_unique<BPlusTreeIndex>(
+        bpm_, index_name, table_name, table_info->schema, key_col_id,
+        is_unique, log_manager_);
+  }
   index_info->index_id = next_index_id_++;
+  index_info->is_unique = is_unique;
+  index_info->index_type = index_type;
+  unlogged_pages_.push_back(index_info->index->GetHeaderPageId());
 
   // 维护索引映射关系
   table_to_indexes_[table_name].push_back(index_info);
   indexes_[index_name] = index_info;
+  version_++;
   return indexes_[index_name].get();
 }
 
@@ -90,6 +162,27 @@ IndexInfo *Catalog::GetIndex(const std::string &table_name,
   return nullptr;
 }
 
+bool Catalog::DropIndex(const std::string &index_name) {
+  auto it = indexes_.find(index_name);
+  if (it == indexes_.end()) {
+    return false;
+  }
+  unlogged_pages_.erase(std::remove(unlogged_pages_.begin(),
+                                    unlogged_pages_.end(),
+                                    it->second->index->GetHeaderPageId()),
+                        unlogged_pages_.end());
+  auto &table_indexes = table_to_indexes_[it->second->table_name];
+  for (auto iter = table_indexes.begin(); iter != table_indexes.end(); ++iter) {
+    if (*iter == it->second) {
+      table_indexes.erase(iter);
+      break;
+    }
+  }
+  indexes_.erase(it);
+  version_++;
+  return true;
+}
+
 std::vector<std::shared_ptr<IndexInfo>> &
 Catalog ::GetIndexes(const std::string &table_name) {
   auto it = table_to_indexes_.find(table_name);
@@ -109,4 +202,210 @@ void Catalog::ListIndexes() {
   }
 }
 
+size_t Catalog::CollectGarbage(txn_id_t horizon, Transaction *txn) {
+  size_t reclaimed = 0;
+  for (auto &[name, table_info] : tables_) {
+    auto &indexes = GetIndexes(name);
+    reclaimed += table_info->table->CollectGarbage(
+        horizon, txn, [&indexes, txn](const RID &rid, const Tuple &tuple) {
+          for (const auto &index : indexes) {
+            index->index->DeleteEntry(tuple, rid, txn);
+          }
+        });
+  }
+  return reclaimed;
+}
+
+bool Catalog::Load() {
+  std::vector<char> data;
+  page_id_t page_id = CATALOG_PAGE_ID;
+  while (page_id != INVALID_PAGE_ID) {
+    auto pageguard = bpm_->FetchPageGuarded(page_id);
+    const char *page_data = pageguard.GetPage()->GetData();
+    auto header = reinterpret_cast<const CatalogPageHeader *>(page_data);
+    if (header->magic != CATALOG_MAGIC) {
+      if (page_id == CATALOG_PAGE_ID) {
+        break;
+      }
+      throw std::runtime_error("broken catalog page " +
+                               std::to_string(page_id));
+    }
+    const char *content = page_data + sizeof(*header);
+    data.insert(data.end(), content, content + header->size);
+    catalog_page_ids_.push_back(page_id);
+    page_id = header->next_page_id;
+  }
+  if (!catalog_page_ids_.empty()) {
+    Deserialize(data);
+    return true;
+  }
+
+  // 新文件：读第 0 页只是拿到一页全零，还要真正分配出来
+  page_id_t new_page_id;
+  bpm_->NewPageGuarded(&new_page_id);
+  if (new_page_id != CATALOG_PAGE_ID) {
+    throw std::runtime_error("data file has no catalog page");
+  }
+  catalog_page_ids_.push_back(new_page_id);
+  Persist();
+  bpm_->FlushPage(new_page_id);
+  return false;
+}
+
+void Catalog::Persist(TransactionManager *txn_manager) {
+  if (catalog_page_ids_.empty()) {
+    return;
+  }
+  std::vector<char> data = Serialize();
+  while (catalog_page_ids_.size() * CATALOG_PAGE_CAPACITY < data.size()) {
+    page_id_t page_id;
+    bpm_->NewPageGuarded(&page_id);
+    catalog_page_ids_.push_back(page_id);
+  }
+
+  // 先在副本里拼好每一页，链上多出来的页留空
+  std::vector<std::pair<page_id_t, std::vector<char>>> images;
+  for (size_t i = 0; i < catalog_page_ids_.size(); ++i) {
+    std::vector<char> image(PAGE_SIZE, 0);
+    CatalogPageHeader header{INVALID_LSN, CATALOG_MAGIC, INVALID_PAGE_ID, 0};
+    if (i + 1 < catalog_page_ids_.size()) {
+      header.next_page_id = catalog_page_ids_[i + 1];
+    }
+    size_t begin = std::min(data.size(), i * CATALOG_PAGE_CAPACITY);
+    size_t end = std::min(data.size(), begin + CATALOG_PAGE_CAPACITY);
+    header.size = static_cast<uint32_t>(end - begin);
+    std::memcpy(image.data(), &header, sizeof(header));
+    std::copy(data.begin() + begin, data.begin() + end,
+              image.begin() + sizeof(header));
+    images.emplace_back(catalog_page_ids_[i], std::move(image));
+  }
+  for (page_id_t page_id : unlogged_pages_) {
+    auto pageguard = bpm_->FetchPageGuarded(page_id);
+    const char *content = pageguard.GetPage()->GetData();
+    images.emplace_back(page_id,
+                        std::vector<char>(content, content + PAGE_SIZE));
+  }
+  unlogged_pages_.clear();
+
+  Transaction *txn = nullptr;
+  lsn_t lsn = INVALID_LSN;
+  if (txn_manager != nullptr && log_manager_ != nullptr) {
+    txn = txn_manager->Begin();
+    std::vector<std::pair<page_id_t, const char *>> pages;
+    for (const auto &[page_id, image] : images) {
+      pages.emplace_back(page_id, image.data());
+    }
+    LogRecord record(txn->GetTxnId(), txn->GetPrevLSN(), txn->GetPrevLSN(),
+                     pages);
+    lsn = log_manager_->AppendLogRecord(&record);
+    txn->SetPrevLSN(lsn);
+  }
+  for (const auto &[page_id, image] : images) {
+    auto pageguard = bpm_->FetchPageGuarded(page_id);
+    std::memcpy(pageguard.GetPage()->GetData(), image.data(), PAGE_SIZE);
+    pageguard.SetDirty();
+    if (txn != nullptr) {
+      pageguard.GetPage()->SetLSN(lsn);
+      bpm_->LowerRecLSN(page_id, lsn);
+    }
+  }
+  if (txn != nullptr) {
+    txn_manager->Commit(txn);
+  }
+}
+
+std::vector<char> Catalog::Serialize() const {
+  std::vector<char> data;
+  Put(&data, next_table_id_);
+  Put(&data, next_index_id_);
+  Put(&data, static_cast<uint32_t>(tables_.size()));
+  for (const auto &[name, table_info] : tables_) {
+    PutString(&data, name);
+    Put(&data, table_info->table_id);
+    Put(&data, table_info->table->GetFirstPageId());
+    const auto &columns = table_info->schema->GetColumns();
+    Put(&data, static_cast<uint32_t>(columns.size()));
+    for (const Column &column : columns) {
+      PutString(&data, column.name);
+      Put(&data, column.type);
+      Put(&data, column.offset);
+      Put(&data, column.length);
+    }
+  }
+  // 按建索引的顺序写，重新载入后每个表上索引的先后不变
+  std::vector<const IndexInfo *> indexes;
+  for (const auto &entry : indexes_) {
+    indexes.push_back(entry.second.get());
+  }
+  std::sort(indexes.begin(), indexes.end(),
+            [](const IndexInfo *a, const IndexInfo *b) {
+              return a->index_id < b->index_id;
+            });
+  Put(&data, static_cast<uint32_t>(indexes.size()));
+  for (const IndexInfo *index_info : indexes) {
+    PutString(&data, index_info->index_name);
+    PutString(&data, index_info->table_name);
+    PutString(&data, index_info->key_schema->GetColumn(0).name);
+    Put(&data, index_info->index_id);
+    Put(&data, index_info->is_unique);
+    Put(&data, index_info->index_type);
+    Put(&data, index_info->index->GetHeaderPageId());
+  }
+  return data;
+}
+
+void Catalog::Deserialize(const std::vector<char> &data) {
+  const char *pos = data.data();
+  next_table_id_ = Get<int32_t>(&pos);
+  next_index_id_ = Get<int32_t>(&pos);
+  auto table_count = Get<uint32_t>(&pos);
+  for (uint32_t i = 0; i < table_count; ++i) {
+    auto table_info = std::make_unique<TableInfo>();
+    table_info->name = GetString(&pos);
+    table_info->table_id = Get<int32_t>(&pos);
+    auto first_page_id = Get<page_id_t>(&pos);
+    std::vector<Column> columns(Get<uint32_t>(&pos));
+    for (Column &column : columns) {
+      column.name = GetString(&pos);
+      column.type = Get<DataType>(&pos);
+      column.offset = Get<uint32_t>(&pos);
+      column.length = Get<uint32_t>(&pos);
+    }
+    table_info->schema = std::make_shared<Schema>(std::move(columns));
+    table_info->table =
+        std::make_shared<TableHeap>(bpm_, first_page_id, log_manager_);
+    std::string name = table_info->name;
+    tables_[name] = std::move(table_info);
+  }
+  auto index_count = Get<uint32_t>(&pos);
+  for (uint32_t i = 0; i < index_count; ++i) {
+    auto index_info = std::make_shared<IndexInfo>();
+    index_info->index_name = GetString(&pos);
+    index_info->table_name = GetString(&pos);
+    std::string column_name = GetString(&pos);
+    index_info->index_id = Get<int32_t>(&pos);
+    index_info->is_unique = Get<bool>(&pos);
+    index_info->index_type = Get<IndexType>(&pos);
+    auto header_page_id = Get<page_id_t>(&pos);
+
+    const auto &schema = tables_.at(index_info->table_name)->schema;
+    uint32_t key_col_id = schema->GetColumnIndex(column_name);
+    index_info->key_schema = std::make_unique<Schema>();
+    index_info->key_schema->AddColumn(column_name,
+                                      schema->GetColumn(key_col_id).type);
+    if (index_info->index_type == IndexType::HASH) {
+      index_info->index = std::make_unique<HashIndex>(
+          bpm_, index_info->index_name, index_info->table_name, schema,
+          key_col_id, header_page_id, log_manager_);
+    } else {
+      index_info->index = std::make_unique<BPlusTreeIndex>(
+          bpm_, index_info->index_name, index_info->table_name, schema,
+          key_col_id, header_page_id, log_manager_);
+    }
+    table_to_indexes_[index_info->table_name].push_back(index_info);
+    indexes_[index_info->index_name] = index_info;
+  }
+  version_++;
+}
+
 } // namespace mini
@@ -0,0 +1,212 @@
+#include "catalog/statistics.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <unordered_map>
+
+namespace mini {
+
+uint64_t HyperLogLog::Hash(const char *data, size_t size) {
+  // FNV-1a，再用 splitmix64 的收尾把位打散，高位也均匀
+  uint64_t hash = 14695981039346656037ULL;
+  for (size_t i = 0; i < size; ++i) {
+    hash = (hash ^ static_cast<uint8_t>(data[i])) * 1099511628211ULL;
+  }
+  hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebULL;
+  return hash ^ (hash >> 31);
+}
+
+void HyperLogLog::Add(uint64_t hash) {
+  size_t index = hash >> (64 - PRECISION);
+  uint64_t rest = hash << PRECISION;
+  // 剩下的位全是 0 时按最长算
+  uint8_t rank = rest == 0 ? 64 - PRECISION + 1
+                           : static_cast<uint8_t>(__builtin_clzll(rest) + 1);
+  registers_[index] = std::max(registers_[index], rank);
+}
+
+double HyperLogLog::Estimate() const {
+  double m = static_cast<double>(registers_.size());
+  double sum = 0;
+  size_t zeros = 0;
+  for (uint8_t rank : registers_) {
+    sum += std::ldexp(1.0, -rank);
+    zeros += rank == 0;
+  }
+  double estimate = 0.7213 / (1 + 1.079 / m) * m * m / sum;
+  // 值少时很多寄存器还是 0，改用线性计数
+  if (estimate <= 2.5 * m && zeros > 0) {
+    estimate = m * std::log(m / zeros);
+  }
+  return estimate;
+}
+
+std::unique_ptr<TableStatistics>
+TableStatistics::Collect(TableHeap *heap, const Schema &schema,
+                         const Snapshot *snapshot) {
+  auto stats = std::make_unique<TableStatistics>();
+  const auto &columns = schema.GetColumns();
+  stats->columns_.resize(columns.size());
+
+  // 蓄水池抽样：第 n 个以 k / n 的概率换掉样本里随机的一个，读完后每一个
+  // 留在样本里的概率相同。固定种子，同样的表建出同样的计划
+  std::mt19937_64 gen(42);
+  std::vector<page_id_t> page_ids = heap->GetPageIds();
+  stats->page_count_ = page_ids.size();
+  std::vector<page_id_t> sample_pages;
+  for (size_t n = 0; n < page_ids.size(); ++n) {
+    if (n < SAMPLE_PAGES) {
+      sample_pages.push_back(page_ids[n]);
+    } else if (size_t slot = gen() % (n + 1); slot < SAMPLE_PAGES) {
+      sample_pages[slot] = page_ids[n];
+    }
+  }
+  // 按页号读，接近顺序读盘
+  std::sort(sample_pages.begin(), sample_pages.end());
+  bool sampled = sample_pages.size() < page_ids.size();
+
+  std::vector<std::vector<int32_t>> samples(columns.size());
+  // 抽样时数每个值在样本里出现了几次，估计不同值个数用
+  std::vector<std::unordered_map<uint64_t, uint32_t>> frequencies(
+      sampled ? columns.size() : 0);
+  for (page_id_t page_id : sample_pages) {
+    for (const Tuple &tuple : heap->GetPageTuples(page_id, snapshot)) {
+      stats->AddRow(schema, tuple);
+      for (size_t i = 0; i < frequencies.size(); ++i) {
+        frequencies[i][HyperLogLog::Hash(tuple.Data() + columns[i].offset,
+                                         columns[i].length)]++;
+      }
+      size_t slot = stats->row_count_ - 1;
+      if (slot >= SAMPLE_SIZE) {
+        slot = gen() % stats->row_count_;
+        if (slot >= SAMPLE_SIZE) {
+          continue;
+        }
+      }
+      for (size_t i = 0; i < columns.size(); ++i) {
+        if (columns[i].type != DataType::INTEGER) {
+          continue;
+        }
+        int32_t value;
+        memcpy(&value, tuple.Data() + columns[i].offset, sizeof(int32_t));
+        if (slot == samples[i].size()) {
+          samples[i].push_back(value);
+        } else {
+          samples[i][slot] = value;
+        }
+      }
+    }
+  }
+
+  if (sampled && stats->row_count_ > 0) {
+    // 每页的行数差不多，按页数放大
+    double n = static_cast<double>(stats->row_count_);
+    double total = n * page_ids.size() / sample_pages.size();
+    stats->row_count_ = static_cast<size_t>(std::llround(total));
+    // Duj1：D = n * d / (n - f1 + f1 * n / N)，d 是样本里的不同值个数，
+    // f1 是只出现一次的个数。全都只出现一次时 D = N，没有时 D = d
+    for (size_t i = 0; i < columns.size(); ++i) {
+      double d = static_cast<double>(frequencies[i].size());
+      double f1 = 0;
+      for (const auto &[hash, count] : frequencies[i]) {
+        f1 += count == 1;
+      }
+      double estimate = n * d / (n - f1 + f1 * n / total);
+      ColumnStatistics &column = stats->columns_[i];
+      column.unseen_distinct =
+          std::max(estimate - column.distinct.Estimate(), 0.0);
+    }
+  }
+
+  // 样本排好序后每隔 n / 桶数行取一个上界
+  for (size_t i = 0; i < columns.size(); ++i) {
+    std::vector<int32_t> &values = samples[i];
+    if (values.empty()) {
+      continue;
+    }
+    std::sort(values.begin(), values.end());
+    size_t buckets = std::min(HISTOGRAM_BUCKETS, values.size());
+    for (size_t b = 1; b <= buckets; ++b) {
+      stats->columns_[i].bounds.push_back(values[b * values.size() / buckets -
+                                                 1]);
+    }
+  }
+  return stats;
+}
+
+void TableStatistics::AddRow(const Schema &schema, const Tuple &tuple) {
+  const auto &columns = schema.GetColumns();
+  for (size_t i = 0; i < columns.size(); ++i) {
+    const char *data = tuple.Data() + columns[i].offset;
+    ColumnStatistics &column = columns_[i];
+    column.distinct.Add(HyperLogLog::Hash(data, columns[i].length));
+    if (columns[i].type != DataType::INTEGER) {
+      continue;
+    }
+    int32_t value;
+    memcpy(&value, data, sizeof(int32_t));
+    column.min = column.has_range ? std::min(column.min, value) : value;
+    column.max = column.has_range ? std::max(column.max, value) : value;
+    column.has_range = true;
+  }
+  row_count_++;
+}
+
+void TableStatistics::RecordInsert(const Schema &schema,
+                                   const std::vector<Tuple> &tuples) {
+  std::lock_guard<std::mutex> guard(latch_);
+  for (const Tuple &tuple : tuples) {
+    AddRow(schema, tuple);
+  }
+  insert_count_ += tuples.size();
+}
+
+double TableStatistics::RowCount() const {
+  std::lock_guard<std::mutex> guard(latch_);
+  return static_cast<double>(row_count_);
+}
+
+size_t TableStatistics::InsertCount() const {
+  std::lock_guard<std::mutex> guard(latch_);
+  return insert_count_;
+}
+
+double TableStatistics::Distinct(uint32_t column) const {
+  std::lock_guard<std::mutex> guard(latch_);
+  // 估计值可能比行数略多
+  const ColumnStatistics &stats = columns_[column];
+  return std::clamp(stats.distinct.Estimate() + stats.unseen_distinct, 1.0,
+                    std::max<double>(row_count_, 1));
+}
+
+bool TableStatistics::Range(uint32_t column, int32_t *min,
+                            int32_t *max) const {
+  std::lock_guard<std::mutex> guard(latch_);
+  const ColumnStatistics &stats = columns_[column];
+  *min = stats.min;
+  *max = stats.max;
+  return stats.has_range;
+}
+
+double TableStatistics::EqualSelectivity(uint32_t column,
+                                         int32_t value) const {
+  double distinct = Distinct(column);
+  std::lock_guard<std::mutex> guard(latch_);
+  const ColumnStatistics &stats = columns_[column];
+  if (!stats.has_range) {
+    return 1 / distinct;
+  }
+  if (value < stats.min || value > stats.max) {
+    return 0;
+  }
+  // 一个值占了好几个桶的上界，说明它至少有这么多个桶的行
+  size_t hits = std::count(stats.bounds.begin(), stats.bounds.end(), value);
+  if (hits >= 2) {
+    return static_cast<double>(hits) / stats.bounds.size();
+  }
+  return 1 / distinct;
+}
+
+} // namespace mini
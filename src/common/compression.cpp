@@ -0,0 +1,142 @@
+#include "common/compression.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace mini {
+
+static constexpr size_t MIN_MATCH = 4;
+static constexpr size_t MAX_OFFSET = 65535;
+static constexpr int HASH_BITS = 12;
+
+static uint32_t Read32(const char *p) {
+  uint32_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static size_t Hash(uint32_t v) {
+  return (v * 2654435761u) >> (32 - HASH_BITS);
+}
+
+// 长度超过 15 的部分：若干个 255，最后一个小于 255
+static void PutLength(std::vector<char> *out, size_t length) {
+  while (length >= 255) {
+    out->push_back(static_cast<char>(255));
+    length -= 255;
+  }
+  out->push_back(static_cast<char>(length));
+}
+
+static void PutSequence(std::vector<char> *out, const char *literals,
+                        size_t literal_length, size_t offset,
+                        size_t match_length) {
+  size_t match_code = match_length == 0 ? 0 : match_length - MIN_MATCH;
+  uint8_t token = static_cast<uint8_t>(std::min<size_t>(literal_length, 15)
+                                       << 4) |
+                  static_cast<uint8_t>(std::min<size_t>(match_code, 15));
+  out->push_back(static_cast<char>(token));
+  if (literal_length >= 15) {
+    PutLength(out, literal_length - 15);
+  }
+  out->insert(out->end(), literals, literals + literal_length);
+  if (match_length == 0) {
+    return;
+  }
+  out->push_back(static_cast<char>(offset & 0xff));
+  out->push_back(static_cast<char>(offset >> 8));
+  if (match_code >= 15) {
+    PutLength(out, match_code - 15);
+  }
+}
+
+std::vector<char> Compress(const char *data, size_t size) {
+  std::vector<char> out;
+  out.reserve(size / 2 + 16);
+  // 每个 4 字节序列的哈希 -> 最近一次出现的位置 + 1，0 表示没有
+  std::vector<uint32_t> table(size_t{1} << HASH_BITS, 0);
+  size_t anchor = 0; // 还没输出的字面量从这里开始
+  size_t pos = 0;
+  while (pos + MIN_MATCH <= size) {
+    uint32_t v = Read32(data + pos);
+    size_t h = Hash(v);
+    size_t candidate = table[h];
+    table[h] = static_cast<uint32_t>(pos + 1);
+    if (candidate == 0 || pos - (candidate - 1) > MAX_OFFSET ||
+        Read32(data + candidate - 1) != v) {
+      pos++;
+      continue;
+    }
+    size_t match = candidate - 1;
+    size_t length = MIN_MATCH;
+    while (pos + length < size && data[match + length] == data[pos + length]) {
+      length++;
+    }
+    PutSequence(&out, data + anchor, pos - anchor, pos - match, length);
+    pos += length;
+    anchor = pos;
+  }
+  PutSequence(&out, data + anchor, size - anchor, 0, 0);
+  return out;
+}
+
+// 读一个长度的扩展部分，越界时返回 false
+static bool GetLength(const uint8_t **in, const uint8_t *end, size_t *length) {
+  uint8_t b;
+  do {
+    if (*in >= end) {
+      return false;
+    }
+    b = *(*in)++;
+    *length += b;
+  } while (b == 255);
+  return true;
+}
+
+bool Decompress(const char *data, size_t size, char *out, size_t out_size) {
+  const auto *in = reinterpret_cast<const uint8_t *>(data);
+  const uint8_t *end = in + size;
+  size_t written = 0;
+  // 最后一个序列只有字面量，没读到它就是被截断了
+  while (true) {
+    if (in >= end) {
+      return false;
+    }
+    uint8_t token = *in++;
+    size_t literal_length = token >> 4;
+    if (literal_length == 15 && !GetLength(&in, end, &literal_length)) {
+      return false;
+    }
+    if (literal_length > static_cast<size_t>(end - in) ||
+        literal_length > out_size - written) {
+      return false;
+    }
+    std::memcpy(out + written, in, literal_length);
+    in += literal_length;
+    written += literal_length;
+    if (in == end) {
+      return written == out_size;
+    }
+    if (end - in < 2) {
+      return false;
+    }
+    size_t offset = in[0] | (static_cast<size_t>(in[1]) << 8);
+    in += 2;
+    size_t match_length = token & 0xf;
+    if (match_length == 15 && !GetLength(&in, end, &match_length)) {
+      return false;
+    }
+    match_length += MIN_MATCH;
+    if (offset == 0 || offset > written ||
+        match_length > out_size - written) {
+      return false;
+    }
+    // 匹配可以和自己重叠（offset < 长度），只能逐字节拷贝
+    for (size_t i = 0; i < match_length; ++i) {
+      out[written + i] = out[written - offset + i];
+    }
+    written += match_length;
+  }
+}
+
+} // namespace mini
@@ -12,6 +12,20 @@ PageGuard::PageGuard(PageGuard &&other) noexcept
   other.page_ = nullptr;
 }
 
+PageGuard &PageGuard::operator=(PageGuard &&other) noexcept {
+  if (this != &other) {
+    if (page_ != nullptr) {
+      bpm_->UnpinPage(pid_, dirty_);
+    }
+    bpm_ = other.bpm_;
+    pid_ = other.pid_;
+    page_ = other.page_;
+    dirty_ = other.dirty_;
+    other.page_ = nullptr;
+  }
+  return *this;
+}
+
 PageGuard::~PageGuard() {
   if (page_ != nullptr) {
     bpm_->UnpinPage(pid_, dirty_);
@@ -0,0 +1,375 @@
+#include "concurrency/lock_manager.h"
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <unordered_set>
+
+namespace mini {
+
+LockManager::LockManager(std::chrono::milliseconds detection_interval,
+                         size_t partitions) {
+  assert(partitions > 0);
+  for (size_t i = 0; i < partitions; ++i) {
+    partitions_.push_back(std::make_unique<Partition>());
+  }
+  if (detection_interval.count() > 0) {
+    detection_thread_ =
+        std::thread(&LockManager::DetectionThread, this, detection_interval);
+  }
+}
+
+LockManager::~LockManager() {
+  {
+    std::lock_guard<std::mutex> guard(detection_latch_);
+    running_ = false;
+  }
+  detection_cv_.notify_one();
+  if (detection_thread_.joinable()) {
+    detection_thread_.join();
+  }
+}
+
+bool LockManager::Compatible(LockMode a, LockMode b) {
+  // 行列顺序和 LockMode 的定义一致：IS, IX, S, SIX, X
+  static constexpr bool MATRIX[5][5] = {
+      {true, true, true, true, false},
+      {true, true, false, false, false},
+      {true, false, true, false, false},
+      {true, false, false, false, false},
+      {false, false, false, false, false},
+  };
+  return MATRIX[static_cast<int>(a)][static_cast<int>(b)];
+}
+
+LockMode LockManager::Combine(LockMode a, LockMode b) {
+  if (a == b) {
+    return a;
+  }
+  if (a == LockMode::EXCLUSIVE || b == LockMode::EXCLUSIVE) {
+    return LockMode::EXCLUSIVE;
+  }
+  // IS 被其余的锁覆盖；剩下的两两组合（IX/S/SIX）都是 SIX
+  if (a == LockMode::INTENTION_SHARED) {
+    return b;
+  }
+  if (b == LockMode::INTENTION_SHARED) {
+    return a;
+  }
+  return LockMode::SHARED_INTENTION_EXCLUSIVE;
+}
+
+LockManager::Partition &LockManager::PartitionOf(int32_t table_id) {
+  return *partitions_[std::hash<int32_t>()(table_id) % partitions_.size()];
+}
+
+LockManager::Partition &LockManager::PartitionOf(const RID &rid) {
+  return *partitions_[std::hash<RID>()(rid) % partitions_.size()];
+}
+
+void LockManager::LockTable(Transaction *txn, LockMode mode,
+                            int32_t table_id) {
+  auto &held_locks = txn->GetTableLocks();
+  auto held = held_locks.find(table_id);
+  if (held != held_locks.end()) {
+    mode = Combine(held->second, mode);
+    if (mode == held->second) {
+      return;
+    }
+  }
+  Partition &partition = PartitionOf(table_id);
+  std::unique_lock<std::mutex> guard(partition.latch);
+  LockQueue &queue = partition.tables[table_id];
+  try {
+    Acquire(guard, queue, txn, mode,
+            held == held_locks.end() ? nullptr : &held->second);
+  } catch (const TransactionAbortException &) {
+    if (queue.requests.empty()) {
+      partition.tables.erase(table_id);
+    }
+    held_locks.erase(table_id);
+    throw;
+  }
+  held_locks[table_id] = mode;
+}
+
+void LockManager::LockRow(Transaction *txn, LockMode mode, int32_t table_id,
+                          const RID &rid) {
+  assert(mode == LockMode::SHARED || mode == LockMode::EXCLUSIVE);
+  auto &table_locks = txn->GetTableLocks();
+  assert(table_locks.count(table_id) != 0);
+  assert(mode == LockMode::SHARED ||
+         table_locks.at(table_id) != LockMode::INTENTION_SHARED);
+  assert(mode == LockMode::SHARED ||
+         table_locks.at(table_id) != LockMode::SHARED);
+  (void)table_id;
+  (void)table_locks;
+
+  auto &held_locks = txn->GetRowLocks();
+  auto held = held_locks.find(rid);
+  if (held != held_locks.end()) {
+    mode = Combine(held->second, mode);
+    if (mode == held->second) {
+      return;
+    }
+  }
+  Partition &partition = PartitionOf(rid);
+  std::unique_lock<std::mutex> guard(partition.latch);
+  LockQueue &queue = partition.rows[rid];
+  try {
+    Acquire(guard, queue, txn, mode,
+            held == held_locks.end() ? nullptr : &held->second);
+  } catch (const TransactionAbortException &) {
+    if (queue.requests.empty()) {
+      partition.rows.erase(rid);
+    }
+    held_locks.erase(rid);
+    throw;
+  }
+  held_locks[rid] = mode;
+}
+
+void LockManager::Acquire(std::unique_lock<std::mutex> &guard,
+                          LockQueue &queue, Transaction *txn, LockMode mode,
+                          const LockMode *held) {
+  txn_id_t txn_id = txn->GetTxnId();
+  requests_++;
+  std::list<LockRequest>::iterator it;
+  if (held != nullptr) {
+    // 同一时间只允许一个升级，否则两个升级者一定互相等待
+    if (queue.upgrading != INVALID_TXN_ID) {
+      Release(queue, txn_id);
+      throw TransactionAbortException(txn_id, "upgrade conflict");
+    }
+    auto old = std::find_if(
+        queue.requests.begin(), queue.requests.end(),
+        [txn_id](const LockRequest &r) { return r.txn_id == txn_id; });
+    assert(old != queue.requests.end() && old->granted);
+    queue.requests.erase(old);
+    auto first_waiting = std::find_if(
+        queue.requests.begin(), queue.requests.end(),
+        [](const LockRequest &r) { return !r.granted; });
+    it = queue.requests.insert(first_waiting, {txn_id, mode});
+    queue.upgrading = txn_id;
+  } else {
+    it = queue.requests.insert(queue.requests.end(), {txn_id, mode});
+  }
+
+  if (!Grantable(queue, it)) {
+    auto start = std::chrono::steady_clock::now();
+    queue.cv.wait(guard, [&] { return it->aborted || Grantable(queue, it); });
+    RecordWait(std::chrono::steady_clock::now() - start);
+    if (it->aborted) {
+      queue.requests.erase(it);
+      if (queue.upgrading == txn_id) {
+        queue.upgrading = INVALID_TXN_ID;
+      }
+      // 后面的等待者可能因此可以授予
+      queue.cv.notify_all();
+      throw TransactionAbortException(txn_id, "deadlock");
+    }
+    // 后面兼容的等待者可能和它一起被唤醒过，当时它还没授予又睡了，
+    // 要再叫醒一次；它们要等这里放掉分区锁才会检查
+    if (std::next(it) != queue.requests.end()) {
+      queue.cv.notify_all();
+    }
+  }
+  it->granted = true;
+  if (queue.upgrading == txn_id) {
+    queue.upgrading = INVALID_TXN_ID;
+  }
+}
+
+bool LockManager::Grantable(const LockQueue &queue,
+                            std::list<LockRequest>::const_iterator it) {
+  // 排在前面的请求都已授予并且兼容，后面的请求不会挡住它
+  for (auto r = queue.requests.begin(); r != it; ++r) {
+    if (!r->granted || !Compatible(r->mode, it->mode)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void LockManager::Release(LockQueue &queue, txn_id_t txn_id) {
+  auto it = std::find_if(
+      queue.requests.begin(), queue.requests.end(),
+      [txn_id](const LockRequest &r) { return r.txn_id == txn_id; });
+  if (it != queue.requests.end()) {
+    queue.requests.erase(it);
+    queue.cv.notify_all();
+  }
+}
+
+void LockManager::ReleaseAll(Transaction *txn) {
+  txn_id_t txn_id = txn->GetTxnId();
+  for (const auto &[rid, mode] : txn->GetRowLocks()) {
+    Partition &partition = PartitionOf(rid);
+    std::lock_guard<std::mutex> guard(partition.latch);
+    auto queue = partition.rows.find(rid);
+    assert(queue != partition.rows.end());
+    Release(queue->second, txn_id);
+    if (queue->second.requests.empty()) {
+      partition.rows.erase(queue);
+    }
+  }
+  txn->GetRowLocks().clear();
+  for (const auto &[table_id, mode] : txn->GetTableLocks()) {
+    Partition &partition = PartitionOf(table_id);
+    std::lock_guard<std::mutex> guard(partition.latch);
+    auto queue = partition.tables.find(table_id);
+    assert(queue != partition.tables.end());
+    Release(queue->second, txn_id);
+    if (queue->second.requests.empty()) {
+      partition.tables.erase(queue);
+    }
+  }
+  txn->GetTableLocks().clear();
+}
+
+void LockManager::CollectEdges(
+    const LockQueue &queue, const WaitPoint &point,
+    std::unordered_map<txn_id_t, std::vector<txn_id_t>> *graph,
+    std::unordered_map<txn_id_t, WaitPoint> *waiting) {
+  for (auto w = queue.requests.begin(); w != queue.requests.end(); ++w) {
+    if (w->granted || w->aborted) {
+      continue;
+    }
+    (*waiting)[w->txn_id] = point;
+    // 按 Grantable 的规则，挡住它的是前面不兼容或者还在等的请求
+    for (auto r = queue.requests.begin(); r != w; ++r) {
+      if (!r->granted || !Compatible(r->mode, w->mode)) {
+        (*graph)[w->txn_id].push_back(r->txn_id);
+      }
+    }
+  }
+}
+
+size_t LockManager::DetectDeadlocks() {
+  // 各分区依次拷贝，不同时持有两把分区锁。真正的死锁不会自己消失，
+  // 拷贝期间变化的只是不构成死锁的等待
+  std::unordered_map<txn_id_t, std::vector<txn_id_t>> graph;
+  std::unordered_map<txn_id_t, WaitPoint> waiting;
+  for (size_t i = 0; i < partitions_.size(); ++i) {
+    Partition &partition = *partitions_[i];
+    std::lock_guard<std::mutex> guard(partition.latch);
+    for (const auto &[table_id, queue] : partition.tables) {
+      CollectEdges(queue, {i, false, table_id, RID{}}, &graph, &waiting);
+    }
+    for (const auto &[rid, queue] : partition.rows) {
+      CollectEdges(queue, {i, true, 0, rid}, &graph, &waiting);
+    }
+  }
+  // 按事务号从小到大搜索，结果和哈希表的遍历顺序无关
+  std::vector<txn_id_t> nodes;
+  for (auto &[txn_id, edges] : graph) {
+    nodes.push_back(txn_id);
+    std::sort(edges.begin(), edges.end());
+  }
+  std::sort(nodes.begin(), nodes.end());
+
+  std::unordered_set<txn_id_t> removed;
+  size_t victims = 0;
+  while (true) {
+    // 深度优先找环，找到时返回环上最大的事务号
+    std::unordered_set<txn_id_t> visited;
+    std::vector<txn_id_t> path;
+    std::unordered_set<txn_id_t> on_path;
+    txn_id_t victim = INVALID_TXN_ID;
+    std::function<bool(txn_id_t)> dfs = [&](txn_id_t node) {
+      visited.insert(node);
+      path.push_back(node);
+      on_path.insert(node);
+      auto edges = graph.find(node);
+      if (edges != graph.end()) {
+        for (txn_id_t next : edges->second) {
+          if (removed.count(next) != 0) {
+            continue;
+          }
+          if (on_path.count(next) != 0) {
+            auto begin = std::find(path.begin(), path.end(), next);
+            victim = *std::max_element(begin, path.end());
+            return true;
+          }
+          if (visited.count(next) == 0 && dfs(next)) {
+            return true;
+          }
+        }
+      }
+      path.pop_back();
+      on_path.erase(node);
+      return false;
+    };
+    for (txn_id_t node : nodes) {
+      if (removed.count(node) == 0 && visited.count(node) == 0 &&
+          dfs(node)) {
+        break;
+      }
+    }
+    if (victim == INVALID_TXN_ID) {
+      break;
+    }
+    removed.insert(victim);
+    AbortWaiter(victim, waiting.at(victim));
+    victims++;
+  }
+  return victims;
+}
+
+void LockManager::AbortWaiter(txn_id_t txn_id, const WaitPoint &point) {
+  Partition &partition = *partitions_[point.partition];
+  std::lock_guard<std::mutex> guard(partition.latch);
+  LockQueue *queue = nullptr;
+  if (point.is_row) {
+    auto it = partition.rows.find(point.rid);
+    queue = it == partition.rows.end() ? nullptr : &it->second;
+  } else {
+    auto it = partition.tables.find(point.table_id);
+    queue = it == partition.tables.end() ? nullptr : &it->second;
+  }
+  if (queue == nullptr) {
+    return;
+  }
+  for (auto &request : queue->requests) {
+    if (request.txn_id == txn_id && !request.granted) {
+      // 在唤醒之前计数，牺牲者醒来时统计里已经有这次死锁
+      deadlocks_++;
+      request.aborted = true;
+      queue->cv.notify_all();
+      return;
+    }
+  }
+}
+
+void LockManager::RecordWait(std::chrono::steady_clock::duration waited) {
+  double ms = std::chrono::duration<double, std::milli>(waited).count();
+  std::lock_guard<std::mutex> guard(stats_latch_);
+  waits_++;
+  wait_millis_ += ms;
+  max_wait_millis_ = std::max(max_wait_millis_, ms);
+}
+
+LockStats LockManager::GetStats() const {
+  LockStats stats;
+  stats.requests = requests_.load();
+  stats.deadlocks = deadlocks_.load();
+  std::lock_guard<std::mutex> guard(stats_latch_);
+  stats.waits = waits_;
+  stats.wait_millis = wait_millis_;
+  stats.max_wait_millis = max_wait_millis_;
+  return stats;
+}
+
+void LockManager::DetectionThread(std::chrono::milliseconds interval) {
+  std::unique_lock<std::mutex> guard(detection_latch_);
+  while (running_) {
+    detection_cv_.wait_for(guard, interval);
+    if (!running_) {
+      break;
+    }
+    guard.unlock();
+    DetectDeadlocks();
+    guard.lock();
+  }
+}
+
+} // namespace mini
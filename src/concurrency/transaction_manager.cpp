@@ -0,0 +1,169 @@
+#include "concurrency/transaction_manager.h"
+#include "index/index.h"
+#include "storage/table_heap.h"
+#include <algorithm>
+#include <cassert>
+
+namespace mini {
+
+Transaction *TransactionManager::Begin(ConcurrencyMode mode) {
+  Transaction *raw;
+  {
+    std::lock_guard<std::mutex> guard(latch_);
+    auto txn = std::make_unique<Transaction>(next_txn_id_, mode);
+    txn->SetSnapshot(TakeSnapshot(next_txn_id_));
+    next_txn_id_++;
+    raw = txn.get();
+    txns_.emplace(raw->GetTxnId(), std::move(txn));
+  }
+  AppendTxnRecord(raw, LogRecordType::BEGIN);
+  return raw;
+}
+
+void TransactionManager::Commit(Transaction *txn) {
+  assert(txn->GetState() == TransactionState::RUNNING);
+  if (!Validate(txn)) {
+    txn_id_t txn_id = txn->GetTxnId();
+    Abort(txn);
+    throw TransactionAbortException(txn_id, "validation failed");
+  }
+  lsn_t lsn = AppendTxnRecord(txn, LogRecordType::COMMIT);
+  if (lsn != INVALID_LSN) {
+    log_manager_->Flush(lsn);
+  }
+  txn->SetState(TransactionState::COMMITTED);
+  // Release 之后 txn 就释放了
+  std::vector<std::function<void()>> actions =
+      std::move(txn->GetCommitActions());
+  Release(txn);
+  for (const auto &action : actions) {
+    action();
+  }
+}
+
+void TransactionManager::Abort(Transaction *txn) {
+  assert(txn->GetState() == TransactionState::RUNNING);
+  RollbackTo(txn, 0);
+  // ABORT 不用等落盘：丢了的话恢复时沿 CLR 发现已经没有要撤销的了
+  AppendTxnRecord(txn, LogRecordType::ABORT);
+  txn->SetState(TransactionState::ABORTED);
+  Release(txn);
+}
+
+void TransactionManager::RollbackTo(Transaction *txn, size_t savepoint) {
+  auto &write_set = txn->GetWriteSet();
+  assert(savepoint <= write_set.size());
+  while (write_set.size() > savepoint) {
+    Undo(txn, write_set.back());
+    write_set.pop_back();
+  }
+}
+
+Snapshot TransactionManager::GetSnapshot() {
+  std::lock_guard<std::mutex> guard(latch_);
+  return TakeSnapshot(INVALID_TXN_ID);
+}
+
+txn_id_t TransactionManager::GetGcHorizon() {
+  std::lock_guard<std::mutex> guard(latch_);
+  txn_id_t horizon = next_txn_id_;
+  for (const auto &[txn_id, txn] : txns_) {
+    horizon = std::min(horizon, txn->GetSnapshot().xmin);
+  }
+  return horizon;
+}
+
+size_t TransactionManager::GetActiveCount() {
+  std::lock_guard<std::mutex> guard(latch_);
+  return txns_.size();
+}
+
+lsn_t TransactionManager::AppendTxnRecord(Transaction *txn,
+                                          LogRecordType type) {
+  if (log_manager_ == nullptr) {
+    return INVALID_LSN;
+  }
+  LogRecord record(txn->GetTxnId(), txn->GetPrevLSN(), type);
+  lsn_t lsn = log_manager_->AppendLogRecord(&record);
+  txn->SetPrevLSN(lsn);
+  return lsn;
+}
+
+void TransactionManager::Undo(Transaction *txn, const WriteRecord &write) {
+  // 补偿操作本身照常写日志
+  if (write.index != nullptr) {
+    if (write.type == WriteType::INSERT) {
+      write.index->DeleteEntry(write.tuple, write.rid, txn);
+    } else {
+      write.index->InsertEntry(write.tuple, write.rid, txn);
+    }
+  } else if (write.type == WriteType::INSERT) {
+    write.table->ApplyDelete(write.rid, txn);
+  } else {
+    write.table->RollbackDelete(write.rid, txn);
+  }
+  if (log_manager_ != nullptr) {
+    LogRecord clr(txn->GetTxnId(), txn->GetPrevLSN(), write.undo_next);
+    txn->SetPrevLSN(log_manager_->AppendLogRecord(&clr));
+  }
+}
+
+bool TransactionManager::Validate(Transaction *txn) {
+  std::vector<RID> writes;
+  for (const auto &write : txn->GetWriteSet()) {
+    if (write.index == nullptr) {
+      writes.push_back(write.rid);
+    }
+  }
+  std::lock_guard<std::mutex> guard(validation_latch_);
+  if (txn->GetMode() == ConcurrencyMode::OPTIMISTIC) {
+    const Snapshot &snapshot = txn->GetSnapshot();
+    const auto &reads = txn->GetReadSet();
+    for (const auto &committed : committed_writes_) {
+      if (snapshot.Sees(committed.txn_id)) {
+        continue;
+      }
+      for (const RID &rid : committed.rids) {
+        if (reads.count(rid) != 0 ||
+            std::find(writes.begin(), writes.end(), rid) != writes.end()) {
+          return false;
+        }
+      }
+    }
+  }
+  // 所有活跃事务都看得到的提交不会再让谁验证失败
+  txn_id_t horizon = GetGcHorizon();
+  committed_writes_.erase(
+      std::remove_if(committed_writes_.begin(), committed_writes_.end(),
+                     [horizon](const CommittedWrites &committed) {
+                       return committed.txn_id < horizon;
+                     }),
+      committed_writes_.end());
+  if (!writes.empty()) {
+    committed_writes_.push_back({txn->GetTxnId(), std::move(writes)});
+  }
+  return true;
+}
+
+void TransactionManager::Release(Transaction *txn) {
+  if (lock_manager_ != nullptr) {
+    lock_manager_->ReleaseAll(txn);
+  }
+  std::lock_guard<std::mutex> guard(latch_);
+  txns_.erase(txn->GetTxnId());
+}
+
+Snapshot TransactionManager::TakeSnapshot(txn_id_t own) {
+  Snapshot snapshot;
+  snapshot.xmax = next_txn_id_;
+  snapshot.xmin = next_txn_id_;
+  snapshot.own = own;
+  for (const auto &[txn_id, txn] : txns_) {
+    snapshot.active.push_back(txn_id);
+    snapshot.xmin = std::min(snapshot.xmin, txn_id);
+  }
+  std::sort(snapshot.active.begin(), snapshot.active.end());
+  return snapshot;
+}
+
+} // namespace mini
@@ -3,32 +3,40 @@
 #include "catalog/catalog.h"
 #include "catalog/column.h"
 #include "parser/statement.h"
+#include "planner/planner.h"
 #include "storage/tuple.h"
 #include "type/data_type.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
 #include <cstdint>
+#include <cstdio>
 #include <cstring>
 #include <iostream>
 #include <memory>
 #include <stdexcept>
+#include <tuple>
 #include <vector>
 
 namespace mini {
 
 void InsertExecutor::Init() { done_ = false; }
 
-bool InsertExecutor::Next(Tuple *) {
-  if (done_)
-    return false;
+Tuple InsertExecutor::BuildTuple(size_t row) const {
   // TODO: 支持错误处理,以及非全量数据
   auto schema = bound_insert_stmt_->Table()->schema;
   const auto &columns = schema->GetColumns();
 
+  // Binder 已经检查过，这里防止直接构造的语句越界
+  if (bound_insert_stmt_->ValueCount(row) != columns.size()) {
+    throw std::runtime_error("InsertExecutor: value count mismatch");
+  }
   uint32_t len = schema->GetTupleLength();
   Tuple tuple;
   char *buf = tuple.Resize(len);
-  for (size_t i = 0; i < bound_insert_stmt_->ValueCount(); ++i) {
+  for (size_t i = 0; i < bound_insert_stmt_->ValueCount(row); ++i) {
     auto col = columns[i];
-    const Value *value = bound_insert_stmt_->ValueAt(i);
+    const Value *value = bound_insert_stmt_->ValueAt(row, i);
     switch (value->Type()) {
     case DataType::INTEGER: {
       const IntValue *intv = dynamic_cast<const IntValue *>(value);
@@ -53,59 +61,582 @@ bool InsertExecutor::Next(Tuple *) {
     }
     }
   }
-  auto rid = bound_insert_stmt_->Table()->table->InsertTuple(tuple);
+  return tuple;
+}
 
-  auto indexes =
-      Context().GetCatalog().GetIndexes(bound_insert_stmt_->Table()->name);
-  for (const auto &index : indexes) {
-    index->index->InsertEntry(tuple, rid);
+bool InsertExecutor::Next(Tuple *) {
+  if (done_)
+    return false;
+  std::vector<Tuple> tuples;
+  for (size_t row = 0; row < bound_insert_stmt_->RowCount(); ++row) {
+    tuples.push_back(BuildTuple(row));
+  }
+  TableInfo *table = bound_insert_stmt_->Table();
+  // 不在显式事务里时这条 INSERT 自成一个事务，提交时等日志落盘
+  auto &txn_manager = Context().GetTransactionManager();
+  Transaction *txn = Context().GetTransaction();
+  bool autocommit = txn == nullptr;
+  if (autocommit) {
+    txn = txn_manager.Begin(Context().GetConcurrencyMode());
+  }
+  // 表上加 IX，新行加 X，直到事务结束才放。读走快照，不加锁
+  LockManager *lock_manager = txn->GetMode() == ConcurrencyMode::LOCKING
+                                  ? txn_manager.GetLockManager()
+                                  : nullptr;
+  if (lock_manager != nullptr) {
+    try {
+      lock_manager->LockTable(txn, LockMode::INTENTION_EXCLUSIVE,
+                              table->table_id);
+    } catch (const TransactionAbortException &) {
+      // 加锁失败的事务整个回滚，显式事务也随之结束
+      txn_manager.Abort(txn);
+      Context().SetTransaction(nullptr);
+      throw;
+    }
+  }
+  size_t savepoint = txn->GetWriteSet().size();
+  // 多行的 INSERT 在堆上一页只写一条日志
+  std::vector<lsn_t> heap_undo_next;
+  auto rids = table->table->InsertTuples(tuples, txn, &heap_undo_next);
+  for (size_t row = 0; row < rids.size(); ++row) {
+    txn->AppendWrite({WriteType::INSERT, table->table.get(), nullptr,
+                      rids[row], Tuple(), heap_undo_next[row]});
+    if (lock_manager != nullptr) {
+      // 新行别的事务还看不到，不会等待
+      lock_manager->LockRow(txn, LockMode::EXCLUSIVE, table->table_id,
+                            rids[row]);
+    }
   }
 
+  auto &indexes = Context().GetCatalog().GetIndexes(table->name);
+  for (size_t row = 0; row < rids.size(); ++row) {
+    for (const auto &index : indexes) {
+      lsn_t undo_next = txn->GetPrevLSN();
+      if (!index->index->InsertEntry(tuples[row], rids[row], txn)) {
+        // 唯一约束冲突：只撤销这条语句的修改，显式事务继续
+        if (autocommit) {
+          txn_manager.Abort(txn);
+        } else {
+          txn_manager.RollbackTo(txn, savepoint);
+        }
+        throw std::runtime_error("duplicate key violates unique index " +
+                                 index->index_name);
+      }
+      txn->AppendWrite({WriteType::INSERT, table->table.get(),
+                        index->index.get(), rids[row], tuples[row],
+                        undo_next});
+    }
+  }
+
+  // 统计信息跟着插入的行更新，不用每次都重新 ANALYZE。只记提交了的，
+  // 回滚或者乐观事务验证失败时不算
+  if (auto statistics = std::atomic_load(&table->statistics)) {
+    txn->OnCommit([statistics, schema = table->schema,
+                   tuples = std::move(tuples)] {
+      statistics->RecordInsert(*schema, tuples);
+    });
+  }
+  if (autocommit) {
+    // 乐观事务验证失败时已经回滚
+    txn_manager.Commit(txn);
+  }
   return done_ = true;
 }
 
+// EXPLAIN ANALYZE 时量一段执行，把时间和这期间缓冲池的命中、缺页加到
+// 每个 actual 上。actual 为空时什么也不做
+class ActualTimer {
+public:
+  ActualTimer(ExecutionContext &context, PlanActual *actual)
+      : pool_(context.GetCatalog().GetBufferPool()) {
+    if (actual != nullptr) {
+      actuals_.push_back(actual);
+      Start();
+    }
+  }
+  ActualTimer(ExecutionContext &context, std::vector<PlanActual *> actuals)
+      : actuals_(std::move(actuals)),
+        pool_(context.GetCatalog().GetBufferPool()) {
+    if (!actuals_.empty()) {
+      Start();
+    }
+  }
+  ~ActualTimer() { Stop(); }
+
+  void Stop() {
+    if (actuals_.empty()) {
+      return;
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start_;
+    size_t misses = pool_->GetMissCount() - misses_;
+    size_t hits = pool_->GetFetchCount() - fetches_ - misses;
+    for (PlanActual *actual : actuals_) {
+      actual->ms += std::chrono::duration<double, std::milli>(elapsed).count();
+      actual->hits += hits;
+      actual->misses += misses;
+    }
+    actuals_.clear();
+  }
+
+private:
+  void Start() {
+    fetches_ = pool_->GetFetchCount();
+    misses_ = pool_->GetMissCount();
+    start_ = std::chrono::steady_clock::now();
+  }
+
+  std::vector<PlanActual *> actuals_;
+  BufferPool *pool_;
+  size_t fetches_{0};
+  size_t misses_{0};
+  std::chrono::steady_clock::time_point start_;
+};
+
+// 包在聚合、排序这些算子外面，记下它们的实际执行情况
+class InstrumentedExecutor : public Executor {
+public:
+  InstrumentedExecutor(ExecutionContext &context,
+                       std::unique_ptr<Executor> child, PlanActual *actual)
+      : Executor(context), child_(std::move(child)), actual_(actual) {}
+
+  void Init() override {
+    ActualTimer timer(Context(), actual_);
+    actual_->loops++;
+    child_->Init();
+  }
+  bool Next(Tuple *tuple) override {
+    ActualTimer timer(Context(), actual_);
+    bool found = child_->Next(tuple);
+    actual_->rows += found;
+    return found;
+  }
+  std::shared_ptr<Schema> GetSchema() const override {
+    return child_->GetSchema();
+  }
+
+private:
+  std::unique_ptr<Executor> child_;
+  PlanActual *actual_;
+};
+
+class SelectExecutor::RowSource : public Executor {
+public:
+  RowSource(ExecutionContext &context, SelectExecutor *select)
+      : Executor(context), select_(select) {}
+
+  void Init() override {}
+  bool Next(Tuple *tuple) override { return select_->NextRow(tuple); }
+  std::shared_ptr<Schema> GetSchema() const override {
+    return select_->bound_select_stmt_->GetScanSchema();
+  }
+
+private:
+  SelectExecutor *select_;
+};
+
+static int32_t ReadInt(const Tuple &tuple, uint32_t offset) {
+  int32_t value;
+  memcpy(&value, tuple.Data() + offset, sizeof(int32_t));
+  return value;
+}
+
+// 把 columns 这些列按顺序紧挨着拷到 out
+static void ProjectRow(const Tuple &row, const std::vector<Column> &columns,
+                       Tuple *out) {
+  uint32_t length = 0;
+  for (const Column &col : columns) {
+    length += col.length;
+  }
+  char *buf = out->Resize(length);
+  for (const Column &col : columns) {
+    memcpy(buf, row.Data() + col.offset, col.length);
+    buf += col.length;
+  }
+  out->SetRid(row.GetRid());
+}
+
+// 连接输出的 schema：左边的列接上右边的列
+static std::shared_ptr<Schema> JoinSchema(const Schema &left,
+                                          const Schema &right) {
+  std::vector<Column> columns = left.GetColumns();
+  for (Column column : right.GetColumns()) {
+    column.offset += left.GetTupleLength();
+    columns.push_back(std::move(column));
+  }
+  return std::make_shared<Schema>(std::move(columns));
+}
+
+SelectExecutor::SelectExecutor(ExecutionContext &context,
+                               std::unique_ptr<BoundSelectStatement> bstat,
+                               PlanNode *plan, bool analyze)
+    : Executor(context), bound_select_stmt_(std::move(bstat)), plan_(plan),
+      analyze_(analyze) {
+  if (plan_ == nullptr) {
+    own_plan_ = Planner(context).PlanSelect(*bound_select_stmt_);
+    plan_ = own_plan_.get();
+  }
+  const BoundAggregation *aggregation = bound_select_stmt_->Aggregation();
+  if (bound_select_stmt_->IsCountStar()) {
+    output_schema_ = std::make_shared<Schema>();
+    output_schema_->AddColumn("count", DataType::INTEGER);
+  } else if (aggregation != nullptr) {
+    output_schema_ = aggregation->schema;
+  } else if (bound_select_stmt_->Projection() != nullptr) {
+    output_schema_ = bound_select_stmt_->Projection();
+  } else {
+    output_schema_ = bound_select_stmt_->GetSchema();
+  }
+  const auto &scan_columns = bound_select_stmt_->ScanColumns();
+  for (uint32_t column : scan_columns) {
+    scan_columns_.push_back(bound_select_stmt_->GetSchema()->GetColumn(column));
+  }
+  if (bound_select_stmt_->HasWhere()) {
+    uint32_t where = bound_select_stmt_->WhereColumnId();
+    auto it = std::find(scan_columns.begin(), scan_columns.end(), where);
+    where_offset_ =
+        it == scan_columns.end()
+            ? bound_select_stmt_->Table()->schema->GetColumn(where).offset
+            : bound_select_stmt_->GetScanSchema()
+                  ->GetColumn(it - scan_columns.begin())
+                  .offset;
+  }
+
+  // 从根往下走到产生行的扫描或连接，记下路过的节点
+  PlanNode *aggregate_node = nullptr;
+  PlanNode *order = nullptr;
+  PlanNode *projection = nullptr;
+  input_ = plan_;
+  while (!input_->IsScan() && !input_->IsJoin()) {
+    switch (input_->type) {
+    case PlanType::COUNT:
+      count_node_ = input_;
+      break;
+    case PlanType::HASH_AGGREGATE:
+      aggregate_node = input_;
+      break;
+    case PlanType::SORT:
+    case PlanType::TOP_N:
+      order = input_;
+      break;
+    case PlanType::PROJECTION:
+      projection = input_;
+      break;
+    case PlanType::LIMIT:
+      limit_node_ = input_;
+      break;
+    default:
+      break;
+    }
+    input_ = input_->Child();
+  }
+  if (BoundJoin *join = bound_select_stmt_->Join()) {
+    BuildJoin(join, input_);
+  }
+  if (aggregation != nullptr) {
+    auto aggregate = std::make_unique<HashAggregateExecutor>(
+        context, std::make_unique<RowSource>(context, this), *aggregation);
+    aggregate_ = aggregate.get();
+    top_ = Instrument(std::move(aggregate), aggregate_node);
+  }
+  if (order != nullptr) {
+    std::unique_ptr<Executor> child =
+        top_ != nullptr ? std::move(top_)
+                        : std::make_unique<RowSource>(context, this);
+    const auto &order_by = bound_select_stmt_->OrderBy();
+    if (order->type == PlanType::TOP_N) {
+      auto top_n = std::make_unique<TopNExecutor>(context, std::move(child),
+                                                  order_by, order->limit);
+      top_n_ = top_n.get();
+      top_ = Instrument(std::move(top_n), order);
+    } else {
+      auto sort =
+          std::make_unique<SortExecutor>(context, std::move(child), order_by);
+      sort_ = sort.get();
+      top_ = Instrument(std::move(sort), order);
+    }
+  }
+  // 只给 ORDER BY 和 WHERE 用的列排完序后去掉
+  if (projection != nullptr) {
+    std::unique_ptr<Executor> child =
+        top_ != nullptr ? std::move(top_)
+                        : std::make_unique<RowSource>(context, this);
+    std::vector<uint32_t> columns(output_schema_->GetColumnCount());
+    for (uint32_t i = 0; i < columns.size(); ++i) {
+      columns[i] = i;
+    }
+    top_ = Instrument(std::make_unique<ProjectionExecutor>(
+                          context, std::move(child), columns),
+                      projection);
+  }
+}
+
+std::unique_ptr<Executor>
+SelectExecutor::Instrument(std::unique_ptr<Executor> executor,
+                           PlanNode *node) {
+  if (!analyze_) {
+    return executor;
+  }
+  return std::make_unique<InstrumentedExecutor>(
+      Context(), std::move(executor), &node->actual);
+}
+
+void SelectExecutor::SetSnapshot(const Snapshot &snapshot) {
+  snapshot_ = snapshot;
+  has_snapshot_ = true;
+}
+
+void SelectExecutor::BuildJoin(BoundJoin *join, PlanNode *node) {
+  if (node->type == PlanType::INDEX_NESTED_LOOP_JOIN) {
+    bool outer_left = node->left_first;
+    auto outer = std::make_unique<SelectExecutor>(
+        Context(), std::move(outer_left ? join->left : join->right),
+        node->Child(outer_left ? 0 : 1), analyze_);
+    (outer_left ? left_scan_ : right_scan_) = outer.get();
+    inner_node_ = node->Child(outer_left ? 1 : 0);
+    IndexInfo *inner_index = inner_node_->index;
+    auto index_join = std::make_unique<IndexNestedLoopJoinExecutor>(
+        Context(), std::move(outer),
+        outer_left ? join->left_column : join->right_column,
+        std::move(outer_left ? join->right : join->left), inner_index,
+        outer_left);
+    index_join_ = index_join.get();
+    join_ = std::move(index_join);
+    return;
+  }
+
+  bool merge = node->type == PlanType::SORT_MERGE_JOIN;
+  auto left = std::make_unique<SelectExecutor>(
+      Context(), std::move(join->left), node->Child(0), analyze_);
+  auto right = std::make_unique<SelectExecutor>(
+      Context(), std::move(join->right), node->Child(1), analyze_);
+  left_scan_ = left.get();
+  right_scan_ = right.get();
+  if (merge) {
+    join_ = std::make_unique<SortMergeJoinExecutor>(
+        Context(), std::move(left), std::move(right), join->left_column,
+        join->right_column);
+    return;
+  }
+  join_ = std::make_unique<HashJoinExecutor>(
+      Context(), std::move(left), std::move(right), join->left_column,
+      join->right_column, node->left_first);
+}
+
 void SelectExecutor::Init() {
+  // LIMIT 在最外层，Init 的时间都算它的
+  ActualTimer limit_timer(
+      Context(), analyze_ && limit_node_ != nullptr ? &limit_node_->actual
+                                                    : nullptr);
+  // 准备扫描或连接的这段也算进上面的节点，它们自己的 Init 在这之后
+  std::vector<PlanActual *> setup;
+  if (analyze_) {
+    for (PlanNode *node = plan_; node != input_; node = node->Child()) {
+      if (node != limit_node_) {
+        setup.push_back(&node->actual);
+      }
+    }
+    setup.push_back(&input_->actual);
+  }
+  ActualTimer input_timer(Context(), std::move(setup));
+  if (analyze_) {
+    for (PlanNode *node : {input_, count_node_, limit_node_}) {
+      if (node != nullptr) {
+        node->actual.loops++;
+      }
+    }
+  }
   TableInfo *table = bound_select_stmt_->Table();
-  table_iter_ = table->table->Begin();
+  skipped_ = 0;
+  returned_ = 0;
+  Transaction *txn = Context().GetTransaction();
+  if (!has_snapshot_) {
+    snapshot_ = txn != nullptr
+                    ? txn->GetSnapshot()
+                    : Context().GetTransactionManager().GetSnapshot();
+  }
+  if (join_ != nullptr) {
+    // 两边用同一个快照，各自把读到的版本记进乐观事务的读集合
+    for (SelectExecutor *scan : {left_scan_, right_scan_}) {
+      if (scan != nullptr) {
+        scan->SetSnapshot(snapshot_);
+      }
+    }
+    if (index_join_ != nullptr) {
+      index_join_->SetSnapshot(snapshot_);
+    }
+    join_->Init();
+    inited_ = true;
+    input_timer.Stop();
+    if (top_ != nullptr) {
+      top_->Init();
+    }
+    return;
+  }
+  if (txn != nullptr && txn->GetMode() == ConcurrencyMode::OPTIMISTIC) {
+    optimistic_txn_ = txn;
+  }
+  table_iter_ = table->table->Begin(&snapshot_);
   end_ = table->table->End();
 
   if (bound_select_stmt_->HasWhere()) {
     auto index = bound_select_stmt_->Index();
-    if (index != nullptr) {
-      std::cout << "SelectExecutor: using index " << index->index_name << "\n";
+    if (input_->type != PlanType::SEQ_SCAN) {
       auto where_value = bound_select_stmt_->WhereValue();
-      if (const IntValue *int_val =
-              dynamic_cast<const IntValue *>(where_value)) {
-        index->index->ScanKey(*int_val, &index_scan_result_);
-      } else {
+      if (where_value->Type() != DataType::INTEGER) {
         throw std::runtime_error("Unsupported literal type in WHERE clause");
       }
+      use_index_ = true;
+      // COUNT(*) 走 CountKey，不需要取出 RID；表上有可能不可见的版本，
+      // 或者乐观事务要记下读到的版本时，还是要逐个取出
+      count_by_key_ = optimistic_txn_ == nullptr &&
+                      bound_select_stmt_->IsIndexOnly() &&
+                      bound_select_stmt_->IsCountStar() &&
+                      table->table->IsAllVisible();
+      if (!count_by_key_) {
+        index->index->ScanKey(*where_value, &index_scan_result_);
+      }
     }
   }
 
   inited_ = true;
+  input_timer.Stop();
+  if (top_ != nullptr) {
+    // 读完所有行聚合、排好序，之后从最上面取
+    top_->Init();
+  }
 }
 
 bool SelectExecutor::Next(Tuple *ret) {
   if (!inited_)
     return false;
+  if (!bound_select_stmt_->HasLimit()) {
+    return NextOutput(ret);
+  }
+  ActualTimer timer(Context(), analyze_ ? &limit_node_->actual : nullptr);
+  // 没有排序和聚合时扫描是一行一行拉的，够了就停，后面的页不会读
+  for (; skipped_ < bound_select_stmt_->Offset(); ++skipped_) {
+    if (!NextOutput(ret)) {
+      return false;
+    }
+  }
+  if (returned_ >= bound_select_stmt_->Limit() || !NextOutput(ret)) {
+    return false;
+  }
+  returned_++;
+  if (analyze_) {
+    limit_node_->actual.rows++;
+  }
+  return true;
+}
+
+bool SelectExecutor::NextOutput(Tuple *ret) {
+  if (top_ != nullptr) {
+    return top_->Next(ret);
+  }
+  if (!bound_select_stmt_->IsCountStar()) {
+    return NextRow(ret);
+  }
+
+  if (count_done_)
+    return false;
+  ActualTimer timer(Context(), analyze_ ? &count_node_->actual : nullptr);
+  int32_t count = 0;
+  if (count_by_key_) {
+    ActualTimer input_timer(Context(), analyze_ ? &input_->actual : nullptr);
+    count = static_cast<int32_t>(bound_select_stmt_->Index()->index->CountKey(
+        *bound_select_stmt_->WhereValue()));
+    if (analyze_) {
+      input_->actual.rows += count;
+    }
+  } else {
+    Tuple row;
+    while (NextRow(&row)) {
+      count++;
+    }
+  }
+  char *buf = ret->Resize(sizeof(int32_t));
+  memcpy(buf, &count, sizeof(int32_t));
+  count_done_ = true;
+  if (analyze_) {
+    count_node_->actual.rows = 1;
+  }
+  return true;
+}
 
-  if (!index_scan_result_.empty()) {
-    if (index_scan_pos_ >= index_scan_result_.size()) {
+bool SelectExecutor::NextRow(Tuple *ret) {
+  ActualTimer timer(Context(), analyze_ ? &input_->actual : nullptr);
+  if (!ScanRow(ret)) {
+    if (analyze_ && inner_node_ != nullptr) {
+      // 内表每查一次索引算一轮
+      inner_node_->actual.loops = index_join_->GetProbeCount();
+      inner_node_->actual.rows = input_->actual.rows;
+    }
+    return false;
+  }
+  if (analyze_) {
+    input_->actual.rows++;
+  }
+  if (optimistic_txn_ != nullptr) {
+    optimistic_txn_->AddRead(ret->GetRid());
+  }
+  return true;
+}
+
+bool SelectExecutor::ScanRow(Tuple *ret) {
+  if (join_ != nullptr) {
+    if (scan_columns_.empty()) {
+      return join_->Next(ret);
+    }
+    if (!join_->Next(&join_row_)) {
       return false;
     }
-    RID rid = index_scan_result_[index_scan_pos_++];
-    return bound_select_stmt_->Table()->table->GetTuple(rid, ret);
+    ProjectRow(join_row_, scan_columns_, ret);
+    return true;
+  }
+  if (use_index_) {
+    // 索引里有所有版本的项，跳过对快照不可见的
+    TableHeap *heap = bound_select_stmt_->Table()->table.get();
+    while (index_scan_pos_ < index_scan_result_.size()) {
+      RID rid = index_scan_result_[index_scan_pos_++];
+      if (bound_select_stmt_->IsIndexOnly()) {
+        // 要取的列都是索引键，记录就是 WHERE 里的值，
+        // 页全部可见时不用回表
+        if (!heap->IsAllVisible(rid.page_id) &&
+            !heap->IsVisible(rid, snapshot_)) {
+          continue;
+        }
+        auto int_val =
+            static_cast<const IntValue *>(bound_select_stmt_->WhereValue());
+        int32_t key = int_val->GetValue();
+        // 投影时每一列也都是这一列
+        size_t count = std::max<size_t>(scan_columns_.size(), 1);
+        char *buf = ret->Resize(count * sizeof(int32_t));
+        for (size_t i = 0; i < count; ++i) {
+          memcpy(buf + i * sizeof(int32_t), &key, sizeof(int32_t));
+        }
+        ret->SetRid(rid);
+        return true;
+      }
+      bool visible = scan_columns_.empty()
+                         ? heap->GetTuple(rid, ret, &snapshot_)
+                         : heap->GetTuple(rid, scan_columns_, ret, &snapshot_);
+      if (visible) {
+        return true;
+      }
+    }
+    return false;
   }
 
   while (table_iter_ != end_) {
-    *ret = *table_iter_;
+    // 只拷要用的列
+    if (scan_columns_.empty()) {
+      *ret = *table_iter_;
+    } else {
+      table_iter_.Read(scan_columns_, ret);
+    }
     if (bound_select_stmt_->HasWhere()) {
       auto where_value = bound_select_stmt_->WhereValue();
-      auto col_id = bound_select_stmt_->WhereColumnId();
-      const auto &col =
-          bound_select_stmt_->Table()->schema->GetColumns()[col_id];
-      const char *data = ret->Data() + col.offset;
+      const char *data = ret->Data() + where_offset_;
 
       if (where_value->Type() == DataType::INTEGER) {
         const IntValue *int_val = dynamic_cast<const IntValue *>(where_value);
@@ -128,6 +659,953 @@ bool SelectExecutor::Next(Tuple *ret) {
   return false;
 }
 
+HashJoinExecutor::HashJoinExecutor(ExecutionContext &context,
+                                   std::unique_ptr<Executor> left,
+                                   std::unique_ptr<Executor> right,
+                                   uint32_t left_column, uint32_t right_column,
+                                   bool build_left)
+    : Executor(context), left_(std::move(left)), right_(std::move(right)),
+      build_left_(build_left) {
+  auto left_schema = left_->GetSchema();
+  auto right_schema = right_->GetSchema();
+  uint32_t left_offset = left_schema->GetColumn(left_column).offset;
+  uint32_t right_offset = right_schema->GetColumn(right_column).offset;
+  build_ = build_left_ ? left_.get() : right_.get();
+  probe_ = build_left_ ? right_.get() : left_.get();
+  build_offset_ = build_left_ ? left_offset : right_offset;
+  probe_offset_ = build_left_ ? right_offset : left_offset;
+  schema_ = JoinSchema(*left_schema, *right_schema);
+}
+
+int32_t HashJoinExecutor::KeyOf(const Tuple &tuple, uint32_t offset) {
+  int32_t key;
+  memcpy(&key, tuple.Data() + offset, sizeof(int32_t));
+  return key;
+}
+
+size_t HashJoinExecutor::PartitionOf(int32_t key, size_t level,
+                                     size_t fanout) {
+  // 每一层用不同的哈希，上一层分到一起的键这一层能分开
+  uint64_t h =
+      (static_cast<uint64_t>(level) << 32) | static_cast<uint32_t>(key);
+  h *= 0x9E3779B97F4A7C15ull;
+  return (h >> 32) % fanout;
+}
+
+size_t HashJoinExecutor::Fanout() {
+  return std::clamp<size_t>(Context().GetWorkMemory() / PAGE_SIZE, 2,
+                            MAX_FANOUT);
+}
+
+size_t HashJoinExecutor::AddPartitions(size_t level) {
+  BufferPool *buffer_pool = Context().GetCatalog().GetBufferPool();
+  size_t first = pending_.size();
+  for (size_t i = 0; i < Fanout(); ++i) {
+    pending_.push_back({std::make_unique<SpillFile>(buffer_pool),
+                        std::make_unique<SpillFile>(buffer_pool), level});
+  }
+  partition_count_ += Fanout();
+  return first;
+}
+
+void HashJoinExecutor::SpillBuildTable() {
+  spilled_ = true;
+  AddPartitions(0);
+  for (const auto &[key, tuple] : table_) {
+    pending_[PartitionOf(key, 0, Fanout())].build->Append(tuple);
+  }
+  table_.clear();
+  table_bytes_ = 0;
+}
+
+void HashJoinExecutor::Init() {
+  left_->Init();
+  right_->Init();
+  table_.clear();
+  table_bytes_ = 0;
+  spilled_ = false;
+  partition_count_ = 0;
+  pending_.clear();
+  current_ = Partition{};
+
+  // 每一项除了 tuple 本身还有哈希表节点的开销，粗略算 48 字节
+  constexpr size_t ENTRY_OVERHEAD = 48;
+  size_t budget = Context().GetWorkMemory();
+  Tuple tuple;
+  while (build_->Next(&tuple)) {
+    int32_t key = KeyOf(tuple, build_offset_);
+    if (spilled_) {
+      pending_[PartitionOf(key, 0, Fanout())].build->Append(tuple);
+      continue;
+    }
+    table_bytes_ += tuple.Size() + ENTRY_OVERHEAD;
+    table_.emplace(key, tuple);
+    if (table_bytes_ > budget) {
+      SpillBuildTable();
+    }
+  }
+  if (spilled_) {
+    // probe 一边按同样的哈希分区，之后两边逐个分区连接
+    while (probe_->Next(&tuple)) {
+      int32_t key = KeyOf(tuple, probe_offset_);
+      pending_[PartitionOf(key, 0, Fanout())].probe->Append(tuple);
+    }
+    LoadNextPartition();
+  }
+  match_ = match_end_ = table_.end();
+}
+
+bool HashJoinExecutor::LoadNextPartition() {
+  table_.clear();
+  match_ = match_end_ = table_.end();
+  while (!pending_.empty()) {
+    Partition partition = std::move(pending_.back());
+    pending_.pop_back();
+    // 内连接，有一边是空的就没有结果
+    if (partition.build->GetTupleCount() == 0 ||
+        partition.probe->GetTupleCount() == 0) {
+      continue;
+    }
+    partition.build->Rewind();
+    partition.probe->Rewind();
+    Tuple tuple;
+    if (partition.build->GetPageCount() * PAGE_SIZE >
+            Context().GetWorkMemory() &&
+        partition.level < MAX_LEVEL) {
+      // 还是放不下，换一层哈希再分
+      size_t level = partition.level + 1;
+      size_t first = AddPartitions(level);
+      while (partition.build->Next(&tuple)) {
+        int32_t key = KeyOf(tuple, build_offset_);
+        pending_[first + PartitionOf(key, level, Fanout())].build->Append(
+            tuple);
+      }
+      while (partition.probe->Next(&tuple)) {
+        int32_t key = KeyOf(tuple, probe_offset_);
+        pending_[first + PartitionOf(key, level, Fanout())].probe->Append(
+            tuple);
+      }
+      continue;
+    }
+    while (partition.build->Next(&tuple)) {
+      table_.emplace(KeyOf(tuple, build_offset_), tuple);
+    }
+    current_ = std::move(partition);
+    match_ = match_end_ = table_.end();
+    return true;
+  }
+  current_ = Partition{};
+  return false;
+}
+
+bool HashJoinExecutor::NextProbe(Tuple *tuple) {
+  if (!spilled_) {
+    return probe_->Next(tuple);
+  }
+  return current_.probe != nullptr && current_.probe->Next(tuple);
+}
+
+void HashJoinExecutor::Emit(const Tuple &build, const Tuple &probe,
+                            Tuple *out) const {
+  const Tuple &left = build_left_ ? build : probe;
+  const Tuple &right = build_left_ ? probe : build;
+  char *buf = out->Resize(left.Size() + right.Size());
+  memcpy(buf, left.Data(), left.Size());
+  memcpy(buf + left.Size(), right.Data(), right.Size());
+}
+
+bool HashJoinExecutor::Next(Tuple *tuple) {
+  while (true) {
+    if (match_ != match_end_) {
+      Emit(match_->second, probe_tuple_, tuple);
+      ++match_;
+      return true;
+    }
+    if (!NextProbe(&probe_tuple_)) {
+      if (!spilled_ || !LoadNextPartition()) {
+        return false;
+      }
+      continue;
+    }
+    std::tie(match_, match_end_) =
+        table_.equal_range(KeyOf(probe_tuple_, probe_offset_));
+  }
+}
+
+IndexNestedLoopJoinExecutor::IndexNestedLoopJoinExecutor(
+    ExecutionContext &context, std::unique_ptr<Executor> outer,
+    uint32_t outer_column, std::unique_ptr<BoundSelectStatement> inner,
+    IndexInfo *inner_index, bool outer_left)
+    : Executor(context), outer_(std::move(outer)), inner_(std::move(inner)),
+      inner_index_(inner_index), outer_left_(outer_left) {
+  auto outer_schema = outer_->GetSchema();
+  outer_offset_ = outer_schema->GetColumn(outer_column).offset;
+  auto inner_schema = inner_->GetSchema();
+  schema_ = outer_left_ ? JoinSchema(*outer_schema, *inner_schema)
+                        : JoinSchema(*inner_schema, *outer_schema);
+}
+
+void IndexNestedLoopJoinExecutor::SetSnapshot(const Snapshot &snapshot) {
+  snapshot_ = snapshot;
+  has_snapshot_ = true;
+}
+
+void IndexNestedLoopJoinExecutor::Init() {
+  Transaction *txn = Context().GetTransaction();
+  if (!has_snapshot_) {
+    snapshot_ = txn != nullptr
+                    ? txn->GetSnapshot()
+                    : Context().GetTransactionManager().GetSnapshot();
+  }
+  if (txn != nullptr && txn->GetMode() == ConcurrencyMode::OPTIMISTIC) {
+    optimistic_txn_ = txn;
+  }
+  outer_->Init();
+  batch_.clear();
+  inner_rows_.clear();
+  outer_pos_ = key_pos_ = inner_pos_ = 0;
+  probe_count_ = 0;
+}
+
+bool IndexNestedLoopJoinExecutor::InnerMatches(const Tuple &tuple) const {
+  if (!inner_->HasWhere()) {
+    return true;
+  }
+  const auto &col = inner_->Table()->schema->GetColumn(inner_->WhereColumnId());
+  int32_t val;
+  memcpy(&val, tuple.Data() + col.offset, sizeof(int32_t));
+  return val == static_cast<const IntValue *>(inner_->WhereValue())->GetValue();
+}
+
+bool IndexNestedLoopJoinExecutor::LoadBatch() {
+  batch_.clear();
+  Tuple tuple;
+  while (batch_.size() < BATCH_SIZE && outer_->Next(&tuple)) {
+    int32_t key;
+    memcpy(&key, tuple.Data() + outer_offset_, sizeof(int32_t));
+    batch_.emplace_back(key, std::move(tuple));
+  }
+  if (batch_.empty()) {
+    return false;
+  }
+  std::sort(batch_.begin(), batch_.end(),
+            [](const auto &a, const auto &b) { return a.first < b.first; });
+  std::vector<int32_t> keys;
+  for (const auto &entry : batch_) {
+    if (keys.empty() || keys.back() != entry.first) {
+      keys.push_back(entry.first);
+    }
+  }
+  std::vector<std::vector<RID>> rids;
+  inner_index_->index->ScanKeys(keys, &rids);
+  probe_count_ += keys.size();
+
+  // 索引里有所有版本的项，跳过对快照不可见的
+  TableHeap *heap = inner_->Table()->table.get();
+  inner_rows_.assign(keys.size(), {});
+  for (size_t k = 0; k < keys.size(); ++k) {
+    for (const RID &rid : rids[k]) {
+      if (!heap->GetTuple(rid, &tuple, &snapshot_) || !InnerMatches(tuple)) {
+        continue;
+      }
+      if (optimistic_txn_ != nullptr) {
+        optimistic_txn_->AddRead(rid);
+      }
+      inner_rows_[k].push_back(tuple);
+    }
+  }
+  outer_pos_ = key_pos_ = inner_pos_ = 0;
+  return true;
+}
+
+bool IndexNestedLoopJoinExecutor::Next(Tuple *tuple) {
+  while (true) {
+    if (outer_pos_ >= batch_.size()) {
+      if (!LoadBatch()) {
+        return false;
+      }
+      continue;
+    }
+    const auto &matches = inner_rows_[key_pos_];
+    if (inner_pos_ < matches.size()) {
+      const Tuple &outer = batch_[outer_pos_].second;
+      const Tuple &inner = matches[inner_pos_++];
+      const Tuple &left = outer_left_ ? outer : inner;
+      const Tuple &right = outer_left_ ? inner : outer;
+      char *buf = tuple->Resize(left.Size() + right.Size());
+      memcpy(buf, left.Data(), left.Size());
+      memcpy(buf + left.Size(), right.Data(), right.Size());
+      return true;
+    }
+    inner_pos_ = 0;
+    outer_pos_++;
+    if (outer_pos_ < batch_.size() &&
+        batch_[outer_pos_].first != batch_[outer_pos_ - 1].first) {
+      key_pos_++;
+    }
+  }
+}
+
+SortExecutor::SortExecutor(ExecutionContext &context,
+                           std::unique_ptr<Executor> child,
+                           std::vector<SortKey> keys)
+    : Executor(context), child_(std::move(child)), keys_(std::move(keys)) {
+  assert(!keys_.empty());
+  schema_ = child_->GetSchema();
+  for (const SortKey &key : keys_) {
+    key_columns_.push_back(schema_->GetColumn(key.column));
+  }
+  const Column &first = key_columns_.front();
+  prefix_exact_ = first.type == DataType::INTEGER || first.length <= 8;
+}
+
+uint64_t SortExecutor::PrefixOf(const char *row) const {
+  const Column &col = key_columns_.front();
+  uint64_t prefix = 0;
+  if (col.type == DataType::INTEGER) {
+    // 翻转符号位，负数排到正数前面
+    int32_t value;
+    memcpy(&value, row + col.offset, sizeof(int32_t));
+    prefix = static_cast<uint64_t>(static_cast<uint32_t>(value) ^ 0x80000000u)
+             << 32;
+  } else {
+    // 字符串按字节比较，取前 8 个字节按大端拼起来
+    for (uint32_t i = 0; i < 8; ++i) {
+      uint8_t byte = i < col.length ? row[col.offset + i] : 0;
+      prefix = (prefix << 8) | byte;
+    }
+  }
+  return keys_.front().desc ? ~prefix : prefix;
+}
+
+// 从第 first 个排序键开始比较两行，columns 是每个键所在的列
+static int CompareKeys(const std::vector<SortKey> &keys,
+                       const std::vector<Column> &columns, const char *a,
+                       const char *b, size_t first) {
+  for (size_t k = first; k < keys.size(); ++k) {
+    const Column &col = columns[k];
+    int cmp;
+    if (col.type == DataType::INTEGER) {
+      int32_t x, y;
+      memcpy(&x, a + col.offset, sizeof(int32_t));
+      memcpy(&y, b + col.offset, sizeof(int32_t));
+      cmp = x < y ? -1 : x > y ? 1 : 0;
+    } else {
+      cmp = memcmp(a + col.offset, b + col.offset, col.length);
+    }
+    if (cmp != 0) {
+      return keys[k].desc ? -cmp : cmp;
+    }
+  }
+  return 0;
+}
+
+int SortExecutor::Compare(const char *a, const char *b, size_t first) const {
+  return CompareKeys(keys_, key_columns_, a, b, first);
+}
+
+void SortExecutor::SortBuffer() {
+  const char *data = buffer_.data();
+  size_t first = prefix_exact_ ? 1 : 0;
+  std::sort(entries_.begin(), entries_.end(),
+            [this, data, first](const SortEntry &a, const SortEntry &b) {
+              if (a.prefix != b.prefix) {
+                return a.prefix < b.prefix;
+              }
+              return Compare(data + a.offset, data + b.offset, first) < 0;
+            });
+}
+
+void SortExecutor::SpillBuffer() {
+  SortBuffer();
+  auto run =
+      std::make_unique<SpillFile>(Context().GetCatalog().GetBufferPool());
+  for (const SortEntry &entry : entries_) {
+    run->Append(Tuple(buffer_.data() + entry.offset, entry.size));
+  }
+  run->Rewind();
+  runs_.push_back(std::move(run));
+  run_count_++;
+  buffer_.clear();
+  entries_.clear();
+}
+
+bool SortExecutor::HeadLess(const Merge &merge, size_t i, size_t j) const {
+  if (!merge.live[i] || !merge.live[j]) {
+    return merge.live[i] && !merge.live[j];
+  }
+  return Compare(merge.heads[i].Data(), merge.heads[j].Data(), 0) < 0;
+}
+
+void SortExecutor::StartMerge(Merge *merge, std::vector<SpillFile *> inputs) {
+  merge->inputs = std::move(inputs);
+  size_t k = merge->inputs.size();
+  merge->heads.assign(k, Tuple());
+  merge->live.assign(k, false);
+  for (size_t i = 0; i < k; ++i) {
+    merge->live[i] = merge->inputs[i]->Next(&merge->heads[i]);
+  }
+  merge->tree.Build(
+      k, [this, merge](size_t i, size_t j) { return HeadLess(*merge, i, j); });
+}
+
+bool SortExecutor::PopMerge(Merge *merge, Tuple *tuple) {
+  if (merge->inputs.empty()) {
+    return false;
+  }
+  size_t winner = merge->tree.Winner();
+  if (!merge->live[winner]) {
+    return false;
+  }
+  std::swap(*tuple, merge->heads[winner]);
+  merge->live[winner] = merge->inputs[winner]->Next(&merge->heads[winner]);
+  merge->tree.Replay(
+      [this, merge](size_t i, size_t j) { return HeadLess(*merge, i, j); });
+  return true;
+}
+
+std::unique_ptr<SpillFile> SortExecutor::MergeRuns(size_t first,
+                                                   size_t count) {
+  std::vector<SpillFile *> inputs;
+  for (size_t i = first; i < first + count; ++i) {
+    inputs.push_back(runs_[i].get());
+  }
+  Merge merge;
+  StartMerge(&merge, std::move(inputs));
+  auto out =
+      std::make_unique<SpillFile>(Context().GetCatalog().GetBufferPool());
+  Tuple tuple;
+  while (PopMerge(&merge, &tuple)) {
+    out->Append(tuple);
+  }
+  out->Rewind();
+  // 归并完的段马上还掉临时页
+  for (size_t i = first; i < first + count; ++i) {
+    runs_[i].reset();
+  }
+  merge_count_++;
+  return out;
+}
+
+void SortExecutor::Init() {
+  child_->Init();
+  buffer_.clear();
+  entries_.clear();
+  output_pos_ = 0;
+  runs_.clear();
+  run_count_ = 0;
+  merge_count_ = 0;
+  merge_ = Merge{};
+
+  size_t budget = Context().GetWorkMemory();
+  Tuple tuple;
+  while (child_->Next(&tuple)) {
+    entries_.push_back({PrefixOf(tuple.Data()), buffer_.size(), tuple.Size()});
+    buffer_.insert(buffer_.end(), tuple.Data(), tuple.Data() + tuple.Size());
+    if (buffer_.size() + entries_.size() * sizeof(SortEntry) > budget) {
+      SpillBuffer();
+    }
+  }
+  if (runs_.empty()) {
+    SortBuffer();
+    return;
+  }
+  if (!entries_.empty()) {
+    SpillBuffer();
+  }
+
+  // 段比一次能归并的多时，先把最早的几段归并成一段放到最后
+  size_t fan_in = std::clamp<size_t>(Context().GetWorkMemory() / PAGE_SIZE, 2,
+                                     MAX_FAN_IN);
+  size_t first = 0;
+  while (runs_.size() - first > fan_in) {
+    runs_.push_back(MergeRuns(first, fan_in));
+    first += fan_in;
+  }
+  std::vector<SpillFile *> inputs;
+  for (size_t i = first; i < runs_.size(); ++i) {
+    inputs.push_back(runs_[i].get());
+  }
+  StartMerge(&merge_, std::move(inputs));
+}
+
+bool SortExecutor::Next(Tuple *tuple) {
+  if (runs_.empty()) {
+    if (output_pos_ >= entries_.size()) {
+      return false;
+    }
+    const SortEntry &entry = entries_[output_pos_++];
+    tuple->SetData(buffer_.data() + entry.offset, entry.size);
+    return true;
+  }
+  return PopMerge(&merge_, tuple);
+}
+
+ProjectionExecutor::ProjectionExecutor(ExecutionContext &context,
+                                       std::unique_ptr<Executor> child,
+                                       const std::vector<uint32_t> &columns)
+    : Executor(context), child_(std::move(child)) {
+  auto input = child_->GetSchema();
+  schema_ = std::make_shared<Schema>();
+  for (uint32_t column : columns) {
+    const Column &col = input->GetColumn(column);
+    columns_.push_back(col);
+    schema_->AddColumn(col.name, col.type, col.length);
+  }
+}
+
+bool ProjectionExecutor::Next(Tuple *tuple) {
+  if (!child_->Next(&row_)) {
+    return false;
+  }
+  ProjectRow(row_, columns_, tuple);
+  return true;
+}
+
+TopNExecutor::TopNExecutor(ExecutionContext &context,
+                           std::unique_ptr<Executor> child,
+                           std::vector<SortKey> keys, size_t n)
+    : Executor(context), child_(std::move(child)), keys_(std::move(keys)),
+      n_(n) {
+  assert(!keys_.empty());
+  schema_ = child_->GetSchema();
+  for (const SortKey &key : keys_) {
+    key_columns_.push_back(schema_->GetColumn(key.column));
+  }
+}
+
+bool TopNExecutor::Less(const Tuple &a, const Tuple &b) const {
+  return CompareKeys(keys_, key_columns_, a.Data(), b.Data(), 0) < 0;
+}
+
+void TopNExecutor::Init() {
+  child_->Init();
+  heap_.clear();
+  output_pos_ = 0;
+  if (n_ == 0) {
+    return;
+  }
+  auto less = [this](const Tuple &a, const Tuple &b) { return Less(a, b); };
+  Tuple tuple;
+  while (child_->Next(&tuple)) {
+    if (heap_.size() < n_) {
+      heap_.push_back(std::move(tuple));
+      std::push_heap(heap_.begin(), heap_.end(), less);
+    } else if (Less(tuple, heap_.front())) {
+      std::pop_heap(heap_.begin(), heap_.end(), less);
+      std::swap(heap_.back(), tuple);
+      std::push_heap(heap_.begin(), heap_.end(), less);
+    }
+  }
+  std::sort_heap(heap_.begin(), heap_.end(), less);
+}
+
+bool TopNExecutor::Next(Tuple *tuple) {
+  if (output_pos_ >= heap_.size()) {
+    return false;
+  }
+  *tuple = std::move(heap_[output_pos_++]);
+  return true;
+}
+
+SortMergeJoinExecutor::SortMergeJoinExecutor(ExecutionContext &context,
+                                             std::unique_ptr<Executor> left,
+                                             std::unique_ptr<Executor> right,
+                                             uint32_t left_column,
+                                             uint32_t right_column)
+    : Executor(context) {
+  auto left_schema = left->GetSchema();
+  auto right_schema = right->GetSchema();
+  left_offset_ = left_schema->GetColumn(left_column).offset;
+  right_offset_ = right_schema->GetColumn(right_column).offset;
+  schema_ = JoinSchema(*left_schema, *right_schema);
+  left_ = std::make_unique<SortExecutor>(
+      context, std::move(left), std::vector<SortKey>{{left_column, false}});
+  right_ = std::make_unique<SortExecutor>(
+      context, std::move(right), std::vector<SortKey>{{right_column, false}});
+}
+
+void SortMergeJoinExecutor::Init() {
+  left_->Init();
+  right_->Init();
+  has_right_ = right_->Next(&right_row_);
+  group_.clear();
+  group_pos_ = 0;
+}
+
+bool SortMergeJoinExecutor::Next(Tuple *tuple) {
+  while (true) {
+    if (group_pos_ < group_.size()) {
+      const Tuple &right = group_[group_pos_++];
+      char *buf = tuple->Resize(left_row_.Size() + right.Size());
+      memcpy(buf, left_row_.Data(), left_row_.Size());
+      memcpy(buf + left_row_.Size(), right.Data(), right.Size());
+      return true;
+    }
+    if (!left_->Next(&left_row_)) {
+      return false;
+    }
+    int32_t key = ReadInt(left_row_, left_offset_);
+    group_pos_ = 0;
+    if (!group_.empty() && key == group_key_) {
+      continue;
+    }
+    // 左边换了一个更大的键，右边跳过更小的键，收集相等的一组
+    group_.clear();
+    group_key_ = key;
+    while (has_right_ && ReadInt(right_row_, right_offset_) < key) {
+      has_right_ = right_->Next(&right_row_);
+    }
+    while (has_right_ && ReadInt(right_row_, right_offset_) == key) {
+      group_.push_back(right_row_);
+      has_right_ = right_->Next(&right_row_);
+    }
+    if (group_.empty() && !has_right_) {
+      return false;
+    }
+  }
+}
+
+static int64_t ReadInt64(const char *data) {
+  int64_t value;
+  memcpy(&value, data, sizeof(int64_t));
+  return value;
+}
+
+static void WriteInt64(char *data, int64_t value) {
+  memcpy(data, &value, sizeof(int64_t));
+}
+
+HashAggregateExecutor::HashAggregateExecutor(
+    ExecutionContext &context, std::unique_ptr<Executor> child,
+    const BoundAggregation &aggregation)
+    : Executor(context), child_(std::move(child)),
+      group_by_(aggregation.group_by), items_(aggregation.items),
+      schema_(aggregation.schema) {
+  auto input = child_->GetSchema();
+  for (uint32_t column : group_by_) {
+    key_columns_.push_back(input->GetColumn(column));
+    key_size_ += key_columns_.back().length;
+  }
+  record_size_ = key_size_;
+  for (const BoundSelectItem &item : items_) {
+    // COUNT(*) 的 column 是 0，拿到的列用不上
+    const Column &column = input->GetColumn(item.column);
+    item_columns_.push_back(column);
+    switch (item.aggregate) {
+    case AggregateType::NONE: {
+      auto it = std::find(group_by_.begin(), group_by_.end(), item.column);
+      assert(it != group_by_.end());
+      uint32_t offset = 0;
+      for (auto k = group_by_.begin(); k != it; ++k) {
+        offset += input->GetColumn(*k).length;
+      }
+      state_offsets_.push_back(offset);
+      break;
+    }
+    case AggregateType::MIN:
+    case AggregateType::MAX:
+      // 存这一列的原值
+      state_offsets_.push_back(record_size_);
+      record_size_ += column.length;
+      break;
+    case AggregateType::AVG:
+      // 和与行数
+      state_offsets_.push_back(record_size_);
+      record_size_ += 2 * sizeof(int64_t);
+      break;
+    default:
+      state_offsets_.push_back(record_size_);
+      record_size_ += sizeof(int64_t);
+      break;
+    }
+  }
+}
+
+uint64_t HashAggregateExecutor::HashKey(const char *key) const {
+  // FNV-1a，最后再搅一下让低位也均匀
+  uint64_t h = 0xcbf29ce484222325ull;
+  for (uint32_t i = 0; i < key_size_; ++i) {
+    h = (h ^ static_cast<uint8_t>(key[i])) * 0x100000001b3ull;
+  }
+  h ^= h >> 32;
+  return h * 0x9E3779B97F4A7C15ull;
+}
+
+size_t HashAggregateExecutor::PartitionOf(uint64_t hash, size_t level,
+                                          size_t fanout) {
+  // 每一层用不同的哈希，上一层分到一起的组这一层能分开
+  uint64_t h = (hash ^ (level * 0xff51afd7ed558ccdull)) * 0xc4ceb9fe1a85ec53ull;
+  return (h >> 32) % fanout;
+}
+
+size_t HashAggregateExecutor::Fanout() {
+  return std::clamp<size_t>(Context().GetWorkMemory() / PAGE_SIZE, 2,
+                            MAX_FANOUT);
+}
+
+size_t HashAggregateExecutor::AddPartitions(size_t level) {
+  BufferPool *buffer_pool = Context().GetCatalog().GetBufferPool();
+  size_t first = pending_.size();
+  for (size_t i = 0; i < Fanout(); ++i) {
+    pending_.push_back({std::make_unique<SpillFile>(buffer_pool), level});
+  }
+  partition_count_ += Fanout();
+  return first;
+}
+
+size_t HashAggregateExecutor::MemoryUsage() const {
+  return groups_.size() + hashes_.size() * sizeof(uint64_t) +
+         slots_.size() * sizeof(uint32_t);
+}
+
+char *HashAggregateExecutor::FindOrInsert(const char *key, uint64_t hash,
+                                          bool *inserted) {
+  if ((group_count_ + 1) * 2 > slots_.size()) {
+    // 装填超过一半时翻倍，按记下的哈希重新放
+    slots_.assign(std::max<size_t>(16, slots_.size() * 2), 0);
+    size_t mask = slots_.size() - 1;
+    for (size_t i = 0; i < group_count_; ++i) {
+      size_t pos = hashes_[i] & mask;
+      while (slots_[pos] != 0) {
+        pos = (pos + 1) & mask;
+      }
+      slots_[pos] = static_cast<uint32_t>(i + 1);
+    }
+  }
+  size_t mask = slots_.size() - 1;
+  for (size_t pos = hash & mask;; pos = (pos + 1) & mask) {
+    uint32_t slot = slots_[pos];
+    if (slot == 0) {
+      slots_[pos] = static_cast<uint32_t>(group_count_ + 1);
+      hashes_.push_back(hash);
+      groups_.resize(groups_.size() + record_size_);
+      char *record = Group(group_count_++);
+      memcpy(record, key, key_size_);
+      *inserted = true;
+      return record;
+    }
+    size_t i = slot - 1;
+    if (hashes_[i] == hash && memcmp(Group(i), key, key_size_) == 0) {
+      *inserted = false;
+      return Group(i);
+    }
+  }
+}
+
+void HashAggregateExecutor::ClearTable() {
+  groups_.clear();
+  hashes_.clear();
+  slots_.clear();
+  group_count_ = 0;
+  output_pos_ = 0;
+}
+
+void HashAggregateExecutor::InitState(char *record, const char *row) const {
+  for (size_t i = 0; i < items_.size(); ++i) {
+    char *state = record + state_offsets_[i];
+    const Column &col = item_columns_[i];
+    switch (items_[i].aggregate) {
+    case AggregateType::NONE:
+      break;
+    case AggregateType::COUNT_STAR:
+    case AggregateType::COUNT:
+      WriteInt64(state, 1);
+      break;
+    case AggregateType::SUM: {
+      int32_t value;
+      memcpy(&value, row + col.offset, sizeof(int32_t));
+      WriteInt64(state, value);
+      break;
+    }
+    case AggregateType::AVG: {
+      int32_t value;
+      memcpy(&value, row + col.offset, sizeof(int32_t));
+      WriteInt64(state, value);
+      WriteInt64(state + sizeof(int64_t), 1);
+      break;
+    }
+    case AggregateType::MIN:
+    case AggregateType::MAX:
+      memcpy(state, row + col.offset, col.length);
+      break;
+    }
+  }
+}
+
+void HashAggregateExecutor::CombineState(char *record,
+                                         const char *other) const {
+  for (size_t i = 0; i < items_.size(); ++i) {
+    char *state = record + state_offsets_[i];
+    const char *from = other + state_offsets_[i];
+    const Column &col = item_columns_[i];
+    switch (items_[i].aggregate) {
+    case AggregateType::NONE:
+      break;
+    case AggregateType::AVG:
+      WriteInt64(state + sizeof(int64_t),
+                 ReadInt64(state + sizeof(int64_t)) +
+                     ReadInt64(from + sizeof(int64_t)));
+      [[fallthrough]];
+    case AggregateType::COUNT_STAR:
+    case AggregateType::COUNT:
+    case AggregateType::SUM:
+      WriteInt64(state, ReadInt64(state) + ReadInt64(from));
+      break;
+    case AggregateType::MIN:
+    case AggregateType::MAX: {
+      int cmp;
+      if (col.type == DataType::INTEGER) {
+        int32_t x, y;
+        memcpy(&x, from, sizeof(int32_t));
+        memcpy(&y, state, sizeof(int32_t));
+        cmp = x < y ? -1 : x > y ? 1 : 0;
+      } else {
+        cmp = memcmp(from, state, col.length);
+      }
+      if (items_[i].aggregate == AggregateType::MIN ? cmp < 0 : cmp > 0) {
+        memcpy(state, from, col.length);
+      }
+      break;
+    }
+    }
+  }
+}
+
+void HashAggregateExecutor::SpillTable() {
+  if (!spilled_) {
+    spilled_ = true;
+    AddPartitions(0);
+  }
+  for (size_t i = 0; i < group_count_; ++i) {
+    pending_[PartitionOf(hashes_[i], 0, Fanout())].file->Append(
+        Tuple(Group(i), record_size_));
+  }
+  ClearTable();
+}
+
+void HashAggregateExecutor::Init() {
+  child_->Init();
+  ClearTable();
+  spilled_ = false;
+  partition_count_ = 0;
+  pending_.clear();
+
+  size_t budget = Context().GetWorkMemory();
+  std::vector<char> key(key_size_);
+  std::vector<char> partial(record_size_);
+  Tuple tuple;
+  while (child_->Next(&tuple)) {
+    const char *row = tuple.Data();
+    char *k = key.data();
+    for (const Column &col : key_columns_) {
+      memcpy(k, row + col.offset, col.length);
+      k += col.length;
+    }
+    bool inserted;
+    char *record = FindOrInsert(key.data(), HashKey(key.data()), &inserted);
+    if (inserted) {
+      InitState(record, row);
+    } else {
+      InitState(partial.data(), row);
+      CombineState(record, partial.data());
+    }
+    if (MemoryUsage() > budget) {
+      SpillTable();
+    }
+  }
+  if (spilled_) {
+    // 剩下的组也写出去，同一组的部分结果都在同一个分区里
+    SpillTable();
+    LoadNextPartition();
+  } else if (group_count_ == 0 && group_by_.empty()) {
+    groups_.assign(record_size_, 0);
+    hashes_.push_back(0);
+    group_count_ = 1;
+  }
+}
+
+bool HashAggregateExecutor::LoadNextPartition() {
+  ClearTable();
+  while (!pending_.empty()) {
+    Partition partition = std::move(pending_.back());
+    pending_.pop_back();
+    if (partition.file->GetTupleCount() == 0) {
+      continue;
+    }
+    partition.file->Rewind();
+    Tuple tuple;
+    if (partition.file->GetPageCount() * PAGE_SIZE >
+            Context().GetWorkMemory() &&
+        partition.level < MAX_LEVEL) {
+      // 部分结果还是放不下，换一层哈希再分
+      size_t level = partition.level + 1;
+      size_t first = AddPartitions(level);
+      while (partition.file->Next(&tuple)) {
+        size_t i = PartitionOf(HashKey(tuple.Data()), level, Fanout());
+        pending_[first + i].file->Append(tuple);
+      }
+      continue;
+    }
+    while (partition.file->Next(&tuple)) {
+      bool inserted;
+      char *record =
+          FindOrInsert(tuple.Data(), HashKey(tuple.Data()), &inserted);
+      if (inserted) {
+        memcpy(record, tuple.Data(), record_size_);
+      } else {
+        CombineState(record, tuple.Data());
+      }
+    }
+    return true;
+  }
+  return false;
+}
+
+void HashAggregateExecutor::Emit(const char *record, Tuple *out) const {
+  char *buf = out->Resize(schema_->GetTupleLength());
+  memset(buf, 0, schema_->GetTupleLength());
+  for (size_t i = 0; i < items_.size(); ++i) {
+    const Column &col = schema_->GetColumn(i);
+    const char *state = record + state_offsets_[i];
+    int64_t value;
+    switch (items_[i].aggregate) {
+    case AggregateType::NONE:
+    case AggregateType::MIN:
+    case AggregateType::MAX:
+      memcpy(buf + col.offset, state, col.length);
+      continue;
+    case AggregateType::AVG: {
+      // 整数平均，向零取整
+      int64_t count = ReadInt64(state + sizeof(int64_t));
+      value = count == 0 ? 0 : ReadInt64(state) / count;
+      break;
+    }
+    default:
+      value = ReadInt64(state);
+      break;
+    }
+    if (value < INT32_MIN || value > INT32_MAX) {
+      throw std::runtime_error("Aggregate result out of INT range: " +
+                               col.name);
+    }
+    int32_t result = static_cast<int32_t>(value);
+    memcpy(buf + col.offset, &result, sizeof(int32_t));
+  }
+}
+
+bool HashAggregateExecutor::Next(Tuple *tuple) {
+  while (true) {
+    if (output_pos_ < group_count_) {
+      Emit(Group(output_pos_++), tuple);
+      return true;
+    }
+    if (!spilled_ || !LoadNextPartition()) {
+      return false;
+    }
+  }
+}
+
 void CreateTableExecutor::Init() {
   auto table_name = bound_create_table_stmt_->TableName();
   auto columns = bound_create_table_stmt_->Columns();
@@ -151,35 +1629,194 @@ void CreateTableExecutor::Init() {
   auto schema = std::make_shared<Schema>(cols);
   catalog.CreateTable(table_name, schema);
 
+  if (bound_create_table_stmt_->HasPrimaryKey()) {
+    // 主键用一个唯一 B+Tree 索引来保证
+    auto index = catalog.CreateIndex(table_name + "_pkey", table_name,
+                                     bound_create_table_stmt_->PrimaryKey()[0],
+                                     true);
+    if (index == nullptr) {
+      // 表还没写进目录页，删掉就像没建过
+      catalog.DropTable(table_name);
+      throw std::runtime_error(
+          "CreateTableExecutor: create primary key index failed");
+    }
+  }
+  // 新表写进目录页，连同堆的第一页和主键索引的头页一起记一条日志
+  catalog.Persist(&Context().GetTransactionManager());
+
   done_ = true;
 }
 
 bool CreateTableExecutor::Next(Tuple *) { return !done_; }
 
 void CreateIndexExecutor::Init() {
-  auto index = Context().GetCatalog().CreateIndex(
-      bound_create_index_stmt_->IndexName(),
-      bound_create_index_stmt_->TableName(),
-      bound_create_index_stmt_->ColumnIds()[0]);
-  //  TODO: 将表中数据拿到索引里
-  TableInfo *table =
-      Context().GetCatalog().GetTable(bound_create_index_stmt_->TableName());
-  auto col_id = bound_create_index_stmt_->ColumnIds()[0];
-  auto col = table->schema->GetColumns()[col_id];
-  auto iter = table->table->Begin();
-  auto end = table->table->End();
-  while (iter != end) {
-    if (col.type == DataType::INTEGER) {
-      index->index->InsertEntry(*iter, iter.GetRID());
-    } else if (col.type == DataType::VARCHAR) {
+  // 显式事务的快照是事务开始时拍的，看不到之后提交的行，建出的索引会缺项
+  if (Context().GetTransaction() != nullptr) {
+    throw std::runtime_error(
+        "CreateIndexExecutor: CREATE INDEX cannot run inside a transaction");
+  }
+  Catalog &catalog = Context().GetCatalog();
+  auto &txn_manager = Context().GetTransactionManager();
+  TableInfo *table = catalog.GetTable(bound_create_index_stmt_->TableName());
+  // 建索引在自己的事务里：表上加 S 锁，等正在写这张表的事务结束，也挡住
+  // 新的写。加上锁之后再拍快照，只收已提交、没删除的版本。索引的插入和
+  // 分裂都写日志，提交时落盘，崩溃后能重做出来
+  Transaction *txn = txn_manager.Begin();
+  if (LockManager *lock_manager = txn_manager.GetLockManager()) {
+    try {
+      lock_manager->LockTable(txn, LockMode::SHARED, table->table_id);
+    } catch (const TransactionAbortException &) {
+      txn_manager.Abort(txn);
+      throw;
+    }
+  }
+  txn->SetSnapshot(txn_manager.GetSnapshot());
+  auto index = catalog.CreateIndex(bound_create_index_stmt_->IndexName(),
+                                   bound_create_index_stmt_->TableName(),
+                                   bound_create_index_stmt_->ColumnIds()[0],
+                                   bound_create_index_stmt_->IsUnique(),
+                                   bound_create_index_stmt_->GetIndexType());
+  if (index == nullptr) {
+    txn_manager.Abort(txn);
+    throw std::runtime_error("CreateIndexExecutor: create index failed");
+  }
+  const Snapshot &snapshot = txn->GetSnapshot();
+  for (auto iter = table->table->Begin(&snapshot), end = table->table->End();
+       iter != end; ++iter) {
+    if (!index->index->InsertEntry(*iter, iter.GetRID(), txn)) {
+      // 已有数据违反唯一约束，索引不能建，已经分配的页都还回去
+      txn_manager.Abort(txn);
+      index->index->Destroy();
+      catalog.DropIndex(index->index_name);
       throw std::runtime_error(
-          "CreateIndexExecutor: unsupported column type for indexing");
+          "CreateIndexExecutor: duplicate key in existing rows");
     }
-    ++iter;
   }
+  txn_manager.Commit(txn);
+  // 索引项提交之后才写目录页，崩溃时不会留下一个项被撤销掉的索引
+  catalog.Persist(&txn_manager);
   done_ = true;
 }
 
 bool CreateIndexExecutor::Next(Tuple *) { return !done_; }
 
+void AnalyzeExecutor::Init() {
+  TableInfo *table = bound_analyze_stmt_->Table();
+  Transaction *txn = Context().GetTransaction();
+  Snapshot snapshot = txn != nullptr
+                          ? txn->GetSnapshot()
+                          : Context().GetTransactionManager().GetSnapshot();
+  std::shared_ptr<TableStatistics> statistics =
+      TableStatistics::Collect(table->table.get(), *table->schema, &snapshot);
+  std::atomic_store(&table->statistics, std::move(statistics));
+  done_ = true;
+}
+
+bool AnalyzeExecutor::Next(Tuple *) { return !done_; }
+
+ExplainExecutor::ExplainExecutor(
+    ExecutionContext &context,
+    std::unique_ptr<BoundExplainStatement> bound_explain_stmt)
+    : Executor(context), bound_explain_stmt_(std::move(bound_explain_stmt)),
+      schema_(std::make_shared<Schema>()) {
+  schema_->AddColumn("QUERY PLAN", DataType::VARCHAR, LINE_WIDTH);
+}
+
+void ExplainExecutor::Init() {
+  auto &select = bound_explain_stmt_->Select();
+  std::unique_ptr<PlanNode> plan = Planner(Context()).PlanSelect(*select);
+  std::string text;
+  if (bound_explain_stmt_->IsAnalyze()) {
+    // 输出的行丢掉，只留下记在计划节点上的实际执行情况
+    SelectExecutor executor(Context(), std::move(select), plan.get(), true);
+    auto start = std::chrono::steady_clock::now();
+    executor.Init();
+    Tuple row;
+    while (executor.Next(&row)) {
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    char total[64];
+    snprintf(total, sizeof(total), "Execution Time: %.3f ms",
+             std::chrono::duration<double, std::milli>(elapsed).count());
+    text = plan->ToString(true) + total + "\n";
+  } else {
+    text = plan->ToString();
+  }
+  lines_.clear();
+  pos_ = 0;
+  for (size_t begin = 0, end; begin < text.size(); begin = end + 1) {
+    end = text.find('\n', begin);
+    lines_.push_back(text.substr(begin, end - begin));
+  }
+}
+
+void PrepareExecutor::Init() {
+  std::string sql = PlanCache::Normalize(bound_prepare_stmt_->Sql());
+  // 先绑定一次，表或列不存在时在 PREPARE 就报错
+  Context().GetPlanCache().Get(sql);
+  Context().Prepare(bound_prepare_stmt_->Name(), std::move(sql));
+  done_ = true;
+}
+
+bool PrepareExecutor::Next(Tuple *) { return !done_; }
+
+ExecuteExecutor::ExecuteExecutor(
+    ExecutionContext &context,
+    std::unique_ptr<BoundExecuteStatement> bound_execute_stmt)
+    : Executor(context) {
+  const std::string &name = bound_execute_stmt->Name();
+  const std::string *sql = context.GetPrepared(name);
+  if (sql == nullptr) {
+    throw std::runtime_error("prepared statement not found: " + name);
+  }
+  std::shared_ptr<const CachedStatement> cached =
+      context.GetPlanCache().Get(*sql);
+  std::unique_ptr<BoundStatement> stmt =
+      cached->Instantiate(bound_execute_stmt->Parameters());
+  type_ = stmt->Type();
+  executor_ = Planner(context).CreateExecutor(std::move(stmt));
+}
+
+bool ExplainExecutor::Next(Tuple *tuple) {
+  if (pos_ >= lines_.size()) {
+    return false;
+  }
+  const std::string &line = lines_[pos_++];
+  char *buf = tuple->Resize(LINE_WIDTH);
+  memset(buf, 0, LINE_WIDTH);
+  memcpy(buf, line.data(), std::min<size_t>(line.size(), LINE_WIDTH));
+  return true;
+}
+
+void TransactionExecutor::Init() {
+  auto &txn_manager = Context().GetTransactionManager();
+  Transaction *txn = Context().GetTransaction();
+  switch (bound_txn_stmt_->Command()) {
+  case TransactionCommand::BEGIN:
+    if (txn != nullptr) {
+      throw std::runtime_error("there is already a transaction in progress");
+    }
+    Context().SetTransaction(
+        txn_manager.Begin(Context().GetConcurrencyMode()));
+    break;
+  case TransactionCommand::COMMIT:
+    if (txn == nullptr) {
+      throw std::runtime_error("there is no transaction in progress");
+    }
+    Context().SetTransaction(nullptr);
+    txn_manager.Commit(txn);
+    break;
+  case TransactionCommand::ROLLBACK:
+    if (txn == nullptr) {
+      throw std::runtime_error("there is no transaction in progress");
+    }
+    Context().SetTransaction(nullptr);
+    txn_manager.Abort(txn);
+    break;
+  }
+  done_ = true;
+}
+
+bool TransactionExecutor::Next(Tuple *) { return !done_; }
+
 } // namespace mini
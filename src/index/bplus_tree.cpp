@@ -8,31 +8,110 @@
 
 namespace mini {
 
+template <typename KeyType, typename ValueType, typename Comparator>
+BPlusTree<KeyType, ValueType, Comparator>::BPlusTree(BufferPool *buffer_pool,
+                                                     bool unique,
+                                                     LogManager *log_manager)
+    : buffer_pool_(buffer_pool), log_manager_(log_manager), unique_(unique) {
+  auto pageguard = buffer_pool_->NewPageGuarded(&header_page_id_);
+  if (pageguard.GetPage() == nullptr) {
+    throw std::runtime_error("BPlusTree: no free frame for the header page");
+  }
+  auto header = BPlusTreeHeaderPage::From(pageguard.GetPage());
+  header->lsn = INVALID_LSN;
+  header->root_page_id = INVALID_PAGE_ID;
+  header->height = 0;
+  header->key_type = KeyTypeOf<KeyType>();
+  header->key_size = sizeof(KeyType);
+  header->entry_count = 0;
+  header->unique = unique_;
+  pageguard.SetDirty();
+}
+
+template <typename KeyType, typename ValueType, typename Comparator>
+BPlusTree<KeyType, ValueType, Comparator>::BPlusTree(BufferPool *buffer_pool,
+                                                     page_id_t header_page_id,
+                                                     LogManager *log_manager)
+    : buffer_pool_(buffer_pool), log_manager_(log_manager),
+      header_page_id_(header_page_id) {
+  auto pageguard = FetchPage(header_page_id_);
+  auto header = BPlusTreeHeaderPage::From(pageguard.GetPage());
+  if (header->key_type != KeyTypeOf<KeyType>() ||
+      header->key_size != sizeof(KeyType)) {
+    throw std::runtime_error("index header does not match the key type");
+  }
+  root_page_id_ = header->root_page_id;
+  height_ = header->height;
+  entry_count_ = header->entry_count;
+  unique_ = header->unique;
+}
+
+// 事务里下一条记录的 undo_next：指向事务目前的最后一条日志
+static lsn_t LastLSN(Transaction *txn) {
+  return txn == nullptr ? INVALID_LSN : txn->GetPrevLSN();
+}
+
 template <typename KeyType, typename ValueType, typename Comparator>
 bool BPlusTree<KeyType, ValueType, Comparator>::Insert(const KeyType &key,
-                                                       const ValueType &value) {
+                                                       const ValueType &value,
+                                                       Transaction *txn) {
   if (root_page_id_ == INVALID_PAGE_ID) {
-    //树为空，创建一个新的页作为根节点
-    auto newpage = buffer_pool_->NewPageGuarded(&root_page_id_);
-    auto page = newpage.GetPage();
-    auto leaf = BPlusTreeLeafPage<KeyType, RID, Comparator>::From(page);
-    leaf->Init(root_page_id_);
+    //树为空，创建一个新的页作为根节点，要改的页都取到了才动
+    lsn_t undo_next = LastLSN(txn);
+    std::vector<PageGuard> modified;
+    modified.push_back(FetchPage(header_page_id_));
+    page_id_t root_page_id;
+    auto newpage = buffer_pool_->NewPageGuarded(&root_page_id);
+    if (newpage.GetPage() == nullptr) {
+      throw std::runtime_error("BPlusTree: no free frame for a new page");
+    }
+    auto leaf =
+        BPlusTreeLeafPage<KeyType, RID, Comparator>::From(newpage.GetPage());
+    leaf->Init(root_page_id);
+    newpage.SetDirty();
+    root_page_id_ = root_page_id;
+    height_ = 1;
+    UpdateHeader(&modified.back());
+    modified.push_back(std::move(newpage));
+    LogStructureModification(txn, undo_next, &modified);
   }
-  page_id_t new_page_id;
-  KeyType new_key;
-  if (InsertDown(root_page_id_, key, value, &new_page_id, &new_key)) {
-    //根节点分裂了，创建一个新的根节点
-    page_id_t father_page_id;
-    auto father_pageguard = buffer_pool_->NewPageGuarded(&father_page_id);
-    auto father_page =
-        BPlusTreeInternalPage<KeyType, page_id_t, Comparator>::From(
-            father_pageguard.GetPage());
-    father_page->Init(father_page_id);
-    MergeNewPages(root_page_id_, new_page_id, father_page_id);
 
-    root_page_id_ = father_page_id;
+  while (true) {
+    std::vector<page_id_t> path;
+    auto pageguard = DescendToLeaf(key, &path);
+    auto node = BPlusTreePage::From(pageguard.GetPage());
+    if (node->GetKeyCount() >= node->GetMaxKeyCount()) {
+      // 之前的分裂没取到页，留下了满的节点，先把它分开再重新下降
+      if (!SplitFullNode(std::move(pageguard), &path, txn, LastLSN(txn))) {
+        throw std::runtime_error("BPlusTree: no free frame to split a node");
+      }
+      continue;
+    }
+    auto leaf =
+        BPlusTreeLeafPage<KeyType, RID, Comparator>::From(pageguard.GetPage());
+    if (unique_) {
+      // 探测和插入在同一次下降中完成，不需要额外的 GetValue
+      uint16_t index = leaf->KeyIndex(key);
+      if (index < leaf->GetKeyCount() &&
+          Comparator{}(leaf->KeyAt(index), key) == 0) {
+        return false;
+      }
+    }
+    {
+      auto header_guard = FetchPage(header_page_id_);
+      if (!leaf->Insert(key, value)) {
+        throw std::runtime_error("leaf is not full but insert failed");
+      }
+      pageguard.SetDirty();
+      LogEntry(txn, LogRecordType::INDEX_INSERT, &pageguard, &header_guard,
+               key, value);
+    }
+    if (leaf->IsFull()) {
+      // 插入已经完成，分裂取不到页时叶子留着满的，下次经过时再分
+      SplitFullNode(std::move(pageguard), &path, txn, LastLSN(txn));
+    }
+    return true;
   }
-  return true;
 }
 
 template <typename KeyType, typename ValueType, typename Comparator>
@@ -41,55 +120,184 @@ bool BPlusTree<KeyType, ValueType, Comparator>::GetValue(
   if (root_page_id_ == INVALID_PAGE_ID) {
     return false;
   }
-  page_id_t nowpid = root_page_id_;
-  auto page = buffer_pool_->FetchPage(nowpid);
-  auto dummy = BPlusTreePage::From(page);
-  while (!dummy->IsLeaf()) {
-    auto internal =
-        BPlusTreeInternalPage<KeyType, page_id_t, Comparator>::From(page);
-    uint16_t left = 1, right = internal->GetKeyCount() - 1;
-    while (left <= right) {
-      uint16_t mid = left + (right - left) / 2;
-      if (Comparator{}(key, internal->KeyAt(mid)) < 0) {
-        right = mid - 1;
-      } else {
-        left = mid + 1;
+  auto pageguard = FindLeftmostLeaf(key);
+  // 重复的 key 可能跨越多个叶子，沿叶子链表一直扫到第一个更大的 key
+  while (true) {
+    auto leaf =
+        BPlusTreeLeafPage<KeyType, RID, Comparator>::From(pageguard.GetPage());
+    for (uint16_t i = leaf->KeyIndex(key); i < leaf->GetKeyCount(); ++i) {
+      if (Comparator{}(leaf->KeyAt(i), key) != 0) {
+        return !value->empty();
       }
+      value->push_back(leaf->ValueAt(i));
     }
-    page_id_t child_page_id = internal->ValueAt(left - 1);
-    buffer_pool_->UnpinPage(nowpid, false);
-    nowpid = child_page_id;
-    page = buffer_pool_->FetchPage(nowpid);
-    dummy = BPlusTreePage::From(page);
+    page_id_t nowpid = leaf->GetNextPageId();
+    if (nowpid == INVALID_PAGE_ID) {
+      break;
+    }
+    pageguard = buffer_pool_->FetchPageGuarded(nowpid);
   }
+  return !value->empty();
+}
 
-  auto leaf = BPlusTreeLeafPage<KeyType, RID, Comparator>::From(page);
+template <typename KeyType, typename ValueType, typename Comparator>
+void BPlusTree<KeyType, ValueType, Comparator>::GetValues(
+    const std::vector<KeyType> &keys,
+    std::vector<std::vector<ValueType>> *values) {
+  values->assign(keys.size(), {});
+  if (root_page_id_ == INVALID_PAGE_ID) {
+    return;
+  }
+  PageGuard pageguard(buffer_pool_, INVALID_PAGE_ID, nullptr);
+  for (size_t k = 0; k < keys.size(); ++k) {
+    const KeyType &key = keys[k];
+    // 上一个 key 停在的叶子里有大于它的项，比它大的 key 只要不超过
+    // 这个叶子的最后一项，就从这个叶子开始找
+    bool reuse = false;
+    if (pageguard.GetPage() != nullptr) {
+      auto leaf = BPlusTreeLeafPage<KeyType, RID, Comparator>::From(
+          pageguard.GetPage());
+      reuse = leaf->GetKeyCount() > 0 &&
+              Comparator{}(leaf->KeyAt(leaf->GetKeyCount() - 1), key) >= 0;
+    }
+    if (!reuse) {
+      pageguard = FindLeftmostLeaf(key);
+    }
+    while (true) {
+      auto leaf = BPlusTreeLeafPage<KeyType, RID, Comparator>::From(
+          pageguard.GetPage());
+      uint16_t i = leaf->KeyIndex(key);
+      while (i < leaf->GetKeyCount() &&
+             Comparator{}(leaf->KeyAt(i), key) == 0) {
+        (*values)[k].push_back(leaf->ValueAt(i++));
+      }
+      if (i < leaf->GetKeyCount()) {
+        break;
+      }
+      page_id_t nowpid = leaf->GetNextPageId();
+      if (nowpid == INVALID_PAGE_ID) {
+        break;
+      }
+      pageguard = buffer_pool_->FetchPageGuarded(nowpid);
+    }
+  }
+}
 
+template <typename KeyType, typename ValueType, typename Comparator>
+size_t
+BPlusTree<KeyType, ValueType, Comparator>::CountValue(const KeyType &key) {
+  if (root_page_id_ == INVALID_PAGE_ID) {
+    return 0;
+  }
+  size_t count = 0;
+  auto pageguard = FindLeftmostLeaf(key);
   while (true) {
-    if (!leaf->Lookup(key, value)) {
+    auto leaf =
+        BPlusTreeLeafPage<KeyType, RID, Comparator>::From(pageguard.GetPage());
+    uint16_t begin = leaf->KeyIndex(key);
+    uint16_t i = begin;
+    while (i < leaf->GetKeyCount() && Comparator{}(leaf->KeyAt(i), key) == 0) {
+      i++;
+    }
+    count += i - begin;
+    if (i < leaf->GetKeyCount()) {
       break;
     }
-    // 要么是当前页的key遍历完了
-    if (leaf->GetNextPageId() == INVALID_PAGE_ID) {
-      // 如果没法继续加载新页
+    page_id_t nowpid = leaf->GetNextPageId();
+    if (nowpid == INVALID_PAGE_ID) {
       break;
     }
-    // 否则就加载新页
-    page_id_t next_page_id = leaf->GetNextPageId();
-    buffer_pool_->UnpinPage(nowpid, false);
-    nowpid = next_page_id;
-    page = buffer_pool_->FetchPage(nowpid);
-    leaf = BPlusTreeLeafPage<KeyType, RID, Comparator>::From(page);
+    pageguard = buffer_pool_->FetchPageGuarded(nowpid);
   }
-  buffer_pool_->UnpinPage(nowpid, false);
-  return !value->empty();
+  return count;
 }
 
 template <typename KeyType, typename ValueType, typename Comparator>
-bool BPlusTree<KeyType, ValueType, Comparator>::Remove(const KeyType &key) {
+bool BPlusTree<KeyType, ValueType, Comparator>::Remove(const KeyType &key,
+                                                       const ValueType &value,
+                                                       Transaction *txn) {
+  if (root_page_id_ == INVALID_PAGE_ID) {
+    return false;
+  }
+  auto pageguard = FindLeftmostLeaf(key);
+  while (true) {
+    auto leaf =
+        BPlusTreeLeafPage<KeyType, RID, Comparator>::From(pageguard.GetPage());
+    for (uint16_t i = leaf->KeyIndex(key); i < leaf->GetKeyCount(); ++i) {
+      if (Comparator{}(leaf->KeyAt(i), key) != 0) {
+        return false;
+      }
+      if (leaf->ValueAt(i) == value) {
+        auto header_guard = FetchPage(header_page_id_);
+        leaf->RemoveAt(i);
+        pageguard.SetDirty();
+        LogEntry(txn, LogRecordType::INDEX_DELETE, &pageguard, &header_guard,
+                 key, value);
+        return true;
+      }
+    }
+    page_id_t nowpid = leaf->GetNextPageId();
+    if (nowpid == INVALID_PAGE_ID) {
+      break;
+    }
+    pageguard = FetchPage(nowpid);
+  }
   return false;
 }
 
+template <typename KeyType, typename ValueType, typename Comparator>
+void BPlusTree<KeyType, ValueType, Comparator>::Destroy() {
+  // 从根开始一层层找出所有的页，读完一页就放掉，最后一起删
+  std::vector<page_id_t> pages{header_page_id_};
+  if (root_page_id_ != INVALID_PAGE_ID) {
+    pages.push_back(root_page_id_);
+  }
+  for (size_t i = 1; i < pages.size(); ++i) {
+    auto pageguard = buffer_pool_->FetchPageGuarded(pages[i]);
+    if (BPlusTreePage::From(pageguard.GetPage())->IsLeaf()) {
+      continue;
+    }
+    auto internal = BPlusTreeInternalPage<KeyType, page_id_t, Comparator>::From(
+        pageguard.GetPage());
+    for (uint16_t k = 0; k < internal->GetKeyCount(); ++k) {
+      pages.push_back(internal->ValueAt(k));
+    }
+  }
+  for (page_id_t page_id : pages) {
+    buffer_pool_->DeletePage(page_id);
+  }
+  header_page_id_ = INVALID_PAGE_ID;
+  root_page_id_ = INVALID_PAGE_ID;
+  height_ = 0;
+  entry_count_ = 0;
+}
+
+template <typename KeyType, typename ValueType, typename Comparator>
+PageGuard BPlusTree<KeyType, ValueType, Comparator>::FindLeftmostLeaf(
+    const KeyType &key) {
+  page_id_t nowpid = root_page_id_;
+  while (true) {
+    auto pageguard = buffer_pool_->FetchPageGuarded(nowpid);
+    auto dummy = BPlusTreePage::From(pageguard.GetPage());
+    if (dummy->IsLeaf()) {
+      return pageguard;
+    }
+    auto internal = BPlusTreeInternalPage<KeyType, page_id_t, Comparator>::From(
+        pageguard.GetPage());
+    // 找第一个 KeyAt(i) >= key 的位置，等于分隔键的 key 也可能留在左边的子树
+    uint16_t left = 1, right = internal->GetKeyCount();
+    while (left < right) {
+      uint16_t mid = left + (right - left) / 2;
+      if (Comparator{}(internal->KeyAt(mid), key) < 0) {
+        left = mid + 1;
+      } else {
+        right = mid;
+      }
+    }
+    nowpid = internal->ValueAt(left - 1);
+  }
+}
+
 template <typename KeyType, typename ValueType, typename Comparator>
 void BPlusTree<KeyType, ValueType, Comparator>::Print(std::ostream &os) const {
   os << "-----B+tree struct-----" << std::endl;
@@ -125,110 +333,224 @@ void BPlusTree<KeyType, ValueType, Comparator>::Print(std::ostream &os) const {
 }
 
 template <typename KeyType, typename ValueType, typename Comparator>
-bool BPlusTree<KeyType, ValueType, Comparator>::InsertDown(
-    page_id_t page_id, const KeyType &key, const ValueType &value,
-    page_id_t *new_page_id, KeyType *new_key) {
-  //辅助递归函数，功能为将kv插入到以p为根的树中
-  //若出现与p同级的分裂，也就是p在此次插入后满了分裂
-  //修改pidret为新页页号，返回true，
-  //否则返回false
-  auto pageguard = buffer_pool_->FetchPageGuarded(page_id);
-  auto dummy = BPlusTreePage::From(pageguard.GetPage());
-  // leaf page
-  if (dummy->IsLeaf()) {
-    auto leaf =
-        BPlusTreeLeafPage<KeyType, RID, Comparator>::From(pageguard.GetPage());
-    if (!leaf->Insert(key, value)) {
-      throw std::runtime_error("leaf is not full but insert failed");
+PageGuard BPlusTree<KeyType, ValueType, Comparator>::DescendToLeaf(
+    const KeyType &key, std::vector<page_id_t> *path) {
+  page_id_t nowpid = root_page_id_;
+  while (true) {
+    auto pageguard = FetchPage(nowpid);
+    auto node = BPlusTreePage::From(pageguard.GetPage());
+    if (node->IsLeaf() || node->GetKeyCount() >= node->GetMaxKeyCount()) {
+      return pageguard;
     }
-    pageguard.SetDirty();
+    auto internal = BPlusTreeInternalPage<KeyType, page_id_t, Comparator>::From(
+        pageguard.GetPage());
+    //找到要插入的子树：第一个 KeyAt(i) > key 的左边
+    uint16_t left = 1, right = internal->GetKeyCount();
+    while (left < right) {
+      uint16_t mid = left + (right - left) / 2;
+      if (Comparator{}(key, internal->KeyAt(mid)) < 0) {
+        right = mid;
+      } else {
+        left = mid + 1;
+      }
+    }
+    path->push_back(nowpid);
+    nowpid = internal->ValueAt(left - 1);
+  }
+}
 
-    if (leaf->IsFull()) {
-      auto newpage = buffer_pool_->NewPageGuarded(new_page_id);
-      auto new_leaf =
-          BPlusTreeLeafPage<KeyType, RID, Comparator>::From(newpage.GetPage());
-      new_leaf->Init(*new_page_id);
+template <typename KeyType, typename ValueType, typename Comparator>
+bool BPlusTree<KeyType, ValueType, Comparator>::SplitFullNode(
+    PageGuard pageguard, std::vector<page_id_t> *path, Transaction *txn,
+    lsn_t undo_next) {
+  // 结构修改涉及的页，写日志之前不能被换出；不写日志时随改随放，
+  // 小缓冲池里也能分裂
+  std::vector<PageGuard> modified;
+  bool logging = log_manager_ != nullptr && txn != nullptr;
+  while (true) {
+    // 先取到新的右兄弟和父节点（根分裂时是新根），写日志时还有头页，
+    // 都取到了才修改这一层
+    bool root = path->empty();
+    page_id_t new_page_id;
+    page_id_t parent_page_id = root ? INVALID_PAGE_ID : path->back();
+    std::vector<PageGuard> level;
+    level.push_back(buffer_pool_->NewPageGuarded(&new_page_id));
+    if (level.back().GetPage() != nullptr) {
+      level.push_back(root ? buffer_pool_->NewPageGuarded(&parent_page_id)
+                           : buffer_pool_->FetchPageGuarded(parent_page_id));
+    }
+    if (root && logging && level.back().GetPage() != nullptr) {
+      level.push_back(buffer_pool_->FetchPageGuarded(header_page_id_));
+    }
+    if (level.back().GetPage() == nullptr) {
+      // 失败之前取到的只可能是新分配的页，还回去。下面已经分好的层
+      // 照常写日志，这一层留着满的节点
+      level.pop_back();
+      std::vector<page_id_t> allocated;
+      for (auto &guard : level) {
+        allocated.push_back(guard.GetPageId());
+      }
+      level.clear();
+      for (page_id_t page_id : allocated) {
+        buffer_pool_->DeletePage(page_id);
+      }
+      LogStructureModification(txn, undo_next, &modified);
+      return false;
+    }
+
+    KeyType child_key; // 分裂后左半边的第一个 key，根分裂时用
+    KeyType new_key;   // 右兄弟的第一个 key，要插入父节点
+    if (BPlusTreePage::From(pageguard.GetPage())->IsLeaf()) {
+      auto leaf = BPlusTreeLeafPage<KeyType, RID, Comparator>::From(
+          pageguard.GetPage());
+      auto new_leaf = BPlusTreeLeafPage<KeyType, RID, Comparator>::From(
+          level[0].GetPage());
+      new_leaf->Init(new_page_id);
       leaf->Split(new_leaf);
-      *new_key = new_leaf->KeyAt(0);
+      child_key = leaf->KeyAt(0);
+      new_key = new_leaf->KeyAt(0);
+    } else {
+      auto internal =
+          BPlusTreeInternalPage<KeyType, page_id_t, Comparator>::From(
+              pageguard.GetPage());
+      auto new_internal =
+          BPlusTreeInternalPage<KeyType, page_id_t, Comparator>::From(
+              level[0].GetPage());
+      new_internal->Init(new_page_id);
+      internal->Split(new_internal);
+      child_key = internal->KeyAt(0);
+      new_key = new_internal->KeyAt(0);
+    }
+    page_id_t child_page_id = pageguard.GetPageId();
+    pageguard.SetDirty();
+    level[0].SetDirty();
+    modified.push_back(std::move(pageguard));
+    modified.push_back(std::move(level[0]));
+
+    if (root) {
+      NewRoot(&level[1], child_key, child_page_id, new_key, new_page_id);
+      modified.push_back(std::move(level[1]));
+      if (logging) {
+        UpdateHeader(&level[2]);
+        modified.push_back(std::move(level[2]));
+      } else {
+        // 不写日志时先放掉分裂的两页，头页总能取到空出来的帧，
+        // 除非别的线程同时把它们占了
+        modified.clear();
+        auto header_guard = FetchPage(header_page_id_);
+        UpdateHeader(&header_guard);
+      }
+      LogStructureModification(txn, undo_next, &modified);
       return true;
     }
-    return false;
-  }
 
-  // internal page
-  auto internal = BPlusTreeInternalPage<KeyType, page_id_t, Comparator>::From(
-      pageguard.GetPage());
-  //找到要插入的子树
-  page_id_t child_page_id = internal->ValueAt(internal->GetKeyCount() - 1);
-  for (uint16_t i = 1; i < internal->GetKeyCount(); ++i) {
-    if (Comparator{}(key, internal->KeyAt(i)) < 0) {
-      child_page_id = internal->ValueAt(i - 1);
-      break;
+    // 分裂向上传播，只有这时才按记录的路径重新取回祖先，
+    // 已经修改的页保持 pin 住
+    path->pop_back();
+    if (!logging) {
+      modified.clear();
     }
-  }
-  page_id_t new_child_page_id;
-  KeyType new_child_key;
-  if (InsertDown(child_page_id, key, value, &new_child_page_id,
-                 &new_child_key)) {
-    // 子树分裂了，插入新的key和page_id
+    pageguard = std::move(level[1]);
+    auto internal = BPlusTreeInternalPage<KeyType, page_id_t, Comparator>::From(
+        pageguard.GetPage());
     // NOTE: 不是insert
-    if (!internal->InsertAfter(child_page_id, new_child_key,
-                               new_child_page_id)) {
+    if (!internal->InsertAfter(child_page_id, new_key, new_page_id)) {
       throw std::runtime_error("internal is not full but insert failed");
     }
     pageguard.SetDirty();
+    if (!internal->IsFull()) {
+      modified.push_back(std::move(pageguard));
+      LogStructureModification(txn, undo_next, &modified);
+      return true;
+    }
   }
+}
 
-  if (internal->IsFull()) {
-    auto newpage = buffer_pool_->NewPageGuarded(new_page_id);
-    auto new_internal =
-        BPlusTreeInternalPage<KeyType, page_id_t, Comparator>::From(
-            newpage.GetPage());
-    new_internal->Init(*new_page_id);
-    internal->Split(new_internal);
-    *new_key = new_internal->KeyAt(0);
-    return true;
+template <typename KeyType, typename ValueType, typename Comparator>
+void BPlusTree<KeyType, ValueType, Comparator>::NewRoot(
+    PageGuard *pageguard, const KeyType &left_key, page_id_t left_page_id,
+    const KeyType &right_key, page_id_t right_page_id) {
+  auto root = BPlusTreeInternalPage<KeyType, page_id_t, Comparator>::From(
+      pageguard->GetPage());
+  root->Init(pageguard->GetPageId());
+  root->SetKeyAt(0, left_key);
+  root->SetValueAt(0, left_page_id);
+  root->SetKeyAt(1, right_key);
+  root->SetValueAt(1, right_page_id);
+  root->SetKeyCount(2);
+  pageguard->SetDirty();
+  root_page_id_ = pageguard->GetPageId();
+  height_++;
+}
+
+template <typename KeyType, typename ValueType, typename Comparator>
+void BPlusTree<KeyType, ValueType, Comparator>::UpdateHeader(
+    PageGuard *header_guard) {
+  auto header = BPlusTreeHeaderPage::From(header_guard->GetPage());
+  header->root_page_id = root_page_id_;
+  header->height = height_;
+  header_guard->SetDirty();
+}
+
+template <typename KeyType, typename ValueType, typename Comparator>
+PageGuard BPlusTree<KeyType, ValueType, Comparator>::FetchPage(
+    page_id_t page_id) {
+  auto pageguard = buffer_pool_->FetchPageGuarded(page_id);
+  if (pageguard.GetPage() == nullptr) {
+    throw std::runtime_error("BPlusTree: no free frame in the buffer pool");
   }
-  return false;
+  return pageguard;
+}
+
+template <typename KeyType, typename ValueType, typename Comparator>
+void BPlusTree<KeyType, ValueType, Comparator>::AppendLog(Transaction *txn,
+                                                          LogRecord *record,
+                                                          Page *page) {
+  if (log_manager_ == nullptr || txn == nullptr) {
+    return;
+  }
+  lsn_t lsn = log_manager_->AppendLogRecord(record);
+  txn->SetPrevLSN(lsn);
+  page->SetLSN(lsn);
 }
 
 template <typename KeyType, typename ValueType, typename Comparator>
-void BPlusTree<KeyType, ValueType, Comparator>::MergeNewPages(
-    page_id_t left_pid, page_id_t right_pid, page_id_t parent_pid) {
-  auto left_pageguard = buffer_pool_->FetchPageGuarded(left_pid);
-  auto right_pageguard = buffer_pool_->FetchPageGuarded(right_pid);
-  auto parent_pageguard = buffer_pool_->FetchPageGuarded(parent_pid);
-
-  auto dummy = BPlusTreePage::From(left_pageguard.GetPage());
-  if (dummy->IsLeaf()) {
-    auto left_leaf = BPlusTreeLeafPage<KeyType, RID, Comparator>::From(
-        left_pageguard.GetPage());
-    auto right_leaf = BPlusTreeLeafPage<KeyType, RID, Comparator>::From(
-        right_pageguard.GetPage());
-    auto parent = BPlusTreeInternalPage<KeyType, page_id_t, Comparator>::From(
-        parent_pageguard.GetPage());
-
-    parent->Insert(left_leaf->KeyAt(0), left_pid);
-    parent->Insert(right_leaf->KeyAt(0), right_pid);
-    // right_leaf->SetNextPageId(left_leaf->GetNextPageId());
-    // left_leaf->SetNextPageId(right_pid);
-    // left_pageguard.SetDirty();
-    // right_pageguard.SetDirty();
-  } else {
-    auto left_leaf =
-        BPlusTreeInternalPage<KeyType, page_id_t, Comparator>::From(
-            left_pageguard.GetPage());
-    auto right_leaf =
-        BPlusTreeInternalPage<KeyType, page_id_t, Comparator>::From(
-            right_pageguard.GetPage());
-    auto parent = BPlusTreeInternalPage<KeyType, page_id_t, Comparator>::From(
-        parent_pageguard.GetPage());
-
-    parent->Insert(left_leaf->KeyAt(0), left_pid);
-    parent->Insert(right_leaf->KeyAt(0), right_pid);
-  }
-  parent_pageguard.SetDirty();
+void BPlusTree<KeyType, ValueType, Comparator>::LogEntry(
+    Transaction *txn, LogRecordType type, PageGuard *pageguard,
+    PageGuard *header_guard, const KeyType &key, const ValueType &value) {
+  entry_count_ += type == LogRecordType::INDEX_INSERT ? 1 : -1;
+  BPlusTreeHeaderPage::From(header_guard->GetPage())->entry_count =
+      entry_count_;
+  header_guard->SetDirty();
+  if (log_manager_ == nullptr || txn == nullptr) {
+    return;
+  }
+  LogRecord record(txn->GetTxnId(), txn->GetPrevLSN(), type, header_page_id_,
+                   pageguard->GetPageId(), value,
+                   reinterpret_cast<const char *>(&key), sizeof(KeyType));
+  AppendLog(txn, &record, pageguard->GetPage());
+  header_guard->GetPage()->SetLSN(record.GetLSN());
 }
+
+template <typename KeyType, typename ValueType, typename Comparator>
+void BPlusTree<KeyType, ValueType, Comparator>::LogStructureModification(
+    Transaction *txn, lsn_t undo_next, std::vector<PageGuard> *modified) {
+  if (log_manager_ != nullptr && txn != nullptr) {
+    // 镜像里的 page LSN 是旧的，重做时由恢复改成这条记录的 LSN
+    std::vector<std::pair<page_id_t, const char *>> pages;
+    for (auto &pageguard : *modified) {
+      pages.emplace_back(pageguard.GetPageId(), pageguard.GetPage()->GetData());
+    }
+    LogRecord record(txn->GetTxnId(), txn->GetPrevLSN(), undo_next, pages);
+    lsn_t lsn = log_manager_->AppendLogRecord(&record);
+    txn->SetPrevLSN(lsn);
+    for (auto &pageguard : *modified) {
+      pageguard.GetPage()->SetLSN(lsn);
+    }
+  }
+  modified->clear();
+}
+
 template class BPlusTree<int32_t, RID, mini::IntComparator>;
 
 } // namespace mini
@@ -105,10 +105,7 @@ bool BPlusTreeLeafPage<KeyType, ValueType, Comparator>::Insert(
     return false;
   }
   uint16_t key_count = this->GetKeyCount();
-  uint16_t index = 0;
-  while (index < key_count && Comparator{}(array_[index].key, key) < 0) {
-    index++;
-  }
+  uint16_t index = KeyIndex(key);
   for (uint16_t i = key_count; i > index; --i) {
     array_[i] = array_[i - 1];
   }
@@ -118,6 +115,31 @@ bool BPlusTreeLeafPage<KeyType, ValueType, Comparator>::Insert(
   return true;
 }
 
+template <typename KeyType, typename ValueType, typename Comparator>
+uint16_t BPlusTreeLeafPage<KeyType, ValueType, Comparator>::KeyIndex(
+    const KeyType &key) const {
+  uint16_t left = 0, right = this->GetKeyCount();
+  while (left < right) {
+    uint16_t mid = left + (right - left) / 2;
+    if (Comparator{}(array_[mid].key, key) < 0) {
+      left = mid + 1;
+    } else {
+      right = mid;
+    }
+  }
+  return left;
+}
+
+template <typename KeyType, typename ValueType, typename Comparator>
+void BPlusTreeLeafPage<KeyType, ValueType, Comparator>::RemoveAt(
+    uint16_t index) {
+  uint16_t key_count = this->GetKeyCount();
+  for (uint16_t i = index; i + 1 < key_count; ++i) {
+    array_[i] = array_[i + 1];
+  }
+  this->SetKeyCount(key_count - 1);
+}
+
 template <typename KeyType, typename ValueType, typename Comparator>
 bool BPlusTreeLeafPage<KeyType, ValueType, Comparator>::Split(
     BPlusTreeLeafPage *new_page) {
@@ -0,0 +1,444 @@
+#include "index/extendible_hash_table.h"
+#include "common/comparator.h"
+#include "common/page.h"
+#include "index/bplus_tree_page.h"
+#include "index/hash_table_page.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <set>
+#include <stdexcept>
+
+namespace mini {
+
+template <typename KeyType, typename ValueType, typename Comparator>
+ExtendibleHashTable<KeyType, ValueType, Comparator>::ExtendibleHashTable(
+    BufferPool *buffer_pool, bool unique, LogManager *log_manager,
+    uint16_t bucket_max_size)
+    : buffer_pool_(buffer_pool), log_manager_(log_manager), unique_(unique),
+      bucket_max_size_(bucket_max_size) {
+  if (bucket_max_size_ < 2 || bucket_max_size_ > BucketPage::MAX_SIZE) {
+    throw std::invalid_argument("bucket size out of range");
+  }
+  // 目录页和第一个桶等第一次插入时再建，那时才有事务可以记日志
+  auto pageguard = buffer_pool_->NewPageGuarded(&header_page_id_);
+  auto header = HashTableHeaderPage::From(pageguard.GetPage());
+  header->lsn = INVALID_LSN;
+  header->global_depth = 0;
+  header->key_type = KeyTypeOf<KeyType>();
+  header->key_size = sizeof(KeyType);
+  header->unique = unique_;
+  header->bucket_max_size = bucket_max_size_;
+  header->directory_page_count = 0;
+  pageguard.SetDirty();
+}
+
+template <typename KeyType, typename ValueType, typename Comparator>
+ExtendibleHashTable<KeyType, ValueType, Comparator>::ExtendibleHashTable(
+    BufferPool *buffer_pool, page_id_t header_page_id, LogManager *log_manager)
+    : buffer_pool_(buffer_pool), log_manager_(log_manager),
+      header_page_id_(header_page_id) {
+  auto pageguard = buffer_pool_->FetchPageGuarded(header_page_id_);
+  auto header = HashTableHeaderPage::From(pageguard.GetPage());
+  if (header->key_type != KeyTypeOf<KeyType>() ||
+      header->key_size != sizeof(KeyType)) {
+    throw std::runtime_error("index header does not match the key type");
+  }
+  global_depth_ = header->global_depth;
+  unique_ = header->unique;
+  bucket_max_size_ = header->bucket_max_size;
+  directory_page_ids_.assign(header->directory_page_ids,
+                             header->directory_page_ids +
+                                 header->directory_page_count);
+}
+
+// 事务里下一条记录的 undo_next：指向事务目前的最后一条日志
+static lsn_t LastLSN(Transaction *txn) {
+  return txn == nullptr ? INVALID_LSN : txn->GetPrevLSN();
+}
+
+template <typename KeyType, typename ValueType, typename Comparator>
+bool ExtendibleHashTable<KeyType, ValueType, Comparator>::Insert(
+    const KeyType &key, const ValueType &value, Transaction *txn) {
+  if (directory_page_ids_.empty()) {
+    CreateDirectory(txn);
+  }
+  while (true) {
+    uint32_t slot = Hash(key) & ((1U << global_depth_) - 1);
+    page_id_t page_id = BucketPageIdOf(slot);
+    page_id_t free_page_id = INVALID_PAGE_ID; // 第一个有空位的页
+    page_id_t tail_page_id = INVALID_PAGE_ID;
+    bool same_key = true; // 链上全是这个 key，分裂也分不开
+    // 唯一表要看完整条链才知道 key 在不在
+    while (page_id != INVALID_PAGE_ID) {
+      auto pageguard = buffer_pool_->FetchPageGuarded(page_id);
+      auto bucket = BucketPage::From(pageguard.GetPage());
+      if (unique_ && bucket->Contains(key)) {
+        return false;
+      }
+      // 没有溢出页的桶有空位就直接插
+      if (tail_page_id == INVALID_PAGE_ID && !bucket->IsFull() &&
+          bucket->GetNextPageId() == INVALID_PAGE_ID) {
+        bucket->Insert(key, value);
+        pageguard.SetDirty();
+        LogEntry(txn, LogRecordType::HASH_INSERT, &pageguard, key, value);
+        return true;
+      }
+      if (!bucket->IsFull() && free_page_id == INVALID_PAGE_ID) {
+        free_page_id = page_id;
+      }
+      same_key = same_key &&
+                 (bucket->IsEmpty() ||
+                  (Comparator{}(bucket->KeyAt(0), key) == 0 &&
+                   Comparator{}(bucket->KeyAt(bucket->Size() - 1), key) == 0));
+      tail_page_id = page_id;
+      page_id = bucket->GetNextPageId();
+    }
+
+    // 溢出链上只放同一个 key：链上还有别的 key 时连同整条链分裂，
+    // 之后重新定位。分不开时才往链上的空位插，或者接一个溢出页
+    uint32_t local_depth = LocalDepthOf(slot);
+    bool can_split = local_depth < global_depth_ ||
+                     global_depth_ < HashTableHeaderPage::MAX_GLOBAL_DEPTH;
+    if (!same_key && can_split) {
+      SplitBucket(slot, txn);
+    } else if (free_page_id != INVALID_PAGE_ID) {
+      auto pageguard = buffer_pool_->FetchPageGuarded(free_page_id);
+      BucketPage::From(pageguard.GetPage())->Insert(key, value);
+      pageguard.SetDirty();
+      LogEntry(txn, LogRecordType::HASH_INSERT, &pageguard, key, value);
+      return true;
+    } else {
+      AppendOverflowPage(tail_page_id, txn);
+    }
+  }
+}
+
+template <typename KeyType, typename ValueType, typename Comparator>
+bool ExtendibleHashTable<KeyType, ValueType, Comparator>::GetValue(
+    const KeyType &key, std::vector<ValueType> *value) {
+  if (directory_page_ids_.empty()) {
+    return false;
+  }
+  bool found = false;
+  page_id_t page_id = BucketPageIdOf(Hash(key) & ((1U << global_depth_) - 1));
+  while (page_id != INVALID_PAGE_ID) {
+    auto pageguard = buffer_pool_->FetchPageGuarded(page_id);
+    auto bucket = BucketPage::From(pageguard.GetPage());
+    found = bucket->Lookup(key, value) || found;
+    page_id = bucket->GetNextPageId();
+  }
+  return found;
+}
+
+template <typename KeyType, typename ValueType, typename Comparator>
+bool ExtendibleHashTable<KeyType, ValueType, Comparator>::Remove(
+    const KeyType &key, const ValueType &value, Transaction *txn) {
+  if (directory_page_ids_.empty()) {
+    return false;
+  }
+  // 溢出页空了也留在链上
+  page_id_t page_id = BucketPageIdOf(Hash(key) & ((1U << global_depth_) - 1));
+  while (page_id != INVALID_PAGE_ID) {
+    auto pageguard = buffer_pool_->FetchPageGuarded(page_id);
+    auto bucket = BucketPage::From(pageguard.GetPage());
+    if (bucket->Remove(key, value)) {
+      pageguard.SetDirty();
+      LogEntry(txn, LogRecordType::HASH_DELETE, &pageguard, key, value);
+      return true;
+    }
+    page_id = bucket->GetNextPageId();
+  }
+  return false;
+}
+
+template <typename KeyType, typename ValueType, typename Comparator>
+void ExtendibleHashTable<KeyType, ValueType, Comparator>::Destroy() {
+  std::set<page_id_t> pages{header_page_id_};
+  for (page_id_t directory_page_id : directory_page_ids_) {
+    pages.insert(directory_page_id);
+    std::vector<page_id_t> buckets;
+    {
+      auto pageguard = buffer_pool_->FetchPageGuarded(directory_page_id);
+      auto dir = HashTableDirectoryPage::From(pageguard.GetPage());
+      for (uint32_t i = 0; i < HashTableDirectoryPage::SLOTS_PER_PAGE; ++i) {
+        buckets.push_back(dir->GetBucketPageId(i));
+      }
+    }
+    // 多个槽位可能指向同一个桶，见过的桶不再沿溢出链走
+    for (page_id_t page_id : buckets) {
+      while (page_id != INVALID_PAGE_ID && pages.insert(page_id).second) {
+        auto pageguard = buffer_pool_->FetchPageGuarded(page_id);
+        page_id = BucketPage::From(pageguard.GetPage())->GetNextPageId();
+      }
+    }
+  }
+  for (page_id_t page_id : pages) {
+    buffer_pool_->DeletePage(page_id);
+  }
+  header_page_id_ = INVALID_PAGE_ID;
+  directory_page_ids_.clear();
+}
+
+template <typename KeyType, typename ValueType, typename Comparator>
+uint32_t
+ExtendibleHashTable<KeyType, ValueType, Comparator>::Hash(const KeyType &key) {
+  // murmur3 的 fmix32，让低位也分布均匀，目录只看低 global depth 位
+  uint32_t h = static_cast<uint32_t>(key);
+  h ^= h >> 16;
+  h *= 0x85ebca6b;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35;
+  h ^= h >> 16;
+  return h;
+}
+
+template <typename KeyType, typename ValueType, typename Comparator>
+page_id_t
+ExtendibleHashTable<KeyType, ValueType, Comparator>::BucketPageIdOf(
+    uint32_t slot) {
+  auto pageguard = buffer_pool_->FetchPageGuarded(
+      directory_page_ids_[slot / HashTableDirectoryPage::SLOTS_PER_PAGE]);
+  return HashTableDirectoryPage::From(pageguard.GetPage())
+      ->GetBucketPageId(slot % HashTableDirectoryPage::SLOTS_PER_PAGE);
+}
+
+template <typename KeyType, typename ValueType, typename Comparator>
+uint32_t ExtendibleHashTable<KeyType, ValueType, Comparator>::LocalDepthOf(
+    uint32_t slot) {
+  auto pageguard = buffer_pool_->FetchPageGuarded(
+      directory_page_ids_[slot / HashTableDirectoryPage::SLOTS_PER_PAGE]);
+  return HashTableDirectoryPage::From(pageguard.GetPage())
+      ->GetLocalDepth(slot % HashTableDirectoryPage::SLOTS_PER_PAGE);
+}
+
+template <typename KeyType, typename ValueType, typename Comparator>
+void ExtendibleHashTable<KeyType, ValueType, Comparator>::CreateDirectory(
+    Transaction *txn) {
+  // global depth 为 0，只有一个桶
+  lsn_t undo_next = LastLSN(txn);
+  StagedPages staged;
+  page_id_t bucket_page_id;
+  BucketPage::From(StageNewPage(&staged, &bucket_page_id))
+      ->Init(bucket_max_size_);
+  page_id_t directory_page_id;
+  auto dir =
+      HashTableDirectoryPage::From(StageNewPage(&staged, &directory_page_id));
+  dir->Init();
+  dir->SetBucketPageId(0, bucket_page_id);
+  directory_page_ids_.push_back(directory_page_id);
+  StageHeader(&staged);
+  ApplyStructureModification(txn, undo_next, &staged);
+}
+
+template <typename KeyType, typename ValueType, typename Comparator>
+void ExtendibleHashTable<KeyType, ValueType, Comparator>::SplitBucket(
+    uint32_t slot, Transaction *txn) {
+  lsn_t undo_next = LastLSN(txn);
+  StagedPages staged;
+  uint32_t local_depth = LocalDepthOf(slot);
+  if (local_depth == global_depth_) {
+    // 目录翻倍，新的一半复制旧的一半。一页以内在页里复制，
+    // 之后每个目录页复制出一个新页
+    if (global_depth_ < HashTableDirectoryPage::DIRECTORY_PAGE_DEPTH) {
+      auto dir =
+          HashTableDirectoryPage::From(Stage(&staged, directory_page_ids_[0]));
+      uint32_t old_size = 1U << global_depth_;
+      for (uint32_t i = 0; i < old_size; ++i) {
+        dir->SetBucketPageId(old_size + i, dir->GetBucketPageId(i));
+        dir->SetLocalDepth(old_size + i, dir->GetLocalDepth(i));
+      }
+    } else {
+      size_t old_count = directory_page_ids_.size();
+      for (size_t i = 0; i < old_count; ++i) {
+        page_id_t page_id;
+        char *data = StageNewPage(&staged, &page_id);
+        auto pageguard = buffer_pool_->FetchPageGuarded(directory_page_ids_[i]);
+        std::memcpy(data, pageguard.GetPage()->GetData(), PAGE_SIZE);
+        directory_page_ids_.push_back(page_id);
+      }
+    }
+    global_depth_++;
+    StageHeader(&staged);
+  }
+
+  // 按第 local_depth 位把整条链上的项分成两份。原来的链页留着重用，
+  // 第一页还是留下的那一份的第一页，目录里其余的槽位不用改
+  uint32_t split_bit = 1U << local_depth;
+  std::vector<Entry> kept, moved;
+  std::vector<page_id_t> chain;
+  for (page_id_t page_id = BucketPageIdOf(slot); page_id != INVALID_PAGE_ID;) {
+    chain.push_back(page_id);
+    auto bucket = BucketPage::From(Stage(&staged, page_id));
+    for (uint16_t i = 0; i < bucket->Size(); ++i) {
+      auto &side = (Hash(bucket->KeyAt(i)) & split_bit) ? moved : kept;
+      side.emplace_back(bucket->KeyAt(i), bucket->ValueAt(i));
+    }
+    page_id = bucket->GetNextPageId();
+  }
+  std::vector<page_id_t> spare(chain.rbegin(), chain.rend());
+  page_id_t old_page_id = WriteChain(&staged, kept, &spare);
+  page_id_t new_page_id = WriteChain(&staged, moved, &spare);
+  // 原来的链里有空页时会剩下，接在留下的那条链后面
+  page_id_t tail_page_id = old_page_id;
+  while (!spare.empty()) {
+    page_id_t next_page_id;
+    while ((next_page_id = BucketPage::From(Stage(&staged, tail_page_id))
+                               ->GetNextPageId()) != INVALID_PAGE_ID) {
+      tail_page_id = next_page_id;
+    }
+    auto bucket = BucketPage::From(Stage(&staged, spare.back()));
+    bucket->SetSize(0);
+    bucket->SetNextPageId(INVALID_PAGE_ID);
+    BucketPage::From(Stage(&staged, tail_page_id))
+        ->SetNextPageId(spare.back());
+    spare.pop_back();
+  }
+
+  // 指向旧桶的槽位低 local_depth 位都和 slot 相同，其中一半改为指向新桶
+  for (uint32_t i = slot & (split_bit - 1); i < (1U << global_depth_);
+       i += split_bit) {
+    auto dir = HashTableDirectoryPage::From(Stage(
+        &staged,
+        directory_page_ids_[i / HashTableDirectoryPage::SLOTS_PER_PAGE]));
+    uint32_t offset = i % HashTableDirectoryPage::SLOTS_PER_PAGE;
+    dir->SetLocalDepth(offset, local_depth + 1);
+    if (i & split_bit) {
+      dir->SetBucketPageId(offset, new_page_id);
+    }
+  }
+  ApplyStructureModification(txn, undo_next, &staged);
+}
+
+template <typename KeyType, typename ValueType, typename Comparator>
+page_id_t ExtendibleHashTable<KeyType, ValueType, Comparator>::WriteChain(
+    StagedPages *staged, const std::vector<Entry> &entries,
+    std::vector<page_id_t> *spare) {
+  // 每页里的项按 key 有序，整条链一起排好再按顺序切开
+  std::vector<Entry> sorted = entries;
+  std::stable_sort(sorted.begin(), sorted.end(),
+                   [](const auto &a, const auto &b) {
+                     return Comparator{}(a.first, b.first) < 0;
+                   });
+  page_id_t head_page_id = INVALID_PAGE_ID;
+  BucketPage *prev = nullptr;
+  size_t next = 0;
+  do {
+    page_id_t page_id;
+    BucketPage *bucket;
+    if (!spare->empty()) {
+      // 重用的页保留原来的 page LSN
+      page_id = spare->back();
+      spare->pop_back();
+      bucket = BucketPage::From(Stage(staged, page_id));
+    } else {
+      bucket = BucketPage::From(StageNewPage(staged, &page_id));
+      bucket->Init(bucket_max_size_);
+    }
+    uint16_t count = static_cast<uint16_t>(
+        std::min<size_t>(bucket->MaxSize(), sorted.size() - next));
+    for (uint16_t i = 0; i < count; ++i, ++next) {
+      bucket->SetKeyAt(i, sorted[next].first);
+      bucket->SetValueAt(i, sorted[next].second);
+    }
+    bucket->SetSize(count);
+    bucket->SetNextPageId(INVALID_PAGE_ID);
+    if (prev == nullptr) {
+      head_page_id = page_id;
+    } else {
+      prev->SetNextPageId(page_id);
+    }
+    prev = bucket;
+  } while (next < sorted.size());
+  return head_page_id;
+}
+
+template <typename KeyType, typename ValueType, typename Comparator>
+void ExtendibleHashTable<KeyType, ValueType, Comparator>::AppendOverflowPage(
+    page_id_t tail_page_id, Transaction *txn) {
+  lsn_t undo_next = LastLSN(txn);
+  StagedPages staged;
+  page_id_t page_id;
+  BucketPage::From(StageNewPage(&staged, &page_id))->Init(bucket_max_size_);
+  BucketPage::From(Stage(&staged, tail_page_id))->SetNextPageId(page_id);
+  ApplyStructureModification(txn, undo_next, &staged);
+}
+
+template <typename KeyType, typename ValueType, typename Comparator>
+char *ExtendibleHashTable<KeyType, ValueType, Comparator>::Stage(
+    StagedPages *staged, page_id_t page_id) {
+  auto it = staged->find(page_id);
+  if (it == staged->end()) {
+    auto pageguard = buffer_pool_->FetchPageGuarded(page_id);
+    const char *data = pageguard.GetPage()->GetData();
+    it = staged->emplace(page_id, std::vector<char>(data, data + PAGE_SIZE))
+             .first;
+  }
+  return it->second.data();
+}
+
+template <typename KeyType, typename ValueType, typename Comparator>
+char *ExtendibleHashTable<KeyType, ValueType, Comparator>::StageNewPage(
+    StagedPages *staged, page_id_t *page_id) {
+  buffer_pool_->NewPageGuarded(page_id);
+  return staged->emplace(*page_id, std::vector<char>(PAGE_SIZE, 0))
+      .first->second.data();
+}
+
+template <typename KeyType, typename ValueType, typename Comparator>
+void ExtendibleHashTable<KeyType, ValueType, Comparator>::StageHeader(
+    StagedPages *staged) {
+  auto header = HashTableHeaderPage::From(Stage(staged, header_page_id_));
+  header->global_depth = global_depth_;
+  header->directory_page_count =
+      static_cast<uint32_t>(directory_page_ids_.size());
+  std::copy(directory_page_ids_.begin(), directory_page_ids_.end(),
+            header->directory_page_ids);
+}
+
+template <typename KeyType, typename ValueType, typename Comparator>
+void ExtendibleHashTable<KeyType, ValueType, Comparator>::
+    ApplyStructureModification(Transaction *txn, lsn_t undo_next,
+                               StagedPages *staged) {
+  bool logging = log_manager_ != nullptr && txn != nullptr;
+  lsn_t lsn = INVALID_LSN;
+  if (logging) {
+    // 副本里的 page LSN 是旧的，重做时由恢复改成这条记录的 LSN
+    std::vector<std::pair<page_id_t, const char *>> pages;
+    for (const auto &[page_id, data] : *staged) {
+      pages.emplace_back(page_id, data.data());
+    }
+    LogRecord record(txn->GetTxnId(), txn->GetPrevLSN(), undo_next, pages);
+    lsn = log_manager_->AppendLogRecord(&record);
+    txn->SetPrevLSN(lsn);
+  }
+  for (const auto &[page_id, data] : *staged) {
+    auto pageguard = buffer_pool_->FetchPageGuarded(page_id);
+    std::memcpy(pageguard.GetPage()->GetData(), data.data(), PAGE_SIZE);
+    pageguard.SetDirty();
+    if (logging) {
+      pageguard.GetPage()->SetLSN(lsn);
+      buffer_pool_->LowerRecLSN(page_id, lsn);
+    }
+  }
+  staged->clear();
+}
+
+template <typename KeyType, typename ValueType, typename Comparator>
+void ExtendibleHashTable<KeyType, ValueType, Comparator>::LogEntry(
+    Transaction *txn, LogRecordType type, PageGuard *pageguard,
+    const KeyType &key, const ValueType &value) {
+  if (log_manager_ == nullptr || txn == nullptr) {
+    return;
+  }
+  LogRecord record(txn->GetTxnId(), txn->GetPrevLSN(), type, header_page_id_,
+                   pageguard->GetPageId(), value,
+                   reinterpret_cast<const char *>(&key), sizeof(KeyType));
+  lsn_t lsn = log_manager_->AppendLogRecord(&record);
+  txn->SetPrevLSN(lsn);
+  pageguard->GetPage()->SetLSN(lsn);
+}
+
+template class ExtendibleHashTable<int32_t, RID, mini::IntComparator>;
+
+} // namespace mini
@@ -0,0 +1,92 @@
+#include "index/hash_table_page.h"
+#include "common/comparator.h"
+#include "common/rid.h"
+#include <cstdint>
+
+namespace mini {
+
+// ---------------------------HashTableDirectoryPage------------------------------
+void HashTableDirectoryPage::Init() {
+  lsn_ = INVALID_LSN;
+  for (uint32_t i = 0; i < SLOTS_PER_PAGE; ++i) {
+    local_depths_[i] = 0;
+    bucket_page_ids_[i] = INVALID_PAGE_ID;
+  }
+}
+
+// ----------------------------HashTableBucketPage--------------------------------
+template <typename KeyType, typename ValueType, typename Comparator>
+uint16_t HashTableBucketPage<KeyType, ValueType, Comparator>::KeyIndex(
+    const KeyType &key) const {
+  uint16_t left = 0, right = header_.size;
+  while (left < right) {
+    uint16_t mid = left + (right - left) / 2;
+    if (Comparator{}(array_[mid].key, key) < 0) {
+      left = mid + 1;
+    } else {
+      right = mid;
+    }
+  }
+  return left;
+}
+
+template <typename KeyType, typename ValueType, typename Comparator>
+bool HashTableBucketPage<KeyType, ValueType, Comparator>::Contains(
+    const KeyType &key) const {
+  uint16_t index = KeyIndex(key);
+  return index < header_.size && Comparator{}(array_[index].key, key) == 0;
+}
+
+template <typename KeyType, typename ValueType, typename Comparator>
+bool HashTableBucketPage<KeyType, ValueType, Comparator>::Lookup(
+    const KeyType &key, std::vector<ValueType> *value) const {
+  bool found = false;
+  for (uint16_t i = KeyIndex(key);
+       i < header_.size && Comparator{}(array_[i].key, key) == 0; ++i) {
+    value->push_back(array_[i].value);
+    found = true;
+  }
+  return found;
+}
+
+template <typename KeyType, typename ValueType, typename Comparator>
+bool HashTableBucketPage<KeyType, ValueType, Comparator>::Insert(
+    const KeyType &key, const ValueType &value) {
+  if (IsFull()) {
+    return false;
+  }
+  uint16_t index = KeyIndex(key);
+  for (uint16_t i = header_.size; i > index; --i) {
+    array_[i] = array_[i - 1];
+  }
+  array_[index].key = key;
+  array_[index].value = value;
+  header_.size++;
+  return true;
+}
+
+template <typename KeyType, typename ValueType, typename Comparator>
+bool HashTableBucketPage<KeyType, ValueType, Comparator>::Remove(
+    const KeyType &key, const ValueType &value) {
+  for (uint16_t i = KeyIndex(key);
+       i < header_.size && Comparator{}(array_[i].key, key) == 0; ++i) {
+    if (array_[i].value == value) {
+      RemoveAt(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+template <typename KeyType, typename ValueType, typename Comparator>
+void HashTableBucketPage<KeyType, ValueType, Comparator>::RemoveAt(
+    uint16_t index) {
+  for (uint16_t i = index; i + 1 < header_.size; ++i) {
+    array_[i] = array_[i + 1];
+  }
+  header_.size--;
+}
+
+template class HashTableBucketPage<int32_t, RID, mini::IntComparator>;
+
+} // namespace mini
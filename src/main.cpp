@@ -12,10 +12,16 @@
 
 #include "binder/binder.h"
 #include "catalog/catalog.h"
+#include "concurrency/lock_manager.h"
+#include "concurrency/transaction_manager.h"
 #include "execution/execution_context.h"
 #include "execution/executor.h"
 #include "parser/lexer.h"
 #include "parser/parser.h"
+#include "planner/planner.h"
+#include "recovery/checkpoint_manager.h"
+#include "recovery/log_manager.h"
+#include "recovery/log_recovery.h"
 #include "storage/buffer_pool.h"
 #include "storage/disk_manager.h"
 #include "storage/tuple.h"
@@ -103,7 +109,7 @@ static void PrintSelectHeader(const std::vector<Column> &cols,
 
 template <class ValueOf>
 static void PrintRows(const std::vector<Column> &cols,
-                      const std::vector<size_t> &widths, SelectExecutor &exec,
+                      const std::vector<size_t> &widths, Executor &exec,
                       ValueOf value_of) {
   Tuple t;
   size_t row_count = 0;
@@ -138,12 +144,39 @@ int main() {
     // std::filesystem::remove("data/mini.db");
     auto disk = std::make_unique<DiskManager>("mini.db");
 
-    BufferPool bpm(1000, disk.get());
+    LogManager log_manager(disk.get());
+    BufferPool bpm(1000, disk.get(), &log_manager);
 
-    Catalog catalog(&bpm);
-    ExecutionContext ctx(catalog);
+    // 上次没有正常退出时，先用日志把数据文件恢复到一致的状态
+    LogRecovery recovery(disk.get(), &bpm, &log_manager);
+    recovery.Recover();
+    if (recovery.GetRedoCount() > 0 || recovery.GetLoserCount() > 0) {
+      std::cout << "recovered: redo " << recovery.GetRedoCount()
+                << " changes, rolled back " << recovery.GetLoserCount()
+                << " transactions\n";
+    }
+
+    Catalog catalog(&bpm, &log_manager);
+    LockManager lock_manager;
+    TransactionManager txn_manager(&log_manager, &lock_manager);
+    ExecutionContext ctx(catalog, &txn_manager);
+
+    // 从目录页读回上次建的表和索引，第一次启动时才建默认表
+    catalog.Load();
+    if (catalog.GetTable("t") == nullptr) {
+      BootstrapCatalog(catalog);
+      // 建表和初始数据不写日志，写完立即刷盘
+      catalog.Persist();
+      bpm.FlushAllPages();
+    }
+    // 之后按时间或日志增长在后台做检查点，下次启动从这里开始恢复
+    CheckpointManager checkpoint_manager(disk.get(), &bpm, &log_manager);
+    checkpoint_manager.Checkpoint();
 
-    BootstrapCatalog(catalog);
+    // 每执行这么多条语句回收一次旧版本。只有一个会话，
+    // 在语句之间回收不会和读写并发
+    constexpr size_t GC_INTERVAL = 64;
+    size_t statements = 0;
 
     std::cout << "MiniDB ready. Type SQL, or 'quit'.\n";
 
@@ -178,113 +211,99 @@ int main() {
       }
 
       // 3.3 Executor
-      switch (bound->Type()) {
-
-      case BoundStatementType::BOUND_INSERT: {
-        auto *raw = dynamic_cast<BoundInsertStatement *>(bound.release());
-        if (!raw) {
-          std::cerr << "[exec error] bad bound stmt type\n";
-          continue;
+      try {
+        BoundStatementType type = bound->Type();
+        TransactionCommand command{};
+        if (type == BoundStatementType::BOUND_TRANSACTION) {
+          command =
+              static_cast<BoundTransactionStatement *>(bound.get())->Command();
         }
-        std::unique_ptr<BoundInsertStatement> ins(raw);
-
-        // 改动：传 ctx
-        InsertExecutor exec(ctx, std::move(ins));
-        exec.Init();
-        while (exec.Next(nullptr)) {
+        // SELECT 先由 Planner 建计划树，再按计划组装算子
+        Planner planner(ctx);
+        std::unique_ptr<Executor> exec =
+            planner.CreateExecutor(std::move(bound));
+        if (type == BoundStatementType::BOUND_EXECUTE) {
+          // 按预编译的语句输出
+          type = static_cast<ExecuteExecutor *>(exec.get())->GetStatementType();
         }
-        std::cout << "OK (insert)\n";
-        break;
-      }
 
-      case BoundStatementType::BOUND_SELECT: {
-        auto *raw = dynamic_cast<BoundSelectStatement *>(bound.release());
-        if (!raw) {
-          std::cerr << "[exec error] bad bound stmt type\n";
-          continue;
+        if (type == BoundStatementType::BOUND_EXPLAIN) {
+          // 计划一行一个节点，不用表格
+          auto schema = exec->GetSchema();
+          exec->Init();
+          Tuple t;
+          while (exec->Next(&t)) {
+            std::cout << t.GetValue(schema, 0)->ToString() << "\n";
+          }
+        } else if (type == BoundStatementType::BOUND_SELECT) {
+          auto schema = exec->GetSchema();
+          const std::vector<Column> &cols = schema->GetColumns();
+          std::vector<size_t> widths(cols.size());
+          for (size_t i = 0; i < cols.size(); i++) {
+            widths[i] = std::max(cols[i].name.size(), DefaultWidth(cols[i]));
+          }
+          auto start = std::chrono::steady_clock::now();
+          exec->Init();
+          PrintSelectHeader(cols, widths);
+          PrintRows(cols, widths, *exec,
+                    [&schema](const Tuple &t, size_t col_idx) -> std::string {
+                      return t.GetValue(schema, col_idx)->ToString();
+                    });
+          auto end = std::chrono::steady_clock::now();
+          auto duration = end - start;
+          double ms =
+              std::chrono::duration<double, std::milli>(duration).count();
+          std::cout << "(time: " << ms << " ms)\n";
+        } else {
+          exec->Init();
+          while (exec->Next(nullptr)) {
+          }
+          switch (type) {
+          case BoundStatementType::BOUND_INSERT:
+            std::cout << "OK (insert)\n";
+            break;
+          case BoundStatementType::BOUND_CREATE_TABLE:
+            std::cout << "OK (create table)\n";
+            break;
+          case BoundStatementType::BOUND_CREATE_INDEX:
+            std::cout << "OK (create index)\n";
+            break;
+          case BoundStatementType::BOUND_ANALYZE:
+            std::cout << "OK (analyze)\n";
+            break;
+          case BoundStatementType::BOUND_PREPARE:
+            std::cout << "OK (prepare)\n";
+            break;
+          case BoundStatementType::BOUND_TRANSACTION:
+            std::cout << (command == TransactionCommand::BEGIN ? "BEGIN\n"
+                          : command == TransactionCommand::COMMIT
+                              ? "COMMIT\n"
+                              : "ROLLBACK\n");
+            break;
+          default:
+            break;
+          }
         }
-        std::unique_ptr<BoundSelectStatement> sel(raw);
-
-        // 改动：传 ctx
-        SelectExecutor exec(ctx, std::move(sel));
-
-        auto schema = exec.GetSchema();
-        const std::vector<Column> &cols = schema->GetColumns();
-        std::vector<size_t> widths(cols.size());
-        for (size_t i = 0; i < cols.size(); i++) {
-          widths[i] = std::max(cols[i].name.size(), DefaultWidth(cols[i]));
-        }
-        auto start = std::chrono::steady_clock::now();
-        exec.Init();
-        PrintSelectHeader(cols, widths);
-        PrintRows(cols, widths, exec,
-                  [&schema](const Tuple &t, size_t col_idx) -> std::string {
-                    return t.GetValue(schema, col_idx)->ToString();
-                  });
-        auto end = std::chrono::steady_clock::now();
-        auto duration = end - start;
-        double ms = std::chrono::duration<double, std::milli>(duration).count();
-        std::cout << "(time: " << ms << " ms)\n";
-        break;
+      } catch (const std::exception &e) {
+        // 单条语句出错（例如违反唯一约束）不影响 REPL 继续运行
+        std::cerr << "[exec error] " << e.what() << "\n";
       }
 
-      case BoundStatementType::BOUND_CREATE_TABLE: {
-        auto *raw = dynamic_cast<BoundCreateTableStatement *>(bound.release());
-        if (!raw) {
-          std::cerr << "[exec error] bad bound stmt type\n";
-          continue;
-        }
-        std::unique_ptr<BoundCreateTableStatement> ct(raw);
-
-        // 改动：传 ctx
-        CreateTableExecutor exec(ctx, std::move(ct));
-        exec.Init();
-        while (exec.Next(nullptr)) {
-        }
-        std::cout << "OK (create table)\n";
-        break;
-      }
-
-      case BoundStatementType::BOUND_CREATE_INDEX: {
-        auto *raw = dynamic_cast<BoundCreateIndexStatement *>(bound.release());
-        if (!raw) {
-          std::cerr << "[exec error] bad bound stmt type\n";
-          continue;
-        }
-        std::unique_ptr<BoundCreateIndexStatement> ci(raw);
-
-        // 改动：传 ctx
-        CreateIndexExecutor exec(ctx, std::move(ci));
-        exec.Init();
-        while (exec.Next(nullptr)) {
-        }
-        std::cout << "OK (create index)\n";
-        break;
-      }
-
-        // case BoundStatementType::BOUND_DELETE: {
-        //   auto *raw = dynamic_cast<BoundDeleteStatement *>(bound.release());
-        //   if (!raw) {
-        //     std::cerr << "[exec error] bad bound stmt type\n";
-        //     continue;
-        //   }
-        //   std::unique_ptr<BoundDeleteStatement> del(raw);
-
-        //   // 改动：传 ctx
-        //   DeleteExecutor exec(ctx, std::move(del));
-        //   exec.Init();
-        //   while (exec.Next(nullptr)) {
-        //   }
-        //   std::cout << "OK (delete)\n";
-        //   break;
-        // }
-
-      default:
-        std::cerr << "[exec error] unsupported statement\n";
-        break;
+      if (++statements % GC_INTERVAL == 0) {
+        // 回收本身也是一个事务，删版本和删索引项一起写日志
+        txn_id_t horizon = txn_manager.GetGcHorizon();
+        Transaction *gc = txn_manager.Begin();
+        catalog.CollectGarbage(horizon, gc);
+        txn_manager.Commit(gc);
       }
     }
 
+    // 退出时还没提交的事务回滚
+    if (ctx.GetTransaction() != nullptr) {
+      txn_manager.Abort(ctx.GetTransaction());
+      ctx.SetTransaction(nullptr);
+    }
+    bpm.FlushAllPages();
     std::cout << "bye.\n";
     return 0;
 
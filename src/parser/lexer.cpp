@@ -180,6 +180,10 @@ Token Lexer::ScanSymbol() {
     AdvanceChar();
     return Token(TokenType::TOKEN_EQUAL, span,
                  std::string_view(&input_[start_pos], 1));
+  case '?':
+    AdvanceChar();
+    return Token(TokenType::TOKEN_PARAMETER, span,
+                 std::string_view(&input_[start_pos], 1));
   default:
     return MakeErrorToken(ErrorKind::ERROR_INVALID_CHARACTER, span,
                           "Invalid character");
@@ -220,6 +224,56 @@ TokenType Lexer::MatchKeyword(std::string_view lexeme) const {
     return TokenType::TOKEN_INDEX;
   } else if (lexeme == "ON") {
     return TokenType::TOKEN_ON;
+  } else if (lexeme == "UNIQUE") {
+    return TokenType::TOKEN_UNIQUE;
+  } else if (lexeme == "PRIMARY") {
+    return TokenType::TOKEN_PRIMARY;
+  } else if (lexeme == "KEY") {
+    return TokenType::TOKEN_KEY;
+  } else if (lexeme == "USING") {
+    return TokenType::TOKEN_USING;
+  } else if (lexeme == "COUNT") {
+    return TokenType::TOKEN_COUNT;
+  } else if (lexeme == "BEGIN") {
+    return TokenType::TOKEN_BEGIN;
+  } else if (lexeme == "COMMIT") {
+    return TokenType::TOKEN_COMMIT;
+  } else if (lexeme == "ROLLBACK") {
+    return TokenType::TOKEN_ROLLBACK;
+  } else if (lexeme == "JOIN") {
+    return TokenType::TOKEN_JOIN;
+  } else if (lexeme == "ORDER") {
+    return TokenType::TOKEN_ORDER;
+  } else if (lexeme == "BY") {
+    return TokenType::TOKEN_BY;
+  } else if (lexeme == "ASC") {
+    return TokenType::TOKEN_ASC;
+  } else if (lexeme == "DESC") {
+    return TokenType::TOKEN_DESC;
+  } else if (lexeme == "GROUP") {
+    return TokenType::TOKEN_GROUP;
+  } else if (lexeme == "SUM") {
+    return TokenType::TOKEN_SUM;
+  } else if (lexeme == "MIN") {
+    return TokenType::TOKEN_MIN;
+  } else if (lexeme == "MAX") {
+    return TokenType::TOKEN_MAX;
+  } else if (lexeme == "AVG") {
+    return TokenType::TOKEN_AVG;
+  } else if (lexeme == "LIMIT") {
+    return TokenType::TOKEN_LIMIT;
+  } else if (lexeme == "OFFSET") {
+    return TokenType::TOKEN_OFFSET;
+  } else if (lexeme == "ANALYZE") {
+    return TokenType::TOKEN_ANALYZE;
+  } else if (lexeme == "EXPLAIN") {
+    return TokenType::TOKEN_EXPLAIN;
+  } else if (lexeme == "PREPARE") {
+    return TokenType::TOKEN_PREPARE;
+  } else if (lexeme == "EXECUTE") {
+    return TokenType::TOKEN_EXECUTE;
+  } else if (lexeme == "AS") {
+    return TokenType::TOKEN_AS;
   }
   return TokenType::TOKEN_IDENTIFIER;
 }
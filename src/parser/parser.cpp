@@ -16,6 +16,18 @@ std::unique_ptr<Statement> Parser::ParseStatement() {
     return ParseInsertStatement();
   case TokenType::TOKEN_SELECT:
     return ParseSelectStatement();
+  case TokenType::TOKEN_BEGIN:
+  case TokenType::TOKEN_COMMIT:
+  case TokenType::TOKEN_ROLLBACK:
+    return ParseTransactionStatement();
+  case TokenType::TOKEN_ANALYZE:
+    return ParseAnalyzeStatement();
+  case TokenType::TOKEN_EXPLAIN:
+    return ParseExplainStatement();
+  case TokenType::TOKEN_PREPARE:
+    return ParsePrepareStatement();
+  case TokenType::TOKEN_EXECUTE:
+    return ParseExecuteStatement();
   case TokenType::TOKEN_CREATE: {
     Expect(TokenType::TOKEN_CREATE);
     Token next = lexer_->PeekToken();
@@ -23,9 +35,12 @@ std::unique_ptr<Statement> Parser::ParseStatement() {
       return ParseCreateTableStatement();
     } else if (next.GetType() == TokenType::TOKEN_INDEX) {
       return ParseCreateIndexStatement();
+    } else if (next.GetType() == TokenType::TOKEN_UNIQUE) {
+      Expect(TokenType::TOKEN_UNIQUE);
+      return ParseCreateIndexStatement(true);
     } else {
       error_ = ParserError(ErrorKind::ERROR_UNSUPPORTED_TOKEN, next.GetSpan(),
-                           "Expected TABLE or INDEX after CREATE.");
+                           "Expected TABLE, INDEX or UNIQUE after CREATE.");
       return nullptr;
     }
   }
@@ -41,8 +56,27 @@ std::unique_ptr<Statement> Parser::ParseInsertStatement() {
   Expect(TokenType::TOKEN_INTO);
   Token table_name = Expect(TokenType::TOKEN_IDENTIFIER);
   Expect(TokenType::TOKEN_VALUES);
+  std::vector<InsertStatement::Row> rows;
+  do {
+    auto values = ParseInsertRow();
+    if (!values) {
+      return nullptr;
+    }
+    rows.push_back(std::move(*values));
+    if (lexer_->PeekToken().GetType() != TokenType::TOKEN_COMMA) {
+      break;
+    }
+    Expect(TokenType::TOKEN_COMMA);
+  } while (true);
+  Expect(TokenType::TOKEN_SEMICOLON);
+  return std::make_unique<InsertStatement>(std::string(table_name.GetLexeme()),
+                                           std::move(rows));
+}
+
+std::optional<InsertStatement::Row> Parser::ParseInsertRow() {
+  // (value, ...)
   Expect(TokenType::TOKEN_LEFT_PAREN);
-  std::vector<std::unique_ptr<Literal>> values;
+  InsertStatement::Row values;
   do {
     Token next = lexer_->PeekToken();
     if (next.GetType() == TokenType::TOKEN_RIGHT_PAREN) {
@@ -53,7 +87,13 @@ std::unique_ptr<Statement> Parser::ParseInsertStatement() {
       continue;
     }
 
-    if (next.GetType() == TokenType::TOKEN_STRING) {
+    if (next.GetType() == TokenType::TOKEN_PARAMETER) {
+      if (!ParseParameter()) {
+        return std::nullopt;
+      }
+      values.push_back(
+          std::make_unique<ParameterLiteral>(parameter_count_ - 1));
+    } else if (next.GetType() == TokenType::TOKEN_STRING) {
       Token str_token = Expect(TokenType::TOKEN_STRING);
       values.push_back(std::make_unique<StringLiteral>(str_token.GetLexeme()));
     } else if (next.GetType() == TokenType::TOKEN_NUMBER) {
@@ -62,48 +102,211 @@ std::unique_ptr<Statement> Parser::ParseInsertStatement() {
     } else {
       error_ = ParserError(ErrorKind::ERROR_UNSUPPORTED_TOKEN, next.GetSpan(),
                            "Expected literal value.");
-      return nullptr;
+      return std::nullopt;
     }
   } while (true);
   Expect(TokenType::TOKEN_RIGHT_PAREN);
-  Expect(TokenType::TOKEN_SEMICOLON);
-  return std::make_unique<InsertStatement>(std::string(table_name.GetLexeme()),
-                                           std::move(values));
+  return values;
 }
 
 std::unique_ptr<Statement> Parser::ParseSelectStatement() {
-  // TODO: v1 only support "SELECT * FROM table_name;"
+  // SELECT * FROM table_name [WHERE col = value];
+  // SELECT COUNT(*) FROM table_name [WHERE col = value];
+  // SELECT * FROM a JOIN b ON a.x = b.y [WHERE a.col = value];
+  // SELECT col, SUM(col), ... FROM ... [WHERE ...] [GROUP BY col, ...];
+  // 以上都可以跟 [ORDER BY col [ASC|DESC], ...]，COUNT(*) 除外，
+  // 最后是 [LIMIT n [OFFSET m]]
   Expect(TokenType::TOKEN_SELECT);
-  Expect(TokenType::TOKEN_STAR);
+  bool is_select_all = false;
+  std::vector<SelectItem> select_list;
+  if (lexer_->PeekToken().GetType() == TokenType::TOKEN_STAR) {
+    Expect(TokenType::TOKEN_STAR);
+    is_select_all = true;
+  } else {
+    do {
+      if (!select_list.empty()) {
+        Expect(TokenType::TOKEN_COMMA);
+      }
+      select_list.push_back(ParseSelectItem());
+    } while (lexer_->PeekToken().GetType() == TokenType::TOKEN_COMMA &&
+             !error_.has_value());
+  }
   Expect(TokenType::TOKEN_FROM);
   Token table_name = Expect(TokenType::TOKEN_IDENTIFIER);
 
-  Token next = lexer_->PeekToken();
-  if (next.GetType() == TokenType::TOKEN_WHERE) {
+  std::optional<JoinClause> join;
+  if (lexer_->PeekToken().GetType() == TokenType::TOKEN_JOIN) {
+    Expect(TokenType::TOKEN_JOIN);
+    Token join_table = Expect(TokenType::TOKEN_IDENTIFIER);
+    Expect(TokenType::TOKEN_ON);
+    ColumnRef left = ParseColumnRef();
+    Expect(TokenType::TOKEN_EQUAL);
+    ColumnRef right = ParseColumnRef();
+    join = JoinClause{std::string(join_table.GetLexeme()), std::move(left),
+                      std::move(right)};
+  }
+
+  bool has_where = false;
+  ColumnRef where_column;
+  std::unique_ptr<Value> where_value;
+  if (lexer_->PeekToken().GetType() == TokenType::TOKEN_WHERE) {
     Expect(TokenType::TOKEN_WHERE);
     // SELECT * FROM stu WHERE id = 1;
-    Token column_name_token = Expect(TokenType::TOKEN_IDENTIFIER);
+    where_column = ParseColumnRef();
     Expect(TokenType::TOKEN_EQUAL);
-    // TODO: only support int literal in where clause in v1
-    Token value_token = Expect(TokenType::TOKEN_NUMBER);
-    Expect(TokenType::TOKEN_SEMICOLON);
-    return std::make_unique<SelectStatement>(
-        std::string(table_name.GetLexeme()), true, true,
-        std::string(column_name_token.GetLexeme()),
-        std::make_unique<IntValue>(
-            std::stoi(std::string(value_token.GetLexeme()))));
+    if (lexer_->PeekToken().GetType() == TokenType::TOKEN_PARAMETER) {
+      // WHERE id = ?，参数只能是 INT
+      if (!ParseParameter()) {
+        return nullptr;
+      }
+      where_value = std::make_unique<ParameterValue>(parameter_count_ - 1,
+                                                     DataType::INTEGER);
+    } else {
+      // TODO: only support int literal in where clause in v1
+      Token value_token = Expect(TokenType::TOKEN_NUMBER);
+      if (error_.has_value()) {
+        return nullptr;
+      }
+      where_value = std::make_unique<IntValue>(
+          std::stoi(std::string(value_token.GetLexeme())));
+    }
+    has_where = true;
   }
 
+  std::vector<ColumnRef> group_by;
+  if (lexer_->PeekToken().GetType() == TokenType::TOKEN_GROUP) {
+    Expect(TokenType::TOKEN_GROUP);
+    Expect(TokenType::TOKEN_BY);
+    do {
+      if (!group_by.empty()) {
+        Expect(TokenType::TOKEN_COMMA);
+      }
+      group_by.push_back(ParseColumnRef());
+    } while (lexer_->PeekToken().GetType() == TokenType::TOKEN_COMMA &&
+             !error_.has_value());
+  }
+
+  std::vector<OrderByItem> order_by;
+  if (lexer_->PeekToken().GetType() == TokenType::TOKEN_ORDER) {
+    order_by = ParseOrderBy();
+  }
+  bool has_limit = false;
+  size_t limit = 0;
+  size_t offset = 0;
+  if (lexer_->PeekToken().GetType() == TokenType::TOKEN_LIMIT) {
+    Expect(TokenType::TOKEN_LIMIT);
+    Token limit_token = Expect(TokenType::TOKEN_NUMBER);
+    if (!error_.has_value()) {
+      has_limit = true;
+      limit = std::stoull(std::string(limit_token.GetLexeme()));
+    }
+    if (lexer_->PeekToken().GetType() == TokenType::TOKEN_OFFSET) {
+      Expect(TokenType::TOKEN_OFFSET);
+      Token offset_token = Expect(TokenType::TOKEN_NUMBER);
+      if (!error_.has_value()) {
+        offset = std::stoull(std::string(offset_token.GetLexeme()));
+      }
+    }
+  }
   Expect(TokenType::TOKEN_SEMICOLON);
-  return std::make_unique<SelectStatement>(std::string(table_name.GetLexeme()));
+  if (error_.has_value()) {
+    return nullptr;
+  }
+  // 只有 COUNT(*) 一项时还按原来的 COUNT(*) 查询处理
+  bool is_count_star =
+      group_by.empty() && select_list.size() == 1 &&
+      select_list[0].aggregate == AggregateType::COUNT_STAR;
+  if (is_count_star) {
+    select_list.clear();
+  }
+  auto statement = std::make_unique<SelectStatement>(
+      std::string(table_name.GetLexeme()), is_select_all, has_where,
+      where_column.column, std::move(where_value), is_count_star,
+      where_column.table, std::move(join), std::move(order_by));
+  statement->Set_select_list(std::move(select_list));
+  statement->Set_group_by(std::move(group_by));
+  if (has_limit) {
+    statement->Set_limit(limit, offset);
+  }
+  return statement;
+}
+
+SelectItem Parser::ParseSelectItem() {
+  AggregateType aggregate = AggregateType::NONE;
+  TokenType next = lexer_->PeekToken().GetType();
+  switch (next) {
+  case TokenType::TOKEN_COUNT:
+    aggregate = AggregateType::COUNT;
+    break;
+  case TokenType::TOKEN_SUM:
+    aggregate = AggregateType::SUM;
+    break;
+  case TokenType::TOKEN_MIN:
+    aggregate = AggregateType::MIN;
+    break;
+  case TokenType::TOKEN_MAX:
+    aggregate = AggregateType::MAX;
+    break;
+  case TokenType::TOKEN_AVG:
+    aggregate = AggregateType::AVG;
+    break;
+  default:
+    return SelectItem{AggregateType::NONE, ParseColumnRef()};
+  }
+  Expect(next);
+  Expect(TokenType::TOKEN_LEFT_PAREN);
+  SelectItem item{aggregate, {}};
+  if (aggregate == AggregateType::COUNT &&
+      lexer_->PeekToken().GetType() == TokenType::TOKEN_STAR) {
+    Expect(TokenType::TOKEN_STAR);
+    item.aggregate = AggregateType::COUNT_STAR;
+  } else {
+    item.column = ParseColumnRef();
+  }
+  Expect(TokenType::TOKEN_RIGHT_PAREN);
+  return item;
+}
+
+ColumnRef Parser::ParseColumnRef() {
+  Token first = Expect(TokenType::TOKEN_IDENTIFIER);
+  if (lexer_->PeekToken().GetType() != TokenType::TOKEN_DOT) {
+    return ColumnRef{"", std::string(first.GetLexeme())};
+  }
+  Expect(TokenType::TOKEN_DOT);
+  Token column = Expect(TokenType::TOKEN_IDENTIFIER);
+  return ColumnRef{std::string(first.GetLexeme()),
+                   std::string(column.GetLexeme())};
+}
+
+std::vector<OrderByItem> Parser::ParseOrderBy() {
+  Expect(TokenType::TOKEN_ORDER);
+  Expect(TokenType::TOKEN_BY);
+  std::vector<OrderByItem> items;
+  do {
+    if (!items.empty()) {
+      Expect(TokenType::TOKEN_COMMA);
+    }
+    SelectItem selected = ParseSelectItem();
+    OrderByItem item{selected.column, false, selected.aggregate};
+    TokenType next = lexer_->PeekToken().GetType();
+    if (next == TokenType::TOKEN_ASC || next == TokenType::TOKEN_DESC) {
+      Expect(next);
+      item.desc = next == TokenType::TOKEN_DESC;
+    }
+    items.push_back(std::move(item));
+  } while (lexer_->PeekToken().GetType() == TokenType::TOKEN_COMMA &&
+           !error_.has_value());
+  return items;
 }
 
 std::unique_ptr<Statement> Parser::ParseCreateTableStatement() {
-  // TODO: only support "CREATE TABLE table_name (col_name col_type,...);"
+  // CREATE TABLE table_name (col_name col_type [PRIMARY KEY], ...
+  //                          [, PRIMARY KEY (col_name)]);
   Expect(TokenType::TOKEN_TABLE);
   Token table_name = Expect(TokenType::TOKEN_IDENTIFIER);
   Expect(TokenType::TOKEN_LEFT_PAREN);
   std::vector<std::pair<std::string, ColumnType>> columns;
+  std::vector<std::string> primary_key;
   do {
     Token next = lexer_->PeekToken();
     if (next.GetType() == TokenType::TOKEN_RIGHT_PAREN) {
@@ -113,6 +316,21 @@ std::unique_ptr<Statement> Parser::ParseCreateTableStatement() {
       Expect(TokenType::TOKEN_COMMA);
       continue;
     }
+    if (next.GetType() == TokenType::TOKEN_PRIMARY) {
+      // 表级约束 PRIMARY KEY (col_name)
+      Expect(TokenType::TOKEN_PRIMARY);
+      Expect(TokenType::TOKEN_KEY);
+      Expect(TokenType::TOKEN_LEFT_PAREN);
+      Token pk_token = Expect(TokenType::TOKEN_IDENTIFIER);
+      Expect(TokenType::TOKEN_RIGHT_PAREN);
+      if (!primary_key.empty()) {
+        error_ = ParserError(ErrorKind::ERROR_UNSUPPORTED_TOKEN,
+                             next.GetSpan(), "Multiple primary keys.");
+        return nullptr;
+      }
+      primary_key.emplace_back(pk_token.GetLexeme());
+      continue;
+    }
 
     Token col_name_token = Expect(TokenType::TOKEN_IDENTIFIER);
     Token col_type_token = Expect(TokenType::TOKEN_IDENTIFIER);
@@ -134,15 +352,28 @@ std::unique_ptr<Statement> Parser::ParseCreateTableStatement() {
                            col_type_token.GetSpan(), "Unsupported data type.");
       return nullptr;
     }
+
+    if (lexer_->PeekToken().GetType() == TokenType::TOKEN_PRIMARY) {
+      // 列级约束 col_name col_type PRIMARY KEY
+      Token pk_token = Expect(TokenType::TOKEN_PRIMARY);
+      Expect(TokenType::TOKEN_KEY);
+      if (!primary_key.empty()) {
+        error_ = ParserError(ErrorKind::ERROR_UNSUPPORTED_TOKEN,
+                             pk_token.GetSpan(), "Multiple primary keys.");
+        return nullptr;
+      }
+      primary_key.push_back(col_name);
+    }
   } while (true);
   Expect(TokenType::TOKEN_RIGHT_PAREN);
   Expect(TokenType::TOKEN_SEMICOLON);
   return std::make_unique<CreateTableStatement>(
-      std::string(table_name.GetLexeme()), std::move(columns));
+      std::string(table_name.GetLexeme()), std::move(columns),
+      std::move(primary_key));
 }
 
-std::unique_ptr<Statement> Parser::ParseCreateIndexStatement() {
-  // CREATE INDEX idx_stu_id ON stu(id);
+std::unique_ptr<Statement> Parser::ParseCreateIndexStatement(bool is_unique) {
+  // CREATE [UNIQUE] INDEX idx_stu_id ON stu(id) [USING HASH|BTREE];
   Expect(TokenType::TOKEN_INDEX);
   Token index_name = Expect(TokenType::TOKEN_IDENTIFIER);
   Expect(TokenType::TOKEN_ON);
@@ -153,10 +384,17 @@ std::unique_ptr<Statement> Parser::ParseCreateIndexStatement() {
   Token column_name_token = Expect(TokenType::TOKEN_IDENTIFIER);
   column_names.push_back(std::string(column_name_token.GetLexeme()));
   Expect(TokenType::TOKEN_RIGHT_PAREN);
+  std::string index_method;
+  if (lexer_->PeekToken().GetType() == TokenType::TOKEN_USING) {
+    // ... USING HASH;
+    Expect(TokenType::TOKEN_USING);
+    Token method_token = Expect(TokenType::TOKEN_IDENTIFIER);
+    index_method = std::string(method_token.GetLexeme());
+  }
   Expect(TokenType::TOKEN_SEMICOLON);
   return std::make_unique<CreateIndexStatement>(
       std::string(index_name.GetLexeme()), std::string(table_name.GetLexeme()),
-      std::move(column_names));
+      std::move(column_names), is_unique, std::move(index_method));
 }
 
 Token Parser::Expect(TokenType expected) {
@@ -178,4 +416,144 @@ Token Parser::Expect(TokenType expected) {
   return token;
 }
 
+std::unique_ptr<Statement> Parser::ParseTransactionStatement() {
+  // BEGIN; COMMIT; ROLLBACK;
+  Token token = lexer_->NextToken();
+  TransactionCommand command;
+  switch (token.GetType()) {
+  case TokenType::TOKEN_BEGIN:
+    command = TransactionCommand::BEGIN;
+    break;
+  case TokenType::TOKEN_COMMIT:
+    command = TransactionCommand::COMMIT;
+    break;
+  case TokenType::TOKEN_ROLLBACK:
+    command = TransactionCommand::ROLLBACK;
+    break;
+  default:
+    error_ = ParserError(ErrorKind::ERROR_UNSUPPORTED_TOKEN, token.GetSpan(),
+                         "Expected BEGIN, COMMIT or ROLLBACK.");
+    return nullptr;
+  }
+  Expect(TokenType::TOKEN_SEMICOLON);
+  if (error_.has_value()) {
+    return nullptr;
+  }
+  return std::make_unique<TransactionStatement>(command);
+}
+
+std::unique_ptr<Statement> Parser::ParseAnalyzeStatement() {
+  // ANALYZE t;
+  Expect(TokenType::TOKEN_ANALYZE);
+  Token table_name = Expect(TokenType::TOKEN_IDENTIFIER);
+  Expect(TokenType::TOKEN_SEMICOLON);
+  if (error_.has_value()) {
+    return nullptr;
+  }
+  return std::make_unique<AnalyzeStatement>(
+      std::string(table_name.GetLexeme()));
+}
+
+std::unique_ptr<Statement> Parser::ParseExplainStatement() {
+  // EXPLAIN [ANALYZE] SELECT ...;
+  Expect(TokenType::TOKEN_EXPLAIN);
+  bool analyze = false;
+  if (lexer_->PeekToken().GetType() == TokenType::TOKEN_ANALYZE) {
+    Expect(TokenType::TOKEN_ANALYZE);
+    analyze = true;
+  }
+  if (lexer_->PeekToken().GetType() != TokenType::TOKEN_SELECT) {
+    error_ = ParserError(ErrorKind::ERROR_UNSUPPORTED_TOKEN,
+                         lexer_->PeekToken().GetSpan(),
+                         "Expected SELECT after EXPLAIN.");
+    return nullptr;
+  }
+  std::unique_ptr<Statement> select = ParseSelectStatement();
+  if (select == nullptr) {
+    return nullptr;
+  }
+  return std::make_unique<ExplainStatement>(
+      std::unique_ptr<SelectStatement>(
+          static_cast<SelectStatement *>(select.release())),
+      analyze);
+}
+
+std::unique_ptr<Statement> Parser::ParsePrepareStatement() {
+  // PREPARE name AS SELECT ... / INSERT ...;
+  Expect(TokenType::TOKEN_PREPARE);
+  Token name = Expect(TokenType::TOKEN_IDENTIFIER);
+  Expect(TokenType::TOKEN_AS);
+  if (error_.has_value()) {
+    return nullptr;
+  }
+  Token next = lexer_->PeekToken();
+  if (next.GetType() != TokenType::TOKEN_SELECT &&
+      next.GetType() != TokenType::TOKEN_INSERT) {
+    error_ = ParserError(ErrorKind::ERROR_UNSUPPORTED_TOKEN, next.GetSpan(),
+                         "Expected SELECT or INSERT after PREPARE ... AS.");
+    return nullptr;
+  }
+  // 这里只检查语法，正文由 PlanCache 解析、绑定后缓存
+  bool allow_parameters = allow_parameters_;
+  allow_parameters_ = true;
+  std::unique_ptr<Statement> body = next.GetType() == TokenType::TOKEN_SELECT
+                                        ? ParseSelectStatement()
+                                        : ParseInsertStatement();
+  allow_parameters_ = allow_parameters;
+  if (body == nullptr || error_.has_value()) {
+    return nullptr;
+  }
+  size_t start = next.GetSpan().start;
+  return std::make_unique<PrepareStatement>(
+      std::string(name.GetLexeme()),
+      std::string(
+          lexer_->GetInput().substr(start, lexer_->GetPosition() - start)));
+}
+
+std::unique_ptr<Statement> Parser::ParseExecuteStatement() {
+  // EXECUTE name [(value, ...)];
+  Expect(TokenType::TOKEN_EXECUTE);
+  Token name = Expect(TokenType::TOKEN_IDENTIFIER);
+  std::vector<std::unique_ptr<Value>> parameters;
+  if (lexer_->PeekToken().GetType() == TokenType::TOKEN_LEFT_PAREN) {
+    Expect(TokenType::TOKEN_LEFT_PAREN);
+    while (!error_.has_value() &&
+           lexer_->PeekToken().GetType() != TokenType::TOKEN_RIGHT_PAREN) {
+      if (!parameters.empty()) {
+        Expect(TokenType::TOKEN_COMMA);
+        if (error_.has_value()) {
+          break;
+        }
+      }
+      Token value = lexer_->NextToken();
+      if (value.GetType() == TokenType::TOKEN_NUMBER) {
+        parameters.push_back(std::make_unique<IntValue>(value.GetLexeme()));
+      } else if (value.GetType() == TokenType::TOKEN_STRING) {
+        parameters.push_back(std::make_unique<StringValue>(value.GetLexeme()));
+      } else {
+        error_ = ParserError(ErrorKind::ERROR_UNSUPPORTED_TOKEN,
+                             value.GetSpan(), "Expected literal value.");
+      }
+    }
+    Expect(TokenType::TOKEN_RIGHT_PAREN);
+  }
+  Expect(TokenType::TOKEN_SEMICOLON);
+  if (error_.has_value()) {
+    return nullptr;
+  }
+  return std::make_unique<ExecuteStatement>(std::string(name.GetLexeme()),
+                                            std::move(parameters));
+}
+
+bool Parser::ParseParameter() {
+  Token token = Expect(TokenType::TOKEN_PARAMETER);
+  if (!allow_parameters_) {
+    error_ = ParserError(ErrorKind::ERROR_UNSUPPORTED_TOKEN, token.GetSpan(),
+                         "Parameter ? is only allowed in PREPARE.");
+    return false;
+  }
+  parameter_count_++;
+  return true;
+}
+
 } // namespace mini
@@ -0,0 +1,152 @@
+#include "planner/plan_cache.h"
+#include "binder/binder.h"
+#include "parser/lexer.h"
+#include "parser/parser.h"
+#include <stdexcept>
+
+namespace mini {
+
+using Parameters = std::vector<std::unique_ptr<Value>>;
+
+static std::unique_ptr<Value> InstantiateValue(const Value *value,
+                                               const Parameters &parameters) {
+  if (value == nullptr) {
+    return nullptr;
+  }
+  const auto *param = dynamic_cast<const ParameterValue *>(value);
+  if (param == nullptr) {
+    return value->Clone();
+  }
+  const Value *actual = parameters[param->Index()].get();
+  if (actual->Type() != param->Type()) {
+    throw std::runtime_error(
+        "parameter " + std::to_string(param->Index() + 1) + " should be " +
+        (param->Type() == DataType::INTEGER ? "INT" : "VARCHAR"));
+  }
+  return actual->Clone();
+}
+
+static std::unique_ptr<BoundSelectStatement>
+InstantiateSelect(const BoundSelectStatement &stmt,
+                  const Parameters &parameters) {
+  std::unique_ptr<BoundSelectStatement> copy;
+  if (const BoundJoin *join = stmt.Join()) {
+    auto join_copy = std::make_unique<BoundJoin>();
+    join_copy->left = InstantiateSelect(*join->left, parameters);
+    join_copy->right = InstantiateSelect(*join->right, parameters);
+    join_copy->left_column = join->left_column;
+    join_copy->right_column = join->right_column;
+    join_copy->left_index = join->left_index;
+    join_copy->right_index = join->right_index;
+    copy = std::make_unique<BoundSelectStatement>(
+        std::move(join_copy), stmt.GetSchema(), stmt.IsCountStar());
+  } else {
+    copy = std::make_unique<BoundSelectStatement>(
+        stmt.Table(), stmt.Index(), stmt.HasWhere(), stmt.WhereColumn(),
+        InstantiateValue(stmt.WhereValue(), parameters), stmt.IsCountStar(),
+        stmt.IsIndexOnly());
+  }
+  copy->SetOrderBy(stmt.OrderBy());
+  if (const BoundAggregation *aggregation = stmt.Aggregation()) {
+    copy->SetAggregation(std::make_unique<BoundAggregation>(*aggregation));
+  }
+  copy->SetScanColumns(stmt.ScanColumns(), stmt.GetScanSchema());
+  copy->SetProjection(stmt.Projection());
+  if (stmt.HasLimit()) {
+    copy->SetLimit(stmt.Limit(), stmt.Offset());
+  }
+  return copy;
+}
+
+std::unique_ptr<BoundStatement>
+CachedStatement::Instantiate(const Parameters &parameters) const {
+  if (parameters.size() != parameter_count) {
+    throw std::runtime_error("expected " + std::to_string(parameter_count) +
+                             " parameters, got " +
+                             std::to_string(parameters.size()));
+  }
+  if (bound->Type() == BoundStatementType::BOUND_SELECT) {
+    return InstantiateSelect(static_cast<const BoundSelectStatement &>(*bound),
+                             parameters);
+  }
+  const auto &insert = static_cast<const BoundInsertStatement &>(*bound);
+  std::vector<BoundInsertStatement::Row> rows(insert.RowCount());
+  for (size_t r = 0; r < rows.size(); ++r) {
+    for (size_t i = 0; i < insert.ValueCount(r); ++i) {
+      rows[r].push_back(InstantiateValue(insert.ValueAt(r, i), parameters));
+    }
+  }
+  return std::make_unique<BoundInsertStatement>(insert.Table(),
+                                                std::move(rows));
+}
+
+std::string PlanCache::Normalize(const std::string &sql) {
+  Lexer lexer(sql);
+  std::string normalized;
+  for (Token token = lexer.NextToken();
+       token.GetType() != TokenType::TOKEN_EOF &&
+       token.GetType() != TokenType::TOKEN_INVALID;
+       token = lexer.NextToken()) {
+    if (!normalized.empty()) {
+      normalized += ' ';
+    }
+    if (token.GetType() == TokenType::TOKEN_STRING) {
+      normalized += "'" + std::string(token.GetLexeme()) + "'";
+    } else {
+      normalized += token.GetLexeme();
+    }
+  }
+  return normalized;
+}
+
+std::shared_ptr<const CachedStatement> PlanCache::Get(const std::string &sql) {
+  std::lock_guard<std::mutex> guard(latch_);
+  auto it = entries_.find(sql);
+  if (it != entries_.end()) {
+    if (it->second->second->catalog_version == catalog_.GetVersion()) {
+      hit_count_++;
+      lru_.splice(lru_.begin(), lru_, it->second);
+      return it->second->second;
+    }
+    lru_.erase(it->second);
+    entries_.erase(it);
+  }
+  miss_count_++;
+  std::shared_ptr<const CachedStatement> cached = Bind(sql);
+  lru_.emplace_front(sql, cached);
+  entries_[sql] = lru_.begin();
+  if (lru_.size() > CAPACITY) {
+    entries_.erase(lru_.back().first);
+    lru_.pop_back();
+  }
+  return cached;
+}
+
+size_t PlanCache::Size() const {
+  std::lock_guard<std::mutex> guard(latch_);
+  return lru_.size();
+}
+
+std::shared_ptr<const CachedStatement>
+PlanCache::Bind(const std::string &sql) {
+  Parser parser(std::make_unique<Lexer>(sql), true);
+  auto stmt = parser.ParseStatement();
+  if (stmt == nullptr) {
+    throw std::runtime_error("parse error: " + parser.GetError().Message());
+  }
+  if (stmt->Type() != StatementType::SELECT &&
+      stmt->Type() != StatementType::INSERT) {
+    throw std::runtime_error("only SELECT and INSERT can be prepared");
+  }
+  Binder binder(catalog_);
+  auto cached = std::make_shared<CachedStatement>();
+  cached->bound = binder.BindStatement(*stmt);
+  if (cached->bound == nullptr) {
+    throw std::runtime_error("bind error: " + binder.GetError().Message());
+  }
+  cached->parameter_count = parser.ParameterCount();
+  cached->catalog_version = catalog_.GetVersion();
+  return cached;
+}
+
+} // namespace mini
@@ -0,0 +1,80 @@
+#include "planner/plan_node.h"
+#include <cstdio>
+#include <functional>
+
+namespace mini {
+
+std::string PlanNode::Describe(bool analyze) const {
+  std::string text;
+  switch (type) {
+  case PlanType::SEQ_SCAN:
+    text = "Seq Scan on " + table->name;
+    break;
+  case PlanType::INDEX_SCAN:
+    text = "Index Scan on " + table->name + " using " + index->index_name;
+    break;
+  case PlanType::INDEX_ONLY_SCAN:
+    text = "Index Only Scan on " + table->name + " using " + index->index_name;
+    break;
+  case PlanType::HASH_JOIN:
+    text = "Hash Join build on " + Child(left_first ? 0 : 1)->table->name;
+    break;
+  case PlanType::INDEX_NESTED_LOOP_JOIN:
+    text = "Index Nested Loop Join outer " +
+           Child(left_first ? 0 : 1)->table->name;
+    break;
+  case PlanType::SORT_MERGE_JOIN:
+    text = "Sort Merge Join";
+    break;
+  case PlanType::COUNT:
+    text = "Count";
+    break;
+  case PlanType::HASH_AGGREGATE:
+    text = "Hash Aggregate";
+    break;
+  case PlanType::SORT:
+    text = "Sort";
+    break;
+  case PlanType::TOP_N:
+    text = "Top-N " + std::to_string(limit);
+    break;
+  case PlanType::PROJECTION:
+    text = "Projection";
+    break;
+  case PlanType::LIMIT:
+    text = "Limit " + std::to_string(limit);
+    if (offset > 0) {
+      text += " offset " + std::to_string(offset);
+    }
+    break;
+  }
+  char estimate[64];
+  snprintf(estimate, sizeof(estimate), " (rows=%.0f cost=%.2f)", rows, cost);
+  text += estimate;
+  if (!analyze) {
+    return text;
+  }
+  if (actual.loops == 0) {
+    return text + " (never executed)";
+  }
+  char buf[128];
+  snprintf(buf, sizeof(buf),
+           " (actual rows=%zu loops=%zu time=%.3fms hits=%zu misses=%zu)",
+           actual.rows, actual.loops, actual.ms, actual.hits, actual.misses);
+  return text + buf;
+}
+
+std::string PlanNode::ToString(bool analyze) const {
+  std::string out;
+  std::function<void(const PlanNode &, size_t)> print =
+      [&](const PlanNode &node, size_t depth) {
+        out += std::string(depth * 2, ' ') + node.Describe(analyze) + "\n";
+        for (const auto &child : node.children) {
+          print(*child, depth + 1);
+        }
+      };
+  print(*this, 0);
+  return out;
+}
+
+} // namespace mini
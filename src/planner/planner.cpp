@@ -0,0 +1,354 @@
+#include "planner/planner.h"
+#include "common/page.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace mini {
+
+// child 上面接一个 type 节点，代价在 child 之上再加 cost
+static std::unique_ptr<PlanNode> Wrap(PlanType type,
+                                      std::unique_ptr<PlanNode> child,
+                                      double rows, double cost) {
+  auto node = std::make_unique<PlanNode>(type);
+  node->rows = rows;
+  node->cost = child->cost + cost;
+  node->children.push_back(std::move(child));
+  return node;
+}
+
+static double Width(const Schema &schema) {
+  return std::max<double>(schema.GetTupleLength(), 1);
+}
+
+std::unique_ptr<PlanNode>
+Planner::PlanSelect(const BoundSelectStatement &stmt) {
+  bool ordered = OrderedByJoinColumn(stmt);
+  std::unique_ptr<PlanNode> node =
+      stmt.Join() != nullptr ? PlanJoin(stmt, ordered) : PlanScan(stmt);
+  bool sorted = ordered && node->type == PlanType::SORT_MERGE_JOIN;
+  double width = Width(*stmt.GetScanSchema());
+
+  if (stmt.IsCountStar()) {
+    double rows = node->rows;
+    node = Wrap(PlanType::COUNT, std::move(node), 1, rows * CPU_OPERATOR_COST);
+  }
+  if (const BoundAggregation *aggregation = stmt.Aggregation()) {
+    double groups = 1;
+    for (uint32_t column : aggregation->group_by) {
+      groups *= ColumnDistinct(stmt, column);
+    }
+    if (!aggregation->group_by.empty()) {
+      groups = std::min(groups, std::max(node->rows, 1.0));
+    }
+    double cost = node->rows * (CPU_TUPLE_COST + aggregation->items.size() *
+                                                     CPU_OPERATOR_COST);
+    // 哈希表放不下时部分结果写到分区再读回来
+    double group_width = Width(*aggregation->schema);
+    if (groups * (group_width + 48) > context_.GetWorkMemory()) {
+      cost += 2 * Pages(node->rows, width) * SEQ_PAGE_COST;
+    }
+    node = Wrap(PlanType::HASH_AGGREGATE, std::move(node), groups, cost);
+    width = group_width;
+  }
+
+  const auto &order_by = stmt.OrderBy();
+  if (!order_by.empty() && !sorted) {
+    double rows = node->rows;
+    // 要留的行放得进工作内存时只留前面的行，不用整个排序
+    size_t keep = stmt.Limit() + stmt.Offset();
+    if (stmt.HasLimit() && keep >= stmt.Limit() &&
+        keep <= context_.GetWorkMemory() / static_cast<size_t>(width)) {
+      double cost = rows * std::log2(std::max<double>(keep, 2)) *
+                    CPU_OPERATOR_COST;
+      node = Wrap(PlanType::TOP_N, std::move(node),
+                  std::min<double>(rows, keep), cost);
+      node->limit = keep;
+    } else {
+      node = Wrap(PlanType::SORT, std::move(node), rows,
+                  SortCost(rows, width));
+    }
+  }
+
+  auto projection = stmt.Projection();
+  if (projection != nullptr &&
+      projection->GetColumnCount() < stmt.ScanColumns().size()) {
+    double rows = node->rows;
+    node = Wrap(PlanType::PROJECTION, std::move(node), rows,
+                rows * CPU_OPERATOR_COST);
+  }
+  if (stmt.HasLimit()) {
+    double rows = std::max(node->rows - stmt.Offset(), 0.0);
+    node = Wrap(PlanType::LIMIT, std::move(node),
+                std::min<double>(rows, stmt.Limit()), 0);
+    node->limit = stmt.Limit();
+    node->offset = stmt.Offset();
+  }
+  return node;
+}
+
+std::unique_ptr<PlanNode> Planner::PlanScan(const BoundSelectStatement &stmt) {
+  TableInfo *table = stmt.Table();
+  double rows = TableRows(table);
+  double pages = TablePages(table);
+  auto node = std::make_unique<PlanNode>(PlanType::SEQ_SCAN);
+  node->table = table;
+  node->rows = rows;
+  node->cost = pages * SEQ_PAGE_COST + rows * CPU_TUPLE_COST;
+  if (!stmt.HasWhere()) {
+    return node;
+  }
+  node->rows = rows * Selectivity(table, stmt.WhereColumnId(),
+                                  *stmt.WhereValue());
+  node->cost += rows * CPU_OPERATOR_COST;
+
+  IndexInfo *index = stmt.Index();
+  if (index == nullptr || stmt.WhereValue()->Type() != DataType::INTEGER) {
+    return node;
+  }
+  // 索引能数出准确的匹配行数。每个匹配的行都要回表，最多把表上的页
+  // 都随机读一遍；只读索引时不回表
+  double matches = index->index->CountKey(*stmt.WhereValue());
+  double cost = RANDOM_PAGE_COST;
+  if (stmt.IsIndexOnly()) {
+    cost += matches * CPU_OPERATOR_COST;
+  } else {
+    cost += std::min(matches, pages) * RANDOM_PAGE_COST +
+            matches * CPU_TUPLE_COST;
+  }
+  node->rows = matches;
+  if (cost < node->cost) {
+    node->type =
+        stmt.IsIndexOnly() ? PlanType::INDEX_ONLY_SCAN : PlanType::INDEX_SCAN;
+    node->index = index;
+    node->cost = cost;
+  }
+  return node;
+}
+
+std::unique_ptr<PlanNode> Planner::PlanJoin(const BoundSelectStatement &stmt,
+                                            bool sorted_output) {
+  const BoundJoin *join = stmt.Join();
+  std::unique_ptr<PlanNode> left = PlanScan(*join->left);
+  std::unique_ptr<PlanNode> right = PlanScan(*join->right);
+  double left_width = Width(*join->left->GetSchema());
+  double right_width = Width(*join->right->GetSchema());
+  double left_distinct = std::min(
+      Distinct(join->left->Table(), join->left_column), left->rows);
+  double right_distinct = std::min(
+      Distinct(join->right->Table(), join->right_column), right->rows);
+  // 等值连接：一边的每个值在另一边按均匀分布匹配
+  double rows = left->rows * right->rows /
+                std::max({left_distinct, right_distinct, 1.0});
+  double output_cost = rows * CPU_TUPLE_COST;
+
+  struct Candidate {
+    PlanType type;
+    bool left_first;
+    double cost;
+  };
+  std::vector<Candidate> candidates;
+  for (bool build_left : {true, false}) {
+    const PlanNode &build = build_left ? *left : *right;
+    const PlanNode &probe = build_left ? *right : *left;
+    double build_width = build_left ? left_width : right_width;
+    double probe_width = build_left ? right_width : left_width;
+    double cost = left->cost + right->cost + build.rows * CPU_TUPLE_COST +
+                  probe.rows * CPU_OPERATOR_COST + output_cost;
+    // 哈希表超过工作内存时两边都分区写出再读回
+    if (build.rows * (build_width + 48) > context_.GetWorkMemory()) {
+      cost += 2 * SEQ_PAGE_COST *
+              (Pages(build.rows, build_width) + Pages(probe.rows, probe_width));
+    }
+    candidates.push_back({PlanType::HASH_JOIN, build_left, cost});
+  }
+  // 外表每个不同的键查一次索引叶子，匹配的行从内表取。内表的页大多
+  // 已经在缓冲池里，每页按顺序读一次算
+  for (bool outer_left : {true, false}) {
+    IndexInfo *index = outer_left ? join->right_index : join->left_index;
+    if (index == nullptr) {
+      continue;
+    }
+    const PlanNode &outer = outer_left ? *left : *right;
+    const PlanNode &inner = outer_left ? *right : *left;
+    double probes = outer_left ? left_distinct : right_distinct;
+    double cost = outer.cost + probes * RANDOM_PAGE_COST +
+                  std::min(rows, TablePages(inner.table)) * SEQ_PAGE_COST +
+                  rows * CPU_TUPLE_COST + output_cost;
+    candidates.push_back({PlanType::INDEX_NESTED_LOOP_JOIN, outer_left, cost});
+  }
+  double merge_cost = left->cost + right->cost +
+                      SortCost(left->rows, left_width) +
+                      SortCost(right->rows, right_width) +
+                      (left->rows + right->rows) * CPU_OPERATOR_COST +
+                      output_cost;
+  // 其他连接之后还要把输出排序，排序归并连接不用
+  if (sorted_output) {
+    double sort_cost = SortCost(rows, left_width + right_width);
+    for (Candidate &candidate : candidates) {
+      candidate.cost += sort_cost;
+    }
+  }
+  candidates.push_back({PlanType::SORT_MERGE_JOIN, true, merge_cost});
+
+  Candidate best = candidates[0];
+  for (const Candidate &candidate : candidates) {
+    if (candidate.cost < best.cost) {
+      best = candidate;
+    }
+  }
+  if (sorted_output && best.type != PlanType::SORT_MERGE_JOIN) {
+    // 排序在 PlanSelect 里另外加节点
+    best.cost -= SortCost(rows, left_width + right_width);
+  }
+
+  auto node = std::make_unique<PlanNode>(best.type);
+  node->rows = rows;
+  node->cost = best.cost;
+  node->left_first = best.left_first;
+  if (best.type == PlanType::INDEX_NESTED_LOOP_JOIN) {
+    // 内表不扫描，换成按连接键查索引
+    std::unique_ptr<PlanNode> &inner = best.left_first ? right : left;
+    auto lookup = std::make_unique<PlanNode>(PlanType::INDEX_SCAN);
+    lookup->table = inner->table;
+    lookup->index = best.left_first ? join->right_index : join->left_index;
+    lookup->rows = rows;
+    lookup->cost = best.cost - (best.left_first ? left : right)->cost;
+    inner = std::move(lookup);
+  }
+  node->children.push_back(std::move(left));
+  node->children.push_back(std::move(right));
+  return node;
+}
+
+bool Planner::OrderedByJoinColumn(const BoundSelectStatement &stmt) {
+  const BoundJoin *join = stmt.Join();
+  const auto &order_by = stmt.OrderBy();
+  if (join == nullptr || stmt.Aggregation() != nullptr ||
+      order_by.size() != 1 || order_by[0].desc) {
+    return false;
+  }
+  // ORDER BY 的下标指向扫描出来的行，换回连接输出里的位置
+  const auto &scan_columns = stmt.ScanColumns();
+  uint32_t column = scan_columns.empty() ? order_by[0].column
+                                         : scan_columns[order_by[0].column];
+  uint32_t left_count = join->left->GetSchema()->GetColumnCount();
+  return column == join->left_column ||
+         column == left_count + join->right_column;
+}
+
+// ANALYZE 过的表用统计信息里的行数，否则用表里的槽数（含删掉的版本）。
+// 页数总是表实际占的页数
+double Planner::TableRows(const TableInfo *table) const {
+  if (auto statistics = std::atomic_load(&table->statistics)) {
+    return statistics->RowCount();
+  }
+  return static_cast<double>(table->table->GetSlotCount());
+}
+
+double Planner::TablePages(const TableInfo *table) const {
+  return std::max<double>(table->table->GetPageCount(), 1);
+}
+
+double Planner::Distinct(const TableInfo *table, uint32_t column) {
+  if (auto statistics = std::atomic_load(&table->statistics)) {
+    return statistics->Distinct(column);
+  }
+  double rows = std::max(TableRows(table), 1.0);
+  // 唯一索引上每行的值都不同
+  const std::string &name = table->schema->GetColumn(column).name;
+  for (const auto &index : context_.GetCatalog().GetIndexes(table->name)) {
+    if (index->is_unique && index->key_schema->GetColumn(0).name == name) {
+      return rows;
+    }
+  }
+  return std::min(rows, DEFAULT_DISTINCT);
+}
+
+double Planner::Selectivity(const TableInfo *table, uint32_t column,
+                            const Value &value) {
+  auto statistics = std::atomic_load(&table->statistics);
+  if (statistics != nullptr && value.Type() == DataType::INTEGER) {
+    return statistics->EqualSelectivity(
+        column, static_cast<const IntValue &>(value).GetValue());
+  }
+  return 1 / Distinct(table, column);
+}
+
+double Planner::ColumnDistinct(const BoundSelectStatement &stmt,
+                               uint32_t column) {
+  const auto &scan_columns = stmt.ScanColumns();
+  if (!scan_columns.empty()) {
+    column = scan_columns[column];
+  }
+  const BoundJoin *join = stmt.Join();
+  if (join == nullptr) {
+    return Distinct(stmt.Table(), column);
+  }
+  uint32_t left_count = join->left->GetSchema()->GetColumnCount();
+  return column < left_count
+             ? Distinct(join->left->Table(), column)
+             : Distinct(join->right->Table(), column - left_count);
+}
+
+double Planner::SortCost(double rows, double width) const {
+  double cost = rows * std::log2(std::max(rows, 2.0)) * CPU_OPERATOR_COST;
+  // 每行还有一个排序项，放不下时写出顺串再归并读回
+  if (rows * (width + 24) > context_.GetWorkMemory()) {
+    cost += 2 * Pages(rows, width) * SEQ_PAGE_COST;
+  }
+  return cost;
+}
+
+double Planner::Pages(double rows, double width) const {
+  return std::ceil(rows * width / PAGE_SIZE);
+}
+
+std::unique_ptr<Executor>
+Planner::CreateExecutor(std::unique_ptr<BoundStatement> stmt) {
+  switch (stmt->Type()) {
+  case BoundStatementType::BOUND_SELECT:
+    return std::make_unique<SelectExecutor>(
+        context_, std::unique_ptr<BoundSelectStatement>(
+                      static_cast<BoundSelectStatement *>(stmt.release())));
+  case BoundStatementType::BOUND_INSERT:
+    return std::make_unique<InsertExecutor>(
+        context_, std::unique_ptr<BoundInsertStatement>(
+                      static_cast<BoundInsertStatement *>(stmt.release())));
+  case BoundStatementType::BOUND_CREATE_TABLE:
+    return std::make_unique<CreateTableExecutor>(
+        context_,
+        std::unique_ptr<BoundCreateTableStatement>(
+            static_cast<BoundCreateTableStatement *>(stmt.release())));
+  case BoundStatementType::BOUND_CREATE_INDEX:
+    return std::make_unique<CreateIndexExecutor>(
+        context_,
+        std::unique_ptr<BoundCreateIndexStatement>(
+            static_cast<BoundCreateIndexStatement *>(stmt.release())));
+  case BoundStatementType::BOUND_TRANSACTION:
+    return std::make_unique<TransactionExecutor>(
+        context_,
+        std::unique_ptr<BoundTransactionStatement>(
+            static_cast<BoundTransactionStatement *>(stmt.release())));
+  case BoundStatementType::BOUND_ANALYZE:
+    return std::make_unique<AnalyzeExecutor>(
+        context_, std::unique_ptr<BoundAnalyzeStatement>(
+                      static_cast<BoundAnalyzeStatement *>(stmt.release())));
+  case BoundStatementType::BOUND_EXPLAIN:
+    return std::make_unique<ExplainExecutor>(
+        context_, std::unique_ptr<BoundExplainStatement>(
+                      static_cast<BoundExplainStatement *>(stmt.release())));
+  case BoundStatementType::BOUND_PREPARE:
+    return std::make_unique<PrepareExecutor>(
+        context_, std::unique_ptr<BoundPrepareStatement>(
+                      static_cast<BoundPrepareStatement *>(stmt.release())));
+  case BoundStatementType::BOUND_EXECUTE:
+    return std::make_unique<ExecuteExecutor>(
+        context_, std::unique_ptr<BoundExecuteStatement>(
+                      static_cast<BoundExecuteStatement *>(stmt.release())));
+  default:
+    throw std::runtime_error("unsupported statement");
+  }
+}
+
+} // namespace mini
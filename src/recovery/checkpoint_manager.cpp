@@ -0,0 +1,101 @@
+#include "recovery/checkpoint_manager.h"
+#include <algorithm>
+
+namespace mini {
+
+CheckpointManager::CheckpointManager(DiskManager *disk, BufferPool *buffer_pool,
+                                     LogManager *log_manager,
+                                     std::chrono::milliseconds interval,
+                                     size_t log_size)
+    : disk_(disk), buffer_pool_(buffer_pool), log_manager_(log_manager),
+      interval_(interval), log_size_(log_size) {
+  last_checkpoint_lsn_ = disk_->ReadMasterRecord();
+  last_checkpoint_end_ = log_manager_->GetNextLSN();
+  last_checkpoint_time_ = std::chrono::steady_clock::now();
+  checkpoint_thread_ = std::thread(&CheckpointManager::CheckpointThread, this);
+}
+
+CheckpointManager::~CheckpointManager() {
+  {
+    std::lock_guard<std::mutex> guard(latch_);
+    running_ = false;
+  }
+  cv_.notify_one();
+  checkpoint_thread_.join();
+}
+
+lsn_t CheckpointManager::Checkpoint() {
+  std::lock_guard<std::mutex> checkpoint_guard(checkpoint_latch_);
+  lsn_t previous = GetLastCheckpointLSN();
+  if (previous != INVALID_LSN) {
+    buffer_pool_->FlushPagesBefore(previous);
+  }
+  LogRecord begin(INVALID_TXN_ID, INVALID_LSN,
+                  LogRecordType::CHECKPOINT_BEGIN);
+  lsn_t begin_lsn = log_manager_->AppendLogRecord(&begin);
+  // 两张表在不同时刻拷贝，BEGIN 之后的日志会在恢复时补上差异
+  LogRecord end(log_manager_->GetActiveTxns(), buffer_pool_->GetDirtyPages(),
+                log_manager_->GetNextTxnId());
+  lsn_t end_lsn = log_manager_->AppendLogRecord(&end);
+  log_manager_->Flush(end_lsn);
+  // 已经写回、不在脏页表里的页可能还在操作系统的缓存里，恢复不会
+  // 再重做它们，要先把数据文件刷下去
+  disk_->Sync();
+  // END 落盘之后才能让恢复从这里开始
+  disk_->WriteMasterRecord(begin_lsn);
+
+  std::lock_guard<std::mutex> guard(latch_);
+  last_checkpoint_lsn_ = begin_lsn;
+  last_checkpoint_end_ = end_lsn + end.GetSize();
+  last_checkpoint_time_ = std::chrono::steady_clock::now();
+  checkpoint_count_++;
+  return begin_lsn;
+}
+
+lsn_t CheckpointManager::GetLastCheckpointLSN() const {
+  std::lock_guard<std::mutex> guard(latch_);
+  return last_checkpoint_lsn_;
+}
+
+size_t CheckpointManager::GetCheckpointCount() const {
+  std::lock_guard<std::mutex> guard(latch_);
+  return checkpoint_count_;
+}
+
+size_t CheckpointManager::GetRecoveryLogSize() const {
+  lsn_t start = std::max<lsn_t>(GetLastCheckpointLSN(), 0);
+  for (const auto &[page_id, rec_lsn] : buffer_pool_->GetDirtyPages()) {
+    start = std::min(start, rec_lsn);
+  }
+  return static_cast<size_t>(log_manager_->GetNextLSN() - start);
+}
+
+double CheckpointManager::EstimateRecoveryMillis() const {
+  return static_cast<double>(GetRecoveryLogSize()) / (1 << 20) *
+         DEFAULT_RECOVERY_MS_PER_MB;
+}
+
+void CheckpointManager::CheckpointThread() {
+  std::unique_lock<std::mutex> lock(latch_);
+  while (true) {
+    cv_.wait_for(lock, POLL_INTERVAL, [this] { return !running_; });
+    if (!running_) {
+      break;
+    }
+    lsn_t next_lsn = log_manager_->GetNextLSN();
+    // 上次检查点之后没有新日志时，到了时间也不用再做
+    bool due = interval_.count() > 0 && next_lsn > last_checkpoint_end_ &&
+               std::chrono::steady_clock::now() - last_checkpoint_time_ >=
+                   interval_;
+    lsn_t since = std::max<lsn_t>(last_checkpoint_lsn_, 0);
+    due |= log_size_ > 0 && static_cast<size_t>(next_lsn - since) >= log_size_;
+    if (!due) {
+      continue;
+    }
+    lock.unlock();
+    Checkpoint();
+    lock.lock();
+  }
+}
+
+} // namespace mini
@@ -0,0 +1,169 @@
+#include "recovery/log_manager.h"
+#include <algorithm>
+#include <cassert>
+
+namespace mini {
+
+LogManager::LogManager(DiskManager *disk, size_t buffer_size)
+    : disk_(disk), buffer_size_(buffer_size), log_buffer_(buffer_size),
+      flush_buffer_(buffer_size) {
+  // 接着已有的日志往后写
+  next_lsn_ = static_cast<lsn_t>(disk_->GetLogSize());
+  flushed_lsn_ = next_lsn_;
+  flush_thread_ = std::thread(&LogManager::FlushThread, this);
+}
+
+LogManager::~LogManager() {
+  {
+    std::lock_guard<std::mutex> guard(latch_);
+    running_ = false;
+  }
+  flush_cv_.notify_one();
+  flush_thread_.join();
+  // 后台线程退出前已经写完了它拿到的缓冲区，这里只剩最后一批
+  if (log_buffer_offset_ > 0) {
+    disk_->WriteLog(log_buffer_.data(), log_buffer_offset_);
+    flushed_lsn_ = next_lsn_;
+    flush_count_++;
+    log_buffer_offset_ = 0;
+  }
+}
+
+lsn_t LogManager::AppendLogRecord(LogRecord *record) {
+  // 压缩不需要持锁
+  if (compression_) {
+    record->CompressPayload();
+  }
+  std::unique_lock<std::mutex> lock(latch_);
+  size_t size = record->GetSize();
+  if (size > buffer_size_) {
+    // 比缓冲区还大的记录（例如带很多页镜像的 INDEX_SMO）不进缓冲区：
+    // 等前面的日志都落盘后持锁直接写，保证日志的顺序
+    while (log_buffer_offset_ > 0 || flushed_lsn_ != next_lsn_) {
+      flush_requested_ = true;
+      flush_cv_.notify_one();
+      done_cv_.wait(lock);
+    }
+    record->SetLSN(next_lsn_);
+    std::vector<char> data(size);
+    record->SerializeTo(data.data());
+    disk_->WriteLog(data.data(), size);
+    next_lsn_ += static_cast<lsn_t>(size);
+    flushed_lsn_ = next_lsn_;
+    flush_count_++;
+    done_cv_.notify_all();
+  } else {
+    while (log_buffer_offset_ + size > buffer_size_) {
+      flush_requested_ = true;
+      flush_cv_.notify_one();
+      done_cv_.wait(lock);
+    }
+    record->SetLSN(next_lsn_);
+    record->SerializeTo(log_buffer_.data() + log_buffer_offset_);
+    log_buffer_offset_ += size;
+    next_lsn_ += static_cast<lsn_t>(size);
+  }
+  stats_.records++;
+  stats_.bytes += size;
+  stats_.uncompressed_bytes += record->GetUncompressedSize();
+  // 所有事务的日志都经过这里，顺便维护活跃事务表
+  if (record->GetTxnId() != INVALID_TXN_ID) {
+    next_txn_id_ = std::max(next_txn_id_, record->GetTxnId() + 1);
+    if (record->GetType() == LogRecordType::COMMIT ||
+        record->GetType() == LogRecordType::ABORT) {
+      active_txns_.erase(record->GetTxnId());
+    } else {
+      active_txns_[record->GetTxnId()] = record->GetLSN();
+    }
+  }
+  return record->GetLSN();
+}
+
+void LogManager::Flush(lsn_t lsn) {
+  std::unique_lock<std::mutex> lock(latch_);
+  while (lsn >= flushed_lsn_ && lsn < next_lsn_) {
+    flush_requested_ = true;
+    flush_cv_.notify_one();
+    done_cv_.wait(lock);
+  }
+}
+
+void LogManager::FlushAll() {
+  lsn_t last;
+  {
+    std::lock_guard<std::mutex> guard(latch_);
+    last = next_lsn_ - 1;
+  }
+  Flush(last);
+}
+
+void LogManager::TruncateTo(lsn_t lsn) {
+  std::lock_guard<std::mutex> guard(latch_);
+  assert(log_buffer_offset_ == 0 && flushed_lsn_ == next_lsn_ &&
+         "truncate after appending records");
+  assert(lsn <= next_lsn_);
+  disk_->TruncateLog(static_cast<size_t>(lsn));
+  next_lsn_ = lsn;
+  flushed_lsn_ = lsn;
+}
+
+lsn_t LogManager::GetFlushedLSN() const {
+  std::lock_guard<std::mutex> guard(latch_);
+  return flushed_lsn_;
+}
+
+size_t LogManager::GetFlushCount() const {
+  std::lock_guard<std::mutex> guard(latch_);
+  return flush_count_;
+}
+
+LogStats LogManager::GetStats() const {
+  std::lock_guard<std::mutex> guard(latch_);
+  return stats_;
+}
+
+std::vector<std::pair<txn_id_t, lsn_t>> LogManager::GetActiveTxns() const {
+  std::lock_guard<std::mutex> guard(latch_);
+  return {active_txns_.begin(), active_txns_.end()};
+}
+
+txn_id_t LogManager::GetNextTxnId() const {
+  std::lock_guard<std::mutex> guard(latch_);
+  return next_txn_id_;
+}
+
+void LogManager::AdvanceNextTxnId(txn_id_t next_txn_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  next_txn_id_ = std::max(next_txn_id_, next_txn_id);
+}
+
+void LogManager::FlushThread() {
+  std::unique_lock<std::mutex> lock(latch_);
+  while (running_) {
+    // 有人等提交或者缓冲区过半时立即落盘，否则定时落盘
+    flush_cv_.wait_for(lock, FLUSH_INTERVAL, [this] {
+      return !running_ || flush_requested_ ||
+             log_buffer_offset_ > buffer_size_ / 2;
+    });
+    flush_requested_ = false;
+    if (log_buffer_offset_ == 0) {
+      done_cv_.notify_all();
+      continue;
+    }
+    // 交换缓冲区，写盘期间前台继续往另一块里追加
+    std::swap(log_buffer_, flush_buffer_);
+    size_t size = log_buffer_offset_;
+    lsn_t end = next_lsn_;
+    log_buffer_offset_ = 0;
+
+    lock.unlock();
+    disk_->WriteLog(flush_buffer_.data(), size);
+    lock.lock();
+
+    flushed_lsn_ = end;
+    flush_count_++;
+    done_cv_.notify_all();
+  }
+}
+
+} // namespace mini
@@ -0,0 +1,311 @@
+#include "recovery/log_record.h"
+#include "common/compression.h"
+#include <cstring>
+#include <sstream>
+
+namespace mini {
+
+template <typename T> static void Put(char **pos, const T &value) {
+  std::memcpy(*pos, &value, sizeof(T));
+  *pos += sizeof(T);
+}
+
+template <typename T> static T Get(const char **pos) {
+  T value;
+  std::memcpy(&value, *pos, sizeof(T));
+  *pos += sizeof(T);
+  return value;
+}
+
+LogRecord::LogRecord(txn_id_t txn_id, lsn_t prev_lsn, LogRecordType type) {
+  header_.size = sizeof(LogRecordHeader);
+  header_.txn_id = txn_id;
+  header_.prev_lsn = prev_lsn;
+  header_.type = type;
+}
+
+LogRecord::LogRecord(txn_id_t txn_id, lsn_t prev_lsn, LogRecordType type,
+                     const RID &rid, const Tuple &tuple)
+    : LogRecord(txn_id, prev_lsn, type) {
+  rid_ = rid;
+  tuple_ = tuple;
+  header_.size += sizeof(RID) + sizeof(uint32_t) + tuple.Size();
+}
+
+LogRecord::LogRecord(txn_id_t txn_id, lsn_t prev_lsn, page_id_t prev_page_id,
+                     page_id_t page_id)
+    : LogRecord(txn_id, prev_lsn, LogRecordType::NEW_TABLE_PAGE) {
+  prev_page_id_ = prev_page_id;
+  page_id_ = page_id;
+  header_.size += 2 * sizeof(page_id_t);
+}
+
+LogRecord::LogRecord(txn_id_t txn_id, lsn_t prev_lsn, LogRecordType type,
+                     page_id_t index_id, page_id_t page_id, const RID &rid,
+                     const char *key, uint32_t key_size)
+    : LogRecord(txn_id, prev_lsn, type) {
+  index_id_ = index_id;
+  page_id_ = page_id;
+  rid_ = rid;
+  payload_.assign(key, key + key_size);
+  header_.size += 2 * sizeof(page_id_t) + sizeof(RID) + sizeof(uint32_t) +
+                  key_size;
+}
+
+LogRecord::LogRecord(txn_id_t txn_id, lsn_t prev_lsn, const RID &first_rid,
+                     const Tuple *tuples, size_t count)
+    : LogRecord(txn_id, prev_lsn, LogRecordType::INSERT_TUPLES) {
+  rid_ = first_rid;
+  tuples_.assign(tuples, tuples + count);
+  for (const Tuple &tuple : tuples_) {
+    uint32_t size = tuple.Size();
+    const char *size_bytes = reinterpret_cast<const char *>(&size);
+    payload_.insert(payload_.end(), size_bytes, size_bytes + sizeof(size));
+    payload_.insert(payload_.end(), tuple.Data(), tuple.Data() + size);
+  }
+  header_.size += sizeof(RID) + 3 * sizeof(uint32_t) + payload_.size();
+}
+
+LogRecord::LogRecord(
+    txn_id_t txn_id, lsn_t prev_lsn, lsn_t undo_next_lsn,
+    const std::vector<std::pair<page_id_t, const char *>> &pages)
+    : LogRecord(txn_id, prev_lsn, LogRecordType::INDEX_SMO) {
+  undo_next_lsn_ = undo_next_lsn;
+  for (const auto &[page_id, data] : pages) {
+    page_ids_.push_back(page_id);
+    payload_.insert(payload_.end(), data, data + PAGE_SIZE);
+  }
+  header_.size += sizeof(lsn_t) + 3 * sizeof(uint32_t) +
+                  pages.size() * (sizeof(page_id_t) + PAGE_SIZE);
+}
+
+LogRecord::LogRecord(txn_id_t txn_id, lsn_t prev_lsn, lsn_t undo_next_lsn)
+    : LogRecord(txn_id, prev_lsn, LogRecordType::CLR) {
+  undo_next_lsn_ = undo_next_lsn;
+  header_.size += sizeof(lsn_t);
+}
+
+LogRecord::LogRecord(std::vector<std::pair<txn_id_t, lsn_t>> active_txns,
+                     std::vector<std::pair<page_id_t, lsn_t>> dirty_pages,
+                     txn_id_t next_txn_id)
+    : LogRecord(INVALID_TXN_ID, INVALID_LSN, LogRecordType::CHECKPOINT_END) {
+  active_txns_ = std::move(active_txns);
+  dirty_pages_ = std::move(dirty_pages);
+  next_txn_id_ = next_txn_id;
+  header_.size += 2 * sizeof(uint32_t) + sizeof(txn_id_t) +
+                  active_txns_.size() * (sizeof(txn_id_t) + sizeof(lsn_t)) +
+                  dirty_pages_.size() * (sizeof(page_id_t) + sizeof(lsn_t));
+}
+
+void LogRecord::CompressPayload() {
+  if ((header_.type != LogRecordType::INDEX_SMO &&
+       header_.type != LogRecordType::INSERT_TUPLES) ||
+      compressed_size_ != 0) {
+    return;
+  }
+  std::vector<char> compressed = Compress(payload_.data(), payload_.size());
+  if (compressed.size() >= payload_.size()) {
+    return;
+  }
+  compressed_ = std::move(compressed);
+  compressed_size_ = static_cast<uint32_t>(compressed_.size());
+  header_.size -= static_cast<uint32_t>(payload_.size()) - compressed_size_;
+}
+
+// 可压缩的内容：原始长度 + 日志里的长度 + 日志里的字节，两个长度相等时
+// 没有压缩
+static void WritePayload(char **pos, const std::vector<char> &payload,
+                       const std::vector<char> &compressed) {
+  const std::vector<char> &stored = compressed.empty() ? payload : compressed;
+  Put(pos, static_cast<uint32_t>(payload.size()));
+  Put(pos, static_cast<uint32_t>(stored.size()));
+  std::memcpy(*pos, stored.data(), stored.size());
+  *pos += stored.size();
+}
+
+// 解出原始内容，compressed_size 是压缩后的长度，没有压缩时为 0。
+// 内容损坏时返回 false
+static bool ReadPayload(const char **pos, const char *end,
+                       std::vector<char> *payload, uint32_t *compressed_size) {
+  if (end - *pos < static_cast<std::ptrdiff_t>(2 * sizeof(uint32_t))) {
+    return false;
+  }
+  auto raw_size = Get<uint32_t>(pos);
+  auto stored_size = Get<uint32_t>(pos);
+  if (stored_size > static_cast<size_t>(end - *pos)) {
+    return false;
+  }
+  if (stored_size == raw_size) {
+    payload->assign(*pos, *pos + raw_size);
+    *compressed_size = 0;
+  } else {
+    payload->resize(raw_size);
+    if (!Decompress(*pos, stored_size, payload->data(), raw_size)) {
+      return false;
+    }
+    *compressed_size = stored_size;
+  }
+  *pos += stored_size;
+  return true;
+}
+
+void LogRecord::SerializeTo(char *buf) const {
+  char *pos = buf;
+  Put(&pos, header_);
+  switch (header_.type) {
+  case LogRecordType::INSERT_TUPLE:
+  case LogRecordType::MARK_DELETE:
+  case LogRecordType::ROLLBACK_DELETE:
+  case LogRecordType::APPLY_DELETE:
+    Put(&pos, rid_);
+    Put(&pos, tuple_.Size());
+    std::memcpy(pos, tuple_.Data(), tuple_.Size());
+    break;
+  case LogRecordType::INSERT_TUPLES:
+    Put(&pos, rid_);
+    Put(&pos, static_cast<uint32_t>(tuples_.size()));
+    WritePayload(&pos, payload_, compressed_);
+    break;
+  case LogRecordType::NEW_TABLE_PAGE:
+    Put(&pos, prev_page_id_);
+    Put(&pos, page_id_);
+    break;
+  case LogRecordType::INDEX_INSERT:
+  case LogRecordType::INDEX_DELETE:
+  case LogRecordType::HASH_INSERT:
+  case LogRecordType::HASH_DELETE:
+    Put(&pos, index_id_);
+    Put(&pos, page_id_);
+    Put(&pos, rid_);
+    Put(&pos, static_cast<uint32_t>(payload_.size()));
+    std::memcpy(pos, payload_.data(), payload_.size());
+    break;
+  case LogRecordType::INDEX_SMO:
+    Put(&pos, undo_next_lsn_);
+    Put(&pos, static_cast<uint32_t>(page_ids_.size()));
+    for (page_id_t page_id : page_ids_) {
+      Put(&pos, page_id);
+    }
+    WritePayload(&pos, payload_, compressed_);
+    break;
+  case LogRecordType::CLR:
+    Put(&pos, undo_next_lsn_);
+    break;
+  case LogRecordType::CHECKPOINT_END:
+    Put(&pos, static_cast<uint32_t>(active_txns_.size()));
+    for (const auto &[txn_id, lsn] : active_txns_) {
+      Put(&pos, txn_id);
+      Put(&pos, lsn);
+    }
+    Put(&pos, static_cast<uint32_t>(dirty_pages_.size()));
+    for (const auto &[page_id, lsn] : dirty_pages_) {
+      Put(&pos, page_id);
+      Put(&pos, lsn);
+    }
+    Put(&pos, next_txn_id_);
+    break;
+  default:
+    break;
+  }
+}
+
+bool LogRecord::DeserializeFrom(const char *buf, size_t len) {
+  if (len < sizeof(LogRecordHeader)) {
+    return false;
+  }
+  const char *pos = buf;
+  auto header = Get<LogRecordHeader>(&pos);
+  // 日志尾部可能是没写完的记录或者全零，都当作日志结束
+  if (header.size < sizeof(LogRecordHeader) || header.size > len ||
+      header.type <= LogRecordType::INVALID ||
+      header.type > LogRecordType::HASH_DELETE) {
+    return false;
+  }
+  header_ = header;
+  const char *end = buf + header.size;
+  compressed_size_ = 0;
+  compressed_.clear();
+  switch (header_.type) {
+  case LogRecordType::INSERT_TUPLE:
+  case LogRecordType::MARK_DELETE:
+  case LogRecordType::ROLLBACK_DELETE:
+  case LogRecordType::APPLY_DELETE: {
+    rid_ = Get<RID>(&pos);
+    auto tuple_size = Get<uint32_t>(&pos);
+    tuple_.SetData(pos, tuple_size);
+    break;
+  }
+  case LogRecordType::INSERT_TUPLES: {
+    rid_ = Get<RID>(&pos);
+    tuples_.resize(Get<uint32_t>(&pos));
+    if (!ReadPayload(&pos, end, &payload_, &compressed_size_)) {
+      return false;
+    }
+    const char *tuple_pos = payload_.data();
+    for (Tuple &tuple : tuples_) {
+      auto tuple_size = Get<uint32_t>(&tuple_pos);
+      tuple.SetData(tuple_pos, tuple_size);
+      tuple_pos += tuple_size;
+    }
+    break;
+  }
+  case LogRecordType::NEW_TABLE_PAGE:
+    prev_page_id_ = Get<page_id_t>(&pos);
+    page_id_ = Get<page_id_t>(&pos);
+    break;
+  case LogRecordType::INDEX_INSERT:
+  case LogRecordType::INDEX_DELETE:
+  case LogRecordType::HASH_INSERT:
+  case LogRecordType::HASH_DELETE: {
+    index_id_ = Get<page_id_t>(&pos);
+    page_id_ = Get<page_id_t>(&pos);
+    rid_ = Get<RID>(&pos);
+    auto key_size = Get<uint32_t>(&pos);
+    payload_.assign(pos, pos + key_size);
+    break;
+  }
+  case LogRecordType::INDEX_SMO: {
+    undo_next_lsn_ = Get<lsn_t>(&pos);
+    page_ids_.resize(Get<uint32_t>(&pos));
+    for (page_id_t &page_id : page_ids_) {
+      page_id = Get<page_id_t>(&pos);
+    }
+    if (!ReadPayload(&pos, end, &payload_, &compressed_size_) ||
+        payload_.size() != page_ids_.size() * PAGE_SIZE) {
+      return false;
+    }
+    break;
+  }
+  case LogRecordType::CLR:
+    undo_next_lsn_ = Get<lsn_t>(&pos);
+    break;
+  case LogRecordType::CHECKPOINT_END: {
+    active_txns_.resize(Get<uint32_t>(&pos));
+    for (auto &[txn_id, lsn] : active_txns_) {
+      txn_id = Get<txn_id_t>(&pos);
+      lsn = Get<lsn_t>(&pos);
+    }
+    dirty_pages_.resize(Get<uint32_t>(&pos));
+    for (auto &[page_id, lsn] : dirty_pages_) {
+      page_id = Get<page_id_t>(&pos);
+      lsn = Get<lsn_t>(&pos);
+    }
+    next_txn_id_ = Get<txn_id_t>(&pos);
+    break;
+  }
+  default:
+    break;
+  }
+  return true;
+}
+
+std::string LogRecord::ToString() const {
+  std::ostringstream os;
+  os << "LogRecord[size:" << header_.size << ", lsn:" << header_.lsn
+     << ", txn:" << header_.txn_id << ", prev_lsn:" << header_.prev_lsn
+     << ", type:" << static_cast<int>(header_.type) << ", page:" << page_id_
+     << ", rid:" << rid_.page_id << ":" << rid_.slot_id << "]";
+  return os.str();
+}
+
+} // namespace mini
@@ -1,21 +1,33 @@
 #include "storage/buffer_pool.h"
+#include "recovery/log_manager.h"
 #include <numeric>
 
 namespace mini {
-BufferPool::BufferPool(std::size_t pool_size, DiskManager *disk)
+BufferPool::BufferPool(std::size_t pool_size, DiskManager *disk,
+                       LogManager *log_manager)
     : pages_(pool_size), meta_(pool_size), free_list_(pool_size), disk_(disk),
-      hand_(0), pool_size_(pool_size) {
+      log_manager_(log_manager), hand_(0), pool_size_(pool_size) {
   std::iota(free_list_.begin(), free_list_.end(), 0);
 }
 
 BufferPool::~BufferPool() {}
 
 Page *BufferPool::FetchPage(page_id_t pid) {
+  std::lock_guard<std::mutex> guard(latch_);
+  return FetchPageLocked(pid);
+}
+
+Page *BufferPool::FetchPageLocked(page_id_t pid) {
   // 需要选择从磁盘加载到内存，然后返回内存地址
+  fetch_count_++;
   auto it = page_table_.find(pid);
   if (it != page_table_.end()) {
     frame_id_t fid = it->second;
     meta_[fid].pin_count++;
+    if (log_manager_ != nullptr && !meta_[fid].is_dirty &&
+        meta_[fid].rec_lsn == INVALID_LSN) {
+      meta_[fid].rec_lsn = log_manager_->GetNextLSN();
+    }
     return &pages_[fid];
   }
 
@@ -29,26 +41,35 @@ Page *BufferPool::FetchPage(page_id_t pid) {
   }
 
   if (meta_[fid].is_dirty) {
-    disk_->WritePage(meta_[fid].page_id, pages_[fid]);
-    meta_[fid].is_dirty = false;
+    WriteBack(fid);
   }
   disk_->ReadPage(pid, pages_[fid]);
+  miss_count_++;
   page_table_[pid] = fid;
 
   meta_[fid].page_id = pid;
   meta_[fid].pin_count = 1;
   meta_[fid].is_dirty = false;
+  meta_[fid].rec_lsn =
+      log_manager_ == nullptr ? INVALID_LSN : log_manager_->GetNextLSN();
 
   return &pages_[fid];
 }
 
 Page *BufferPool::NewPage(page_id_t *pid) {
+  std::lock_guard<std::mutex> guard(latch_);
   *pid = disk_->AllocatePage();
-  return FetchPage(*pid);
+  Page *page = FetchPageLocked(*pid);
+  if (page == nullptr) {
+    // 没有空闲的帧，页号还回去
+    disk_->DeallocatePage(*pid);
+  }
+  return page;
 }
 
 bool BufferPool::UnpinPage(page_id_t pid, bool is_dirty) {
   // 由上层调用，表明要取消pin并且告诉我们是否被写过
+  std::lock_guard<std::mutex> guard(latch_);
   auto it = page_table_.find(pid);
   if (it != page_table_.end()) {
     frame_id_t fid = it->second;
@@ -56,6 +77,9 @@ bool BufferPool::UnpinPage(page_id_t pid, bool is_dirty) {
       return false;
     meta_[fid].pin_count--;
     meta_[fid].is_dirty |= is_dirty;
+    if (meta_[fid].pin_count == 0 && !meta_[fid].is_dirty) {
+      meta_[fid].rec_lsn = INVALID_LSN;
+    }
 
     return true;
   }
@@ -63,14 +87,30 @@ bool BufferPool::UnpinPage(page_id_t pid, bool is_dirty) {
   return false;
 }
 
+bool BufferPool::DeletePage(page_id_t pid) {
+  std::lock_guard<std::mutex> guard(latch_);
+  auto it = page_table_.find(pid);
+  if (it != page_table_.end()) {
+    frame_id_t fid = it->second;
+    if (meta_[fid].pin_count > 0)
+      return false;
+    page_table_.erase(it);
+    meta_[fid] = FrameMeta{};
+    free_list_.push_back(fid);
+  }
+  disk_->DeallocatePage(pid);
+  return true;
+}
+
 bool BufferPool::FlushPage(page_id_t pid) {
   // 如果是脏页，将某页写回磁盘，并且删掉脏页标记
+  std::lock_guard<std::mutex> guard(latch_);
   auto it = page_table_.find(pid);
   if (it != page_table_.end()) {
     frame_id_t fid = it->second;
     if (meta_[fid].page_id != -1 && meta_[fid].is_dirty) {
-      disk_->WritePage(meta_[fid].page_id, pages_[fid]);
-      meta_[fid].is_dirty = false;
+      WriteBack(fid);
+      disk_->Sync();
     }
     return true;
   }
@@ -80,13 +120,49 @@ bool BufferPool::FlushPage(page_id_t pid) {
 
 void BufferPool::FlushAllPages() {
   // 写回所有页
+  std::lock_guard<std::mutex> guard(latch_);
   for (std::size_t i = 0; i < pool_size_; ++i) {
     if (meta_[i].page_id != -1 && meta_[i].is_dirty) {
-      disk_->WritePage(meta_[i].page_id, pages_[i]);
-      meta_[i].is_dirty = false;
+      WriteBack(static_cast<frame_id_t>(i));
+    }
+  }
+  disk_->Sync();
+}
+
+void BufferPool::FlushPagesBefore(lsn_t lsn) {
+  std::lock_guard<std::mutex> guard(latch_);
+  for (std::size_t i = 0; i < pool_size_; ++i) {
+    if (meta_[i].page_id != -1 && meta_[i].is_dirty &&
+        meta_[i].pin_count == 0 && meta_[i].rec_lsn != INVALID_LSN &&
+        meta_[i].rec_lsn < lsn) {
+      WriteBack(static_cast<frame_id_t>(i));
+    }
+  }
+  disk_->Sync();
+}
+
+void BufferPool::LowerRecLSN(page_id_t pid, lsn_t lsn) {
+  std::lock_guard<std::mutex> guard(latch_);
+  auto it = page_table_.find(pid);
+  if (it == page_table_.end()) {
+    return;
+  }
+  lsn_t &rec_lsn = meta_[it->second].rec_lsn;
+  if (rec_lsn == INVALID_LSN || rec_lsn > lsn) {
+    rec_lsn = lsn;
+  }
+}
+
+std::vector<std::pair<page_id_t, lsn_t>> BufferPool::GetDirtyPages() {
+  std::lock_guard<std::mutex> guard(latch_);
+  std::vector<std::pair<page_id_t, lsn_t>> dirty_pages;
+  for (std::size_t i = 0; i < pool_size_; ++i) {
+    if (meta_[i].page_id != -1 && meta_[i].is_dirty &&
+        meta_[i].rec_lsn != INVALID_LSN) {
+      dirty_pages.emplace_back(meta_[i].page_id, meta_[i].rec_lsn);
     }
   }
-  return;
+  return dirty_pages;
 }
 
 PageGuard BufferPool::FetchPageGuarded(page_id_t pid) {
@@ -99,6 +175,20 @@ PageGuard BufferPool::NewPageGuarded(page_id_t *pid) {
   return PageGuard(this, *pid, page);
 }
 
+void BufferPool::WriteBack(frame_id_t fid) {
+  if (log_manager_ != nullptr) {
+    log_manager_->Flush(pages_[fid].GetLSN());
+  }
+  disk_->WritePage(meta_[fid].page_id, pages_[fid]);
+  meta_[fid].is_dirty = false;
+  // 还被 pin 着的页可能马上又被修改
+  if (meta_[fid].pin_count > 0 && log_manager_ != nullptr) {
+    meta_[fid].rec_lsn = log_manager_->GetNextLSN();
+  } else {
+    meta_[fid].rec_lsn = INVALID_LSN;
+  }
+}
+
 int BufferPool::FindVictimFrame() {
   // 返回可用槽位，可能会失败
   if (!free_list_.empty()) {
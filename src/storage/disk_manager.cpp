@@ -19,15 +19,36 @@ long long DiskManager::OffsetOf(page_id_t page_id) {
   return static_cast<long long>(page_id) * static_cast<long long>(PAGE_SIZE);
 }
 
-DiskManager::DiskManager(const std::string &file_path) : file_path_(file_path) {
+// 把数据文件的扩展名换成 ext
+static std::string SiblingPathOf(const std::string &file_path,
+                                 const std::string &ext) {
+  auto dot = file_path.find_last_of('.');
+  auto slash = file_path.find_last_of('/');
+  if (dot == std::string::npos ||
+      (slash != std::string::npos && dot < slash)) {
+    return file_path + ext;
+  }
+  return file_path.substr(0, dot) + ext;
+}
+
+DiskManager::DiskManager(const std::string &file_path)
+    : file_path_(file_path), log_path_(SiblingPathOf(file_path, ".log")),
+      master_path_(SiblingPathOf(file_path, ".master")) {
   fd_ = ::open(file_path_.c_str(), O_RDWR | O_CREAT, 0644);
   if (fd_ < 0)
     throw SysErr("open failed: " + file_path_);
+  // 重新打开已有文件时，新页接在文件末尾，不覆盖已有的页
+  struct stat st;
+  if (::fstat(fd_, &st) < 0)
+    throw SysErr("fstat failed: " + file_path_);
+  next_page_id_ = static_cast<page_id_t>(st.st_size / PAGE_SIZE);
 }
 
 DiskManager::~DiskManager() {
   if (fd_ >= 0)
     ::close(fd_);
+  if (log_fd_ >= 0)
+    ::close(log_fd_);
 }
 
 void DiskManager::WritePage(page_id_t page_id, const Page &page) {
@@ -39,7 +60,11 @@ void DiskManager::WritePage(page_id_t page_id, const Page &page) {
     throw SysErr("write failed");
   if (n != static_cast<ssize_t>(PAGE_SIZE))
     throw std::runtime_error("partial write");
-  ::fsync(fd_); // 小项目先“稳”，别先追性能
+}
+
+void DiskManager::Sync() {
+  if (::fsync(fd_) < 0)
+    throw SysErr("fsync failed");
 }
 
 void DiskManager::ReadPage(page_id_t page_id, Page &page) {
@@ -56,6 +81,93 @@ void DiskManager::ReadPage(page_id_t page_id, Page &page) {
   }
 }
 
-page_id_t DiskManager::AllocatePage() { return next_page_id_++; }
+page_id_t DiskManager::AllocatePage() {
+  if (!free_pages_.empty()) {
+    page_id_t page_id = free_pages_.back();
+    free_pages_.pop_back();
+    return page_id;
+  }
+  return next_page_id_++;
+}
+
+void DiskManager::DeallocatePage(page_id_t page_id) {
+  free_pages_.push_back(page_id);
+}
+
+void DiskManager::ReservePage(page_id_t page_id) {
+  if (page_id >= next_page_id_) {
+    next_page_id_ = page_id + 1;
+  }
+}
+
+void DiskManager::OpenLog() {
+  if (log_fd_ >= 0)
+    return;
+  log_fd_ = ::open(log_path_.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+  if (log_fd_ < 0)
+    throw SysErr("open failed: " + log_path_);
+}
+
+void DiskManager::WriteLog(const char *data, size_t size) {
+  OpenLog();
+  size_t written = 0;
+  while (written < size) {
+    ssize_t n = ::write(log_fd_, data + written, size - written);
+    if (n < 0)
+      throw SysErr("write failed (log)");
+    written += static_cast<size_t>(n);
+  }
+  // 日志只追加，fdatasync 足够，一次落盘覆盖整批日志
+  if (::fdatasync(log_fd_) < 0)
+    throw SysErr("fdatasync failed (log)");
+}
+
+size_t DiskManager::ReadLog(char *data, size_t size, size_t offset) {
+  OpenLog();
+  ssize_t n = ::pread(log_fd_, data, size, static_cast<off_t>(offset));
+  if (n < 0)
+    throw SysErr("read failed (log)");
+  return static_cast<size_t>(n);
+}
+
+size_t DiskManager::GetLogSize() {
+  OpenLog();
+  struct stat st;
+  if (::fstat(log_fd_, &st) < 0)
+    throw SysErr("fstat failed: " + log_path_);
+  return static_cast<size_t>(st.st_size);
+}
+
+void DiskManager::TruncateLog(size_t size) {
+  OpenLog();
+  if (::ftruncate(log_fd_, static_cast<off_t>(size)) < 0)
+    throw SysErr("ftruncate failed: " + log_path_);
+  if (::fdatasync(log_fd_) < 0)
+    throw SysErr("fdatasync failed (log)");
+}
+
+void DiskManager::WriteMasterRecord(lsn_t checkpoint_lsn) {
+  int fd = ::open(master_path_.c_str(), O_WRONLY | O_CREAT, 0644);
+  if (fd < 0)
+    throw SysErr("open failed: " + master_path_);
+  // 8 字节在一个扇区内，覆盖写不会写坏
+  ssize_t n = ::pwrite(fd, &checkpoint_lsn, sizeof(checkpoint_lsn), 0);
+  int synced = ::fdatasync(fd);
+  ::close(fd);
+  if (n != static_cast<ssize_t>(sizeof(checkpoint_lsn)) || synced < 0)
+    throw SysErr("write failed: " + master_path_);
+}
+
+lsn_t DiskManager::ReadMasterRecord() {
+  int fd = ::open(master_path_.c_str(), O_RDONLY);
+  if (fd < 0)
+    return INVALID_LSN;
+  lsn_t checkpoint_lsn;
+  ssize_t n = ::pread(fd, &checkpoint_lsn, sizeof(checkpoint_lsn), 0);
+  ::close(fd);
+  if (n != static_cast<ssize_t>(sizeof(checkpoint_lsn)))
+    return INVALID_LSN;
+  return checkpoint_lsn;
+}
 
 } // namespace mini
@@ -0,0 +1,83 @@
+#include "storage/spill_file.h"
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+namespace mini {
+
+SpillFile::~SpillFile() {
+  for (page_id_t pid : pages_) {
+    buffer_pool_->DeletePage(pid);
+  }
+}
+
+void SpillFile::Append(const Tuple &tuple) {
+  assert(!finished_ && "append after rewind");
+  size_t need = sizeof(uint32_t) + tuple.Size();
+  if (sizeof(SpillPageHeader) + need > PAGE_SIZE) {
+    throw std::runtime_error("SpillFile: tuple larger than a page");
+  }
+  if (!write_buf_.empty() && write_buf_.size() + need > PAGE_SIZE) {
+    WritePage();
+  }
+  if (write_buf_.empty()) {
+    write_buf_.resize(sizeof(SpillPageHeader));
+  }
+  uint32_t size = tuple.Size();
+  const char *bytes = reinterpret_cast<const char *>(&size);
+  write_buf_.insert(write_buf_.end(), bytes, bytes + sizeof(size));
+  write_buf_.insert(write_buf_.end(), tuple.Data(), tuple.Data() + size);
+  tuple_count_++;
+}
+
+void SpillFile::WritePage() {
+  SpillPageHeader header{INVALID_LSN, static_cast<uint32_t>(write_buf_.size())};
+  std::memcpy(write_buf_.data(), &header, sizeof(header));
+  page_id_t pid;
+  Page *page = buffer_pool_->NewPage(&pid);
+  if (page == nullptr) {
+    throw std::runtime_error("SpillFile: no free frame in buffer pool");
+  }
+  std::memcpy(page->GetData(), write_buf_.data(), write_buf_.size());
+  buffer_pool_->UnpinPage(pid, true);
+  pages_.push_back(pid);
+  write_buf_.clear();
+}
+
+void SpillFile::Rewind() {
+  if (!finished_ && !write_buf_.empty()) {
+    WritePage();
+  }
+  finished_ = true;
+  read_page_ = 0;
+  read_buf_.clear();
+  read_offset_ = 0;
+}
+
+bool SpillFile::Next(Tuple *out) {
+  assert(finished_ && "read before rewind");
+  while (read_offset_ >= read_buf_.size()) {
+    if (read_page_ >= pages_.size()) {
+      return false;
+    }
+    // 整页拷出来就放掉，不占着缓冲池的帧
+    Page *page = buffer_pool_->FetchPage(pages_[read_page_]);
+    if (page == nullptr) {
+      throw std::runtime_error("SpillFile: no free frame in buffer pool");
+    }
+    SpillPageHeader header;
+    std::memcpy(&header, page->GetConstData(), sizeof(header));
+    read_buf_.assign(page->GetConstData(), page->GetConstData() + header.size);
+    buffer_pool_->UnpinPage(pages_[read_page_], false);
+    read_page_++;
+    read_offset_ = sizeof(SpillPageHeader);
+  }
+  uint32_t size;
+  std::memcpy(&size, read_buf_.data() + read_offset_, sizeof(size));
+  read_offset_ += sizeof(size);
+  out->SetData(read_buf_.data() + read_offset_, size);
+  read_offset_ += size;
+  return true;
+}
+
+} // namespace mini
@@ -4,17 +4,20 @@
 #include "storage/table_iterator.h"
 #include <cstdint>
 #include <stdexcept>
+#include <utility>
+#include <vector>
 
 namespace mini {
 
 void TablePage::Init() {
+  header_.lsn = INVALID_LSN;
   header_.next_page_id = -1;
   header_.num_slots = 0;
   header_.free_space_ptr = PAGE_SIZE;
 }
 
 bool TablePage::InsertTuple(const char *tuple_data, uint16_t tuple_size,
-                            uint16_t *out_slot_id) {
+                            uint16_t *out_slot_id, txn_id_t xmin) {
   size_t need = sizeof(Slot) + tuple_size;
   if (GetFreeSpace() < need) {
     return false;
@@ -29,6 +32,8 @@ bool TablePage::InsertTuple(const char *tuple_data, uint16_t tuple_size,
   new_slot->offset = new_offset;
   new_slot->size = tuple_size;
   new_slot->is_deleted = 0;
+  new_slot->xmin = xmin;
+  new_slot->xmax = INVALID_TXN_ID;
   header_.num_slots += 1;
 
   *out_slot_id = header_.num_slots - 1;
@@ -48,7 +53,25 @@ bool TablePage::GetTuple(uint16_t slot_id, const char **out_data,
   return true;
 }
 
-bool TablePage::MarkDelete(uint16_t slot_id) {
+bool TablePage::MarkDelete(uint16_t slot_id, txn_id_t xmax) {
+  if (slot_id >= header_.num_slots)
+    return false;
+  char *page_data = reinterpret_cast<char *>(this);
+  Slot *slot = SlotAt(page_data, slot_id);
+  slot->xmax = xmax;
+  return true;
+}
+
+bool TablePage::RollbackDelete(uint16_t slot_id) {
+  if (slot_id >= header_.num_slots)
+    return false;
+  char *page_data = reinterpret_cast<char *>(this);
+  Slot *slot = SlotAt(page_data, slot_id);
+  slot->xmax = INVALID_TXN_ID;
+  return true;
+}
+
+bool TablePage::ApplyDelete(uint16_t slot_id) {
   if (slot_id >= header_.num_slots)
     return false;
   char *page_data = reinterpret_cast<char *>(this);
@@ -68,6 +91,26 @@ bool TablePage::IsDeleted(uint16_t slot_id) const {
   return false;
 }
 
+bool TablePage::GetVersion(uint16_t slot_id, txn_id_t *xmin,
+                           txn_id_t *xmax) const {
+  if (IsDeleted(slot_id))
+    return false;
+  const Slot *slot =
+      SlotAt(reinterpret_cast<const char *>(this), slot_id);
+  *xmin = slot->xmin;
+  *xmax = slot->xmax;
+  return true;
+}
+
+bool TablePage::IsVisible(uint16_t slot_id, const Snapshot *snapshot) const {
+  txn_id_t xmin, xmax;
+  if (!GetVersion(slot_id, &xmin, &xmax))
+    return false;
+  if (snapshot == nullptr)
+    return xmax == INVALID_TXN_ID;
+  return snapshot->IsVisible(xmin, xmax);
+}
+
 uint16_t TablePage::GetFreeSpace() const {
   return header_.free_space_ptr - sizeof(header_) -
          sizeof(Slot) * header_.num_slots;
@@ -75,23 +118,66 @@ uint16_t TablePage::GetFreeSpace() const {
 
 uint16_t TablePage::GetSlotCount() const { return header_.num_slots; }
 
-TableHeap::TableHeap(BufferPool *buffer_pool) : buffer_pool_(buffer_pool) {
+TableHeap::TableHeap(BufferPool *buffer_pool, LogManager *log_manager)
+    : buffer_pool_(buffer_pool), log_manager_(log_manager) {
   page_id_t pid;
   Page *p0 = buffer_pool_->NewPage(&pid);
   first_page_id_ = pid;
   last_page_id_ = pid;
+  page_ids_.push_back(pid);
   TablePage *tp = TablePage::From(p0->GetData());
   tp->Init();
   buffer_pool_->UnpinPage(pid, true);
 }
 
-RID TableHeap::InsertTuple(const Tuple &tuple) {
+TableHeap::TableHeap(BufferPool *buffer_pool, page_id_t first_page_id,
+                     LogManager *log_manager)
+    : buffer_pool_(buffer_pool), log_manager_(log_manager),
+      first_page_id_(first_page_id), last_page_id_(first_page_id) {
+  while (true) {
+    PageGuard pg = buffer_pool_->FetchPageGuarded(last_page_id_);
+    page_id_t next = pg.GetPage()->As<TablePage>()->GetNextPageId();
+    not_all_visible_.insert(last_page_id_);
+    page_ids_.push_back(last_page_id_);
+    slot_count_ += pg.GetPage()->As<TablePage>()->GetSlotCount();
+    if (next == INVALID_PAGE_ID) {
+      break;
+    }
+    last_page_id_ = next;
+    page_count_++;
+  }
+}
+
+void TableHeap::AppendLog(Transaction *txn, LogRecord *record, Page *page,
+                          Page *other_page) {
+  if (log_manager_ == nullptr || txn == nullptr) {
+    return;
+  }
+  lsn_t lsn = log_manager_->AppendLogRecord(record);
+  txn->SetPrevLSN(lsn);
+  page->SetLSN(lsn);
+  if (other_page != nullptr) {
+    other_page->SetLSN(lsn);
+  }
+}
+
+RID TableHeap::InsertTuple(const Tuple &tuple, Transaction *txn) {
+  std::lock_guard<std::mutex> guard(latch_);
   PageGuard pg = buffer_pool_->FetchPageGuarded(last_page_id_);
   TablePage *tp = pg.GetPage()->As<TablePage>();
   uint16_t out_slot_id;
-  if (tp->InsertTuple(tuple.Data(), tuple.Size(), &out_slot_id)) {
+  txn_id_t txn_id = txn == nullptr ? INVALID_TXN_ID : txn->GetTxnId();
+  if (tp->InsertTuple(tuple.Data(), tuple.Size(), &out_slot_id, txn_id)) {
     pg.SetDirty();
-    return RID{last_page_id_, out_slot_id};
+    slot_count_++;
+    RID rid{last_page_id_, out_slot_id};
+    LogRecord record(txn_id, txn ? txn->GetPrevLSN() : INVALID_LSN,
+                     LogRecordType::INSERT_TUPLE, rid, tuple);
+    AppendLog(txn, &record, pg.GetPage());
+    if (txn != nullptr) {
+      ClearAllVisible(rid.page_id);
+    }
+    return rid;
   }
   // need new page
   page_id_t new_page_id;
@@ -100,45 +186,300 @@ RID TableHeap::InsertTuple(const Tuple &tuple) {
   TablePage *tpNex = pgNex.GetPage()->As<TablePage>();
   tpNex->Init();
   tp->SetNextPageId(new_page_id);
+  LogRecord new_page_record(txn_id, txn ? txn->GetPrevLSN() : INVALID_LSN,
+                            last_page_id_, new_page_id);
+  AppendLog(txn, &new_page_record, pg.GetPage(), pgNex.GetPage());
   last_page_id_ = new_page_id;
+  page_ids_.push_back(new_page_id);
+  page_count_++;
   pg.SetDirty();
   pgNex.SetDirty();
-  if (tpNex->InsertTuple(tuple.Data(), tuple.Size(), &out_slot_id)) {
-    return RID{last_page_id_, out_slot_id};
+  if (tpNex->InsertTuple(tuple.Data(), tuple.Size(), &out_slot_id, txn_id)) {
+    slot_count_++;
+    RID rid{last_page_id_, out_slot_id};
+    LogRecord record(txn_id, txn ? txn->GetPrevLSN() : INVALID_LSN,
+                     LogRecordType::INSERT_TUPLE, rid, tuple);
+    AppendLog(txn, &record, pgNex.GetPage());
+    if (txn != nullptr) {
+      ClearAllVisible(rid.page_id);
+    }
+    return rid;
   }
   throw std::runtime_error("InsertTuple failed even after new page allocated");
 }
 
-bool TableHeap::GetTuple(const RID &rid, Tuple *out) {
+std::vector<RID> TableHeap::InsertTuples(const std::vector<Tuple> &tuples,
+                                         Transaction *txn,
+                                         std::vector<lsn_t> *undo_next) {
+  std::lock_guard<std::mutex> guard(latch_);
+  std::vector<RID> rids;
+  rids.reserve(tuples.size());
+  txn_id_t txn_id = txn == nullptr ? INVALID_TXN_ID : txn->GetTxnId();
+  size_t i = 0;
+  while (true) {
+    PageGuard pg = buffer_pool_->FetchPageGuarded(last_page_id_);
+    TablePage *tp = pg.GetPage()->As<TablePage>();
+    // 先把这一页放满
+    size_t first = i;
+    uint16_t out_slot_id;
+    while (i < tuples.size() &&
+           tp->InsertTuple(tuples[i].Data(), tuples[i].Size(), &out_slot_id,
+                           txn_id)) {
+      rids.push_back(RID{last_page_id_, out_slot_id});
+      i++;
+    }
+    if (i > first) {
+      pg.SetDirty();
+      slot_count_ += i - first;
+      lsn_t prev_lsn = txn ? txn->GetPrevLSN() : INVALID_LSN;
+      // 只有一行时和 InsertTuple 写一样的日志
+      LogRecord record =
+          i - first == 1
+              ? LogRecord(txn_id, prev_lsn, LogRecordType::INSERT_TUPLE,
+                          rids[first], tuples[first])
+              : LogRecord(txn_id, prev_lsn, rids[first], &tuples[first],
+                          i - first);
+      AppendLog(txn, &record, pg.GetPage());
+      if (undo_next != nullptr) {
+        undo_next->push_back(prev_lsn);
+        undo_next->insert(undo_next->end(), i - first - 1,
+                          txn ? txn->GetPrevLSN() : INVALID_LSN);
+      }
+      if (txn != nullptr) {
+        ClearAllVisible(last_page_id_);
+      }
+    }
+    if (i == tuples.size()) {
+      return rids;
+    }
+    if (tp->GetSlotCount() == 0) {
+      throw std::runtime_error("tuple does not fit in an empty page");
+    }
+    // need new page
+    page_id_t new_page_id;
+    PageGuard pgNex = buffer_pool_->NewPageGuarded(&new_page_id);
+    pgNex.GetPage()->As<TablePage>()->Init();
+    tp->SetNextPageId(new_page_id);
+    LogRecord new_page_record(txn_id, txn ? txn->GetPrevLSN() : INVALID_LSN,
+                              last_page_id_, new_page_id);
+    AppendLog(txn, &new_page_record, pg.GetPage(), pgNex.GetPage());
+    last_page_id_ = new_page_id;
+    page_ids_.push_back(new_page_id);
+    page_count_++;
+    pg.SetDirty();
+    pgNex.SetDirty();
+  }
+}
+
+bool TableHeap::GetTuple(const RID &rid, Tuple *out,
+                         const Snapshot *snapshot) {
+  std::lock_guard<std::mutex> guard(latch_);
   PageGuard pg = buffer_pool_->FetchPageGuarded(rid.page_id);
   // TODO: maybe nullptr
   TablePage *tp = pg.GetPage()->As<TablePage>();
   const char *data;
   uint16_t size;
-  if (!tp->GetTuple(rid.slot_id, &data, &size)) {
+  if (!tp->IsVisible(rid.slot_id, snapshot) ||
+      !tp->GetTuple(rid.slot_id, &data, &size)) {
     return false;
   }
   out->SetData(data, size);
+  out->SetRid(rid);
   return true;
 }
 
-bool TableHeap::DeleteTuple(const RID &rid) {
+std::vector<Tuple> TableHeap::GetPageTuples(page_id_t page_id,
+                                            const Snapshot *snapshot) {
+  std::lock_guard<std::mutex> guard(latch_);
+  PageGuard pg = buffer_pool_->FetchPageGuarded(page_id);
+  const TablePage *tp = pg.GetPage()->As<TablePage>();
+  std::vector<Tuple> tuples;
+  for (uint16_t slot_id = 0; slot_id < tp->GetSlotCount(); ++slot_id) {
+    const char *data;
+    uint16_t size;
+    if (tp->IsVisible(slot_id, snapshot) &&
+        tp->GetTuple(slot_id, &data, &size)) {
+      tuples.emplace_back(data, size);
+      tuples.back().SetRid(RID{page_id, slot_id});
+    }
+  }
+  return tuples;
+}
+
+bool TableHeap::GetTuple(const RID &rid, const std::vector<Column> &columns,
+                         Tuple *out, const Snapshot *snapshot) {
+  std::lock_guard<std::mutex> guard(latch_);
   PageGuard pg = buffer_pool_->FetchPageGuarded(rid.page_id);
   TablePage *tp = pg.GetPage()->As<TablePage>();
-  if (!tp->IsDeleted(rid.slot_id)) {
-    if (tp->MarkDelete(rid.slot_id)) {
-      pg.SetDirty();
-      return true;
-    }
+  const char *data;
+  uint16_t size;
+  if (!tp->IsVisible(rid.slot_id, snapshot) ||
+      !tp->GetTuple(rid.slot_id, &data, &size)) {
+    return false;
   }
-  return false;
+  uint32_t length = 0;
+  for (const Column &col : columns) {
+    length += col.length;
+  }
+  char *buf = out->Resize(length);
+  for (const Column &col : columns) {
+    memcpy(buf, data + col.offset, col.length);
+    buf += col.length;
+  }
+  out->SetRid(rid);
+  return true;
+}
+
+bool TableHeap::IsVisible(const RID &rid, const Snapshot &snapshot) {
+  std::lock_guard<std::mutex> guard(latch_);
+  PageGuard pg = buffer_pool_->FetchPageGuarded(rid.page_id);
+  return pg.GetPage()->As<TablePage>()->IsVisible(rid.slot_id, &snapshot);
+}
+
+bool TableHeap::DeleteTuple(const RID &rid, Transaction *txn) {
+  std::lock_guard<std::mutex> guard(latch_);
+  PageGuard pg = buffer_pool_->FetchPageGuarded(rid.page_id);
+  TablePage *tp = pg.GetPage()->As<TablePage>();
+  txn_id_t xmin, xmax;
+  if (!tp->GetVersion(rid.slot_id, &xmin, &xmax) || xmax != INVALID_TXN_ID) {
+    return false;
+  }
+  if (txn == nullptr) {
+    pg.SetDirty();
+    return tp->ApplyDelete(rid.slot_id);
+  }
+  const char *data;
+  uint16_t size;
+  tp->GetTuple(rid.slot_id, &data, &size);
+  // 日志里带上旧的 tuple，撤销时用
+  Tuple old_tuple(data, size);
+  tp->MarkDelete(rid.slot_id, txn->GetTxnId());
+  pg.SetDirty();
+  LogRecord record(txn->GetTxnId(), txn->GetPrevLSN(),
+                   LogRecordType::MARK_DELETE, rid, old_tuple);
+  AppendLog(txn, &record, pg.GetPage());
+  ClearAllVisible(rid.page_id);
+  return true;
 }
 
-TableIterator TableHeap::Begin() {
-  TableIterator iter(this, RID{first_page_id_, UINT16_MAX}, false);
+bool TableHeap::RollbackDelete(const RID &rid, Transaction *txn) {
+  std::lock_guard<std::mutex> guard(latch_);
+  PageGuard pg = buffer_pool_->FetchPageGuarded(rid.page_id);
+  TablePage *tp = pg.GetPage()->As<TablePage>();
+  txn_id_t xmin, xmax;
+  if (!tp->GetVersion(rid.slot_id, &xmin, &xmax) || xmax == INVALID_TXN_ID ||
+      !tp->RollbackDelete(rid.slot_id)) {
+    return false;
+  }
+  pg.SetDirty();
+  const char *data;
+  uint16_t size;
+  tp->GetTuple(rid.slot_id, &data, &size);
+  LogRecord record(txn ? txn->GetTxnId() : INVALID_TXN_ID,
+                   txn ? txn->GetPrevLSN() : INVALID_LSN,
+                   LogRecordType::ROLLBACK_DELETE, rid, Tuple(data, size));
+  AppendLog(txn, &record, pg.GetPage());
+  return true;
+}
+
+bool TableHeap::ApplyDelete(const RID &rid, Transaction *txn) {
+  std::lock_guard<std::mutex> guard(latch_);
+  PageGuard pg = buffer_pool_->FetchPageGuarded(rid.page_id);
+  TablePage *tp = pg.GetPage()->As<TablePage>();
+  const char *data;
+  uint16_t size;
+  if (!tp->GetTuple(rid.slot_id, &data, &size)) {
+    return false;
+  }
+  Tuple old_tuple(data, size);
+  tp->ApplyDelete(rid.slot_id);
+  pg.SetDirty();
+  LogRecord record(txn ? txn->GetTxnId() : INVALID_TXN_ID,
+                   txn ? txn->GetPrevLSN() : INVALID_LSN,
+                   LogRecordType::APPLY_DELETE, rid, old_tuple);
+  AppendLog(txn, &record, pg.GetPage());
+  return true;
+}
+
+TableIterator TableHeap::Begin(const Snapshot *snapshot) {
+  TableIterator iter(this, RID{first_page_id_, UINT16_MAX}, false, snapshot);
   return ++iter;
 }
 
 TableIterator TableHeap::End() { return TableIterator(); }
 
+size_t TableHeap::CollectGarbage(
+    txn_id_t horizon, Transaction *txn,
+    const std::function<void(const RID &, const Tuple &)> &on_reclaim) {
+  size_t reclaimed = 0;
+  std::vector<std::pair<RID, Tuple>> dead;
+  page_id_t page_id = first_page_id_;
+  while (page_id != INVALID_PAGE_ID) {
+    page_id_t next_page_id;
+    bool all_visible = true;
+    {
+      std::lock_guard<std::mutex> guard(latch_);
+      PageGuard pg = buffer_pool_->FetchPageGuarded(page_id);
+      TablePage *tp = pg.GetPage()->As<TablePage>();
+      for (uint16_t slot_id = 0; slot_id < tp->GetSlotCount(); ++slot_id) {
+        txn_id_t xmin, xmax;
+        if (!tp->GetVersion(slot_id, &xmin, &xmax)) {
+          continue;
+        }
+        if (xmax != INVALID_TXN_ID && xmax < horizon) {
+          RID rid{page_id, slot_id};
+          const char *data;
+          uint16_t size;
+          tp->GetTuple(slot_id, &data, &size);
+          dead.emplace_back(rid, Tuple(data, size));
+          tp->ApplyDelete(slot_id);
+          pg.SetDirty();
+          LogRecord record(txn ? txn->GetTxnId() : INVALID_TXN_ID,
+                           txn ? txn->GetPrevLSN() : INVALID_LSN,
+                           LogRecordType::APPLY_DELETE, rid,
+                           dead.back().second);
+          AppendLog(txn, &record, pg.GetPage());
+        } else if (xmax != INVALID_TXN_ID ||
+                   (xmin != INVALID_TXN_ID && xmin >= horizon)) {
+          all_visible = false;
+        }
+      }
+      next_page_id = tp->GetNextPageId();
+      // 还持有 latch_，写者不会在扫描和置位之间修改这一页
+      if (all_visible) {
+        std::lock_guard<std::mutex> visibility_guard(visibility_latch_);
+        not_all_visible_.erase(page_id);
+      }
+    }
+    // 放掉表页再清理索引
+    for (const auto &[rid, tuple] : dead) {
+      on_reclaim(rid, tuple);
+    }
+    reclaimed += dead.size();
+    dead.clear();
+    page_id = next_page_id;
+  }
+  return reclaimed;
+}
+
+std::vector<page_id_t> TableHeap::GetPageIds() {
+  std::lock_guard<std::mutex> guard(latch_);
+  return page_ids_;
+}
+
+bool TableHeap::IsAllVisible(page_id_t page_id) {
+  std::lock_guard<std::mutex> guard(visibility_latch_);
+  return not_all_visible_.count(page_id) == 0;
+}
+
+bool TableHeap::IsAllVisible() {
+  std::lock_guard<std::mutex> guard(visibility_latch_);
+  return not_all_visible_.empty();
+}
+
+void TableHeap::ClearAllVisible(page_id_t page_id) {
+  std::lock_guard<std::mutex> guard(visibility_latch_);
+  not_all_visible_.insert(page_id);
+}
+
 } // namespace mini
@@ -5,15 +5,21 @@
 
 namespace mini {
 
-TableIterator::TableIterator(TableHeap *table_heap, const RID &rid, bool end)
-    : table_heap_(table_heap), rid_(rid), end_(end) {}
+TableIterator::TableIterator(TableHeap *table_heap, const RID &rid, bool end,
+                             const Snapshot *snapshot)
+    : table_heap_(table_heap), rid_(rid), end_(end), snapshot_(snapshot) {}
 
 Tuple TableIterator::operator*() const {
   Tuple tuple;
-  table_heap_->GetTuple(rid_, &tuple);
+  table_heap_->GetTuple(rid_, &tuple, snapshot_);
   return tuple;
 }
 
+void TableIterator::Read(const std::vector<Column> &columns,
+                         Tuple *out) const {
+  table_heap_->GetTuple(rid_, columns, out, snapshot_);
+}
+
 TableIterator &TableIterator::operator++() {
   if (end_) {
     return *this;
@@ -49,7 +55,7 @@ void TableIterator::AdvanceToNextValid() {
   // 查找下一个有效的槽
   while (true) {
     while (next_slot_id < slot_count) {
-      if (!table_page->IsDeleted(next_slot_id)) {
+      if (table_page->IsVisible(next_slot_id, snapshot_)) {
         rid_.slot_id = next_slot_id;
         buffer_pool->UnpinPage(current_page_id, false);
         return;
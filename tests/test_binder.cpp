@@ -64,6 +64,35 @@ TEST_F(BinderTest, BindInsertStatement) {
       "a");
 }
 
+// 值的个数和列数不一样、类型和列不符时绑定失败
+TEST_F(BinderTest, BindInsertChecksValues) {
+  auto schema = std::make_shared<Schema>();
+  schema->AddColumn("col1", DataType::INTEGER);
+  schema->AddColumn("col2", DataType::VARCHAR, 10);
+  catalog_->CreateTable("t", schema);
+
+  for (const char *sql : {"INSERT INTO t VALUES (1, 'a', 3);",
+                          "INSERT INTO t VALUES (1);",
+                          "INSERT INTO t VALUES (1, 'a'), (2);",
+                          "INSERT INTO t VALUES ('a', 'b');",
+                          "INSERT INTO t VALUES (1, 2);"}) {
+    Parser parser(std::make_unique<Lexer>(sql));
+    auto stmt = parser.ParseStatement();
+    ASSERT_NE(stmt, nullptr) << sql;
+    Binder binder(*catalog_);
+    EXPECT_EQ(binder.BindStatement(*stmt), nullptr) << sql;
+    EXPECT_TRUE(binder.HasError()) << sql;
+  }
+
+  // 预编译的 INSERT 多一个 ? 也一样
+  Parser parser(std::make_unique<Lexer>("INSERT INTO t VALUES (?, ?, ?);"),
+                true);
+  auto stmt = parser.ParseStatement();
+  ASSERT_NE(stmt, nullptr);
+  EXPECT_EQ(binder_->BindStatement(*stmt), nullptr);
+  EXPECT_TRUE(binder_->HasError());
+}
+
 // SELECT * FROM t;
 TEST_F(BinderTest, BindSelectStatement) {
   // 首先在 catalog 中创建表 t
@@ -134,3 +163,175 @@ TEST_F(BinderTest, BindCreateIndexStatement) {
   ASSERT_EQ(bound_column_ids.size(), 1);
   ASSERT_EQ(bound_column_ids[0], 0); // col1 在 schema 中的索引是 0
 }
+
+// SELECT * FROM a JOIN b ON b.aid = a.id WHERE w = 1;
+TEST_F(BinderTest, BindJoinStatement) {
+  auto a = std::make_shared<Schema>();
+  a->AddColumn("id", DataType::INTEGER);
+  a->AddColumn("v", DataType::INTEGER);
+  catalog_->CreateTable("a", a);
+  auto b = std::make_shared<Schema>();
+  b->AddColumn("aid", DataType::INTEGER);
+  b->AddColumn("w", DataType::INTEGER);
+  b->AddColumn("v", DataType::INTEGER);
+  catalog_->CreateTable("b", b);
+
+  auto bind = [this](const std::string &sql) {
+    Parser parser(std::make_unique<Lexer>(sql));
+    auto stmt = parser.ParseStatement();
+    EXPECT_NE(stmt, nullptr) << sql;
+    return binder_->BindStatement(*stmt);
+  };
+
+  // ON 两边写反了也按左右表对上，WHERE 下推到右表
+  auto bound_stmt = bind("SELECT * FROM a JOIN b ON b.aid = a.id WHERE w = 1;");
+  ASSERT_NE(bound_stmt, nullptr);
+  auto bound_select = static_cast<BoundSelectStatement *>(bound_stmt.get());
+  BoundJoin *join = bound_select->Join();
+  ASSERT_NE(join, nullptr);
+  EXPECT_EQ(join->left->Table()->name, "a");
+  EXPECT_EQ(join->right->Table()->name, "b");
+  EXPECT_EQ(join->left_column, 0);
+  EXPECT_EQ(join->right_column, 0);
+  EXPECT_FALSE(join->left->HasWhere());
+  EXPECT_TRUE(join->right->HasWhere());
+  auto schema = bound_select->GetSchema();
+  ASSERT_EQ(schema->GetColumnCount(), 5);
+  EXPECT_EQ(schema->GetColumn(2).name, "b.aid");
+  EXPECT_EQ(schema->GetColumn(2).offset, 8);
+
+  // 两张表都有 v
+  EXPECT_EQ(bind("SELECT * FROM a JOIN b ON a.id = v;"), nullptr);
+  EXPECT_EQ(bind("SELECT * FROM a JOIN b ON a.id = a.v;"), nullptr);
+  EXPECT_EQ(bind("SELECT * FROM a JOIN c ON a.id = c.id;"), nullptr);
+}
+
+// ORDER BY 的列解析成输出 schema 里的下标，连接时右表的列排在左表后面
+TEST_F(BinderTest, BindOrderBy) {
+  auto a = std::make_shared<Schema>();
+  a->AddColumn("id", DataType::INTEGER);
+  a->AddColumn("v", DataType::INTEGER);
+  catalog_->CreateTable("a", a);
+  auto b = std::make_shared<Schema>();
+  b->AddColumn("aid", DataType::INTEGER);
+  b->AddColumn("w", DataType::INTEGER);
+  catalog_->CreateTable("b", b);
+
+  auto bind = [this](const std::string &sql) {
+    Parser parser(std::make_unique<Lexer>(sql));
+    auto stmt = parser.ParseStatement();
+    EXPECT_NE(stmt, nullptr) << sql;
+    return binder_->BindStatement(*stmt);
+  };
+
+  auto bound_stmt = bind("SELECT * FROM a ORDER BY v DESC, a.id;");
+  ASSERT_NE(bound_stmt, nullptr);
+  const auto &order_by =
+      static_cast<BoundSelectStatement *>(bound_stmt.get())->OrderBy();
+  ASSERT_EQ(order_by.size(), 2);
+  EXPECT_EQ(order_by[0].column, 1);
+  EXPECT_TRUE(order_by[0].desc);
+  EXPECT_EQ(order_by[1].column, 0);
+  EXPECT_FALSE(order_by[1].desc);
+
+  bound_stmt = bind("SELECT * FROM a JOIN b ON id = aid ORDER BY w;");
+  ASSERT_NE(bound_stmt, nullptr);
+  auto bound_select = static_cast<BoundSelectStatement *>(bound_stmt.get());
+  ASSERT_EQ(bound_select->OrderBy().size(), 1);
+  EXPECT_EQ(bound_select->OrderBy()[0].column, 3);
+
+  EXPECT_EQ(bind("SELECT * FROM a ORDER BY w;"), nullptr);
+  EXPECT_EQ(bind("SELECT * FROM a ORDER BY b.id;"), nullptr);
+  EXPECT_EQ(bind("SELECT COUNT(*) FROM a ORDER BY id;"), nullptr);
+}
+
+// 聚合的输出按 SELECT 列表排列，ORDER BY 指向输出的列
+TEST_F(BinderTest, BindAggregation) {
+  auto a = std::make_shared<Schema>();
+  a->AddColumn("id", DataType::INTEGER);
+  a->AddColumn("name", DataType::VARCHAR, 10);
+  catalog_->CreateTable("a", a);
+  auto b = std::make_shared<Schema>();
+  b->AddColumn("aid", DataType::INTEGER);
+  b->AddColumn("w", DataType::INTEGER);
+  catalog_->CreateTable("b", b);
+
+  auto bind = [this](const std::string &sql) {
+    Parser parser(std::make_unique<Lexer>(sql));
+    auto stmt = parser.ParseStatement();
+    EXPECT_NE(stmt, nullptr) << sql;
+    return binder_->BindStatement(*stmt);
+  };
+
+  auto bound_stmt = bind("SELECT name, COUNT(*), MIN(name), SUM(w) FROM a "
+                         "JOIN b ON id = aid GROUP BY name "
+                         "ORDER BY SUM(w) DESC, name;");
+  ASSERT_NE(bound_stmt, nullptr);
+  auto bound_select = static_cast<BoundSelectStatement *>(bound_stmt.get());
+  const BoundAggregation *aggregation = bound_select->Aggregation();
+  ASSERT_NE(aggregation, nullptr);
+  // 扫描只取 name 和 w 两列，聚合的下标指向扫描出来的行
+  EXPECT_EQ(bound_select->ScanColumns(), (std::vector<uint32_t>{1, 3}));
+  EXPECT_EQ(aggregation->group_by, (std::vector<uint32_t>{0}));
+  ASSERT_EQ(aggregation->items.size(), 4);
+  EXPECT_EQ(aggregation->items[3].column, 1);
+  const auto &schema = *aggregation->schema;
+  ASSERT_EQ(schema.GetColumnCount(), 4);
+  // 连接输出的列名带表名
+  EXPECT_EQ(schema.GetColumn(0).name, "a.name");
+  EXPECT_EQ(schema.GetColumn(1).name, "COUNT(*)");
+  EXPECT_EQ(schema.GetColumn(2).type, DataType::VARCHAR);
+  EXPECT_EQ(schema.GetColumn(2).length, 10);
+  EXPECT_EQ(schema.GetColumn(3).name, "SUM(b.w)");
+  const auto &order_by = bound_select->OrderBy();
+  ASSERT_EQ(order_by.size(), 2);
+  EXPECT_EQ(order_by[0].column, 3);
+  EXPECT_TRUE(order_by[0].desc);
+  EXPECT_EQ(order_by[1].column, 0);
+
+  // 不在 GROUP BY 里的列、VARCHAR 上的 SUM、不在列表里的 ORDER BY
+  EXPECT_EQ(bind("SELECT id, COUNT(*) FROM a;"), nullptr);
+  EXPECT_EQ(bind("SELECT SUM(name) FROM a;"), nullptr);
+  EXPECT_EQ(bind("SELECT id FROM a GROUP BY id ORDER BY MAX(id);"), nullptr);
+  EXPECT_EQ(bind("SELECT * FROM a GROUP BY id;"), nullptr);
+  EXPECT_NE(bind("SELECT id FROM a GROUP BY id;"), nullptr);
+}
+
+// 普通的列表只输出这些列；扫描另外取出 ORDER BY 和 WHERE 用到的列
+TEST_F(BinderTest, BindProjection) {
+  auto a = std::make_shared<Schema>();
+  a->AddColumn("id", DataType::INTEGER);
+  a->AddColumn("name", DataType::VARCHAR, 10);
+  a->AddColumn("v", DataType::INTEGER);
+  catalog_->CreateTable("a", a);
+
+  auto bind = [this](const std::string &sql) {
+    Parser parser(std::make_unique<Lexer>(sql));
+    auto stmt = parser.ParseStatement();
+    EXPECT_NE(stmt, nullptr) << sql;
+    return binder_->BindStatement(*stmt);
+  };
+
+  auto bound_stmt =
+      bind("SELECT name, a.id FROM a WHERE v = 3 ORDER BY v DESC, id;");
+  ASSERT_NE(bound_stmt, nullptr);
+  auto bound_select = static_cast<BoundSelectStatement *>(bound_stmt.get());
+  ASSERT_NE(bound_select->Projection(), nullptr);
+  ASSERT_EQ(bound_select->Projection()->GetColumnCount(), 2);
+  EXPECT_EQ(bound_select->Projection()->GetColumn(0).name, "name");
+  EXPECT_EQ(bound_select->Projection()->GetColumn(1).offset, 10);
+  EXPECT_EQ(bound_select->ScanColumns(), (std::vector<uint32_t>{1, 0, 2}));
+  const auto &order_by = bound_select->OrderBy();
+  ASSERT_EQ(order_by.size(), 2);
+  EXPECT_EQ(order_by[0].column, 2);
+  EXPECT_EQ(order_by[1].column, 1);
+
+  bound_stmt = bind("SELECT v FROM a;");
+  ASSERT_NE(bound_stmt, nullptr);
+  bound_select = static_cast<BoundSelectStatement *>(bound_stmt.get());
+  EXPECT_EQ(bound_select->ScanColumns(), (std::vector<uint32_t>{2}));
+  EXPECT_EQ(bound_select->GetScanSchema()->GetTupleLength(), 4);
+
+  EXPECT_EQ(bind("SELECT w FROM a;"), nullptr);
+  EXPECT_EQ(bind("SELECT id FROM a ORDER BY w;"), nullptr);
+}
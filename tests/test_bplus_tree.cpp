@@ -88,3 +88,203 @@ TEST_F(BPlusTreeTest, RandomInsert) {
     EXPECT_EQ(values[0].slot_id, static_cast<uint16_t>(key));
   }
 }
+
+// 唯一树：重复 key 在同一次下降里被拒绝，树保持不变
+TEST_F(BPlusTreeTest, UniqueInsertRejectsDuplicate) {
+  BPlusTree<int32_t, RID, mini::IntComparator> tree(buffer_pool, true);
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_TRUE(tree.Insert(i, RID{i, static_cast<uint16_t>(i)}));
+  }
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_FALSE(tree.Insert(i, RID{i + 1, 0}));
+  }
+  for (int i = 0; i < 1000; ++i) {
+    std::vector<RID> values;
+    EXPECT_TRUE(tree.GetValue(i, &values));
+    ASSERT_EQ(values.size(), 1);
+    EXPECT_EQ(values[0].page_id, i);
+  }
+}
+
+// 非唯一树中重复 key 跨越多个叶子，查询和删除都要看到全部
+TEST_F(BPlusTreeTest, DuplicateKeysAcrossLeaves) {
+  BPlusTree<int32_t, RID, mini::IntComparator> tree(buffer_pool);
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_TRUE(tree.Insert(i % 2, RID{i, static_cast<uint16_t>(i)}));
+  }
+  std::vector<RID> values;
+  EXPECT_TRUE(tree.GetValue(0, &values));
+  EXPECT_EQ(values.size(), 500);
+
+  for (int i = 0; i < 1000; i += 2) {
+    EXPECT_TRUE(tree.Remove(0, RID{i, static_cast<uint16_t>(i)}));
+  }
+  EXPECT_FALSE(tree.Remove(0, RID{0, 0}));
+  values.clear();
+  EXPECT_FALSE(tree.GetValue(0, &values));
+  EXPECT_TRUE(tree.GetValue(1, &values));
+  EXPECT_EQ(values.size(), 500);
+}
+
+// 批量查找和逐个查找结果一样，排好序的 key 共用叶子，取页少得多
+TEST_F(BPlusTreeTest, GetValuesSortedBatch) {
+  BPlusTree<int32_t, RID, mini::IntComparator> tree(buffer_pool);
+  for (int i = 0; i < 20000; ++i) {
+    // 偶数 key，100 的倍数重复 300 次，跨过好几个叶子
+    int key = i < 3000 ? (i % 10) * 100 : i * 2;
+    tree.Insert(key, RID{i, static_cast<uint16_t>(i)});
+  }
+  std::vector<int32_t> keys;
+  for (int k = -1; k < 12000; k += 3) {
+    keys.push_back(k);
+  }
+  keys.push_back(50000);
+
+  size_t before = buffer_pool->GetFetchCount();
+  std::vector<std::vector<RID>> batch;
+  tree.GetValues(keys, &batch);
+  size_t batch_fetch = buffer_pool->GetFetchCount() - before;
+
+  before = buffer_pool->GetFetchCount();
+  ASSERT_EQ(batch.size(), keys.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    std::vector<RID> values;
+    tree.GetValue(keys[i], &values);
+    ASSERT_EQ(batch[i].size(), values.size()) << keys[i];
+    for (size_t j = 0; j < values.size(); ++j) {
+      EXPECT_EQ(batch[i][j].page_id, values[j].page_id);
+    }
+  }
+  size_t single_fetch = buffer_pool->GetFetchCount() - before;
+  EXPECT_TRUE(batch[1].empty());
+  ASSERT_EQ(keys[67], 200);
+  EXPECT_EQ(batch[67].size(), 300);
+  EXPECT_LT(batch_fetch * 4, single_fetch);
+}
+
+// 插入只 pin 当前页，三层的树用 3 个帧的缓冲池也能建起来
+TEST_F(BPlusTreeTest, InsertWithTinyBufferPool) {
+  delete buffer_pool;
+  buffer_pool = new BufferPool(3, disk_manager);
+  BPlusTree<int32_t, RID, mini::IntComparator> tree(buffer_pool);
+  for (int i = 0; i < 100000; ++i) {
+    ASSERT_TRUE(tree.Insert(i, RID{i, static_cast<uint16_t>(i)}));
+  }
+  for (int i = 0; i < 100000; i += 97) {
+    std::vector<RID> values;
+    EXPECT_TRUE(tree.GetValue(i, &values));
+    ASSERT_EQ(values.size(), 1);
+    EXPECT_EQ(values[0].page_id, i);
+  }
+}
+
+// 缓冲池被别人占住时分裂取不到页，插入抛异常而不是崩溃，
+// 放开之后留下的满节点接着分裂，树仍然完整
+TEST_F(BPlusTreeTest, InsertFailsCleanlyWithoutFreeFrames) {
+  delete buffer_pool;
+  buffer_pool = new BufferPool(4, disk_manager);
+  BPlusTree<int32_t, RID, mini::IntComparator> tree(buffer_pool);
+  int n = 0;
+  for (; n < 1000; ++n) {
+    ASSERT_TRUE(tree.Insert(n, RID{n, 0}));
+  }
+  // 只剩叶子和头页用的两个帧
+  page_id_t a, b;
+  auto guard_a = buffer_pool->NewPageGuarded(&a);
+  auto guard_b = buffer_pool->NewPageGuarded(&b);
+  int failed_key = -1;
+  for (; n < 2000; ++n) {
+    try {
+      ASSERT_TRUE(tree.Insert(n, RID{n, 0}));
+    } catch (const std::runtime_error &) {
+      failed_key = n;
+      break;
+    }
+  }
+  ASSERT_NE(failed_key, -1);
+  guard_a = PageGuard(buffer_pool, INVALID_PAGE_ID, nullptr);
+  guard_b = PageGuard(buffer_pool, INVALID_PAGE_ID, nullptr);
+  for (; n < 2000; ++n) {
+    ASSERT_TRUE(tree.Insert(n, RID{n, 0}));
+  }
+  EXPECT_EQ(tree.GetEntryCount(), 2000);
+  for (int i = 0; i < 2000; ++i) {
+    std::vector<RID> values;
+    ASSERT_TRUE(tree.GetValue(i, &values));
+    ASSERT_EQ(values.size(), 1);
+    EXPECT_EQ(values[0].page_id, i);
+  }
+}
+
+// 不分裂的插入每层只取一次页，分裂时才回头取父节点
+TEST_F(BPlusTreeTest, FetchCountPerInsert) {
+  BPlusTree<int32_t, RID, mini::IntComparator> tree(buffer_pool);
+  std::vector<int> keys(40000);
+  for (int i = 0; i < 40000; ++i) {
+    keys[i] = i;
+  }
+  std::mt19937 gen(42);
+  std::shuffle(keys.begin(), keys.end(), gen);
+  for (int i = 0; i < 20000; ++i) {
+    tree.Insert(keys[i], RID{keys[i], 0});
+  }
+  // 最左叶子的第一个 key 之前，计数只经过每层一次
+  size_t before = buffer_pool->GetFetchCount();
+  tree.CountValue(-1);
+  size_t depth = buffer_pool->GetFetchCount() - before;
+  ASSERT_GE(depth, 2);
+
+  size_t total = 0, min_fetch = SIZE_MAX, max_fetch = 0;
+  for (int i = 20000; i < 40000; ++i) {
+    before = buffer_pool->GetFetchCount();
+    tree.Insert(keys[i], RID{keys[i], 0});
+    size_t fetch = buffer_pool->GetFetchCount() - before;
+    total += fetch;
+    min_fetch = std::min(min_fetch, fetch);
+    max_fetch = std::max(max_fetch, fetch);
+  }
+  // 每次插入还要改头页里的项数
+  EXPECT_EQ(min_fetch, depth + 1);
+  // 每层最多：下降一次 + 回头一次 + 新页一次，再加一个新根
+  EXPECT_LE(max_fetch, 3 * depth + 2);
+  EXPECT_LT(static_cast<double>(total) / 20000, depth + 1.1);
+}
+
+// 头页记下根和元数据，关闭后重新打开文件，树直接可用
+TEST_F(BPlusTreeTest, ReopenFromHeaderPage) {
+  page_id_t header_page_id;
+  uint32_t height;
+  {
+    BPlusTree<int32_t, RID, mini::IntComparator> tree(buffer_pool, true);
+    for (int i = 0; i < 5000; ++i) {
+      ASSERT_TRUE(tree.Insert(i, RID{i, static_cast<uint16_t>(i)}));
+    }
+    header_page_id = tree.GetHeaderPageId();
+    height = tree.GetHeight();
+    EXPECT_GE(height, 2);
+    EXPECT_EQ(tree.GetEntryCount(), 5000);
+  }
+  buffer_pool->FlushAllPages();
+  delete buffer_pool;
+  delete disk_manager;
+  disk_manager = new DiskManager("data/test.db");
+  buffer_pool = new BufferPool(100, disk_manager);
+
+  BPlusTree<int32_t, RID, mini::IntComparator> tree(buffer_pool,
+                                                    header_page_id);
+  EXPECT_EQ(tree.GetHeight(), height);
+  EXPECT_EQ(tree.GetEntryCount(), 5000);
+  EXPECT_TRUE(tree.IsUnique());
+  EXPECT_FALSE(tree.Insert(42, RID{0, 0}));
+  // 新页接在文件末尾，不会覆盖已有的树页
+  for (int i = 5000; i < 10000; ++i) {
+    ASSERT_TRUE(tree.Insert(i, RID{i, static_cast<uint16_t>(i)}));
+  }
+  for (int i = 0; i < 10000; ++i) {
+    std::vector<RID> values;
+    EXPECT_TRUE(tree.GetValue(i, &values));
+    ASSERT_EQ(values.size(), 1);
+    EXPECT_EQ(values[0].page_id, i);
+  }
+  EXPECT_EQ(tree.GetEntryCount(), 10000);
+}
@@ -40,11 +40,11 @@ TEST_F(BPlusTreePageTest, BasicLeafPageInsert) {
   auto *leaf_page =
       BPlusTreeLeafPage<int32_t, RID, mini::IntComparator>::From(&page);
   leaf_page->Init(0);
-  for (int i = 0; i < 339; ++i) {
+  for (int i = 0; i < 338; ++i) {
     EXPECT_TRUE(leaf_page->Insert(i, RID{i, static_cast<uint16_t>(i)}));
   }
-  EXPECT_EQ(leaf_page->GetKeyCount(), 339);
-  for (int i = 0; i < 339; ++i) {
+  EXPECT_EQ(leaf_page->GetKeyCount(), 338);
+  for (int i = 0; i < 338; ++i) {
     EXPECT_EQ(leaf_page->KeyAt(i), i);
     EXPECT_EQ(leaf_page->ValueAt(i).page_id, i);
     EXPECT_EQ(leaf_page->ValueAt(i).slot_id, i);
@@ -108,21 +108,21 @@ TEST_F(BPlusTreePageTest, SplitLeafPage) {
       BPlusTreeLeafPage<int32_t, RID, mini::IntComparator>::From(&page2);
   leaf_page1->Init(0);
   leaf_page2->Init(0);
-  for (int i = 0; i < 339; ++i) {
+  for (int i = 0; i < 338; ++i) {
     EXPECT_TRUE(leaf_page1->Insert(i, RID{i, static_cast<uint16_t>(i)}));
   }
   EXPECT_TRUE(leaf_page1->Split(leaf_page2));
-  EXPECT_EQ(leaf_page1->GetKeyCount(), 170);
+  EXPECT_EQ(leaf_page1->GetKeyCount(), 169);
   EXPECT_EQ(leaf_page2->GetKeyCount(), 169);
-  for (int i = 0; i < 170; ++i) {
+  for (int i = 0; i < 169; ++i) {
     EXPECT_EQ(leaf_page1->KeyAt(i), i);
     EXPECT_EQ(leaf_page1->ValueAt(i).page_id, i);
     EXPECT_EQ(leaf_page1->ValueAt(i).slot_id, i);
   }
   for (int i = 0; i < 169; ++i) {
-    EXPECT_EQ(leaf_page2->KeyAt(i), i + 170);
-    EXPECT_EQ(leaf_page2->ValueAt(i).page_id, i + 170);
-    EXPECT_EQ(leaf_page2->ValueAt(i).slot_id, static_cast<uint16_t>(i + 170));
+    EXPECT_EQ(leaf_page2->KeyAt(i), i + 169);
+    EXPECT_EQ(leaf_page2->ValueAt(i).page_id, i + 169);
+    EXPECT_EQ(leaf_page2->ValueAt(i).slot_id, static_cast<uint16_t>(i + 169));
   }
 }
 
@@ -147,11 +147,11 @@ TEST_F(BPlusTreePageTest, BasicInternalPageInsert) {
       BPlusTreeInternalPage<int32_t, page_id_t, mini::IntComparator>::From(
           &page);
   internal_page->Init(0);
-  for (int i = 0; i < 509; ++i) {
+  for (int i = 0; i < 508; ++i) {
     EXPECT_TRUE(internal_page->Insert(i, i + 1000));
   }
-  EXPECT_EQ(internal_page->GetKeyCount(), 509);
-  for (int i = 0; i < 509; ++i) {
+  EXPECT_EQ(internal_page->GetKeyCount(), 508);
+  for (int i = 0; i < 508; ++i) {
     EXPECT_EQ(internal_page->KeyAt(i), i);
     EXPECT_EQ(internal_page->ValueAt(i), i + 1000);
   }
@@ -170,19 +170,19 @@ TEST_F(BPlusTreePageTest, SplitInternalPage) {
           &page2);
   internal_page1->Init(0);
   internal_page2->Init(0);
-  for (int i = 0; i < 509; ++i) {
+  for (int i = 0; i < 508; ++i) {
     EXPECT_TRUE(internal_page1->Insert(i, i + 1000));
   }
   EXPECT_TRUE(internal_page1->Split(internal_page2));
-  EXPECT_EQ(internal_page1->GetKeyCount(), 255);
+  EXPECT_EQ(internal_page1->GetKeyCount(), 254);
   EXPECT_EQ(internal_page2->GetKeyCount(), 254);
-  for (int i = 0; i < 255; ++i) {
+  for (int i = 0; i < 254; ++i) {
     EXPECT_EQ(internal_page1->KeyAt(i), i);
     EXPECT_EQ(internal_page1->ValueAt(i), i + 1000);
   }
   for (int i = 0; i < 254; ++i) {
-    EXPECT_EQ(internal_page2->KeyAt(i), i + 255);
-    EXPECT_EQ(internal_page2->ValueAt(i), i + 1255);
+    EXPECT_EQ(internal_page2->KeyAt(i), i + 254);
+    EXPECT_EQ(internal_page2->ValueAt(i), i + 1254);
   }
 }
 
@@ -151,3 +151,15 @@ TEST_F(BufferPoolTest, FetchPageGuarded) {
     }
   }
 }
+
+// 池里已有的页算命中，被换出去后再取要重新读盘
+TEST_F(BufferPoolTest, MissCountOnlyCountsDiskReads) {
+  bp_ = std::make_unique<BufferPool>(1, dm_.get());
+
+  for (page_id_t pid : {0, 0, 1, 0}) {
+    ASSERT_NE(bp_->FetchPage(pid), nullptr);
+    EXPECT_TRUE(bp_->UnpinPage(pid, false));
+  }
+  EXPECT_EQ(bp_->GetFetchCount(), 4);
+  EXPECT_EQ(bp_->GetMissCount(), 3);
+}
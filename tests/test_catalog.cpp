@@ -1,7 +1,11 @@
 #include "catalog/catalog.h"
+#include "concurrency/transaction_manager.h"
+#include "recovery/log_manager.h"
+#include "recovery/log_recovery.h"
 #include "storage/buffer_pool.h"
 #include "storage/disk_manager.h"
 #include "storage/table_heap.h"
+#include "storage/table_iterator.h"
 #include <cstdint>
 #include <cstring>
 #include <filesystem>
@@ -98,3 +102,120 @@ TEST_F(CatalogTest, CreateAndGetIndex) {
 
   catalog.ListIndexes();
 }
+
+// 表和索引写进目录页，刷盘后重新打开还能读回来，数据和索引项都在
+TEST_F(CatalogTest, PersistAndLoad) {
+  {
+    Catalog catalog(bp_.get());
+    EXPECT_FALSE(catalog.Load());
+
+    auto schema = std::make_shared<Schema>();
+    schema->AddColumn("id", DataType::INTEGER);
+    schema->AddColumn("name", DataType::VARCHAR, 10);
+    TableInfo *table_info = catalog.CreateTable("users", schema);
+    IndexInfo *tree_index = catalog.CreateIndex("users_pkey", "users", 0, true);
+    IndexInfo *hash_index = catalog.CreateIndex("idx_name_id", "users", 0,
+                                                false, IndexType::HASH);
+    for (int32_t i = 0; i < 100; ++i) {
+      Tuple tuple;
+      char *buf = tuple.Resize(schema->GetTupleLength());
+      memcpy(buf, &i, sizeof(i));
+      RID rid = table_info->table->InsertTuple(tuple);
+      ASSERT_TRUE(tree_index->index->InsertEntry(tuple, rid));
+      ASSERT_TRUE(hash_index->index->InsertEntry(tuple, rid));
+    }
+    catalog.Persist();
+    bp_->FlushAllPages();
+  }
+  bp_.reset();
+  dm_ = std::make_unique<DiskManager>(db_file_.string());
+  bp_ = std::make_unique<BufferPool>(10, dm_.get());
+
+  Catalog catalog(bp_.get());
+  ASSERT_TRUE(catalog.Load());
+  TableInfo *table_info = catalog.GetTable("users");
+  ASSERT_NE(table_info, nullptr);
+  ASSERT_EQ(table_info->schema->GetColumnCount(), 2);
+  EXPECT_EQ(table_info->schema->GetColumn(1).name, "name");
+  EXPECT_EQ(table_info->schema->GetColumn(1).type, DataType::VARCHAR);
+  EXPECT_EQ(table_info->schema->GetColumn(1).length, 10);
+  size_t rows = 0;
+  for (auto iter = table_info->table->Begin(), end = table_info->table->End();
+       iter != end; ++iter) {
+    rows++;
+  }
+  EXPECT_EQ(rows, 100);
+
+  // 两个索引按建的先后载入
+  auto &indexes = catalog.GetIndexes("users");
+  ASSERT_EQ(indexes.size(), 2);
+  IndexInfo *tree_index = indexes[0].get();
+  EXPECT_EQ(tree_index->index_name, "users_pkey");
+  EXPECT_TRUE(tree_index->is_unique);
+  EXPECT_EQ(tree_index->index_type, IndexType::BPLUS_TREE);
+  IndexInfo *hash_index = indexes[1].get();
+  EXPECT_EQ(hash_index->index_name, "idx_name_id");
+  EXPECT_FALSE(hash_index->is_unique);
+  EXPECT_EQ(hash_index->index_type, IndexType::HASH);
+  EXPECT_EQ(hash_index->key_schema->GetColumn(0).name, "id");
+  for (int32_t i = 0; i < 100; ++i) {
+    EXPECT_EQ(tree_index->index->CountKey(IntValue(i)), 1);
+    EXPECT_EQ(hash_index->index->CountKey(IntValue(i)), 1);
+  }
+
+  // 载入之后接着分配的编号不会和已有的重复
+  catalog.CreateTable("orders", table_info->schema);
+  EXPECT_NE(catalog.GetTable("orders")->table_id, table_info->table_id);
+}
+
+// 目录页的修改写日志：没刷盘就崩溃，恢复之后照样能读回表和索引
+TEST_F(CatalogTest, PersistIsRecoveredFromLog) {
+  std::filesystem::path log_file{"test_catalog.log"};
+  std::filesystem::remove(log_file);
+  bp_.reset();
+  page_id_t header_page_id;
+  {
+    auto log_manager = std::make_unique<LogManager>(dm_.get());
+    auto bp = std::make_unique<BufferPool>(10, dm_.get(), log_manager.get());
+    TransactionManager txn_manager(log_manager.get());
+    Catalog catalog(bp.get(), log_manager.get());
+    catalog.Load();
+    auto schema = std::make_shared<Schema>();
+    schema->AddColumn("id", DataType::INTEGER);
+    catalog.CreateTable("users", schema);
+    header_page_id = catalog.CreateIndex("idx_id", "users", 0, false,
+                                         IndexType::HASH)
+                         ->index->GetHeaderPageId();
+    catalog.Persist(&txn_manager);
+    // 提交时日志已经落盘，缓冲池里的页都不写回
+    lsn_t durable = log_manager->GetFlushedLSN();
+    bp.reset();
+    log_manager.reset();
+    dm_.reset();
+    std::filesystem::resize_file(log_file, durable);
+  }
+
+  dm_ = std::make_unique<DiskManager>(db_file_.string());
+  auto log_manager = std::make_unique<LogManager>(dm_.get());
+  bp_ = std::make_unique<BufferPool>(10, dm_.get(), log_manager.get());
+  LogRecovery recovery(dm_.get(), bp_.get(), log_manager.get());
+  recovery.Recover();
+  Catalog catalog(bp_.get(), log_manager.get());
+  ASSERT_TRUE(catalog.Load());
+  ASSERT_NE(catalog.GetTable("users"), nullptr);
+  IndexInfo *index_info = catalog.GetIndex("users", "id");
+  ASSERT_NE(index_info, nullptr);
+  EXPECT_EQ(index_info->index_type, IndexType::HASH);
+  EXPECT_EQ(index_info->index->GetHeaderPageId(), header_page_id);
+
+  Tuple tuple;
+  int32_t id = 7;
+  memcpy(tuple.Resize(sizeof(id)), &id, sizeof(id));
+  RID rid = catalog.GetTable("users")->table->InsertTuple(tuple);
+  EXPECT_TRUE(index_info->index->InsertEntry(tuple, rid));
+  EXPECT_EQ(index_info->index->CountKey(IntValue(7)), 1);
+
+  bp_.reset();
+  log_manager.reset();
+  std::filesystem::remove(log_file);
+}
@@ -0,0 +1,68 @@
+#include "common/compression.h"
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace mini;
+
+static std::vector<char> RoundTrip(const std::vector<char> &data) {
+  std::vector<char> compressed = Compress(data.data(), data.size());
+  std::vector<char> out(data.size());
+  EXPECT_TRUE(
+      Decompress(compressed.data(), compressed.size(), out.data(), out.size()));
+  return out;
+}
+
+// 空输入、短输入、全零的页、重复的行和随机字节都能原样解回
+TEST(CompressionTest, RoundTrip) {
+  std::vector<std::vector<char>> inputs;
+  inputs.emplace_back();
+  inputs.push_back({'a', 'b', 'c'});
+  inputs.emplace_back(4096, 0);
+  std::string rows;
+  for (int i = 0; i < 500; ++i) {
+    rows += "row " + std::to_string(i % 37) + " value " + std::to_string(i);
+  }
+  inputs.emplace_back(rows.begin(), rows.end());
+  std::mt19937 gen(7);
+  std::vector<char> random(10000);
+  for (char &c : random) {
+    c = static_cast<char>(gen());
+  }
+  inputs.push_back(random);
+  // 超过 64KB 的输入，匹配不能跨过 2 字节偏移
+  std::vector<char> large;
+  for (int i = 0; i < 3; ++i) {
+    large.insert(large.end(), random.begin(), random.end());
+    large.insert(large.end(), 70000, static_cast<char>(i));
+  }
+  inputs.push_back(large);
+
+  for (const auto &input : inputs) {
+    EXPECT_EQ(RoundTrip(input), input) << input.size();
+  }
+  // 重复的内容压得小，随机字节基本不变
+  EXPECT_LT(Compress(inputs[2].data(), 4096).size(), 64);
+  EXPECT_LT(Compress(rows.data(), rows.size()).size(), rows.size() / 2);
+  EXPECT_LT(Compress(random.data(), random.size()).size(),
+            random.size() + random.size() / 100);
+}
+
+// 长度不符或被截断的输入解压失败，不会越界
+TEST(CompressionTest, RejectsCorruptInput) {
+  std::vector<char> data(4096);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<char>(i % 100);
+  }
+  std::vector<char> compressed = Compress(data.data(), data.size());
+  std::vector<char> out(data.size() + 1);
+  EXPECT_FALSE(Decompress(compressed.data(), compressed.size(), out.data(),
+                          data.size() + 1));
+  EXPECT_FALSE(Decompress(compressed.data(), compressed.size(), out.data(),
+                          data.size() - 1));
+  for (size_t len = 0; len < compressed.size(); ++len) {
+    EXPECT_FALSE(Decompress(compressed.data(), len, out.data(), data.size()))
+        << len;
+  }
+}
@@ -0,0 +1,1004 @@
+#include "binder/binder.h"
+#include "catalog/catalog.h"
+#include "execution/execution_context.h"
+#include "execution/executor.h"
+#include "parser/parser.h"
+#include "storage/buffer_pool.h"
+#include "storage/disk_manager.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <gtest/gtest.h>
+#include <map>
+#include <memory>
+#include <random>
+#include <set>
+#include <stdexcept>
+
+using namespace mini;
+
+class ExecutorTest : public ::testing::Test {
+protected:
+  std::filesystem::path db_file_{"test_executor.db"};
+  std::unique_ptr<DiskManager> dm_;
+  std::unique_ptr<BufferPool> bp_;
+  std::unique_ptr<Catalog> catalog_;
+  std::unique_ptr<ExecutionContext> ctx_;
+
+  void SetUp() override {
+    std::filesystem::remove(db_file_);
+    dm_ = std::make_unique<DiskManager>(db_file_.string());
+    bp_ = std::make_unique<BufferPool>(100, dm_.get());
+    catalog_ = std::make_unique<Catalog>(bp_.get());
+    ctx_ = std::make_unique<ExecutionContext>(*catalog_);
+  }
+
+  void TearDown() override {
+    ctx_.reset();
+    catalog_.reset();
+    bp_.reset();
+    dm_.reset();
+    std::filesystem::remove(db_file_);
+  }
+
+  std::unique_ptr<BoundStatement> Bind(const std::string &sql) {
+    Parser parser(std::make_unique<Lexer>(sql));
+    auto stmt = parser.ParseStatement();
+    if (!stmt) {
+      throw std::runtime_error("parse error: " + parser.GetError().Message());
+    }
+    Binder binder(*catalog_);
+    auto bound = binder.BindStatement(*stmt);
+    if (!bound) {
+      throw std::runtime_error("bind error: " + binder.GetError().Message());
+    }
+    return bound;
+  }
+
+  // 执行非 SELECT 语句
+  void Execute(const std::string &sql) {
+    auto bound = Bind(sql);
+    std::unique_ptr<Executor> exec;
+    switch (bound->Type()) {
+    case BoundStatementType::BOUND_INSERT:
+      exec = std::make_unique<InsertExecutor>(
+          *ctx_, std::unique_ptr<BoundInsertStatement>(
+                     static_cast<BoundInsertStatement *>(bound.release())));
+      break;
+    case BoundStatementType::BOUND_CREATE_TABLE:
+      exec = std::make_unique<CreateTableExecutor>(
+          *ctx_,
+          std::unique_ptr<BoundCreateTableStatement>(
+              static_cast<BoundCreateTableStatement *>(bound.release())));
+      break;
+    case BoundStatementType::BOUND_CREATE_INDEX:
+      exec = std::make_unique<CreateIndexExecutor>(
+          *ctx_,
+          std::unique_ptr<BoundCreateIndexStatement>(
+              static_cast<BoundCreateIndexStatement *>(bound.release())));
+      break;
+    case BoundStatementType::BOUND_TRANSACTION:
+      exec = std::make_unique<TransactionExecutor>(
+          *ctx_,
+          std::unique_ptr<BoundTransactionStatement>(
+              static_cast<BoundTransactionStatement *>(bound.release())));
+      break;
+    default:
+      throw std::runtime_error("unsupported statement in Execute");
+    }
+    exec->Init();
+    while (exec->Next(nullptr)) {
+    }
+  }
+
+  // 一条多行 INSERT 写入 rows 里的每一行 (k, v)
+  void InsertRows(const std::string &table,
+                  const std::vector<std::pair<int, int>> &rows) {
+    std::string sql = "INSERT INTO " + table + " VALUES ";
+    for (size_t i = 0; i < rows.size(); ++i) {
+      sql += (i == 0 ? "(" : ", (") + std::to_string(rows[i].first) + ", " +
+             std::to_string(rows[i].second) + ")";
+    }
+    Execute(sql + ";");
+  }
+
+  std::unique_ptr<SelectExecutor> Scan(const std::string &sql) {
+    auto bound = Bind(sql);
+    return std::make_unique<SelectExecutor>(
+        *ctx_, std::unique_ptr<BoundSelectStatement>(
+                   static_cast<BoundSelectStatement *>(bound.release())));
+  }
+
+  // 执行 SELECT，返回所有结果行
+  std::vector<Tuple> Query(const std::string &sql) {
+    auto bound = Bind(sql);
+    SelectExecutor exec(
+        *ctx_, std::unique_ptr<BoundSelectStatement>(
+                   static_cast<BoundSelectStatement *>(bound.release())));
+    exec.Init();
+    std::vector<Tuple> rows;
+    Tuple t;
+    while (exec.Next(&t)) {
+      rows.push_back(t);
+    }
+    return rows;
+  }
+};
+
+// 主键列上重复插入被拒绝，表和索引都不留下这一行
+TEST_F(ExecutorTest, PrimaryKeyRejectsDuplicate) {
+  Execute("CREATE TABLE t (id INT PRIMARY KEY, v INT);");
+  ASSERT_NE(catalog_->GetIndex("t", "id"), nullptr);
+  EXPECT_TRUE(catalog_->GetIndex("t", "id")->is_unique);
+
+  Execute("INSERT INTO t VALUES (1, 10);");
+  Execute("INSERT INTO t VALUES (2, 20);");
+  EXPECT_THROW(Execute("INSERT INTO t VALUES (1, 30);"), std::runtime_error);
+
+  EXPECT_EQ(Query("SELECT * FROM t;").size(), 2);
+  EXPECT_EQ(Query("SELECT * FROM t WHERE id = 1;").size(), 1);
+}
+
+// 主键索引建不成时整条建表语句不生效，表不留下
+TEST_F(ExecutorTest, CreateTableDropsTableWhenPrimaryKeyFails) {
+  Execute("CREATE TABLE a (id INT, v INT);");
+  Execute("CREATE INDEX b_pkey ON a(id);");
+  EXPECT_THROW(Execute("CREATE TABLE b (id INT PRIMARY KEY, v INT);"),
+               std::runtime_error);
+  EXPECT_EQ(catalog_->GetTable("b"), nullptr);
+  EXPECT_EQ(catalog_->GetIndex("b", "id"), nullptr);
+  EXPECT_THROW(Bind("SELECT * FROM b;"), std::runtime_error);
+}
+
+// 第二个唯一索引冲突时，第一个索引里已写入的项要撤销
+TEST_F(ExecutorTest, UniqueViolationRollsBackEarlierIndexes) {
+  Execute("CREATE TABLE t (a INT, b INT);");
+  Execute("CREATE UNIQUE INDEX idx_a ON t(a);");
+  Execute("CREATE UNIQUE INDEX idx_b ON t(b);");
+  Execute("INSERT INTO t VALUES (1, 1);");
+  EXPECT_THROW(Execute("INSERT INTO t VALUES (2, 1);"), std::runtime_error);
+
+  EXPECT_EQ(Query("SELECT * FROM t WHERE a = 2;").size(), 0);
+  Execute("INSERT INTO t VALUES (2, 2);");
+  EXPECT_EQ(Query("SELECT * FROM t WHERE a = 2;").size(), 1);
+}
+
+// 多行 INSERT 是一条语句：后面的行冲突时前面的行也不留下
+TEST_F(ExecutorTest, MultiRowInsertIsAtomic) {
+  Execute("CREATE TABLE t (id INT PRIMARY KEY, v INT);");
+  Execute("INSERT INTO t VALUES (1, 10), (2, 20), (3, 30);");
+  EXPECT_EQ(Query("SELECT * FROM t;").size(), 3);
+  EXPECT_EQ(Query("SELECT * FROM t WHERE id = 2;").size(), 1);
+
+  EXPECT_THROW(Execute("INSERT INTO t VALUES (4, 40), (5, 50), (1, 60);"),
+               std::runtime_error);
+  EXPECT_EQ(Query("SELECT * FROM t;").size(), 3);
+  EXPECT_EQ(Query("SELECT * FROM t WHERE id = 4;").size(), 0);
+}
+
+// 已有重复数据时不能建唯一索引
+TEST_F(ExecutorTest, CreateUniqueIndexOnDuplicateRows) {
+  Execute("CREATE TABLE t (a INT);");
+  Execute("INSERT INTO t VALUES (1);");
+  Execute("INSERT INTO t VALUES (1);");
+  page_id_t next = dm_->AllocatePage();
+  dm_->DeallocatePage(next);
+  EXPECT_THROW(Execute("CREATE UNIQUE INDEX idx_a ON t(a);"),
+               std::runtime_error);
+  EXPECT_EQ(catalog_->GetIndex("t", "a"), nullptr);
+  // 索引的头页和根都还回去了，接下来分配的页先用它们
+  std::set<page_id_t> reused{dm_->AllocatePage(), dm_->AllocatePage()};
+  EXPECT_EQ(reused, (std::set<page_id_t>{next, next + 1}));
+}
+
+// 建索引只收快照看得到的版本：没提交的插入和已提交的删除都不进索引
+TEST_F(ExecutorTest, CreateIndexSkipsInvisibleVersions) {
+  Execute("CREATE TABLE t (id INT, v INT);");
+  Execute("INSERT INTO t VALUES (1, 10);");
+  Execute("INSERT INTO t VALUES (2, 20);");
+  TableInfo *table = catalog_->GetTable("t");
+  auto &txn_manager = ctx_->GetTransactionManager();
+  auto row = [](int32_t id, int32_t v) {
+    Tuple tuple;
+    char *buf = tuple.Resize(2 * sizeof(int32_t));
+    memcpy(buf, &id, sizeof(int32_t));
+    memcpy(buf + sizeof(int32_t), &v, sizeof(int32_t));
+    return tuple;
+  };
+
+  Transaction *deleter = txn_manager.Begin();
+  for (auto it = table->table->Begin(), end = table->table->End(); it != end;
+       ++it) {
+    int32_t id;
+    memcpy(&id, (*it).Data(), sizeof(int32_t));
+    if (id == 2) {
+      ASSERT_TRUE(table->table->DeleteTuple(it.GetRID(), deleter));
+    }
+  }
+  txn_manager.Commit(deleter);
+  Transaction *writer = txn_manager.Begin();
+  table->table->InsertTuple(row(3, 30), writer);
+
+  Execute("CREATE UNIQUE INDEX idx_id ON t(id);");
+  Index *index = catalog_->GetIndex("t", "id")->index.get();
+  std::vector<RID> result[3];
+  EXPECT_TRUE(index->ScanKey(IntValue(1), &result[0]));
+  EXPECT_FALSE(index->ScanKey(IntValue(2), &result[1]));
+  EXPECT_FALSE(index->ScanKey(IntValue(3), &result[2]));
+  txn_manager.Abort(writer);
+
+  // 显式事务里不能建索引
+  Execute("BEGIN;");
+  EXPECT_THROW(Execute("CREATE INDEX idx_v ON t(v);"), std::runtime_error);
+  Execute("ROLLBACK;");
+}
+
+// USING HASH 建的索引同样用于等值查询和唯一约束
+TEST_F(ExecutorTest, HashIndexPointLookup) {
+  Execute("CREATE TABLE t (id INT, v INT);");
+  for (int i = 0; i < 500; ++i) {
+    Execute("INSERT INTO t VALUES (" + std::to_string(i % 100) + ", " +
+            std::to_string(i) + ");");
+  }
+  Execute("CREATE INDEX idx_id ON t(id) USING HASH;");
+  ASSERT_EQ(catalog_->GetIndex("t", "id")->index_type, IndexType::HASH);
+  EXPECT_EQ(Query("SELECT * FROM t WHERE id = 42;").size(), 5);
+
+  Execute("CREATE TABLE u (id INT, v INT);");
+  Execute("CREATE UNIQUE INDEX idx_u ON u(id) USING HASH;");
+  Execute("INSERT INTO u VALUES (1, 1);");
+  EXPECT_THROW(Execute("INSERT INTO u VALUES (1, 2);"), std::runtime_error);
+  EXPECT_EQ(Query("SELECT * FROM u WHERE id = 1;").size(), 1);
+}
+
+// COUNT(*) 走索引和走全表扫描结果一致
+TEST_F(ExecutorTest, CountStarWithAndWithoutIndex) {
+  Execute("CREATE TABLE t (id INT, v INT);");
+  for (int i = 0; i < 300; ++i) {
+    Execute("INSERT INTO t VALUES (" + std::to_string(i % 10) + ", " +
+            std::to_string(i) + ");");
+  }
+  auto count_of = [this](const std::string &sql) {
+    auto rows = Query(sql);
+    EXPECT_EQ(rows.size(), 1);
+    int32_t count;
+    memcpy(&count, rows[0].Data(), sizeof(int32_t));
+    return count;
+  };
+  EXPECT_EQ(count_of("SELECT COUNT(*) FROM t;"), 300);
+  EXPECT_EQ(count_of("SELECT COUNT(*) FROM t WHERE id = 3;"), 30);
+
+  Execute("CREATE INDEX idx_id ON t(id);");
+  auto bound = Bind("SELECT COUNT(*) FROM t WHERE id = 3;");
+  EXPECT_TRUE(static_cast<BoundSelectStatement *>(bound.get())->IsIndexOnly());
+  EXPECT_EQ(count_of("SELECT COUNT(*) FROM t WHERE id = 3;"), 30);
+  EXPECT_EQ(count_of("SELECT COUNT(*) FROM t WHERE id = 42;"), 0);
+}
+
+// 单列表上的等值查询只读索引，不回表
+TEST_F(ExecutorTest, IndexOnlyScanOnSingleColumnTable) {
+  Execute("CREATE TABLE t (id INT);");
+  for (int i = 0; i < 200; ++i) {
+    Execute("INSERT INTO t VALUES (" + std::to_string(i % 50) + ");");
+  }
+  Execute("CREATE INDEX idx_id ON t(id);");
+  auto bound = Bind("SELECT * FROM t WHERE id = 7;");
+  EXPECT_TRUE(static_cast<BoundSelectStatement *>(bound.get())->IsIndexOnly());
+
+  auto rows = Query("SELECT * FROM t WHERE id = 7;");
+  ASSERT_EQ(rows.size(), 4);
+  for (const auto &row : rows) {
+    int32_t v;
+    memcpy(&v, row.Data(), sizeof(int32_t));
+    EXPECT_EQ(v, 7);
+  }
+
+  Execute("CREATE TABLE u (id INT, v INT);");
+  Execute("CREATE INDEX idx_u ON u(id);");
+  bound = Bind("SELECT * FROM u WHERE id = 7;");
+  EXPECT_FALSE(
+      static_cast<BoundSelectStatement *>(bound.get())->IsIndexOnly());
+}
+
+static int32_t IntAt(const Tuple &tuple, size_t offset) {
+  int32_t v;
+  memcpy(&v, tuple.Data() + offset, sizeof(int32_t));
+  return v;
+}
+
+// 连接的结果是左表的行接右表的行，WHERE 下推到所属的一边
+TEST_F(ExecutorTest, HashJoinTwoTables) {
+  Execute("CREATE TABLE a (id INT, v INT);");
+  Execute("CREATE TABLE b (aid INT, w INT);");
+  std::vector<std::pair<int, int>> rows;
+  for (int i = 0; i < 10; ++i) {
+    rows.push_back({i, i * 10});
+  }
+  InsertRows("a", rows);
+  rows.clear();
+  for (int i = 0; i < 30; ++i) {
+    rows.push_back({i % 15, i});
+  }
+  InsertRows("b", rows);
+
+  auto result = Query("SELECT * FROM a JOIN b ON a.id = b.aid;");
+  ASSERT_EQ(result.size(), 20);
+  for (const auto &row : result) {
+    ASSERT_EQ(row.Size(), 16);
+    EXPECT_EQ(IntAt(row, 0), IntAt(row, 8));
+    EXPECT_EQ(IntAt(row, 4), IntAt(row, 0) * 10);
+    EXPECT_EQ(IntAt(row, 12) % 15, IntAt(row, 8));
+  }
+  // 右表写在前面，输出的列顺序跟着 FROM
+  result = Query("SELECT * FROM b JOIN a ON id = aid WHERE a.id = 3;");
+  ASSERT_EQ(result.size(), 2);
+  EXPECT_EQ(IntAt(result[0], 0), 3);
+  EXPECT_EQ(IntAt(result[0], 12), 30);
+  EXPECT_EQ(Query("SELECT * FROM a JOIN b ON a.id = b.aid WHERE w = 7;").size(),
+            1);
+
+  result = Query("SELECT COUNT(*) FROM a JOIN b ON a.id = b.aid;");
+  ASSERT_EQ(result.size(), 1);
+  EXPECT_EQ(IntAt(result[0], 0), 20);
+}
+
+// build 一边超过工作内存时分区溢出到临时页，结果和全在内存里一样
+TEST_F(ExecutorTest, HashJoinSpillsOverWorkMemory) {
+  Execute("CREATE TABLE a (id INT, v INT);");
+  Execute("CREATE TABLE b (aid INT, w INT);");
+  std::vector<std::pair<int, int>> rows;
+  for (int i = 0; i < 3000; ++i) {
+    rows.push_back({i, i});
+  }
+  InsertRows("a", rows);
+  rows.clear();
+  for (int i = 0; i < 4000; ++i) {
+    // 有 1000 行连不上，0 号键重复 500 次
+    rows.push_back({i < 500 ? 0 : i, i});
+  }
+  InsertRows("b", rows);
+
+  auto join_count = [this](bool build_left) {
+    HashJoinExecutor join(*ctx_, Scan("SELECT * FROM a;"),
+                          Scan("SELECT * FROM b;"), 0, 0, build_left);
+    join.Init();
+    size_t count = 0;
+    Tuple row;
+    while (join.Next(&row)) {
+      EXPECT_EQ(IntAt(row, 0), IntAt(row, 8));
+      count++;
+    }
+    return std::make_pair(count, join.HasSpilled());
+  };
+  EXPECT_EQ(join_count(true), std::make_pair(size_t{3000}, false));
+
+  ctx_->SetWorkMemory(8 * 1024);
+  for (bool build_left : {true, false}) {
+    auto [count, spilled] = join_count(build_left);
+    EXPECT_EQ(count, 3000);
+    EXPECT_TRUE(spilled);
+  }
+  auto result = Query("SELECT COUNT(*) FROM a JOIN b ON a.id = b.aid;");
+  EXPECT_EQ(IntAt(result[0], 0), 3000);
+}
+
+// 一个键重复太多，再分区也分不开，到层数上限后在内存里做完
+TEST_F(ExecutorTest, HashJoinSkewedKeyStopsRepartitioning) {
+  Execute("CREATE TABLE a (id INT, v INT);");
+  Execute("CREATE TABLE b (aid INT, w INT);");
+  InsertRows("a", std::vector<std::pair<int, int>>(1000, {1, 0}));
+  InsertRows("b", std::vector<std::pair<int, int>>(20, {1, 0}));
+  ctx_->SetWorkMemory(8 * 1024);
+
+  HashJoinExecutor join(*ctx_, Scan("SELECT * FROM a;"),
+                        Scan("SELECT * FROM b;"), 0, 0, true);
+  join.Init();
+  size_t count = 0;
+  Tuple row;
+  while (join.Next(&row)) {
+    count++;
+  }
+  EXPECT_EQ(count, 20000);
+  EXPECT_TRUE(join.HasSpilled());
+  EXPECT_EQ(join.GetPartitionCount(),
+            (HashJoinExecutor::MAX_LEVEL + 1) * 2);
+}
+
+// 小表连有索引的大表走索引嵌套循环，结果和哈希连接一样
+TEST_F(ExecutorTest, IndexNestedLoopJoinForSmallOuter) {
+  Execute("CREATE TABLE a (id INT, v INT);");
+  Execute("CREATE TABLE b (aid INT, w INT);");
+  std::vector<std::pair<int, int>> rows;
+  for (int i = 0; i < 20; ++i) {
+    rows.push_back({i % 10 * 7, i}); // 每个键两行
+  }
+  InsertRows("a", rows);
+  rows.clear();
+  for (int i = 0; i < 20000; ++i) {
+    rows.push_back({i % 8000, i});
+    if (rows.size() == 5000) {
+      InsertRows("b", rows);
+      rows.clear();
+    }
+  }
+
+  const std::string sql = "SELECT * FROM b JOIN a ON a.id = b.aid;";
+  auto hash_result = Query(sql);
+  ASSERT_EQ(hash_result.size(), 60);
+  EXPECT_NE(dynamic_cast<HashJoinExecutor *>(Scan(sql)->GetJoin()), nullptr);
+
+  Execute("CREATE INDEX idx_aid ON b(aid);");
+  auto exec = Scan(sql);
+  auto *join = dynamic_cast<IndexNestedLoopJoinExecutor *>(exec->GetJoin());
+  ASSERT_NE(join, nullptr);
+  exec->Init();
+  std::multiset<std::vector<int>> expected, actual;
+  for (const auto &row : hash_result) {
+    expected.insert({IntAt(row, 0), IntAt(row, 4), IntAt(row, 8)});
+  }
+  Tuple row;
+  while (exec->Next(&row)) {
+    // 输出还是按 FROM 的顺序，b 在左
+    EXPECT_EQ(IntAt(row, 0), IntAt(row, 8));
+    actual.insert({IntAt(row, 0), IntAt(row, 4), IntAt(row, 8)});
+  }
+  EXPECT_EQ(actual, expected);
+  // 外表 20 行只有 10 个不同的键，每个键只查一次索引
+  EXPECT_EQ(join->GetProbeCount(), 10);
+
+  // 内表上的 WHERE 在取出行之后过滤
+  auto result = Query("SELECT * FROM a JOIN b ON a.id = b.aid WHERE w = 8007;");
+  ASSERT_EQ(result.size(), 2);
+  EXPECT_EQ(IntAt(result[0], 8), 7);
+  result = Query("SELECT COUNT(*) FROM a JOIN b ON a.id = b.aid;");
+  EXPECT_EQ(IntAt(result[0], 0), 60);
+
+  // 外表比内表的页数还多时，逐行查索引不划算，回到哈希连接
+  rows.clear();
+  for (int i = 0; i < 5000; ++i) {
+    rows.push_back({i, i});
+  }
+  InsertRows("a", rows);
+  EXPECT_NE(dynamic_cast<HashJoinExecutor *>(Scan(sql)->GetJoin()), nullptr);
+}
+
+// 2 万行连 10 万行，比较全在内存里和只有 64KB 工作内存时的耗时
+TEST_F(ExecutorTest, DISABLED_HashJoinBenchmark) {
+  Execute("CREATE TABLE a (id INT, v INT);");
+  Execute("CREATE TABLE b (aid INT, w INT);");
+  constexpr int A_ROWS = 20000;
+  constexpr int B_ROWS = 100000;
+  std::vector<std::pair<int, int>> rows;
+  for (int i = 0; i < A_ROWS; ++i) {
+    rows.push_back({i, i});
+  }
+  InsertRows("a", rows);
+  rows.clear();
+  for (int i = 0; i < B_ROWS; ++i) {
+    rows.push_back({i % A_ROWS, i});
+    if (rows.size() == 5000) {
+      InsertRows("b", rows);
+      rows.clear();
+    }
+  }
+
+  for (size_t work_memory : {size_t{4} << 20, size_t{64} << 10}) {
+    ctx_->SetWorkMemory(work_memory);
+    auto start = std::chrono::steady_clock::now();
+    auto result = Query("SELECT COUNT(*) FROM a JOIN b ON a.id = b.aid;");
+    auto end = std::chrono::steady_clock::now();
+    EXPECT_EQ(IntAt(result[0], 0), B_ROWS);
+    std::cout << "work memory " << (work_memory >> 10) << " KB: "
+              << std::chrono::duration<double, std::milli>(end - start).count()
+              << " ms\n";
+  }
+}
+
+// 200 行连 10 万行，比较索引嵌套循环连接和哈希连接的耗时
+TEST_F(ExecutorTest, DISABLED_IndexNestedLoopJoinBenchmark) {
+  Execute("CREATE TABLE a (id INT, v INT);");
+  Execute("CREATE TABLE b (aid INT, w INT);");
+  std::vector<std::pair<int, int>> rows;
+  for (int i = 0; i < 200; ++i) {
+    rows.push_back({i * 97 % 50000, i});
+  }
+  InsertRows("a", rows);
+  rows.clear();
+  for (int i = 0; i < 100000; ++i) {
+    rows.push_back({i % 50000, i});
+    if (rows.size() == 5000) {
+      InsertRows("b", rows);
+      rows.clear();
+    }
+  }
+  Execute("CREATE INDEX idx_aid ON b(aid);");
+
+  auto time_of = [this](std::unique_ptr<Executor> join) {
+    auto start = std::chrono::steady_clock::now();
+    join->Init();
+    size_t count = 0;
+    Tuple row;
+    while (join->Next(&row)) {
+      count++;
+    }
+    auto end = std::chrono::steady_clock::now();
+    EXPECT_EQ(count, 400);
+    return std::chrono::duration<double, std::milli>(end - start).count();
+  };
+  auto exec = Scan("SELECT * FROM a JOIN b ON a.id = b.aid;");
+  ASSERT_NE(dynamic_cast<IndexNestedLoopJoinExecutor *>(exec->GetJoin()),
+            nullptr);
+  double index_join = time_of(std::move(exec));
+  double hash_join = time_of(std::make_unique<HashJoinExecutor>(
+      *ctx_, Scan("SELECT * FROM a;"), Scan("SELECT * FROM b;"), 0, 0, true));
+  std::cout << "index nested loop join: " << index_join
+            << " ms, hash join: " << hash_join << " ms\n";
+}
+
+// ORDER BY 在内存里排和溢出到临时页多次归并，结果一样
+TEST_F(ExecutorTest, OrderByExternalSort) {
+  Execute("CREATE TABLE t (k INT, v INT);");
+  std::mt19937 gen(7);
+  std::vector<std::pair<int, int>> rows;
+  for (int i = 0; i < 5000; ++i) {
+    rows.push_back({static_cast<int>(gen() % 200), i});
+  }
+  InsertRows("t", rows);
+  auto expected = rows;
+  std::sort(expected.begin(), expected.end(), [](auto &a, auto &b) {
+    return a.first != b.first ? a.first > b.first : a.second < b.second;
+  });
+
+  const std::string sql = "SELECT * FROM t ORDER BY k DESC, v;";
+  for (size_t work_memory : {size_t{4} << 20, size_t{8} << 10}) {
+    ctx_->SetWorkMemory(work_memory);
+    auto exec = Scan(sql);
+    auto *sort = dynamic_cast<SortExecutor *>(exec->GetSort());
+    ASSERT_NE(sort, nullptr);
+    exec->Init();
+    std::vector<std::pair<int, int>> actual;
+    Tuple row;
+    while (exec->Next(&row)) {
+      actual.push_back({IntAt(row, 0), IntAt(row, 4)});
+    }
+    EXPECT_EQ(actual, expected);
+    if (work_memory > (size_t{1} << 20)) {
+      EXPECT_EQ(sort->GetRunCount(), 0);
+    } else {
+      // 8KB 只能两段两段地归并
+      EXPECT_GT(sort->GetRunCount(), 2);
+      EXPECT_EQ(sort->GetMergeCount(), sort->GetRunCount() - 2);
+    }
+  }
+}
+
+// VARCHAR 按字节排序，前 8 个字节相同时比较整列
+TEST_F(ExecutorTest, OrderByVarchar) {
+  Execute("CREATE TABLE t (name VARCHAR(12), id INT);");
+  Execute("INSERT INTO t VALUES ('prefix12b', 1), ('b', 2), "
+          "('prefix12a', 3), ('prefix1', 4), ('a', 5);");
+  std::vector<int> ids;
+  for (const auto &row : Query("SELECT * FROM t ORDER BY name;")) {
+    ids.push_back(IntAt(row, 12));
+  }
+  EXPECT_EQ(ids, (std::vector<int>{5, 2, 4, 3, 1}));
+  ids.clear();
+  for (const auto &row : Query("SELECT * FROM t ORDER BY name DESC;")) {
+    ids.push_back(IntAt(row, 12));
+  }
+  EXPECT_EQ(ids, (std::vector<int>{1, 3, 4, 2, 5}));
+}
+
+// ORDER BY 连接列时走排序归并连接，不用再排；按别的列排序时在连接之后排
+TEST_F(ExecutorTest, SortMergeJoinForOrderByJoinColumn) {
+  Execute("CREATE TABLE a (id INT, v INT);");
+  Execute("CREATE TABLE b (aid INT, w INT);");
+  std::vector<std::pair<int, int>> rows;
+  for (int i = 0; i < 2000; ++i) {
+    rows.push_back({(i * 37) % 500, i}); // 每个键 4 行
+  }
+  InsertRows("a", rows);
+  rows.clear();
+  for (int i = 0; i < 3000; ++i) {
+    rows.push_back({(i * 53) % 1000, i}); // 一半的键连不上
+  }
+  InsertRows("b", rows);
+  ctx_->SetWorkMemory(16 * 1024);
+
+  auto exec = Scan("SELECT * FROM a JOIN b ON a.id = b.aid ORDER BY b.aid;");
+  ASSERT_NE(dynamic_cast<SortMergeJoinExecutor *>(exec->GetJoin()), nullptr);
+  EXPECT_EQ(exec->GetSort(), nullptr);
+  exec->Init();
+  size_t count = 0;
+  int last = INT32_MIN;
+  Tuple row;
+  while (exec->Next(&row)) {
+    EXPECT_EQ(IntAt(row, 0), IntAt(row, 8));
+    EXPECT_GE(IntAt(row, 0), last);
+    last = IntAt(row, 0);
+    count++;
+  }
+  // 500 个键各 4 行连 3 行
+  EXPECT_EQ(count, 6000);
+  auto result = Query("SELECT COUNT(*) FROM a JOIN b ON a.id = b.aid;");
+  EXPECT_EQ(IntAt(result[0], 0), 6000);
+
+  exec = Scan("SELECT * FROM a JOIN b ON a.id = b.aid ORDER BY w DESC;");
+  EXPECT_NE(dynamic_cast<HashJoinExecutor *>(exec->GetJoin()), nullptr);
+  ASSERT_NE(exec->GetSort(), nullptr);
+  exec->Init();
+  count = 0;
+  last = INT32_MAX;
+  while (exec->Next(&row)) {
+    EXPECT_LE(IntAt(row, 12), last);
+    last = IntAt(row, 12);
+    count++;
+  }
+  EXPECT_EQ(count, 6000);
+}
+
+// GROUP BY 的结果和直接算的一样；工作内存很小时部分结果溢出到分区，
+// 读回来再合并，结果不变
+TEST_F(ExecutorTest, HashAggregateGroupBy) {
+  Execute("CREATE TABLE t (k INT, v INT);");
+  std::mt19937 gen(11);
+  std::vector<std::pair<int, int>> rows;
+  struct Expected {
+    int count = 0, sum = 0, min = INT32_MAX, max = 0;
+  };
+  std::map<int, Expected> expected;
+  for (int i = 0; i < 5000; ++i) {
+    int k = static_cast<int>(gen() % 300), v = static_cast<int>(gen() % 1000);
+    rows.push_back({k, v});
+    Expected &e = expected[k];
+    e.count++;
+    e.sum += v;
+    e.min = std::min(e.min, v);
+    e.max = std::max(e.max, v);
+  }
+  InsertRows("t", rows);
+
+  const std::string sql = "SELECT COUNT(*), k, SUM(v), MIN(v), MAX(v), "
+                          "AVG(v) FROM t GROUP BY k;";
+  for (size_t work_memory : {size_t{4} << 20, size_t{8} << 10}) {
+    ctx_->SetWorkMemory(work_memory);
+    auto exec = Scan(sql);
+    ASSERT_NE(exec->GetAggregate(), nullptr);
+    exec->Init();
+    std::map<int, Expected> actual;
+    Tuple row;
+    while (exec->Next(&row)) {
+      int k = IntAt(row, 4);
+      EXPECT_EQ(actual.count(k), 0) << k;
+      actual[k] = {IntAt(row, 0), IntAt(row, 8), IntAt(row, 12),
+                   IntAt(row, 16)};
+      EXPECT_EQ(IntAt(row, 20), IntAt(row, 8) / IntAt(row, 0));
+    }
+    ASSERT_EQ(actual.size(), expected.size());
+    for (const auto &[k, e] : expected) {
+      EXPECT_EQ(actual[k].count, e.count) << k;
+      EXPECT_EQ(actual[k].sum, e.sum) << k;
+      EXPECT_EQ(actual[k].min, e.min) << k;
+      EXPECT_EQ(actual[k].max, e.max) << k;
+    }
+    bool small = work_memory < (size_t{1} << 20);
+    EXPECT_EQ(exec->GetAggregate()->HasSpilled(), small);
+    if (small) {
+      EXPECT_GT(exec->GetAggregate()->GetPartitionCount(), 2);
+    }
+  }
+}
+
+// 没有 GROUP BY 时整张表一组，空表也输出一行；VARCHAR 的 MIN / MAX
+// 按字节比较；可以按聚合的结果排序
+TEST_F(ExecutorTest, AggregateWithoutGroupByAndOrderBy) {
+  Execute("CREATE TABLE t (name VARCHAR(8), v INT);");
+  auto rows = Query("SELECT COUNT(v), SUM(v), MAX(name) FROM t;");
+  ASSERT_EQ(rows.size(), 1);
+  EXPECT_EQ(IntAt(rows[0], 0), 0);
+  EXPECT_EQ(IntAt(rows[0], 4), 0);
+  EXPECT_TRUE(Query("SELECT name, SUM(v) FROM t GROUP BY name;").empty());
+
+  Execute("INSERT INTO t VALUES ('b', 1), ('ab', 7), ('b', 5), ('c', 2), "
+          "('ab', 1), ('abc', 3);");
+  rows = Query("SELECT MIN(name), MAX(name), SUM(v), AVG(v) FROM t;");
+  ASSERT_EQ(rows.size(), 1);
+  EXPECT_EQ(std::string(rows[0].Data()), "ab");
+  EXPECT_EQ(std::string(rows[0].Data() + 8), "c");
+  EXPECT_EQ(IntAt(rows[0], 16), 19);
+  EXPECT_EQ(IntAt(rows[0], 20), 3);
+
+  std::vector<std::pair<std::string, int>> groups;
+  for (const auto &row : Query("SELECT name, SUM(v) FROM t GROUP BY name "
+                               "ORDER BY SUM(v) DESC, name;")) {
+    groups.push_back({std::string(row.Data()), IntAt(row, 8)});
+  }
+  EXPECT_EQ(groups, (std::vector<std::pair<std::string, int>>{
+                        {"ab", 8}, {"b", 6}, {"abc", 3}, {"c", 2}}));
+
+  // 和超出 INT 的范围时报错
+  Execute("INSERT INTO t VALUES ('x', 2000000000), ('x', 2000000000);");
+  EXPECT_THROW(Query("SELECT SUM(v) FROM t;"), std::runtime_error);
+}
+
+// 20 万行、5 万组聚合，比较全在内存里和只有 256KB 工作内存时的耗时
+TEST_F(ExecutorTest, DISABLED_HashAggregateBenchmark) {
+  Execute("CREATE TABLE t (k INT, v INT);");
+  constexpr int ROWS = 200000;
+  std::mt19937 gen(7);
+  std::vector<std::pair<int, int>> rows;
+  for (int i = 0; i < ROWS; ++i) {
+    rows.push_back({(i * 7919) % 50000, static_cast<int>(gen() % 1000)});
+    if (rows.size() == 5000) {
+      InsertRows("t", rows);
+      rows.clear();
+    }
+  }
+
+  for (size_t work_memory : {size_t{16} << 20, size_t{256} << 10}) {
+    ctx_->SetWorkMemory(work_memory);
+    auto exec = Scan("SELECT k, COUNT(*), SUM(v) FROM t GROUP BY k;");
+    auto start = std::chrono::steady_clock::now();
+    exec->Init();
+    size_t count = 0;
+    Tuple row;
+    while (exec->Next(&row)) {
+      count++;
+    }
+    auto end = std::chrono::steady_clock::now();
+    EXPECT_EQ(count, 50000);
+    std::cout << "work memory " << (work_memory >> 10) << " KB: "
+              << std::chrono::duration<double, std::milli>(end - start).count()
+              << " ms, " << exec->GetAggregate()->GetPartitionCount()
+              << " partitions\n";
+  }
+}
+
+// 只输出 SELECT 列表里的列；WHERE、ORDER BY 用到的列扫描时取出来，
+// 输出前去掉。走索引、只读索引和连接时也一样
+TEST_F(ExecutorTest, ProjectionOutputsSelectedColumns) {
+  Execute("CREATE TABLE t (id INT, name VARCHAR(8), pad VARCHAR(100), "
+          "v INT);");
+  Execute("INSERT INTO t VALUES (1, 'one', 'x', 30), (2, 'two', 'y', 10), "
+          "(3, 'three', 'z', 20), (3, 'tri', 'w', 40);");
+
+  auto rows = Query("SELECT v, name FROM t WHERE id = 3;");
+  ASSERT_EQ(rows.size(), 2);
+  EXPECT_EQ(rows[0].Size(), 12);
+  EXPECT_EQ(IntAt(rows[0], 0), 20);
+  EXPECT_EQ(std::string(rows[0].Data() + 4), "three");
+
+  auto exec = Scan("SELECT name FROM t ORDER BY v DESC LIMIT 3;");
+  EXPECT_EQ(exec->GetSchema()->GetTupleLength(), 8);
+  exec->Init();
+  std::vector<std::string> names;
+  Tuple row;
+  while (exec->Next(&row)) {
+    EXPECT_EQ(row.Size(), 8);
+    names.push_back(row.Data());
+  }
+  EXPECT_EQ(names, (std::vector<std::string>{"tri", "one", "three"}));
+
+  Execute("CREATE INDEX idx_id ON t(id);");
+  rows = Query("SELECT id, v FROM t WHERE id = 1;");
+  ASSERT_EQ(rows.size(), 1);
+  EXPECT_EQ(rows[0].Size(), 8);
+  EXPECT_EQ(IntAt(rows[0], 4), 30);
+
+  Execute("CREATE TABLE s (k INT);");
+  Execute("CREATE INDEX idx_k ON s(k);");
+  Execute("INSERT INTO s VALUES (3), (4);");
+  rows = Query("SELECT k, k FROM s WHERE k = 4;");
+  ASSERT_EQ(rows.size(), 1);
+  ASSERT_EQ(rows[0].Size(), 8);
+  EXPECT_EQ(IntAt(rows[0], 4), 4);
+
+  rows = Query("SELECT t.name, s.k FROM t JOIN s ON t.id = s.k;");
+  ASSERT_EQ(rows.size(), 2);
+  for (const auto &r : rows) {
+    EXPECT_EQ(r.Size(), 12);
+    EXPECT_EQ(IntAt(r, 8), 3);
+  }
+}
+
+// 只取索引键这一列时是覆盖查询，值直接用 WHERE 里的键，不读整行
+TEST_F(ExecutorTest, IndexOnlyScanOnCoveredColumn) {
+  Execute("CREATE TABLE t (id INT, v INT);");
+  for (int i = 0; i < 200; ++i) {
+    Execute("INSERT INTO t VALUES (" + std::to_string(i % 50) + ", " +
+            std::to_string(i) + ");");
+  }
+  Execute("CREATE INDEX idx_id ON t(id);");
+  auto bound = Bind("SELECT id FROM t WHERE id = 7;");
+  EXPECT_TRUE(static_cast<BoundSelectStatement *>(bound.get())->IsIndexOnly());
+  // 要取别的列时还得回表
+  bound = Bind("SELECT v FROM t WHERE id = 7;");
+  EXPECT_FALSE(static_cast<BoundSelectStatement *>(bound.get())->IsIndexOnly());
+  bound = Bind("SELECT id, v FROM t WHERE id = 7;");
+  EXPECT_FALSE(static_cast<BoundSelectStatement *>(bound.get())->IsIndexOnly());
+
+  auto rows = Query("SELECT id FROM t WHERE id = 7;");
+  ASSERT_EQ(rows.size(), 4);
+  for (const auto &row : rows) {
+    EXPECT_EQ(row.Size(), 4);
+    EXPECT_EQ(IntAt(row, 0), 7);
+  }
+  EXPECT_EQ(Query("SELECT v FROM t WHERE id = 7;").size(), 4);
+}
+
+// 宽表按一列排序，只取两列时排序搬动的数据少得多
+TEST_F(ExecutorTest, DISABLED_ProjectionBenchmark) {
+  Execute("CREATE TABLE t (id INT, v INT, a VARCHAR(200), b VARCHAR(200), "
+          "c VARCHAR(200));");
+  constexpr int ROWS = 50000;
+  std::mt19937 gen(7);
+  std::string sql;
+  for (int i = 0; i < ROWS; ++i) {
+    sql += (sql.empty() ? "INSERT INTO t VALUES (" : ", (") +
+           std::to_string(i) + ", " + std::to_string(gen() % 1000000) +
+           ", 'a', 'b', 'c')";
+    if ((i + 1) % 2000 == 0) {
+      Execute(sql + ";");
+      sql.clear();
+    }
+  }
+
+  for (const char *query : {"SELECT * FROM t ORDER BY v;",
+                            "SELECT id, v FROM t ORDER BY v;"}) {
+    auto exec = Scan(query);
+    auto start = std::chrono::steady_clock::now();
+    exec->Init();
+    size_t count = 0;
+    Tuple row;
+    while (exec->Next(&row)) {
+      count++;
+    }
+    auto end = std::chrono::steady_clock::now();
+    EXPECT_EQ(count, ROWS);
+    std::cout << query << " "
+              << std::chrono::duration<double, std::milli>(end - start).count()
+              << " ms, " << exec->GetSort()->GetRunCount() << " runs\n";
+  }
+}
+
+// 没有排序时 LIMIT 够了就停止扫描，后面的页不再读
+TEST_F(ExecutorTest, LimitStopsScan) {
+  Execute("CREATE TABLE t (k INT, v INT);");
+  std::vector<std::pair<int, int>> rows;
+  for (int i = 0; i < 5000; ++i) {
+    rows.push_back({i, i * 2});
+  }
+  InsertRows("t", rows);
+
+  size_t before = bp_->GetFetchCount();
+  EXPECT_EQ(Query("SELECT * FROM t;").size(), 5000);
+  size_t full = bp_->GetFetchCount() - before;
+
+  before = bp_->GetFetchCount();
+  auto result = Query("SELECT * FROM t LIMIT 10 OFFSET 20;");
+  size_t limited = bp_->GetFetchCount() - before;
+  ASSERT_EQ(result.size(), 10);
+  for (size_t i = 0; i < result.size(); ++i) {
+    EXPECT_EQ(IntAt(result[i], 0), 20 + static_cast<int>(i));
+  }
+  EXPECT_LT(limited * 50, full);
+
+  EXPECT_TRUE(Query("SELECT * FROM t LIMIT 0;").empty());
+  EXPECT_TRUE(Query("SELECT * FROM t LIMIT 10 OFFSET 5000;").empty());
+  EXPECT_EQ(Query("SELECT * FROM t WHERE k = 7 LIMIT 5;").size(), 1);
+}
+
+// ORDER BY ... LIMIT 只留前面的行，和整个排好序再截取的结果一样；
+// 要留的行放不进工作内存时还是整个排序
+TEST_F(ExecutorTest, TopNForOrderByLimit) {
+  Execute("CREATE TABLE t (k INT, v INT);");
+  std::mt19937 gen(5);
+  std::vector<std::pair<int, int>> rows;
+  for (int i = 0; i < 20000; ++i) {
+    rows.push_back({static_cast<int>(gen() % 1000), i});
+    if (rows.size() == 5000) {
+      InsertRows("t", rows);
+      rows.clear();
+    }
+  }
+  std::vector<std::pair<int, int>> expected;
+  for (const auto &row : Query("SELECT * FROM t ORDER BY k DESC, v;")) {
+    expected.push_back({IntAt(row, 0), IntAt(row, 4)});
+  }
+  ASSERT_EQ(expected.size(), 20000);
+
+  auto run = [this](const std::string &sql) {
+    auto exec = Scan(sql);
+    exec->Init();
+    std::vector<std::pair<int, int>> actual;
+    Tuple row;
+    while (exec->Next(&row)) {
+      actual.push_back({IntAt(row, 0), IntAt(row, 4)});
+    }
+    return std::make_pair(std::move(exec), actual);
+  };
+  const std::string sql = "SELECT * FROM t ORDER BY k DESC, v LIMIT ";
+  auto [top_n, top_rows] = run(sql + "100 OFFSET 10;");
+  EXPECT_NE(top_n->GetTopN(), nullptr);
+  EXPECT_EQ(top_n->GetSort(), nullptr);
+  EXPECT_TRUE(std::equal(top_rows.begin(), top_rows.end(),
+                         expected.begin() + 10, expected.begin() + 110));
+
+  // 8KB 只放得下 1000 行
+  ctx_->SetWorkMemory(size_t{8} << 10);
+  auto [sort, sort_rows] = run(sql + "3000;");
+  EXPECT_EQ(sort->GetTopN(), nullptr);
+  EXPECT_NE(sort->GetSort(), nullptr);
+  EXPECT_TRUE(std::equal(sort_rows.begin(), sort_rows.end(),
+                         expected.begin(), expected.begin() + 3000));
+
+  auto [empty, empty_rows] = run(sql + "0;");
+  EXPECT_TRUE(empty_rows.empty());
+}
+
+// 20 万行取最大的 100 行，比较 Top-N 和整个排序的耗时
+TEST_F(ExecutorTest, DISABLED_TopNBenchmark) {
+  Execute("CREATE TABLE t (k INT, v INT);");
+  constexpr int ROWS = 200000;
+  std::mt19937 gen(7);
+  std::vector<std::pair<int, int>> rows;
+  for (int i = 0; i < ROWS; ++i) {
+    rows.push_back({static_cast<int>(gen() % 1000000000), i});
+    if (rows.size() == 5000) {
+      InsertRows("t", rows);
+      rows.clear();
+    }
+  }
+
+  // 第二条没有 LIMIT，整个排序后只读前 100 行
+  for (const char *sql : {"SELECT * FROM t ORDER BY k DESC LIMIT 100;",
+                          "SELECT * FROM t ORDER BY k DESC;"}) {
+    auto exec = Scan(sql);
+    auto start = std::chrono::steady_clock::now();
+    exec->Init();
+    Tuple row;
+    for (int i = 0; i < 100; ++i) {
+      ASSERT_TRUE(exec->Next(&row));
+    }
+    auto end = std::chrono::steady_clock::now();
+    std::cout << (exec->GetTopN() != nullptr ? "top-n: " : "sort: ")
+              << std::chrono::duration<double, std::milli>(end - start).count()
+              << " ms\n";
+  }
+}
+
+// 20 万行排序，比较全在内存里和只有 256KB 工作内存时的耗时
+TEST_F(ExecutorTest, DISABLED_SortBenchmark) {
+  Execute("CREATE TABLE t (k INT, v INT);");
+  constexpr int ROWS = 200000;
+  std::mt19937 gen(7);
+  std::vector<std::pair<int, int>> rows;
+  for (int i = 0; i < ROWS; ++i) {
+    rows.push_back({static_cast<int>(gen() % 1000000000), i});
+    if (rows.size() == 5000) {
+      InsertRows("t", rows);
+      rows.clear();
+    }
+  }
+
+  for (size_t work_memory : {size_t{16} << 20, size_t{256} << 10}) {
+    ctx_->SetWorkMemory(work_memory);
+    auto exec = Scan("SELECT * FROM t ORDER BY k;");
+    auto start = std::chrono::steady_clock::now();
+    exec->Init();
+    size_t count = 0;
+    Tuple row;
+    while (exec->Next(&row)) {
+      count++;
+    }
+    auto end = std::chrono::steady_clock::now();
+    EXPECT_EQ(count, ROWS);
+    auto *sort = static_cast<SortExecutor *>(exec->GetSort());
+    std::cout << "work memory " << (work_memory >> 10) << " KB: "
+              << std::chrono::duration<double, std::milli>(end - start).count()
+              << " ms, " << sort->GetRunCount() << " runs\n";
+  }
+}
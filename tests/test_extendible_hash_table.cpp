@@ -0,0 +1,233 @@
+#include "common/comparator.h"
+#include "index/bplus_tree.h"
+#include "index/extendible_hash_table.h"
+#include "storage/buffer_pool.h"
+#include "storage/disk_manager.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <gtest/gtest.h>
+#include <iostream>
+#include <random>
+
+using namespace mini;
+
+class ExtendibleHashTableTest : public ::testing::Test {
+protected:
+  std::filesystem::path db_file_{"test_hash_table.db"};
+  std::unique_ptr<DiskManager> dm_;
+  std::unique_ptr<BufferPool> bp_;
+
+  void SetUp() override {
+    std::filesystem::remove(db_file_);
+    dm_ = std::make_unique<DiskManager>(db_file_.string());
+    bp_ = std::make_unique<BufferPool>(100, dm_.get());
+  }
+
+  void TearDown() override {
+    bp_.reset();
+    dm_.reset();
+    std::filesystem::remove(db_file_);
+  }
+};
+
+// 少量数据，不分裂
+TEST_F(ExtendibleHashTableTest, BasicInsert) {
+  ExtendibleHashTable<int32_t, RID, IntComparator> table(bp_.get());
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_TRUE(table.Insert(i, RID{i, static_cast<uint16_t>(i)}));
+  }
+  EXPECT_EQ(table.GetGlobalDepth(), 0);
+  for (int i = 0; i < 100; ++i) {
+    std::vector<RID> values;
+    EXPECT_TRUE(table.GetValue(i, &values));
+    ASSERT_EQ(values.size(), 1);
+    EXPECT_EQ(values[0].page_id, i);
+  }
+  std::vector<RID> values;
+  EXPECT_FALSE(table.GetValue(100, &values));
+}
+
+// 随机数据，多次分裂，目录翻倍
+TEST_F(ExtendibleHashTableTest, InsertWithSplit) {
+  ExtendibleHashTable<int32_t, RID, IntComparator> table(bp_.get());
+  std::vector<int> keys(20000);
+  for (int i = 0; i < 20000; ++i) {
+    keys[i] = i;
+  }
+  std::mt19937 gen(42);
+  std::shuffle(keys.begin(), keys.end(), gen);
+  for (int key : keys) {
+    EXPECT_TRUE(table.Insert(key, RID{key, static_cast<uint16_t>(key)}));
+  }
+  EXPECT_GT(table.GetGlobalDepth(), 0);
+  for (int key : keys) {
+    std::vector<RID> values;
+    EXPECT_TRUE(table.GetValue(key, &values));
+    ASSERT_EQ(values.size(), 1);
+    EXPECT_EQ(values[0].page_id, key);
+  }
+}
+
+// 重复 key 和删除
+TEST_F(ExtendibleHashTableTest, DuplicateAndRemove) {
+  ExtendibleHashTable<int32_t, RID, IntComparator> table(bp_.get());
+  for (int i = 0; i < 3000; ++i) {
+    EXPECT_TRUE(table.Insert(i % 1000, RID{i, 0}));
+  }
+  std::vector<RID> values;
+  EXPECT_TRUE(table.GetValue(7, &values));
+  EXPECT_EQ(values.size(), 3);
+
+  EXPECT_TRUE(table.Remove(7, RID{1007, 0}));
+  EXPECT_FALSE(table.Remove(7, RID{1007, 0}));
+  values.clear();
+  EXPECT_TRUE(table.GetValue(7, &values));
+  EXPECT_EQ(values.size(), 2);
+}
+
+// 唯一表拒绝重复 key
+TEST_F(ExtendibleHashTableTest, UniqueInsertRejectsDuplicate) {
+  ExtendibleHashTable<int32_t, RID, IntComparator> table(bp_.get(), true);
+  for (int i = 0; i < 2000; ++i) {
+    EXPECT_TRUE(table.Insert(i, RID{i, 0}));
+  }
+  for (int i = 0; i < 2000; ++i) {
+    EXPECT_FALSE(table.Insert(i, RID{i + 1, 0}));
+  }
+  std::vector<RID> values;
+  EXPECT_TRUE(table.GetValue(5, &values));
+  ASSERT_EQ(values.size(), 1);
+  EXPECT_EQ(values[0].page_id, 5);
+}
+
+// 同一个 key 的重复项超过一页，桶后面接溢出页，其他 key 照常分裂
+TEST_F(ExtendibleHashTableTest, ManyDuplicatesOfOneKey) {
+  ExtendibleHashTable<int32_t, RID, IntComparator> table(bp_.get());
+  for (int i = 0; i < 5000; ++i) {
+    EXPECT_TRUE(table.Insert(7, RID{i, 0}));
+    EXPECT_TRUE(table.Insert(i + 100, RID{i, 1}));
+  }
+  std::vector<RID> values;
+  EXPECT_TRUE(table.GetValue(7, &values));
+  ASSERT_EQ(values.size(), 5000);
+  std::sort(values.begin(), values.end(),
+            [](const RID &a, const RID &b) { return a.page_id < b.page_id; });
+  for (int i = 0; i < 5000; ++i) {
+    EXPECT_EQ(values[i].page_id, i);
+  }
+  for (int i = 0; i < 5000; ++i) {
+    values.clear();
+    EXPECT_TRUE(table.GetValue(i + 100, &values));
+    ASSERT_EQ(values.size(), 1);
+    EXPECT_EQ(values[0].page_id, i);
+  }
+
+  for (int i = 0; i < 5000; i += 2) {
+    EXPECT_TRUE(table.Remove(7, RID{i, 0}));
+  }
+  values.clear();
+  EXPECT_TRUE(table.GetValue(7, &values));
+  EXPECT_EQ(values.size(), 2500);
+}
+
+// 一个 key 的重复项先占满了一条溢出链，之后的不同 key 落到这个桶时
+// 连同整条链一起分裂：目录照常变深，点查不用沿着长链走
+TEST_F(ExtendibleHashTableTest, DuplicatesThenDistinctKeys) {
+  ExtendibleHashTable<int32_t, RID, IntComparator> table(bp_.get(), false,
+                                                         nullptr, 8);
+  for (int i = 0; i < 200; ++i) {
+    ASSERT_TRUE(table.Insert(7, RID{i, 0}));
+  }
+  EXPECT_EQ(table.GetGlobalDepth(), 0);
+  constexpr int N = 5000;
+  for (int i = 0; i < N; ++i) {
+    ASSERT_TRUE(table.Insert(i + 100, RID{i, 1}));
+  }
+  EXPECT_GE(table.GetGlobalDepth(), 10);
+
+  size_t max_fetch = 0;
+  for (int i = 0; i < N; ++i) {
+    std::vector<RID> values;
+    size_t before = bp_->GetFetchCount();
+    ASSERT_TRUE(table.GetValue(i + 100, &values));
+    max_fetch = std::max(max_fetch, bp_->GetFetchCount() - before);
+    ASSERT_EQ(values.size(), 1);
+    EXPECT_EQ(values[0].page_id, i);
+  }
+  // 一个目录页加一个桶页，不会落进 7 的溢出链
+  EXPECT_EQ(max_fetch, 2);
+  std::vector<RID> values;
+  EXPECT_TRUE(table.GetValue(7, &values));
+  EXPECT_EQ(values.size(), 200);
+}
+
+// 目录超过一页：global depth 大于一个目录页能放下的深度，
+// 从头页重新打开后也能找到所有的 key
+TEST_F(ExtendibleHashTableTest, MoreThanOneDirectoryPage) {
+  constexpr int N = 250000;
+  ExtendibleHashTable<int32_t, RID, IntComparator> table(bp_.get(), true);
+  for (int i = 0; i < N; ++i) {
+    ASSERT_TRUE(table.Insert(i, RID{i, 0}));
+  }
+  EXPECT_GT(table.GetGlobalDepth(),
+            HashTableDirectoryPage::DIRECTORY_PAGE_DEPTH);
+  EXPECT_FALSE(table.Insert(N / 2, RID{0, 0}));
+
+  ExtendibleHashTable<int32_t, RID, IntComparator> reopened(
+      bp_.get(), table.GetHeaderPageId());
+  EXPECT_TRUE(reopened.IsUnique());
+  EXPECT_EQ(reopened.GetGlobalDepth(), table.GetGlobalDepth());
+  for (int i = 0; i < N; ++i) {
+    std::vector<RID> values;
+    ASSERT_TRUE(reopened.GetValue(i, &values)) << i;
+    ASSERT_EQ(values.size(), 1);
+    EXPECT_EQ(values[0].page_id, i);
+  }
+  std::vector<RID> values;
+  EXPECT_FALSE(reopened.GetValue(N, &values));
+}
+
+// 点查性能对比，手动运行：
+// --gtest_also_run_disabled_tests
+// --gtest_filter=ExtendibleHashTableTest.DISABLED_PointLookupBenchmark
+TEST_F(ExtendibleHashTableTest, DISABLED_PointLookupBenchmark) {
+  constexpr int N = 100000;
+  // 足够大的池子，比较的是查找路径本身而不是磁盘
+  bp_ = std::make_unique<BufferPool>(4000, dm_.get());
+  std::vector<int> keys(N);
+  for (int i = 0; i < N; ++i) {
+    keys[i] = i;
+  }
+  std::mt19937 gen(42);
+  std::shuffle(keys.begin(), keys.end(), gen);
+
+  ExtendibleHashTable<int32_t, RID, IntComparator> hash_table(bp_.get());
+  BPlusTree<int32_t, RID, IntComparator> tree(bp_.get());
+  for (int key : keys) {
+    hash_table.Insert(key, RID{key, 0});
+    tree.Insert(key, RID{key, 0});
+  }
+  bp_->FlushAllPages();
+  std::shuffle(keys.begin(), keys.end(), gen);
+
+  auto run = [&keys](const char *name, auto &&lookup) {
+    auto start = std::chrono::steady_clock::now();
+    size_t found = 0;
+    for (int key : keys) {
+      std::vector<RID> values;
+      found += lookup(key, &values);
+    }
+    auto end = std::chrono::steady_clock::now();
+    double ms = std::chrono::duration<double, std::milli>(end - start).count();
+    std::cout << name << ": " << keys.size() << " lookups, " << ms << " ms, "
+              << ms * 1e6 / keys.size() << " ns/lookup" << std::endl;
+    EXPECT_EQ(found, keys.size());
+  };
+  run("extendible hash", [&hash_table](int key, std::vector<RID> *values) {
+    return hash_table.GetValue(key, values);
+  });
+  run("b+tree", [&tree](int key, std::vector<RID> *values) {
+    return tree.GetValue(key, values);
+  });
+}
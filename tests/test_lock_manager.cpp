@@ -0,0 +1,269 @@
+#include "concurrency/lock_manager.h"
+#include "concurrency/transaction.h"
+#include <atomic>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace mini;
+
+namespace {
+
+constexpr int32_t TABLE = 1;
+
+// 等到 fn 返回 true，最多等一秒
+template <typename Fn> bool WaitFor(Fn fn) {
+  for (int i = 0; i < 1000 && !fn(); ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return fn();
+}
+
+} // namespace
+
+TEST(LockManagerTest, CompatibilityMatrix) {
+  using M = LockMode;
+  EXPECT_TRUE(LockManager::Compatible(M::INTENTION_SHARED,
+                                      M::SHARED_INTENTION_EXCLUSIVE));
+  EXPECT_TRUE(LockManager::Compatible(M::INTENTION_EXCLUSIVE,
+                                      M::INTENTION_EXCLUSIVE));
+  EXPECT_FALSE(LockManager::Compatible(M::INTENTION_EXCLUSIVE, M::SHARED));
+  EXPECT_TRUE(LockManager::Compatible(M::SHARED, M::SHARED));
+  EXPECT_FALSE(LockManager::Compatible(M::SHARED_INTENTION_EXCLUSIVE,
+                                       M::INTENTION_EXCLUSIVE));
+  EXPECT_FALSE(LockManager::Compatible(M::EXCLUSIVE, M::INTENTION_SHARED));
+  EXPECT_EQ(LockManager::Combine(M::SHARED, M::INTENTION_EXCLUSIVE),
+            M::SHARED_INTENTION_EXCLUSIVE);
+  EXPECT_EQ(LockManager::Combine(M::INTENTION_SHARED, M::SHARED), M::SHARED);
+  EXPECT_EQ(LockManager::Combine(M::SHARED, M::EXCLUSIVE), M::EXCLUSIVE);
+}
+
+// 行上的 X 挡住别的事务的 S，持有者放锁后等待者拿到锁，等待计入统计
+TEST(LockManagerTest, ExclusiveRowLockBlocksUntilRelease) {
+  LockManager lock_manager(std::chrono::milliseconds(0));
+  Transaction writer(0), reader(1);
+  RID rid{3, 7};
+  lock_manager.LockTable(&writer, LockMode::INTENTION_EXCLUSIVE, TABLE);
+  lock_manager.LockRow(&writer, LockMode::EXCLUSIVE, TABLE, rid);
+  // 意向锁互相兼容
+  lock_manager.LockTable(&reader, LockMode::INTENTION_SHARED, TABLE);
+
+  std::atomic<bool> granted{false};
+  std::thread waiter([&] {
+    lock_manager.LockRow(&reader, LockMode::SHARED, TABLE, rid);
+    granted = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_FALSE(granted);
+  lock_manager.ReleaseAll(&writer);
+  waiter.join();
+  EXPECT_TRUE(granted);
+  EXPECT_EQ(reader.GetRowLocks().at(rid), LockMode::SHARED);
+  EXPECT_TRUE(writer.GetRowLocks().empty());
+  EXPECT_TRUE(writer.GetTableLocks().empty());
+
+  LockStats stats = lock_manager.GetStats();
+  EXPECT_EQ(stats.requests, 4);
+  EXPECT_EQ(stats.waits, 1);
+  EXPECT_GT(stats.wait_millis, 10.0);
+  EXPECT_EQ(stats.max_wait_millis, stats.wait_millis);
+  lock_manager.ReleaseAll(&reader);
+}
+
+// X 放掉之后排在后面的两个 S 都要拿到锁
+TEST(LockManagerTest, ReleaseWakesAllCompatibleWaiters) {
+  LockManager lock_manager(std::chrono::milliseconds(0));
+  Transaction writer(0), r1(1), r2(2);
+  RID rid{2, 5};
+  for (Transaction *txn : {&writer, &r1, &r2}) {
+    lock_manager.LockTable(txn, LockMode::INTENTION_EXCLUSIVE, TABLE);
+  }
+  lock_manager.LockRow(&writer, LockMode::EXCLUSIVE, TABLE, rid);
+  std::vector<std::thread> readers;
+  for (Transaction *txn : {&r1, &r2}) {
+    readers.emplace_back(
+        [&, txn] { lock_manager.LockRow(txn, LockMode::SHARED, TABLE, rid); });
+  }
+  ASSERT_TRUE(WaitFor([&] { return lock_manager.GetStats().requests == 6; }));
+  lock_manager.ReleaseAll(&writer);
+  for (auto &reader : readers) {
+    reader.join();
+  }
+  EXPECT_EQ(r1.GetRowLocks().at(rid), LockMode::SHARED);
+  EXPECT_EQ(r2.GetRowLocks().at(rid), LockMode::SHARED);
+  lock_manager.ReleaseAll(&r1);
+  lock_manager.ReleaseAll(&r2);
+}
+
+// 表上的 S 要等所有 IX 放掉，已经持有的锁再请求不会排队
+TEST(LockManagerTest, SharedTableLockWaitsForIntentionExclusive) {
+  LockManager lock_manager(std::chrono::milliseconds(0));
+  Transaction a(0), b(1), scanner(2);
+  lock_manager.LockTable(&a, LockMode::INTENTION_EXCLUSIVE, TABLE);
+  lock_manager.LockTable(&b, LockMode::INTENTION_EXCLUSIVE, TABLE);
+  lock_manager.LockTable(&a, LockMode::INTENTION_SHARED, TABLE);
+  EXPECT_EQ(a.GetTableLocks().at(TABLE), LockMode::INTENTION_EXCLUSIVE);
+
+  std::atomic<bool> granted{false};
+  std::thread waiter([&] {
+    lock_manager.LockTable(&scanner, LockMode::SHARED, TABLE);
+    granted = true;
+  });
+  lock_manager.ReleaseAll(&a);
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_FALSE(granted);
+  lock_manager.ReleaseAll(&b);
+  waiter.join();
+  EXPECT_TRUE(granted);
+  lock_manager.ReleaseAll(&scanner);
+}
+
+// S 升级到 X 要等别的 S 放掉；同一资源上第二个升级者直接失败
+TEST(LockManagerTest, UpgradeWaitsAndConflictingUpgradeAborts) {
+  LockManager lock_manager(std::chrono::milliseconds(0));
+  Transaction a(0), b(1);
+  RID rid{1, 1};
+  for (Transaction *txn : {&a, &b}) {
+    lock_manager.LockTable(txn, LockMode::INTENTION_EXCLUSIVE, TABLE);
+    lock_manager.LockRow(txn, LockMode::SHARED, TABLE, rid);
+  }
+
+  std::atomic<bool> upgraded{false};
+  std::thread upgrader([&] {
+    lock_manager.LockRow(&a, LockMode::EXCLUSIVE, TABLE, rid);
+    upgraded = true;
+  });
+  ASSERT_TRUE(WaitFor([&] { return lock_manager.GetStats().requests == 5; }));
+  EXPECT_THROW(lock_manager.LockRow(&b, LockMode::EXCLUSIVE, TABLE, rid),
+               TransactionAbortException);
+  EXPECT_EQ(b.GetRowLocks().count(rid), 0);
+  lock_manager.ReleaseAll(&b);
+  upgrader.join();
+  EXPECT_TRUE(upgraded);
+  EXPECT_EQ(a.GetRowLocks().at(rid), LockMode::EXCLUSIVE);
+  lock_manager.ReleaseAll(&a);
+}
+
+// 两个事务交叉等待对方的行，后台检测选事务号大的作牺牲者
+TEST(LockManagerTest, DeadlockBreaksYoungestTransaction) {
+  LockManager lock_manager(std::chrono::milliseconds(5));
+  Transaction older(10), younger(11);
+  RID r1{1, 0}, r2{2, 0};
+  for (Transaction *txn : {&older, &younger}) {
+    lock_manager.LockTable(txn, LockMode::INTENTION_EXCLUSIVE, TABLE);
+  }
+  lock_manager.LockRow(&older, LockMode::EXCLUSIVE, TABLE, r1);
+  lock_manager.LockRow(&younger, LockMode::EXCLUSIVE, TABLE, r2);
+
+  std::atomic<bool> older_granted{false};
+  std::atomic<bool> younger_aborted{false};
+  std::thread t1([&] {
+    lock_manager.LockRow(&older, LockMode::EXCLUSIVE, TABLE, r2);
+    older_granted = true;
+  });
+  std::thread t2([&] {
+    try {
+      lock_manager.LockRow(&younger, LockMode::EXCLUSIVE, TABLE, r1);
+    } catch (const TransactionAbortException &e) {
+      EXPECT_EQ(e.GetTxnId(), younger.GetTxnId());
+      younger_aborted = true;
+      lock_manager.ReleaseAll(&younger);
+    }
+  });
+  t2.join();
+  t1.join();
+  EXPECT_TRUE(younger_aborted);
+  EXPECT_TRUE(older_granted);
+  EXPECT_EQ(lock_manager.GetStats().deadlocks, 1);
+  lock_manager.ReleaseAll(&older);
+  EXPECT_EQ(lock_manager.DetectDeadlocks(), 0);
+}
+
+// 并发转账：按随机顺序锁两个账户，死锁的事务放锁重试，总额不变
+TEST(LockManagerTest, ConcurrentTransfersKeepTotal) {
+  constexpr int ACCOUNTS = 8;
+  constexpr int THREADS = 4;
+  constexpr int TRANSFERS = 200;
+  LockManager lock_manager(std::chrono::milliseconds(1));
+  std::vector<int> balance(ACCOUNTS, 100);
+  std::atomic<txn_id_t> next_txn_id{0};
+  std::atomic<size_t> retries{0};
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < THREADS; ++t) {
+    threads.emplace_back([&, t] {
+      std::mt19937 rng(t);
+      for (int i = 0; i < TRANSFERS; ++i) {
+        int from = rng() % ACCOUNTS;
+        int to = (from + 1 + rng() % (ACCOUNTS - 1)) % ACCOUNTS;
+        while (true) {
+          Transaction txn(next_txn_id++);
+          try {
+            lock_manager.LockTable(&txn, LockMode::INTENTION_EXCLUSIVE, TABLE);
+            lock_manager.LockRow(&txn, LockMode::EXCLUSIVE, TABLE,
+                                 RID{from, 0});
+            std::this_thread::yield();
+            lock_manager.LockRow(&txn, LockMode::EXCLUSIVE, TABLE, RID{to, 0});
+            balance[from] -= 1;
+            balance[to] += 1;
+            lock_manager.ReleaseAll(&txn);
+            break;
+          } catch (const TransactionAbortException &) {
+            lock_manager.ReleaseAll(&txn);
+            retries++;
+          }
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  int total = 0;
+  for (int b : balance) {
+    total += b;
+  }
+  EXPECT_EQ(total, ACCOUNTS * 100);
+  EXPECT_EQ(lock_manager.GetStats().deadlocks, retries.load());
+}
+
+// 锁表分区数对吞吐的影响：每个线程反复锁放自己的一批行，手动运行：
+// --gtest_also_run_disabled_tests
+// --gtest_filter=LockManagerTest.DISABLED_PartitionBenchmark
+TEST(LockManagerTest, DISABLED_PartitionBenchmark) {
+  constexpr int THREADS = 4;
+  constexpr int TXNS = 20000;
+  constexpr int ROWS_PER_TXN = 4;
+  for (size_t partitions : {1, 4, 16, 64}) {
+    LockManager lock_manager(std::chrono::milliseconds(50), partitions);
+    std::atomic<txn_id_t> next_txn_id{0};
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; ++t) {
+      threads.emplace_back([&, t] {
+        for (int i = 0; i < TXNS; ++i) {
+          Transaction txn(next_txn_id++);
+          lock_manager.LockTable(&txn, LockMode::INTENTION_EXCLUSIVE, TABLE);
+          for (int r = 0; r < ROWS_PER_TXN; ++r) {
+            lock_manager.LockRow(&txn, LockMode::EXCLUSIVE, TABLE,
+                                 RID{t * TXNS + i, static_cast<uint16_t>(r)});
+          }
+          lock_manager.ReleaseAll(&txn);
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+    double ms = std::chrono::duration<double, std::milli>(end - start).count();
+    LockStats stats = lock_manager.GetStats();
+    std::cout << partitions << " partitions: " << ms << " ms, "
+              << stats.requests << " requests, " << stats.waits
+              << " waits, " << stats.wait_millis << " ms waiting" << std::endl;
+  }
+}
@@ -0,0 +1,466 @@
+#include "binder/binder.h"
+#include "catalog/catalog.h"
+#include "common/comparator.h"
+#include "concurrency/transaction.h"
+#include "execution/execution_context.h"
+#include "execution/executor.h"
+#include "index/bplus_tree.h"
+#include "parser/parser.h"
+#include "recovery/log_manager.h"
+#include "storage/buffer_pool.h"
+#include "storage/disk_manager.h"
+#include "storage/table_heap.h"
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <gtest/gtest.h>
+#include <iostream>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace mini;
+
+class LogManagerTest : public ::testing::Test {
+protected:
+  std::filesystem::path db_file_{"test_log_manager.db"};
+  std::filesystem::path log_file_{"test_log_manager.log"};
+  std::unique_ptr<DiskManager> dm_;
+  std::unique_ptr<BufferPool> bp_;
+  std::unique_ptr<LogManager> log_;
+
+  void SetUp() override {
+    std::filesystem::remove(db_file_);
+    std::filesystem::remove(log_file_);
+    dm_ = std::make_unique<DiskManager>(db_file_.string());
+    bp_ = std::make_unique<BufferPool>(100, dm_.get());
+    log_ = std::make_unique<LogManager>(dm_.get());
+  }
+
+  void TearDown() override {
+    log_.reset();
+    bp_.reset();
+    dm_.reset();
+    std::filesystem::remove(db_file_);
+    std::filesystem::remove(log_file_);
+  }
+
+  // 读出日志文件里的全部记录
+  std::vector<LogRecord> ReadAll() {
+    std::vector<char> buf(dm_->GetLogSize());
+    size_t len = dm_->ReadLog(buf.data(), buf.size(), 0);
+    std::vector<LogRecord> records;
+    size_t offset = 0;
+    LogRecord record;
+    while (record.DeserializeFrom(buf.data() + offset, len - offset)) {
+      records.push_back(record);
+      offset += record.GetSize();
+    }
+    return records;
+  }
+
+  static Tuple MakeTuple(int32_t a, int32_t b) {
+    Tuple tuple;
+    char *buf = tuple.Resize(8);
+    memcpy(buf, &a, 4);
+    memcpy(buf + 4, &b, 4);
+    return tuple;
+  }
+};
+
+// LSN 是记录的偏移，落盘后能原样读回
+TEST_F(LogManagerTest, AppendAndReadBack) {
+  LogRecord begin(7, INVALID_LSN, LogRecordType::BEGIN);
+  lsn_t lsn0 = log_->AppendLogRecord(&begin);
+  LogRecord insert(7, lsn0, LogRecordType::INSERT_TUPLE, RID{3, 4},
+                   MakeTuple(1, 2));
+  lsn_t lsn1 = log_->AppendLogRecord(&insert);
+  int32_t key = 42;
+  LogRecord index(7, lsn1, LogRecordType::INDEX_INSERT, 1, 5, RID{3, 4},
+                  reinterpret_cast<const char *>(&key), sizeof(key));
+  lsn_t lsn2 = log_->AppendLogRecord(&index);
+  Page left, right;
+  left.GetData()[100] = 'x';
+  right.GetData()[100] = 'y';
+  LogRecord image(7, lsn2, lsn1, {{5, left.GetData()}, {6, right.GetData()}});
+  lsn_t lsn3 = log_->AppendLogRecord(&image);
+  LogRecord commit(7, lsn3, LogRecordType::COMMIT);
+  lsn_t lsn4 = log_->AppendLogRecord(&commit);
+
+  EXPECT_EQ(lsn0, 0);
+  EXPECT_EQ(lsn1, lsn0 + begin.GetSize());
+  EXPECT_EQ(lsn4, lsn3 + image.GetSize());
+  log_->Flush(lsn4);
+  EXPECT_GT(log_->GetFlushedLSN(), lsn4);
+
+  auto records = ReadAll();
+  ASSERT_EQ(records.size(), 5);
+  EXPECT_EQ(records[1].GetType(), LogRecordType::INSERT_TUPLE);
+  EXPECT_EQ(records[1].GetLSN(), lsn1);
+  EXPECT_EQ(records[1].GetPrevLSN(), lsn0);
+  EXPECT_EQ(records[1].GetRID(), (RID{3, 4}));
+  int32_t a;
+  memcpy(&a, records[1].GetTuple().Data(), 4);
+  EXPECT_EQ(a, 1);
+  EXPECT_EQ(records[2].GetIndexId(), 1);
+  EXPECT_EQ(records[2].GetPageId(), 5);
+  int32_t logged_key;
+  memcpy(&logged_key, records[2].GetPayload().data(), sizeof(logged_key));
+  EXPECT_EQ(logged_key, 42);
+  EXPECT_EQ(records[3].GetUndoNextLSN(), lsn1);
+  EXPECT_EQ(records[3].GetPageIds(), (std::vector<page_id_t>{5, 6}));
+  EXPECT_EQ(records[3].GetPageImage(0)[100], 'x');
+  EXPECT_EQ(records[3].GetPageImage(1)[100], 'y');
+  EXPECT_EQ(records[4].GetType(), LogRecordType::COMMIT);
+  EXPECT_EQ(records[4].GetTxnId(), 7);
+}
+
+// 重新打开时接着已有日志的末尾追加
+TEST_F(LogManagerTest, ReopenAppendsAfterExistingLog) {
+  LogRecord begin(1, INVALID_LSN, LogRecordType::BEGIN);
+  log_->AppendLogRecord(&begin);
+  lsn_t end = log_->GetNextLSN();
+  log_.reset();
+  log_ = std::make_unique<LogManager>(dm_.get());
+  EXPECT_EQ(log_->GetNextLSN(), end);
+  EXPECT_EQ(log_->GetFlushedLSN(), end);
+  LogRecord commit(1, 0, LogRecordType::COMMIT);
+  EXPECT_EQ(log_->AppendLogRecord(&commit), end);
+  log_->FlushAll();
+  EXPECT_EQ(ReadAll().size(), 2);
+}
+
+// 比缓冲区还大的记录直接落盘，前后的记录顺序不变
+TEST_F(LogManagerTest, OversizedRecordIsWrittenDirectly) {
+  log_ = std::make_unique<LogManager>(dm_.get(), 4096);
+  LogRecord begin(1, INVALID_LSN, LogRecordType::BEGIN);
+  lsn_t lsn0 = log_->AppendLogRecord(&begin);
+  Page pages[3];
+  std::vector<std::pair<page_id_t, const char *>> images;
+  for (page_id_t i = 0; i < 3; ++i) {
+    pages[i].GetData()[10] = static_cast<char>('a' + i);
+    images.emplace_back(i, pages[i].GetData());
+  }
+  LogRecord smo(1, lsn0, lsn0, images);
+  ASSERT_GT(smo.GetSize(), 4096);
+  lsn_t lsn1 = log_->AppendLogRecord(&smo);
+  EXPECT_EQ(lsn1, lsn0 + begin.GetSize());
+  EXPECT_GT(log_->GetFlushedLSN(), lsn1);
+  LogRecord commit(1, lsn1, LogRecordType::COMMIT);
+  log_->Flush(log_->AppendLogRecord(&commit));
+
+  auto records = ReadAll();
+  ASSERT_EQ(records.size(), 3);
+  EXPECT_EQ(records[1].GetLSN(), lsn1);
+  EXPECT_EQ(records[1].GetPageImage(2)[10], 'c');
+  EXPECT_EQ(records[2].GetType(), LogRecordType::COMMIT);
+}
+
+// 并发提交共享 fsync：落盘次数明显少于提交数
+TEST_F(LogManagerTest, GroupCommitSharesFlushes) {
+  constexpr int THREADS = 8;
+  constexpr int COMMITS = 50;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < THREADS; ++t) {
+    threads.emplace_back([this, t] {
+      for (int i = 0; i < COMMITS; ++i) {
+        Transaction txn(t * COMMITS + i);
+        LogRecord begin(txn.GetTxnId(), INVALID_LSN, LogRecordType::BEGIN);
+        txn.SetPrevLSN(log_->AppendLogRecord(&begin));
+        LogRecord commit(txn.GetTxnId(), txn.GetPrevLSN(),
+                         LogRecordType::COMMIT);
+        lsn_t lsn = log_->AppendLogRecord(&commit);
+        log_->Flush(lsn);
+        EXPECT_GT(log_->GetFlushedLSN(), lsn);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_LT(log_->GetFlushCount(), static_cast<size_t>(THREADS * COMMITS));
+  EXPECT_EQ(ReadAll().size(), static_cast<size_t>(2 * THREADS * COMMITS));
+}
+
+// 堆和 B+Tree 的修改按事务串成链
+TEST_F(LogManagerTest, HeapAndIndexChangesAreLogged) {
+  TableHeap heap(bp_.get(), log_.get());
+  BPlusTree<int32_t, RID, IntComparator> tree(bp_.get(), false, log_.get());
+  Transaction txn(3);
+  RID rid = heap.InsertTuple(MakeTuple(10, 20), &txn);
+  tree.Insert(10, rid, &txn);
+  tree.Remove(10, rid, &txn);
+  heap.DeleteTuple(rid, &txn);
+  // 不带事务的修改不写日志
+  heap.InsertTuple(MakeTuple(11, 21));
+  log_->FlushAll();
+
+  auto records = ReadAll();
+  std::vector<LogRecordType> types;
+  for (const auto &record : records) {
+    EXPECT_EQ(record.GetTxnId(), 3);
+    types.push_back(record.GetType());
+  }
+  // 空树第一次插入：根叶子和头页的整页后像在同一条 INDEX_SMO 里
+  std::vector<LogRecordType> expected{
+      LogRecordType::INSERT_TUPLE, LogRecordType::INDEX_SMO,
+      LogRecordType::INDEX_INSERT, LogRecordType::INDEX_DELETE,
+      LogRecordType::MARK_DELETE};
+  EXPECT_EQ(types, expected);
+  for (size_t i = 1; i < records.size(); ++i) {
+    EXPECT_EQ(records[i].GetPrevLSN(), records[i - 1].GetLSN());
+  }
+  EXPECT_EQ(records.back().GetLSN(), txn.GetPrevLSN());
+  int32_t b;
+  memcpy(&b, records.back().GetTuple().Data() + 4, 4);
+  EXPECT_EQ(b, 20);
+}
+
+// 分裂和换根各写一条 INDEX_SMO，undo_next 指回触发分裂的叶子插入
+TEST_F(LogManagerTest, SplitIsOneRedoOnlyRecord) {
+  BPlusTree<int32_t, RID, IntComparator> tree(bp_.get(), false, log_.get());
+  Transaction txn(5);
+  for (int32_t key = 0; key < 2000; ++key) {
+    tree.Insert(key, RID{key, 0}, &txn);
+  }
+  ASSERT_GE(tree.GetHeight(), 2);
+  log_->FlushAll();
+
+  auto records = ReadAll();
+  std::unordered_map<lsn_t, LogRecordType> types;
+  for (const auto &record : records) {
+    types[record.GetLSN()] = record.GetType();
+  }
+  size_t smos = 0;
+  for (const auto &record : records) {
+    if (record.GetType() != LogRecordType::INDEX_SMO) {
+      continue;
+    }
+    if (smos++ == 0) {
+      // 建根不是由插入触发的，前面没有这个事务的日志
+      EXPECT_EQ(record.GetUndoNextLSN(), INVALID_LSN);
+      EXPECT_EQ(record.GetPageIds().size(), 2);
+      continue;
+    }
+    EXPECT_EQ(record.GetUndoNextLSN(), record.GetPrevLSN());
+    EXPECT_EQ(types.at(record.GetPrevLSN()), LogRecordType::INDEX_INSERT);
+    // 旧叶子、新叶子、父节点；根分裂时还有新根和头页
+    EXPECT_GE(record.GetPageIds().size(), 3);
+  }
+  EXPECT_GT(smos, 2);
+}
+
+// 成批插入每页一条 INSERT_TUPLES，槽位连续；只有一行的页还是 INSERT_TUPLE
+TEST_F(LogManagerTest, BatchedInsertIsOneRecordPerPage) {
+  TableHeap heap(bp_.get(), log_.get());
+  Transaction txn(4);
+  std::vector<Tuple> tuples;
+  for (int32_t i = 0; i < 1000; ++i) {
+    tuples.push_back(MakeTuple(i, i * 2));
+  }
+  std::vector<lsn_t> undo_next;
+  auto rids = heap.InsertTuples(tuples, &txn, &undo_next);
+  ASSERT_EQ(rids.size(), tuples.size());
+  ASSERT_EQ(undo_next.size(), tuples.size());
+  rids.push_back(heap.InsertTuples({MakeTuple(1000, 0)}, &txn)[0]);
+  log_->FlushAll();
+
+  auto records = ReadAll();
+  std::vector<page_id_t> pages;
+  int32_t next = 0;
+  for (const auto &record : records) {
+    if (record.GetType() == LogRecordType::NEW_TABLE_PAGE) {
+      continue;
+    }
+    if (record.GetType() == LogRecordType::INSERT_TUPLE) {
+      EXPECT_EQ(record.GetRID(), rids[next]);
+      next++;
+      continue;
+    }
+    ASSERT_EQ(record.GetType(), LogRecordType::INSERT_TUPLES);
+    pages.push_back(record.GetRID().page_id);
+    for (size_t i = 0; i < record.GetTuples().size(); ++i) {
+      RID rid = record.GetRID();
+      rid.slot_id = static_cast<uint16_t>(rid.slot_id + i);
+      EXPECT_EQ(rid, rids[next]);
+      int32_t a;
+      memcpy(&a, record.GetTuples()[i].Data(), 4);
+      EXPECT_EQ(a, next);
+      // 页里第一行撤销后越过这条记录，其余的回到它本身
+      EXPECT_EQ(undo_next[next],
+                i == 0 ? record.GetPrevLSN() : record.GetLSN());
+      next++;
+    }
+  }
+  EXPECT_EQ(next, 1001);
+  EXPECT_EQ(pages.size(),
+            static_cast<size_t>(rids[999].page_id - rids[0].page_id + 1));
+  EXPECT_EQ(records.back().GetType(), LogRecordType::INSERT_TUPLE);
+}
+
+// 打开压缩后大记录变小，读回来的内容不变
+TEST_F(LogManagerTest, CompressedRecordsReadBack) {
+  log_->SetCompression(true);
+  TableHeap heap(bp_.get(), log_.get());
+  BPlusTree<int32_t, RID, IntComparator> tree(bp_.get(), false, log_.get());
+  Transaction txn(6);
+  std::vector<Tuple> tuples;
+  for (int32_t i = 0; i < 500; ++i) {
+    tuples.push_back(MakeTuple(i, 7));
+  }
+  auto rids = heap.InsertTuples(tuples, &txn);
+  for (int32_t i = 0; i < 500; ++i) {
+    tree.Insert(i, rids[i], &txn);
+  }
+  log_->FlushAll();
+
+  LogStats stats = log_->GetStats();
+  EXPECT_EQ(stats.bytes, static_cast<size_t>(log_->GetNextLSN()));
+  EXPECT_LT(stats.bytes, stats.uncompressed_bytes);
+  auto records = ReadAll();
+  EXPECT_EQ(records.size(), stats.records);
+  int32_t next = 0;
+  size_t smos = 0;
+  for (const auto &record : records) {
+    if (record.GetType() == LogRecordType::INSERT_TUPLES) {
+      EXPECT_LT(record.GetSize(), record.GetUncompressedSize());
+      for (const Tuple &tuple : record.GetTuples()) {
+        EXPECT_EQ(memcmp(tuple.Data(), tuples[next].Data(), 8), 0);
+        next++;
+      }
+    } else if (record.GetType() == LogRecordType::INDEX_SMO) {
+      EXPECT_LT(record.GetSize(), record.GetUncompressedSize());
+      EXPECT_EQ(record.GetPayload().size(),
+                record.GetPageIds().size() * PAGE_SIZE);
+      smos++;
+    }
+  }
+  EXPECT_EQ(next, 500);
+  EXPECT_GT(smos, 1);
+}
+
+// 带日志的 INSERT 语句：BEGIN ... COMMIT，返回时已经落盘
+TEST_F(LogManagerTest, InsertStatementCommitsDurably) {
+  Catalog catalog(bp_.get(), log_.get());
+  ExecutionContext ctx(catalog);
+  auto run = [&](const std::string &sql) {
+    Parser parser(std::make_unique<Lexer>(sql));
+    auto stmt = parser.ParseStatement();
+    ASSERT_NE(stmt, nullptr);
+    Binder binder(catalog);
+    auto bound = binder.BindStatement(*stmt);
+    ASSERT_NE(bound, nullptr);
+    std::unique_ptr<Executor> exec;
+    if (bound->Type() == BoundStatementType::BOUND_INSERT) {
+      exec = std::make_unique<InsertExecutor>(
+          ctx, std::unique_ptr<BoundInsertStatement>(
+                   static_cast<BoundInsertStatement *>(bound.release())));
+    } else {
+      exec = std::make_unique<CreateTableExecutor>(
+          ctx, std::unique_ptr<BoundCreateTableStatement>(
+                   static_cast<BoundCreateTableStatement *>(bound.release())));
+    }
+    exec->Init();
+    while (exec->Next(nullptr)) {
+    }
+  };
+  run("CREATE TABLE t (id INT PRIMARY KEY, v INT);");
+  run("INSERT INTO t VALUES (1, 10);");
+  EXPECT_EQ(log_->GetFlushedLSN(), log_->GetNextLSN());
+
+  auto records = ReadAll();
+  ASSERT_FALSE(records.empty());
+  EXPECT_EQ(records.front().GetType(), LogRecordType::BEGIN);
+  EXPECT_EQ(records.back().GetType(), LogRecordType::COMMIT);
+  size_t index_inserts = 0;
+  for (const auto &record : records) {
+    index_inserts += record.GetType() == LogRecordType::INDEX_INSERT;
+  }
+  EXPECT_EQ(index_inserts, 1);
+}
+
+// 每行的日志字节：逐行插入、成批插入、成批并压缩，手动运行：
+// --gtest_also_run_disabled_tests
+// --gtest_filter=LogManagerTest.DISABLED_LogBytesPerRowBenchmark
+TEST_F(LogManagerTest, DISABLED_LogBytesPerRowBenchmark) {
+  constexpr int ROWS = 100000;
+  constexpr int BATCH = 1000;
+  // 像一般的表行：自增 id、取值不多的状态列
+  std::vector<Tuple> tuples;
+  for (int32_t i = 0; i < ROWS; ++i) {
+    tuples.push_back(MakeTuple(i, i % 16));
+  }
+  struct Mode {
+    const char *name;
+    bool batched;
+    bool compressed;
+  };
+  for (Mode mode : {Mode{"per-row", false, false},
+                    Mode{"batched", true, false},
+                    Mode{"batched+compressed", true, true}}) {
+    TearDown();
+    SetUp();
+    log_->SetCompression(mode.compressed);
+    TableHeap heap(bp_.get(), log_.get());
+    Transaction txn(1);
+    auto start = std::chrono::steady_clock::now();
+    if (mode.batched) {
+      for (int i = 0; i < ROWS; i += BATCH) {
+        heap.InsertTuples({tuples.begin() + i, tuples.begin() + i + BATCH},
+                          &txn);
+      }
+    } else {
+      for (const Tuple &tuple : tuples) {
+        heap.InsertTuple(tuple, &txn);
+      }
+    }
+    log_->FlushAll();
+    auto end = std::chrono::steady_clock::now();
+    LogStats stats = log_->GetStats();
+    std::cout << mode.name << ": "
+              << std::chrono::duration<double, std::milli>(end - start).count()
+              << " ms, " << stats.records << " records, "
+              << static_cast<double>(stats.bytes) / ROWS << " log bytes/row ("
+              << static_cast<double>(stats.uncompressed_bytes) / ROWS
+              << " uncompressed)" << std::endl;
+  }
+}
+
+// 提交吞吐随并发提交者增加，手动运行：
+// --gtest_also_run_disabled_tests
+// --gtest_filter=LogManagerTest.DISABLED_CommitThroughputBenchmark
+TEST_F(LogManagerTest, DISABLED_CommitThroughputBenchmark) {
+  constexpr int TOTAL_COMMITS = 4000;
+  for (int thread_count : {1, 2, 4, 8, 16, 32}) {
+    size_t flushes_before = log_->GetFlushCount();
+    std::atomic<int> next_txn{0};
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < thread_count; ++t) {
+      threads.emplace_back([this, &next_txn] {
+        int txn_id;
+        while ((txn_id = next_txn++) < TOTAL_COMMITS) {
+          Transaction txn(txn_id);
+          LogRecord begin(txn_id, INVALID_LSN, LogRecordType::BEGIN);
+          txn.SetPrevLSN(log_->AppendLogRecord(&begin));
+          LogRecord insert(txn_id, txn.GetPrevLSN(),
+                           LogRecordType::INSERT_TUPLE, RID{txn_id, 0},
+                           MakeTuple(txn_id, txn_id));
+          txn.SetPrevLSN(log_->AppendLogRecord(&insert));
+          LogRecord commit(txn_id, txn.GetPrevLSN(), LogRecordType::COMMIT);
+          log_->Flush(log_->AppendLogRecord(&commit));
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+    double sec = std::chrono::duration<double>(end - start).count();
+    size_t flushes = log_->GetFlushCount() - flushes_before;
+    std::cout << thread_count << " committers: " << TOTAL_COMMITS / sec
+              << " commits/s, " << flushes << " fsyncs, "
+              << static_cast<double>(TOTAL_COMMITS) / flushes
+              << " commits/fsync" << std::endl;
+  }
+}
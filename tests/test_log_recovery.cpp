@@ -0,0 +1,639 @@
+#include "common/comparator.h"
+#include "concurrency/transaction.h"
+#include "concurrency/transaction_manager.h"
+#include "index/bplus_tree.h"
+#include "index/extendible_hash_table.h"
+#include "recovery/checkpoint_manager.h"
+#include "recovery/log_manager.h"
+#include "recovery/log_recovery.h"
+#include "storage/buffer_pool.h"
+#include "storage/disk_manager.h"
+#include "storage/table_heap.h"
+#include "storage/table_iterator.h"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <iostream>
+#include <set>
+#include <thread>
+#include <vector>
+
+using namespace mini;
+
+using Tree = BPlusTree<int32_t, RID, IntComparator>;
+
+// 崩溃注入：缓冲池里没写回的页全部丢失，日志只留下已经落盘的部分
+class LogRecoveryTest : public ::testing::Test {
+protected:
+  std::filesystem::path db_file_{"test_log_recovery.db"};
+  std::filesystem::path log_file_{"test_log_recovery.log"};
+  std::filesystem::path master_file_{"test_log_recovery.master"};
+  std::unique_ptr<DiskManager> dm_;
+  std::unique_ptr<LogManager> log_;
+  std::unique_ptr<BufferPool> bp_;
+  std::unique_ptr<CheckpointManager> checkpoint_;
+  std::unique_ptr<TableHeap> heap_;
+  std::unique_ptr<Tree> tree_;
+  page_id_t first_page_id_{INVALID_PAGE_ID};
+  page_id_t header_page_id_{INVALID_PAGE_ID};
+  txn_id_t next_txn_id_{0};
+
+  void SetUp() override {
+    std::filesystem::remove(db_file_);
+    std::filesystem::remove(log_file_);
+    std::filesystem::remove(master_file_);
+    Open();
+    heap_ = std::make_unique<TableHeap>(bp_.get(), log_.get());
+    tree_ = std::make_unique<Tree>(bp_.get(), false, log_.get());
+    first_page_id_ = heap_->GetFirstPageId();
+    header_page_id_ = tree_->GetHeaderPageId();
+    // 建表和建索引本身不写日志，先刷盘
+    bp_->FlushAllPages();
+  }
+
+  void TearDown() override {
+    checkpoint_.reset();
+    tree_.reset();
+    heap_.reset();
+    bp_.reset();
+    log_.reset();
+    dm_.reset();
+    std::filesystem::remove(db_file_);
+    std::filesystem::remove(log_file_);
+    std::filesystem::remove(master_file_);
+  }
+
+  void Open(size_t pool_size = 16) {
+    dm_ = std::make_unique<DiskManager>(db_file_.string());
+    log_ = std::make_unique<LogManager>(dm_.get());
+    bp_ = std::make_unique<BufferPool>(pool_size, dm_.get(), log_.get());
+  }
+
+  void Crash() {
+    checkpoint_.reset();
+    tree_.reset();
+    heap_.reset();
+    lsn_t durable = log_->GetFlushedLSN();
+    bp_.reset(); // 不写回
+    log_.reset();
+    dm_.reset();
+    std::filesystem::resize_file(log_file_, durable);
+  }
+
+  // 重启并恢复，然后重新打开表和索引
+  LogRecovery Restart(size_t pool_size = 16, size_t redo_threads = 1) {
+    Open(pool_size);
+    LogRecovery recovery(dm_.get(), bp_.get(), log_.get(), redo_threads);
+    recovery.Recover();
+    heap_ = std::make_unique<TableHeap>(bp_.get(), first_page_id_, log_.get());
+    tree_ = std::make_unique<Tree>(bp_.get(), header_page_id_, log_.get());
+    return recovery;
+  }
+
+  static Tuple MakeTuple(int32_t a) {
+    Tuple tuple;
+    char *buf = tuple.Resize(8);
+    memcpy(buf, &a, 4);
+    memcpy(buf + 4, &a, 4);
+    return tuple;
+  }
+
+  void AppendTxnRecord(Transaction *txn, LogRecordType type) {
+    LogRecord record(txn->GetTxnId(), txn->GetPrevLSN(), type);
+    txn->SetPrevLSN(log_->AppendLogRecord(&record));
+  }
+
+  // 一个事务插入 [begin, end)，commit 为 false 时不结束，崩溃后成为失败者
+  std::vector<RID> InsertKeys(int32_t begin, int32_t end, bool commit) {
+    Transaction txn(next_txn_id_++);
+    AppendTxnRecord(&txn, LogRecordType::BEGIN);
+    auto rids = InsertKeys(begin, end, &txn);
+    if (commit) {
+      AppendTxnRecord(&txn, LogRecordType::COMMIT);
+    }
+    log_->FlushAll();
+    return rids;
+  }
+
+  std::vector<RID> InsertKeys(int32_t begin, int32_t end, Transaction *txn) {
+    std::vector<RID> rids;
+    for (int32_t key = begin; key < end; ++key) {
+      RID rid = heap_->InsertTuple(MakeTuple(key), txn);
+      tree_->Insert(key, rid, txn);
+      rids.push_back(rid);
+    }
+    return rids;
+  }
+
+  std::multiset<int32_t> ScanHeap() {
+    std::multiset<int32_t> keys;
+    for (auto it = heap_->Begin(); it != heap_->End(); ++it) {
+      int32_t key;
+      memcpy(&key, (*it).Data(), 4);
+      keys.insert(key);
+    }
+    return keys;
+  }
+
+  // 堆里恰好是 [0, n)，索引里每个 key 恰好一项且指向对的 tuple
+  void ExpectExactly(int32_t n, int32_t probe_end) {
+    std::multiset<int32_t> expected;
+    for (int32_t key = 0; key < n; ++key) {
+      expected.insert(key);
+    }
+    EXPECT_EQ(ScanHeap(), expected);
+    for (int32_t key = 0; key < probe_end; ++key) {
+      std::vector<RID> rids;
+      tree_->GetValue(key, &rids);
+      if (key >= n) {
+        EXPECT_TRUE(rids.empty()) << key;
+        continue;
+      }
+      ASSERT_EQ(rids.size(), 1) << key;
+      Tuple tuple;
+      ASSERT_TRUE(heap_->GetTuple(rids[0], &tuple));
+      int32_t stored;
+      memcpy(&stored, tuple.Data(), 4);
+      EXPECT_EQ(stored, key);
+    }
+  }
+};
+
+// 已提交的修改重做回来，没提交的插入和删除都被撤销
+TEST_F(LogRecoveryTest, RedoCommittedAndUndoLosers) {
+  auto rids = InsertKeys(0, 1000, true);
+  // 失败者：插入新 key，同时删掉一部分已提交的行
+  Transaction loser(next_txn_id_++);
+  AppendTxnRecord(&loser, LogRecordType::BEGIN);
+  for (int32_t key = 0; key < 100; ++key) {
+    heap_->DeleteTuple(rids[key], &loser);
+    tree_->Remove(key, rids[key], &loser);
+  }
+  for (int32_t key = 1000; key < 2000; ++key) {
+    tree_->Insert(key, heap_->InsertTuple(MakeTuple(key), &loser), &loser);
+  }
+  log_->FlushAll();
+  Crash();
+
+  auto recovery = Restart();
+  EXPECT_EQ(recovery.GetLoserCount(), 1);
+  EXPECT_GT(recovery.GetRedoCount(), 0);
+  EXPECT_EQ(recovery.GetUndoCount(), 2 * 100 + 2 * 1000);
+  ExpectExactly(1000, 2000);
+  // 头页里的项数跟着叶子的记录重做和撤销
+  EXPECT_EQ(tree_->GetEntryCount(), 1000);
+}
+
+// 哈希索引的插入、删除、分裂和溢出页都写日志：已提交的重做回来，
+// 失败者按 key 撤销
+TEST_F(LogRecoveryTest, HashIndexRedoAndUndo) {
+  using HashTable = ExtendibleHashTable<int32_t, RID, IntComparator>;
+  auto table = std::make_unique<HashTable>(bp_.get(), false, log_.get());
+  page_id_t hash_header_page_id = table->GetHeaderPageId();
+  bp_->FlushAllPages();
+
+  // 一半是同一个 key 的重复项，要接溢出页
+  Transaction committed(next_txn_id_++);
+  AppendTxnRecord(&committed, LogRecordType::BEGIN);
+  for (int32_t i = 0; i < 3000; ++i) {
+    table->Insert(i, RID{i, 0}, &committed);
+    table->Insert(-1, RID{i, 1}, &committed);
+  }
+  AppendTxnRecord(&committed, LogRecordType::COMMIT);
+
+  Transaction loser(next_txn_id_++);
+  AppendTxnRecord(&loser, LogRecordType::BEGIN);
+  for (int32_t i = 0; i < 100; ++i) {
+    table->Remove(i, RID{i, 0}, &loser);
+  }
+  for (int32_t i = 3000; i < 4000; ++i) {
+    table->Insert(i, RID{i, 0}, &loser);
+  }
+  log_->FlushAll();
+  table.reset();
+  Crash();
+
+  auto recovery = Restart();
+  EXPECT_EQ(recovery.GetLoserCount(), 1);
+  EXPECT_EQ(recovery.GetUndoCount(), 100 + 1000);
+  table = std::make_unique<HashTable>(bp_.get(), hash_header_page_id,
+                                      log_.get());
+  for (int32_t i = 0; i < 4000; ++i) {
+    std::vector<RID> rids;
+    table->GetValue(i, &rids);
+    if (i >= 3000) {
+      EXPECT_TRUE(rids.empty()) << i;
+      continue;
+    }
+    ASSERT_EQ(rids.size(), 1) << i;
+    EXPECT_EQ(rids[0].page_id, i);
+  }
+  std::vector<RID> rids;
+  EXPECT_TRUE(table->GetValue(-1, &rids));
+  EXPECT_EQ(rids.size(), 3000);
+}
+
+// 只写回了一部分页就崩溃（FlushAllPages 做到一半），索引靠日志补齐
+TEST_F(LogRecoveryTest, CrashInTheMiddleOfFlushAllPages) {
+  InsertKeys(0, 3000, true);
+  for (page_id_t page_id = 0; page_id < 200; page_id += 2) {
+    bp_->FlushPage(page_id);
+  }
+  Crash();
+
+  auto recovery = Restart();
+  EXPECT_EQ(recovery.GetLoserCount(), 0);
+  ExpectExactly(3000, 3100);
+  // 恢复后可以继续写
+  InsertKeys(3000, 3100, true);
+  ExpectExactly(3100, 3200);
+}
+
+// 恢复本身写了 CLR 和 ABORT，再崩溃一次也不会重复撤销
+TEST_F(LogRecoveryTest, RecoveryIsRepeatable) {
+  InsertKeys(0, 500, true);
+  InsertKeys(500, 800, false);
+  Crash();
+  auto first = Restart();
+  EXPECT_EQ(first.GetLoserCount(), 1);
+  ExpectExactly(500, 800);
+
+  Crash();
+  auto second = Restart();
+  EXPECT_EQ(second.GetLoserCount(), 0);
+  EXPECT_EQ(second.GetUndoCount(), 0);
+  ExpectExactly(500, 800);
+}
+
+// 日志尾部写了一半的记录被截掉，之后的日志接在有效末尾后面
+TEST_F(LogRecoveryTest, TornLogTailIsTruncated) {
+  InsertKeys(0, 100, true);
+  Crash();
+  size_t durable = std::filesystem::file_size(log_file_);
+  {
+    std::ofstream out(log_file_, std::ios::binary | std::ios::app);
+    uint32_t size = 4096;
+    out.write(reinterpret_cast<const char *>(&size), sizeof(size));
+    out.write("partial", 7);
+  }
+
+  auto recovery = Restart();
+  EXPECT_EQ(recovery.GetLogEnd(), static_cast<lsn_t>(durable));
+  EXPECT_EQ(std::filesystem::file_size(log_file_), durable);
+  InsertKeys(100, 200, true);
+  Crash();
+  Restart();
+  ExpectExactly(200, 200);
+}
+
+// 回滚到一半时崩溃：已经写了 CLR 的部分恢复时不再撤销
+TEST_F(LogRecoveryTest, CrashDuringRollback) {
+  InsertKeys(0, 100, true);
+  TransactionManager txn_manager(log_.get());
+  Transaction *txn = txn_manager.Begin();
+  for (int32_t key = 100; key < 300; ++key) {
+    lsn_t undo_next = txn->GetPrevLSN();
+    RID rid = heap_->InsertTuple(MakeTuple(key), txn);
+    txn->AppendWrite(
+        {WriteType::INSERT, heap_.get(), nullptr, rid, Tuple(), undo_next});
+  }
+  txn_manager.RollbackTo(txn, 100);
+  log_->FlushAll();
+  Crash();
+
+  auto recovery = Restart();
+  EXPECT_EQ(recovery.GetLoserCount(), 1);
+  EXPECT_EQ(recovery.GetUndoCount(), 100);
+  std::multiset<int32_t> expected;
+  for (int32_t key = 0; key < 100; ++key) {
+    expected.insert(key);
+  }
+  EXPECT_EQ(ScanHeap(), expected);
+}
+
+// 分裂写到一半崩溃：INDEX_SMO 作为写了一半的尾部被截掉，盘上还是
+// 分裂之前的页，失败者的插入按 key 撤销，树仍然完整
+TEST_F(LogRecoveryTest, CrashInTheMiddleOfSplit) {
+  InsertKeys(0, 500, true);
+  bp_->FlushAllPages();
+  Transaction loser(next_txn_id_++);
+  AppendTxnRecord(&loser, LogRecordType::BEGIN);
+  lsn_t smo_lsn = INVALID_LSN;
+  int32_t end = 500;
+  while (smo_lsn == INVALID_LSN) {
+    lsn_t before = log_->GetNextLSN();
+    tree_->Insert(end, heap_->InsertTuple(MakeTuple(end), &loser), &loser);
+    end++;
+    if (log_->GetNextLSN() - before > PAGE_SIZE) {
+      smo_lsn = loser.GetPrevLSN();
+    }
+  }
+  log_->FlushAll();
+  Crash();
+  std::filesystem::resize_file(log_file_, smo_lsn + 100);
+
+  auto recovery = Restart();
+  EXPECT_EQ(recovery.GetLogEnd(), smo_lsn);
+  EXPECT_EQ(recovery.GetLoserCount(), 1);
+  EXPECT_EQ(recovery.GetUndoCount(), 2 * (end - 500));
+  ExpectExactly(500, end + 100);
+  // 之后照常插入和分裂
+  InsertKeys(500, 1500, true);
+  ExpectExactly(1500, 1600);
+}
+
+// 成批插入的失败者，日志压缩，回滚到一半时崩溃：恢复从最后一个 CLR
+// 接着撤销，同一页上已经删掉的行再删一次
+TEST_F(LogRecoveryTest, BatchedInsertLoserWithCompression) {
+  log_->SetCompression(true);
+  TransactionManager txn_manager(log_.get());
+  auto insert_batch = [&](Transaction *txn, int32_t begin, int32_t end) {
+    std::vector<Tuple> tuples;
+    for (int32_t key = begin; key < end; ++key) {
+      tuples.push_back(MakeTuple(key));
+    }
+    std::vector<lsn_t> undo_next;
+    auto rids = heap_->InsertTuples(tuples, txn, &undo_next);
+    for (size_t i = 0; i < rids.size(); ++i) {
+      txn->AppendWrite({WriteType::INSERT, heap_.get(), nullptr, rids[i],
+                        Tuple(), undo_next[i]});
+    }
+    return rids;
+  };
+  Transaction *winner = txn_manager.Begin();
+  auto rids = insert_batch(winner, 0, 1000);
+  for (int32_t key = 0; key < 1000; ++key) {
+    tree_->Insert(key, rids[key], winner);
+  }
+  txn_manager.Commit(winner);
+  Transaction *loser = txn_manager.Begin();
+  insert_batch(loser, 1000, 2000);
+  // 后 300 行已经回滚，前 700 行留给恢复
+  txn_manager.RollbackTo(loser, 700);
+  log_->FlushAll();
+  Crash();
+
+  auto recovery = Restart();
+  EXPECT_EQ(recovery.GetLoserCount(), 1);
+  ExpectExactly(1000, 2000);
+  InsertKeys(1000, 1100, true);
+  ExpectExactly(1100, 2000);
+}
+
+// 多线程重做和单线程结果一致：同一页的修改按日志顺序重放
+TEST_F(LogRecoveryTest, ParallelRedo) {
+  auto rids = InsertKeys(0, 3000, true);
+  Transaction deleter(next_txn_id_++);
+  AppendTxnRecord(&deleter, LogRecordType::BEGIN);
+  for (int32_t key = 0; key < 3000; key += 3) {
+    heap_->DeleteTuple(rids[key], &deleter);
+    tree_->Remove(key, rids[key], &deleter);
+  }
+  AppendTxnRecord(&deleter, LogRecordType::COMMIT);
+  InsertKeys(3000, 3500, false);
+  Crash();
+
+  auto recovery = Restart(16, 4);
+  EXPECT_EQ(recovery.GetRedoThreads(), 4);
+  EXPECT_GT(recovery.GetRedoCount(), 0);
+  EXPECT_EQ(recovery.GetLoserCount(), 1);
+  std::multiset<int32_t> expected;
+  for (int32_t key = 0; key < 3000; ++key) {
+    if (key % 3 != 0) {
+      expected.insert(key);
+    }
+  }
+  EXPECT_EQ(ScanHeap(), expected);
+  for (int32_t key = 0; key < 3500; ++key) {
+    std::vector<RID> result;
+    tree_->GetValue(key, &result);
+    EXPECT_EQ(result.size(), expected.count(key)) << key;
+  }
+
+  // 线程数不超过缓冲池帧数
+  Crash();
+  EXPECT_EQ(Restart(4, 64).GetRedoThreads(), 4);
+}
+
+// 检查点记下活跃事务和脏页，master 记录指向它的 BEGIN
+TEST_F(LogRecoveryTest, CheckpointRecordsActiveTxnsAndDirtyPages) {
+  checkpoint_ = std::make_unique<CheckpointManager>(
+      dm_.get(), bp_.get(), log_.get(), std::chrono::milliseconds(0), 0);
+  InsertKeys(0, 100, true);
+  Transaction active(next_txn_id_++);
+  AppendTxnRecord(&active, LogRecordType::BEGIN);
+  InsertKeys(100, 200, &active);
+
+  lsn_t begin_lsn = checkpoint_->Checkpoint();
+  EXPECT_EQ(dm_->ReadMasterRecord(), begin_lsn);
+  EXPECT_EQ(checkpoint_->GetLastCheckpointLSN(), begin_lsn);
+  EXPECT_EQ(log_->GetFlushedLSN(), log_->GetNextLSN());
+
+  // BEGIN 后面紧跟着 END
+  std::vector<char> buf(log_->GetNextLSN() - begin_lsn);
+  dm_->ReadLog(buf.data(), buf.size(), begin_lsn);
+  LogRecord begin, end;
+  ASSERT_TRUE(begin.DeserializeFrom(buf.data(), buf.size()));
+  EXPECT_EQ(begin.GetType(), LogRecordType::CHECKPOINT_BEGIN);
+  ASSERT_TRUE(end.DeserializeFrom(buf.data() + begin.GetSize(),
+                                  buf.size() - begin.GetSize()));
+  ASSERT_EQ(end.GetType(), LogRecordType::CHECKPOINT_END);
+  ASSERT_EQ(end.GetActiveTxns().size(), 1);
+  EXPECT_EQ(end.GetActiveTxns()[0].first, active.GetTxnId());
+  EXPECT_EQ(end.GetActiveTxns()[0].second, active.GetPrevLSN());
+  EXPECT_FALSE(end.GetDirtyPages().empty());
+  for (const auto &[page_id, rec_lsn] : end.GetDirtyPages()) {
+    EXPECT_LT(rec_lsn, begin_lsn);
+    Page *page = bp_->FetchPage(page_id);
+    EXPECT_GE(page->GetLSN(), rec_lsn);
+    bp_->UnpinPage(page_id, false);
+  }
+}
+
+// 恢复从最近的检查点开始分析，重做不早于上一个检查点
+TEST_F(LogRecoveryTest, RecoveryStartsFromLastCheckpoint) {
+  checkpoint_ = std::make_unique<CheckpointManager>(
+      dm_.get(), bp_.get(), log_.get(), std::chrono::milliseconds(0), 0);
+  InsertKeys(0, 2000, true);
+  lsn_t first = checkpoint_->Checkpoint();
+  InsertKeys(2000, 2100, true);
+  lsn_t second = checkpoint_->Checkpoint();
+  InsertKeys(2100, 2200, true);
+  InsertKeys(2200, 2300, false);
+  Crash();
+
+  auto recovery = Restart();
+  EXPECT_EQ(recovery.GetAnalysisStart(), second);
+  EXPECT_GE(recovery.GetRedoStart(), first);
+  EXPECT_EQ(recovery.GetLoserCount(), 1);
+  ExpectExactly(2200, 2300);
+}
+
+// 跨过检查点的失败者：检查点之前的修改也要撤销
+TEST_F(LogRecoveryTest, LoserSpanningCheckpointIsRolledBack) {
+  checkpoint_ = std::make_unique<CheckpointManager>(
+      dm_.get(), bp_.get(), log_.get(), std::chrono::milliseconds(0), 0);
+  InsertKeys(0, 500, true);
+  Transaction loser(next_txn_id_++);
+  AppendTxnRecord(&loser, LogRecordType::BEGIN);
+  InsertKeys(500, 700, &loser);
+  checkpoint_->Checkpoint();
+  InsertKeys(700, 900, &loser);
+  log_->FlushAll();
+  Crash();
+
+  auto recovery = Restart();
+  EXPECT_EQ(recovery.GetLoserCount(), 1);
+  EXPECT_EQ(recovery.GetUndoCount(), 2 * 400);
+  ExpectExactly(500, 900);
+}
+
+// 重启后事务号接着用：页上留着旧版本的 xmin / xmax，撞号会看错可见性。
+// 分析只从检查点开始时，事务号从检查点里记下的值继续
+TEST_F(LogRecoveryTest, TxnIdsContinueAfterRestart) {
+  checkpoint_ = std::make_unique<CheckpointManager>(
+      dm_.get(), bp_.get(), log_.get(), std::chrono::milliseconds(0), 0);
+  auto rids = InsertKeys(0, 100, true);
+  Transaction deleter(next_txn_id_++);
+  AppendTxnRecord(&deleter, LogRecordType::BEGIN);
+  ASSERT_TRUE(heap_->DeleteTuple(rids[0], &deleter));
+  AppendTxnRecord(&deleter, LogRecordType::COMMIT);
+  bp_->FlushAllPages();
+  checkpoint_->Checkpoint();
+  Crash();
+
+  auto recovery = Restart();
+  EXPECT_EQ(recovery.GetRedoCount(), 0);
+  TransactionManager txn_manager(log_.get());
+  Transaction *txn = txn_manager.Begin();
+  EXPECT_GE(txn->GetTxnId(), next_txn_id_);
+  Tuple tuple;
+  EXPECT_FALSE(heap_->GetTuple(rids[0], &tuple, &txn->GetSnapshot()));
+  EXPECT_TRUE(heap_->GetTuple(rids[1], &tuple, &txn->GetSnapshot()));
+  txn_manager.Commit(txn);
+}
+
+// 后台线程按日志增长触发检查点，恢复要读的日志量随之回落
+TEST_F(LogRecoveryTest, BackgroundCheckpointBoundsRecoveryLog) {
+  constexpr size_t LOG_SIZE = 256 << 10;
+  checkpoint_ = std::make_unique<CheckpointManager>(
+      dm_.get(), bp_.get(), log_.get(), std::chrono::milliseconds(0),
+      LOG_SIZE);
+  // 后台线程什么时候被调度到不确定，一直写到它做了两次检查点
+  int32_t inserted = 0;
+  while (inserted < 50000 && checkpoint_->GetCheckpointCount() < 2) {
+    InsertKeys(inserted, inserted + 500, true);
+    inserted += 500;
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  ASSERT_GE(checkpoint_->GetCheckpointCount(), 2);
+  EXPECT_EQ(dm_->ReadMasterRecord(), checkpoint_->GetLastCheckpointLSN());
+
+  // 刷完所有页再做一次检查点，恢复只需要读检查点本身
+  size_t before = checkpoint_->GetRecoveryLogSize();
+  bp_->FlushAllPages();
+  checkpoint_->Checkpoint();
+  size_t after = checkpoint_->GetRecoveryLogSize();
+  EXPECT_LT(after, before);
+  EXPECT_LT(after, 4096);
+  EXPECT_LT(checkpoint_->EstimateRecoveryMillis(), 1.0);
+  Crash();
+  auto recovery = Restart();
+  EXPECT_EQ(recovery.GetRedoCount(), 0);
+  ExpectExactly(inserted, inserted);
+}
+
+// 恢复时间随日志长度增长，手动运行：
+// --gtest_also_run_disabled_tests
+// --gtest_filter=LogRecoveryTest.DISABLED_RecoveryTimeBenchmark
+TEST_F(LogRecoveryTest, DISABLED_RecoveryTimeBenchmark) {
+  constexpr int32_t ROWS_PER_TXN = 10;
+  int32_t inserted = 0;
+  for (int32_t txns : {1000, 2000, 4000, 8000, 16000}) {
+    // 每一轮在上一轮的基础上继续追加，日志一直没有截断
+    while (inserted < txns * ROWS_PER_TXN) {
+      InsertKeys(inserted, inserted + ROWS_PER_TXN, true);
+      inserted += ROWS_PER_TXN;
+    }
+    InsertKeys(inserted, inserted + ROWS_PER_TXN, false);
+    Crash();
+    auto start = std::chrono::steady_clock::now();
+    auto recovery = Restart(1024);
+    auto end = std::chrono::steady_clock::now();
+    double ms = std::chrono::duration<double, std::milli>(end - start).count();
+    std::cout << txns << " txns, log " << recovery.GetLogEnd() / 1024
+              << " KB: redo " << recovery.GetRedoCount() << ", undo "
+              << recovery.GetUndoCount() << ", " << ms << " ms" << std::endl;
+    // 下一轮之前把恢复结果刷盘
+    bp_->FlushAllPages();
+  }
+}
+
+// 同样的负载，每 1MB 日志做一次检查点，恢复时间不再随总日志量增长
+// 同时对比 EstimateRecoveryMillis 的估计值，手动运行：
+// --gtest_also_run_disabled_tests
+// --gtest_filter=LogRecoveryTest.DISABLED_RecoveryTimeWithCheckpoints
+TEST_F(LogRecoveryTest, DISABLED_RecoveryTimeWithCheckpoints) {
+  constexpr int32_t ROWS_PER_TXN = 10;
+  int32_t inserted = 0;
+  for (int32_t txns : {1000, 2000, 4000, 8000, 16000}) {
+    checkpoint_ = std::make_unique<CheckpointManager>(
+        dm_.get(), bp_.get(), log_.get(), std::chrono::milliseconds(0),
+        1 << 20);
+    while (inserted < txns * ROWS_PER_TXN) {
+      InsertKeys(inserted, inserted + ROWS_PER_TXN, true);
+      inserted += ROWS_PER_TXN;
+    }
+    InsertKeys(inserted, inserted + ROWS_PER_TXN, false);
+    double estimate = checkpoint_->EstimateRecoveryMillis();
+    size_t checkpoints = checkpoint_->GetCheckpointCount();
+    Crash();
+    auto start = std::chrono::steady_clock::now();
+    auto recovery = Restart(1024);
+    auto end = std::chrono::steady_clock::now();
+    double ms = std::chrono::duration<double, std::milli>(end - start).count();
+    std::cout << txns << " txns, log " << recovery.GetLogEnd() / 1024
+              << " KB, " << checkpoints << " checkpoints: read "
+              << (recovery.GetLogEnd() - recovery.GetRedoStart()) / 1024
+              << " KB, redo " << recovery.GetRedoCount() << ", " << ms
+              << " ms (estimated " << estimate << " ms)" << std::endl;
+    bp_->FlushAllPages();
+  }
+}
+
+// 同一份崩溃现场分别用 1/2/4/8 个线程重做，手动运行：
+// --gtest_also_run_disabled_tests
+// --gtest_filter=LogRecoveryTest.DISABLED_ParallelRedoBenchmark
+TEST_F(LogRecoveryTest, DISABLED_ParallelRedoBenchmark) {
+  constexpr int32_t ROWS_PER_TXN = 10;
+  constexpr int32_t TXNS = 16000;
+  for (int32_t txn = 0; txn < TXNS; ++txn) {
+    InsertKeys(txn * ROWS_PER_TXN, (txn + 1) * ROWS_PER_TXN, true);
+  }
+  Crash();
+  std::filesystem::path db_copy{"test_log_recovery.db.copy"};
+  std::filesystem::path log_copy{"test_log_recovery.log.copy"};
+  std::filesystem::copy_file(db_file_, db_copy);
+  std::filesystem::copy_file(log_file_, log_copy);
+
+  std::cout << "hardware threads: " << std::thread::hardware_concurrency()
+            << std::endl;
+  for (size_t threads : {1, 2, 4, 8}) {
+    std::filesystem::copy_file(
+        db_copy, db_file_, std::filesystem::copy_options::overwrite_existing);
+    std::filesystem::copy_file(
+        log_copy, log_file_, std::filesystem::copy_options::overwrite_existing);
+    auto start = std::chrono::steady_clock::now();
+    auto recovery = Restart(1024, threads);
+    auto end = std::chrono::steady_clock::now();
+    double ms = std::chrono::duration<double, std::milli>(end - start).count();
+    std::cout << threads << " threads: log " << recovery.GetLogEnd() / 1024
+              << " KB, redo " << recovery.GetRedoCount() << ", " << ms
+              << " ms" << std::endl;
+    ExpectExactly(TXNS * ROWS_PER_TXN, 0);
+    Crash();
+  }
+  std::filesystem::remove(db_copy);
+  std::filesystem::remove(log_copy);
+}
@@ -0,0 +1,43 @@
+#include "execution/loser_tree.h"
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+using namespace mini;
+
+// 任意路数的有序序列归并出来和整体排序一样
+TEST(LoserTreeTest, MergesSortedInputs) {
+  std::mt19937 gen(42);
+  for (size_t k = 1; k <= 9; ++k) {
+    std::vector<std::vector<int>> inputs(k);
+    std::vector<int> expected;
+    for (auto &input : inputs) {
+      // 有的一路是空的
+      size_t size = gen() % 4 == 0 ? 0 : gen() % 50;
+      for (size_t i = 0; i < size; ++i) {
+        input.push_back(static_cast<int>(gen() % 100));
+      }
+      std::sort(input.begin(), input.end());
+      expected.insert(expected.end(), input.begin(), input.end());
+    }
+    std::sort(expected.begin(), expected.end());
+
+    std::vector<size_t> pos(k, 0);
+    auto less = [&](size_t i, size_t j) {
+      if (pos[i] == inputs[i].size() || pos[j] == inputs[j].size()) {
+        return pos[i] < inputs[i].size() && pos[j] == inputs[j].size();
+      }
+      return inputs[i][pos[i]] < inputs[j][pos[j]];
+    };
+    LoserTree tree;
+    tree.Build(k, less);
+    std::vector<int> merged;
+    while (pos[tree.Winner()] < inputs[tree.Winner()].size()) {
+      size_t winner = tree.Winner();
+      merged.push_back(inputs[winner][pos[winner]++]);
+      tree.Replay(less);
+    }
+    EXPECT_EQ(merged, expected) << k;
+  }
+}
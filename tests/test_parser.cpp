@@ -55,6 +55,27 @@ TEST_F(ParserTest, InsertIntoTable) {
   ASSERT_EQ(str_literal->value(), "a");
 }
 
+// 一条 INSERT 带多行，Values() 是第一行
+TEST_F(ParserTest, InsertMultipleRows) {
+  Parser parser(std::make_unique<Lexer>(
+      "INSERT INTO t VALUES (1, 'a'), (2, 'b'), (3, 'c');"));
+  auto stmt = parser.ParseStatement();
+  ASSERT_NE(stmt, nullptr);
+  auto insert_stmt = static_cast<InsertStatement *>(stmt.get());
+  const auto &rows = insert_stmt->Rows();
+  ASSERT_EQ(rows.size(), 3);
+  for (size_t i = 0; i < rows.size(); ++i) {
+    ASSERT_EQ(rows[i].size(), 2);
+    EXPECT_EQ(static_cast<IntLiteral *>(rows[i][0].get())->value(),
+              std::to_string(i + 1));
+  }
+  EXPECT_EQ(&insert_stmt->Values(), &rows[0]);
+
+  Parser missing_row(std::make_unique<Lexer>("INSERT INTO t VALUES (1), ;"));
+  EXPECT_EQ(missing_row.ParseStatement(), nullptr);
+  EXPECT_TRUE(missing_row.HasError());
+}
+
 // CREATE TABLE temp (id INT, name VARCHAR(10));
 // CREATE TABLE t (id INT, name VARCHAR(255));
 TEST_F(ParserTest, CreateTable) {
@@ -108,3 +129,257 @@ TEST_F(ParserTest, SelectWithWhereClause) {
   ASSERT_NE(int_literal, nullptr);
   ASSERT_EQ(int_literal->GetValue(), 1);
 }
+
+// CREATE UNIQUE INDEX idx_id ON t(id);
+TEST_F(ParserTest, CreateUniqueIndex) {
+  std::string query = "CREATE UNIQUE INDEX idx_id ON t(id);";
+  lexer_ = std::make_unique<Lexer>(query);
+  parser_ = std::make_unique<Parser>(std::move(lexer_));
+  auto stmt = parser_->ParseStatement();
+  ASSERT_NE(stmt, nullptr);
+  ASSERT_EQ(stmt->Type(), StatementType::CREATE_INDEX);
+  auto create_index_stmt = static_cast<CreateIndexStatement *>(stmt.get());
+  ASSERT_EQ(create_index_stmt->Index_name(), "idx_id");
+  ASSERT_TRUE(create_index_stmt->Is_unique());
+}
+
+// CREATE TABLE t (id INT PRIMARY KEY, name VARCHAR(10));
+// CREATE TABLE t (id INT, name VARCHAR(10), PRIMARY KEY (id));
+TEST_F(ParserTest, CreateTableWithPrimaryKey) {
+  for (std::string query :
+       {"CREATE TABLE t (id INT PRIMARY KEY, name VARCHAR(10));",
+        "CREATE TABLE t (id INT, name VARCHAR(10), PRIMARY KEY (id));"}) {
+    parser_ = std::make_unique<Parser>(std::make_unique<Lexer>(query));
+    auto stmt = parser_->ParseStatement();
+    ASSERT_NE(stmt, nullptr);
+    ASSERT_FALSE(parser_->HasError());
+    auto create_table_stmt = static_cast<CreateTableStatement *>(stmt.get());
+    ASSERT_EQ(create_table_stmt->Columns().size(), 2);
+    ASSERT_EQ(create_table_stmt->Primary_key().size(), 1);
+    ASSERT_EQ(create_table_stmt->Primary_key()[0], "id");
+  }
+}
+
+// CREATE INDEX idx_id ON t(id) USING HASH;
+TEST_F(ParserTest, CreateIndexUsingHash) {
+  std::string query = "CREATE INDEX idx_id ON t(id) USING HASH;";
+  lexer_ = std::make_unique<Lexer>(query);
+  parser_ = std::make_unique<Parser>(std::move(lexer_));
+  auto stmt = parser_->ParseStatement();
+  ASSERT_NE(stmt, nullptr);
+  ASSERT_FALSE(parser_->HasError());
+  auto create_index_stmt = static_cast<CreateIndexStatement *>(stmt.get());
+  ASSERT_EQ(create_index_stmt->Index_method(), "HASH");
+  ASSERT_FALSE(create_index_stmt->Is_unique());
+}
+
+TEST_F(ParserTest, SelectCountStar) {
+  std::string query = "SELECT COUNT(*) FROM t WHERE id = 3;";
+  lexer_ = std::make_unique<Lexer>(query);
+  parser_ = std::make_unique<Parser>(std::move(lexer_));
+  auto stmt = parser_->ParseStatement();
+  ASSERT_NE(stmt, nullptr);
+  ASSERT_FALSE(parser_->HasError());
+  auto select_stmt = static_cast<SelectStatement *>(stmt.get());
+  ASSERT_EQ(select_stmt->Table_name(), "t");
+  ASSERT_TRUE(select_stmt->Count_star());
+}
+
+// SELECT * FROM a JOIN b ON a.x = b.y WHERE b.z = 3;
+TEST_F(ParserTest, SelectJoin) {
+  std::string query = "SELECT * FROM a JOIN b ON a.x = b.y WHERE b.z = 3;";
+  parser_ = std::make_unique<Parser>(std::make_unique<Lexer>(query));
+  auto stmt = parser_->ParseStatement();
+  ASSERT_NE(stmt, nullptr);
+  ASSERT_FALSE(parser_->HasError());
+  auto select_stmt = static_cast<SelectStatement *>(stmt.get());
+  ASSERT_EQ(select_stmt->Table_name(), "a");
+  const JoinClause *join = select_stmt->Join();
+  ASSERT_NE(join, nullptr);
+  EXPECT_EQ(join->table_name, "b");
+  EXPECT_EQ(join->left.table, "a");
+  EXPECT_EQ(join->left.column, "x");
+  EXPECT_EQ(join->right.table, "b");
+  EXPECT_EQ(join->right.column, "y");
+  ASSERT_TRUE(select_stmt->Has_where());
+  EXPECT_EQ(select_stmt->Where_table(), "b");
+  EXPECT_EQ(select_stmt->Where_column(), "z");
+
+  // 不带表名的列也可以
+  parser_ = std::make_unique<Parser>(
+      std::make_unique<Lexer>("SELECT COUNT(*) FROM a JOIN b ON x = y;"));
+  stmt = parser_->ParseStatement();
+  ASSERT_NE(stmt, nullptr);
+  select_stmt = static_cast<SelectStatement *>(stmt.get());
+  ASSERT_NE(select_stmt->Join(), nullptr);
+  EXPECT_EQ(select_stmt->Join()->left.table, "");
+  EXPECT_TRUE(select_stmt->Count_star());
+}
+
+// SELECT * FROM t WHERE a = 1 ORDER BY b DESC, t.c;
+TEST_F(ParserTest, SelectOrderBy) {
+  std::string query = "SELECT * FROM t WHERE a = 1 ORDER BY b DESC, t.c;";
+  parser_ = std::make_unique<Parser>(std::make_unique<Lexer>(query));
+  auto stmt = parser_->ParseStatement();
+  ASSERT_NE(stmt, nullptr);
+  ASSERT_FALSE(parser_->HasError());
+  auto select_stmt = static_cast<SelectStatement *>(stmt.get());
+  ASSERT_TRUE(select_stmt->Has_where());
+  const auto &order_by = select_stmt->Order_by();
+  ASSERT_EQ(order_by.size(), 2);
+  EXPECT_EQ(order_by[0].column.column, "b");
+  EXPECT_TRUE(order_by[0].desc);
+  EXPECT_EQ(order_by[1].column.table, "t");
+  EXPECT_EQ(order_by[1].column.column, "c");
+  EXPECT_FALSE(order_by[1].desc);
+
+  parser_ = std::make_unique<Parser>(
+      std::make_unique<Lexer>("SELECT * FROM t ORDER BY;"));
+  EXPECT_EQ(parser_->ParseStatement(), nullptr);
+  EXPECT_TRUE(parser_->HasError());
+}
+
+// 聚合函数和 GROUP BY，只有 COUNT(*) 一项时还是原来的 COUNT(*) 查询
+TEST_F(ParserTest, SelectAggregates) {
+  std::string query = "SELECT k, COUNT(*), SUM(v), MAX(t.w) FROM t "
+                      "GROUP BY k, t.j ORDER BY SUM(v) DESC;";
+  parser_ = std::make_unique<Parser>(std::make_unique<Lexer>(query));
+  auto stmt = parser_->ParseStatement();
+  ASSERT_NE(stmt, nullptr);
+  auto select_stmt = static_cast<SelectStatement *>(stmt.get());
+  EXPECT_FALSE(select_stmt->Select_all());
+  EXPECT_FALSE(select_stmt->Count_star());
+  const auto &items = select_stmt->Select_list();
+  ASSERT_EQ(items.size(), 4);
+  EXPECT_EQ(items[0].aggregate, AggregateType::NONE);
+  EXPECT_EQ(items[0].column.column, "k");
+  EXPECT_EQ(items[1].aggregate, AggregateType::COUNT_STAR);
+  EXPECT_EQ(items[2].aggregate, AggregateType::SUM);
+  EXPECT_EQ(items[2].column.column, "v");
+  EXPECT_EQ(items[3].aggregate, AggregateType::MAX);
+  EXPECT_EQ(items[3].column.table, "t");
+  ASSERT_EQ(select_stmt->Group_by().size(), 2);
+  EXPECT_EQ(select_stmt->Group_by()[1].column, "j");
+  ASSERT_EQ(select_stmt->Order_by().size(), 1);
+  EXPECT_EQ(select_stmt->Order_by()[0].aggregate, AggregateType::SUM);
+  EXPECT_TRUE(select_stmt->Order_by()[0].desc);
+
+  parser_ = std::make_unique<Parser>(
+      std::make_unique<Lexer>("SELECT COUNT(*) FROM t;"));
+  stmt = parser_->ParseStatement();
+  ASSERT_NE(stmt, nullptr);
+  select_stmt = static_cast<SelectStatement *>(stmt.get());
+  EXPECT_TRUE(select_stmt->Count_star());
+  EXPECT_TRUE(select_stmt->Select_list().empty());
+
+  for (const char *bad : {"SELECT SUM(*) FROM t;", "SELECT AVG(v FROM t;",
+                          "SELECT k FROM t GROUP k;"}) {
+    parser_ = std::make_unique<Parser>(std::make_unique<Lexer>(bad));
+    EXPECT_EQ(parser_->ParseStatement(), nullptr) << bad;
+    EXPECT_TRUE(parser_->HasError()) << bad;
+  }
+}
+
+TEST_F(ParserTest, SelectLimit) {
+  parser_ = std::make_unique<Parser>(std::make_unique<Lexer>(
+      "SELECT * FROM t ORDER BY a DESC LIMIT 10 OFFSET 5;"));
+  auto stmt = parser_->ParseStatement();
+  ASSERT_NE(stmt, nullptr);
+  auto select_stmt = static_cast<SelectStatement *>(stmt.get());
+  ASSERT_TRUE(select_stmt->Has_limit());
+  EXPECT_EQ(select_stmt->Limit(), 10);
+  EXPECT_EQ(select_stmt->Offset(), 5);
+  EXPECT_EQ(select_stmt->Order_by().size(), 1);
+
+  parser_ =
+      std::make_unique<Parser>(std::make_unique<Lexer>("SELECT * FROM t;"));
+  stmt = parser_->ParseStatement();
+  ASSERT_NE(stmt, nullptr);
+  EXPECT_FALSE(static_cast<SelectStatement *>(stmt.get())->Has_limit());
+
+  for (const char *bad : {"SELECT * FROM t LIMIT;",
+                          "SELECT * FROM t LIMIT 1 OFFSET;",
+                          "SELECT * FROM t LIMIT 1 ORDER BY a;"}) {
+    parser_ = std::make_unique<Parser>(std::make_unique<Lexer>(bad));
+    EXPECT_EQ(parser_->ParseStatement(), nullptr) << bad;
+  }
+}
+
+TEST_F(ParserTest, TransactionStatements) {
+  std::vector<std::pair<std::string, TransactionCommand>> cases{
+      {"BEGIN;", TransactionCommand::BEGIN},
+      {"COMMIT;", TransactionCommand::COMMIT},
+      {"ROLLBACK;", TransactionCommand::ROLLBACK}};
+  for (const auto &[query, command] : cases) {
+    Parser parser(std::make_unique<Lexer>(query));
+    auto stmt = parser.ParseStatement();
+    ASSERT_NE(stmt, nullptr) << query;
+    ASSERT_EQ(stmt->Type(), StatementType::TRANSACTION);
+    EXPECT_EQ(static_cast<TransactionStatement *>(stmt.get())->Command(),
+              command);
+  }
+
+  Parser parser(std::make_unique<Lexer>("COMMIT"));
+  EXPECT_EQ(parser.ParseStatement(), nullptr);
+  EXPECT_TRUE(parser.HasError());
+}
+
+TEST_F(ParserTest, AnalyzeStatement) {
+  Parser parser(std::make_unique<Lexer>("ANALYZE t;"));
+  auto stmt = parser.ParseStatement();
+  ASSERT_NE(stmt, nullptr);
+  ASSERT_EQ(stmt->Type(), StatementType::ANALYZE);
+  EXPECT_EQ(static_cast<AnalyzeStatement *>(stmt.get())->Table_name(), "t");
+
+  Parser bad(std::make_unique<Lexer>("ANALYZE;"));
+  EXPECT_EQ(bad.ParseStatement(), nullptr);
+  EXPECT_TRUE(bad.HasError());
+}
+
+TEST_F(ParserTest, ExplainStatement) {
+  Parser parser(
+      std::make_unique<Lexer>("EXPLAIN ANALYZE SELECT * FROM t WHERE id = 1;"));
+  auto stmt = parser.ParseStatement();
+  ASSERT_NE(stmt, nullptr);
+  ASSERT_EQ(stmt->Type(), StatementType::EXPLAIN);
+  auto *explain = static_cast<ExplainStatement *>(stmt.get());
+  EXPECT_TRUE(explain->IsAnalyze());
+  EXPECT_EQ(explain->Select().Table_name(), "t");
+
+  Parser plain(std::make_unique<Lexer>("EXPLAIN SELECT * FROM t;"));
+  stmt = plain.ParseStatement();
+  ASSERT_NE(stmt, nullptr);
+  EXPECT_FALSE(static_cast<ExplainStatement *>(stmt.get())->IsAnalyze());
+
+  // 只能 EXPLAIN 查询
+  Parser bad(std::make_unique<Lexer>("EXPLAIN INSERT INTO t VALUES (1);"));
+  EXPECT_EQ(bad.ParseStatement(), nullptr);
+  EXPECT_TRUE(bad.HasError());
+}
+
+TEST_F(ParserTest, PrepareAndExecuteStatement) {
+  Parser parser(std::make_unique<Lexer>(
+      "PREPARE q AS SELECT * FROM t WHERE id = ?;"));
+  auto stmt = parser.ParseStatement();
+  ASSERT_NE(stmt, nullptr);
+  ASSERT_EQ(stmt->Type(), StatementType::PREPARE);
+  auto *prepare = static_cast<PrepareStatement *>(stmt.get());
+  EXPECT_EQ(prepare->Name(), "q");
+  EXPECT_EQ(prepare->Sql(), "SELECT * FROM t WHERE id = ?;");
+  EXPECT_EQ(parser.ParameterCount(), 1);
+
+  Parser execute(std::make_unique<Lexer>("EXECUTE q(1, 'a');"));
+  stmt = execute.ParseStatement();
+  ASSERT_NE(stmt, nullptr);
+  ASSERT_EQ(stmt->Type(), StatementType::EXECUTE);
+  const auto &params =
+      static_cast<ExecuteStatement *>(stmt.get())->Parameters();
+  ASSERT_EQ(params.size(), 2);
+  EXPECT_EQ(params[0]->ToString(), "1");
+  EXPECT_EQ(params[1]->ToString(), "a");
+
+  // ? 只能出现在 PREPARE 里
+  Parser bad(std::make_unique<Lexer>("SELECT * FROM t WHERE id = ?;"));
+  EXPECT_EQ(bad.ParseStatement(), nullptr);
+  EXPECT_TRUE(bad.HasError());
+}
@@ -0,0 +1,367 @@
+#include "binder/binder.h"
+#include "catalog/catalog.h"
+#include "execution/execution_context.h"
+#include "execution/executor.h"
+#include "parser/parser.h"
+#include "planner/plan_cache.h"
+#include "planner/planner.h"
+#include "storage/buffer_pool.h"
+#include "storage/disk_manager.h"
+#include <filesystem>
+#include <gtest/gtest.h>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace mini;
+
+class PlannerTest : public ::testing::Test {
+protected:
+  std::filesystem::path db_file_{"test_planner.db"};
+  std::unique_ptr<DiskManager> dm_;
+  std::unique_ptr<BufferPool> bp_;
+  std::unique_ptr<Catalog> catalog_;
+  std::unique_ptr<ExecutionContext> ctx_;
+
+  void SetUp() override {
+    std::filesystem::remove(db_file_);
+    dm_ = std::make_unique<DiskManager>(db_file_.string());
+    bp_ = std::make_unique<BufferPool>(100, dm_.get());
+    catalog_ = std::make_unique<Catalog>(bp_.get());
+    ctx_ = std::make_unique<ExecutionContext>(*catalog_);
+  }
+
+  void TearDown() override {
+    ctx_.reset();
+    catalog_.reset();
+    bp_.reset();
+    dm_.reset();
+    std::filesystem::remove(db_file_);
+  }
+
+  std::unique_ptr<BoundStatement> Bind(const std::string &sql) {
+    Parser parser(std::make_unique<Lexer>(sql));
+    auto stmt = parser.ParseStatement();
+    if (!stmt) {
+      throw std::runtime_error("parse error: " + parser.GetError().Message());
+    }
+    Binder binder(*catalog_);
+    auto bound = binder.BindStatement(*stmt);
+    if (!bound) {
+      throw std::runtime_error("bind error: " + binder.GetError().Message());
+    }
+    return bound;
+  }
+
+  // 执行语句，返回输出的行数
+  size_t Execute(const std::string &sql) {
+    auto exec = Planner(*ctx_).CreateExecutor(Bind(sql));
+    exec->Init();
+    size_t count = 0;
+    Tuple row;
+    while (exec->Next(&row)) {
+      count++;
+    }
+    return count;
+  }
+
+  std::unique_ptr<PlanNode> Plan(const std::string &sql) {
+    auto bound = Bind(sql);
+    return Planner(*ctx_).PlanSelect(
+        *static_cast<BoundSelectStatement *>(bound.get()));
+  }
+
+  // 一条多行 INSERT 写入 (first(i), second(i))，i 从 0 到 n
+  template <typename First, typename Second>
+  void InsertRows(const std::string &table, int n, First first,
+                  Second second) {
+    std::string sql;
+    for (int i = 0; i < n; ++i) {
+      sql += (sql.empty() ? "INSERT INTO " + table + " VALUES (" : ", (") +
+             std::to_string(first(i)) + ", " + std::to_string(second(i)) +
+             ")";
+      if (i % 1000 == 999 || i == n - 1) {
+        Execute(sql + ";");
+        sql.clear();
+      }
+    }
+  }
+};
+
+// 匹配的行少时走索引，多到回表比扫全表还贵时改用顺序扫描
+TEST_F(PlannerTest, SeqOrIndexScanBySelectivity) {
+  Execute("CREATE TABLE t (id INT, v INT);");
+  // 前 4000 行 id 各不相同，后 1000 行 id 都是 99999
+  InsertRows(
+      "t", 5000, [](int i) { return i < 4000 ? i : 99999; },
+      [](int i) { return i; });
+  EXPECT_EQ(Plan("SELECT * FROM t WHERE id = 5;")->type, PlanType::SEQ_SCAN);
+
+  Execute("CREATE INDEX idx_id ON t(id);");
+  auto plan = Plan("SELECT * FROM t WHERE id = 5;");
+  EXPECT_EQ(plan->type, PlanType::INDEX_SCAN);
+  EXPECT_EQ(plan->rows, 1);
+  plan = Plan("SELECT * FROM t WHERE id = 99999;");
+  EXPECT_EQ(plan->type, PlanType::SEQ_SCAN);
+  EXPECT_EQ(plan->rows, 1000);
+
+  EXPECT_EQ(Execute("SELECT * FROM t WHERE id = 5;"), 1);
+  EXPECT_EQ(Execute("SELECT * FROM t WHERE id = 99999;"), 1000);
+}
+
+// 只取索引键这一列时是覆盖查询，值直接用 WHERE 里的键，不读整行
+TEST_F(PlannerTest, CoveredColumnIndexOnlyScan) {
+  Execute("CREATE TABLE t (id INT, v INT);");
+  InsertRows(
+      "t", 2000, [](int i) { return i % 1000; }, [](int i) { return i; });
+  Execute("CREATE INDEX idx_id ON t(id);");
+
+  auto plan = Plan("SELECT id FROM t WHERE id = 5;");
+  EXPECT_EQ(plan->type, PlanType::INDEX_ONLY_SCAN);
+  // 要取别的列时还得回表
+  plan = Plan("SELECT v FROM t WHERE id = 5;");
+  ASSERT_EQ(plan->type, PlanType::PROJECTION);
+  EXPECT_EQ(plan->Child()->type, PlanType::INDEX_SCAN);
+  EXPECT_EQ(Plan("SELECT id, v FROM t WHERE id = 5;")->type,
+            PlanType::INDEX_SCAN);
+
+  auto exec =
+      Planner(*ctx_).CreateExecutor(Bind("SELECT id FROM t WHERE id = 5;"));
+  exec->Init();
+  Tuple row;
+  size_t count = 0;
+  while (exec->Next(&row)) {
+    auto value = row.GetValue(exec->GetSchema(), 0);
+    EXPECT_EQ(static_cast<IntValue *>(value.get())->GetValue(), 5);
+    count++;
+  }
+  EXPECT_EQ(count, 2);
+  EXPECT_EQ(Execute("SELECT v FROM t WHERE id = 5;"), 2);
+}
+
+// 连接算法和内外表跟 FROM 里写的顺序无关，只看两边的大小和索引
+TEST_F(PlannerTest, JoinOrderAndAlgorithmByCost) {
+  Execute("CREATE TABLE a (id INT, v INT);");
+  Execute("CREATE TABLE b (aid INT, w INT);");
+  InsertRows(
+      "a", 20, [](int i) { return i * 7; }, [](int i) { return i; });
+  InsertRows(
+      "b", 20000, [](int i) { return i % 8000; }, [](int i) { return i; });
+
+  // 没有索引时小的一边建哈希表
+  auto plan = Plan("SELECT * FROM a JOIN b ON a.id = b.aid;");
+  ASSERT_EQ(plan->type, PlanType::HASH_JOIN);
+  EXPECT_TRUE(plan->left_first);
+  plan = Plan("SELECT * FROM b JOIN a ON a.id = b.aid;");
+  ASSERT_EQ(plan->type, PlanType::HASH_JOIN);
+  EXPECT_FALSE(plan->left_first);
+  EXPECT_EQ(plan->Child(0)->type, PlanType::SEQ_SCAN);
+
+  // 大表的连接列上有索引时小表做外表
+  Execute("CREATE INDEX idx_aid ON b(aid);");
+  plan = Plan("SELECT * FROM b JOIN a ON a.id = b.aid;");
+  ASSERT_EQ(plan->type, PlanType::INDEX_NESTED_LOOP_JOIN);
+  EXPECT_FALSE(plan->left_first);
+  EXPECT_EQ(plan->Child(0)->type, PlanType::INDEX_SCAN);
+  EXPECT_EQ(plan->Child(0)->index->index_name, "idx_aid");
+  EXPECT_EQ(plan->Child(1)->type, PlanType::SEQ_SCAN);
+  // 用计划建出来的执行器就是这个连接
+  auto exec = Planner(*ctx_).CreateExecutor(
+      Bind("SELECT * FROM a JOIN b ON a.id = b.aid;"));
+  auto *select = dynamic_cast<SelectExecutor *>(exec.get());
+  ASSERT_NE(select, nullptr);
+  EXPECT_EQ(select->GetPlan()->type, PlanType::INDEX_NESTED_LOOP_JOIN);
+  EXPECT_TRUE(select->GetPlan()->left_first);
+  EXPECT_NE(dynamic_cast<IndexNestedLoopJoinExecutor *>(select->GetJoin()),
+            nullptr);
+  EXPECT_EQ(Execute("SELECT * FROM a JOIN b ON a.id = b.aid;"), 60);
+}
+
+// 计划树从上到下是 LIMIT、投影、Top-N、扫描，每个节点带着估计
+TEST_F(PlannerTest, PlanTreeShape) {
+  Execute("CREATE TABLE t (id INT, v INT);");
+  InsertRows(
+      "t", 300, [](int i) { return i; }, [](int i) { return i % 10; });
+
+  auto plan = Plan("SELECT id FROM t WHERE v = 3 ORDER BY id DESC LIMIT 5;");
+  ASSERT_EQ(plan->type, PlanType::LIMIT);
+  EXPECT_EQ(plan->limit, 5);
+  const PlanNode *node = plan->Child();
+  ASSERT_EQ(node->type, PlanType::PROJECTION);
+  node = node->Child();
+  ASSERT_EQ(node->type, PlanType::TOP_N);
+  node = node->Child();
+  ASSERT_EQ(node->type, PlanType::SEQ_SCAN);
+  EXPECT_TRUE(node->children.empty());
+  // 没有统计信息时，一列按最多 200 个不同的值估计
+  EXPECT_DOUBLE_EQ(node->rows, 300.0 / 200);
+  EXPECT_LT(node->cost, plan->cost);
+
+  std::string text = plan->ToString();
+  EXPECT_EQ(text.find("Limit 5"), 0);
+  EXPECT_NE(text.find("\n  Projection"), std::string::npos);
+  EXPECT_NE(text.find("\n    Top-N 5"), std::string::npos);
+  EXPECT_NE(text.find("\n      Seq Scan on t (rows=2"), std::string::npos);
+  EXPECT_EQ(Execute("SELECT id FROM t WHERE v = 3 ORDER BY id DESC LIMIT 5;"),
+            5);
+}
+
+// ANALYZE 之后按直方图和不同值个数估计，插入的行也跟着算进来
+TEST_F(PlannerTest, AnalyzeRefinesEstimates) {
+  Execute("CREATE TABLE t (id INT, v INT);");
+  InsertRows(
+      "t", 5000, [](int i) { return i < 4000 ? i : 99999; },
+      [](int i) { return i % 8; });
+  // 没有统计信息时每个值都按 5000 / 200 行估计
+  EXPECT_DOUBLE_EQ(Plan("SELECT * FROM t WHERE id = 99999;")->rows, 25);
+
+  Execute("ANALYZE t;");
+  TableInfo *table = catalog_->GetTable("t");
+  ASSERT_NE(table->statistics, nullptr);
+  EXPECT_NEAR(Plan("SELECT * FROM t WHERE id = 99999;")->rows, 1000, 200);
+  EXPECT_LT(Plan("SELECT * FROM t WHERE id = 5;")->rows, 2);
+  EXPECT_EQ(Plan("SELECT * FROM t WHERE id = 123456;")->rows, 0);
+  EXPECT_NEAR(Plan("SELECT * FROM t WHERE v = 3;")->rows, 625, 10);
+  // GROUP BY v 估计 8 组
+  auto plan = Plan("SELECT v, COUNT(*) FROM t GROUP BY v;");
+  ASSERT_EQ(plan->type, PlanType::HASH_AGGREGATE);
+  EXPECT_NEAR(plan->rows, 8, 1);
+
+  InsertRows(
+      "t", 1000, [](int i) { return 200000 + i; }, [](int i) { return i; });
+  EXPECT_EQ(table->statistics->InsertCount(), 1000);
+  EXPECT_EQ(Plan("SELECT * FROM t;")->rows, 6000);
+  EXPECT_GT(Plan("SELECT * FROM t WHERE id = 200500;")->rows, 0);
+
+  // 事务里的插入提交之后才算，回滚了不算
+  Execute("BEGIN;");
+  Execute("INSERT INTO t VALUES (300000, 1), (300001, 2);");
+  EXPECT_EQ(table->statistics->InsertCount(), 1000);
+  Execute("ROLLBACK;");
+  EXPECT_EQ(table->statistics->InsertCount(), 1000);
+  Execute("BEGIN;");
+  Execute("INSERT INTO t VALUES (300000, 1), (300001, 2);");
+  Execute("COMMIT;");
+  EXPECT_EQ(table->statistics->InsertCount(), 1002);
+}
+
+// EXPLAIN 每个节点一行；EXPLAIN ANALYZE 把查询执行完，接上实际的行数
+TEST_F(PlannerTest, ExplainAnalyze) {
+  Execute("CREATE TABLE a (id INT, v INT);");
+  Execute("CREATE TABLE b (aid INT, w INT);");
+  InsertRows(
+      "a", 20, [](int i) { return i * 7; }, [](int i) { return i; });
+  InsertRows(
+      "b", 20000, [](int i) { return i % 8000; }, [](int i) { return i; });
+  Execute("CREATE INDEX idx_aid ON b(aid);");
+
+  auto explain = [&](const std::string &sql) {
+    auto exec = Planner(*ctx_).CreateExecutor(Bind(sql));
+    auto schema = exec->GetSchema();
+    exec->Init();
+    std::vector<std::string> lines;
+    Tuple row;
+    while (exec->Next(&row)) {
+      lines.push_back(row.GetValue(schema, 0)->ToString());
+    }
+    return lines;
+  };
+  auto lines = explain("EXPLAIN SELECT * FROM a JOIN b ON a.id = b.aid;");
+  ASSERT_EQ(lines.size(), 3);
+  EXPECT_EQ(lines[0].find("Index Nested Loop Join outer a (rows="), 0);
+  EXPECT_EQ(lines[1].find("  Seq Scan on a"), 0);
+  EXPECT_EQ(lines[2].find("  Index Scan on b using idx_aid"), 0);
+  EXPECT_EQ(lines[0].find("actual"), std::string::npos);
+
+  lines = explain("EXPLAIN ANALYZE SELECT * FROM a JOIN b ON a.id = b.aid;");
+  ASSERT_EQ(lines.size(), 4);
+  EXPECT_NE(lines[0].find("(actual rows=60 loops=1 "), std::string::npos);
+  EXPECT_NE(lines[1].find("(actual rows=20 loops=1 "), std::string::npos);
+  // 外表的 20 个键各查一次索引
+  EXPECT_NE(lines[2].find("(actual rows=60 loops=20 "), std::string::npos);
+  EXPECT_EQ(lines[3].find("Execution Time: "), 0);
+
+  // LIMIT 够了就停，扫描只读出需要的行
+  lines = explain("EXPLAIN ANALYZE SELECT * FROM b LIMIT 3 OFFSET 2;");
+  ASSERT_EQ(lines.size(), 3);
+  EXPECT_NE(lines[0].find("(actual rows=3 loops=1 "), std::string::npos);
+  EXPECT_NE(lines[1].find("(actual rows=5 loops=1 "), std::string::npos);
+
+  // 执行计划的时候也会填到传进去的计划树上
+  auto bound = Bind("SELECT v, COUNT(*) FROM a GROUP BY v;");
+  auto plan = Planner(*ctx_).PlanSelect(
+      *static_cast<BoundSelectStatement *>(bound.get()));
+  SelectExecutor exec(*ctx_,
+                      std::unique_ptr<BoundSelectStatement>(
+                          static_cast<BoundSelectStatement *>(bound.release())),
+                      plan.get(), true);
+  size_t before = bp_->GetFetchCount();
+  exec.Init();
+  Tuple row;
+  while (exec.Next(&row)) {
+  }
+  size_t fetches = bp_->GetFetchCount() - before;
+  ASSERT_EQ(plan->type, PlanType::HASH_AGGREGATE);
+  EXPECT_EQ(plan->actual.rows, 20);
+  EXPECT_EQ(plan->Child()->actual.rows, 20);
+  // 上层的计数包含下层的
+  EXPECT_EQ(plan->actual.hits + plan->actual.misses, fetches);
+  EXPECT_EQ(plan->Child()->actual.hits + plan->Child()->actual.misses,
+            fetches);
+  EXPECT_GE(plan->actual.ms, plan->Child()->actual.ms);
+}
+
+// PREPARE 的语句按规范化的原文缓存，EXECUTE 只代入参数；catalog 变了
+// 之后重新绑定，用上新建的索引
+TEST_F(PlannerTest, PreparedStatementsAndPlanCache) {
+  EXPECT_EQ(PlanCache::Normalize("SELECT *\nFROM t WHERE id=? AND 'a b';"),
+            "SELECT * FROM t WHERE id = ? AND 'a b' ;");
+
+  Execute("CREATE TABLE t (id INT, name VARCHAR(8));");
+  Execute("PREPARE ins AS INSERT INTO t VALUES (?, ?);");
+  for (int i = 0; i < 300; ++i) {
+    Execute("EXECUTE ins(" + std::to_string(i) + ", 'n" + std::to_string(i) +
+            "');");
+  }
+  EXPECT_THROW(Execute("EXECUTE ins('x', 'y');"), std::runtime_error);
+  EXPECT_THROW(Execute("EXECUTE ins(1);"), std::runtime_error);
+  EXPECT_THROW(Execute("EXECUTE nope;"), std::runtime_error);
+
+  Execute("PREPARE q AS SELECT name FROM t WHERE id = ?;");
+  // 另一个名字，规范化后是同一条语句
+  Execute("PREPARE q2 AS SELECT name FROM t WHERE id=?;");
+  PlanCache &cache = ctx_->GetPlanCache();
+  EXPECT_EQ(cache.Size(), 2);
+  size_t misses = cache.GetMissCount();
+
+  auto execute = [&](const std::string &sql) {
+    auto exec = Planner(*ctx_).CreateExecutor(Bind(sql));
+    auto *execute = dynamic_cast<ExecuteExecutor *>(exec.release());
+    EXPECT_NE(execute, nullptr);
+    EXPECT_EQ(execute->GetStatementType(), BoundStatementType::BOUND_SELECT);
+    return std::unique_ptr<ExecuteExecutor>(execute);
+  };
+  auto index = [&]() {
+    auto cached = cache.Get(*ctx_->GetPrepared("q"));
+    return static_cast<BoundSelectStatement *>(cached->bound.get())->Index();
+  };
+  EXPECT_EQ(index(), nullptr);
+  auto exec = execute("EXECUTE q(42);");
+  EXPECT_NE(dynamic_cast<SelectExecutor *>(exec->GetExecutor()), nullptr);
+  exec->Init();
+  Tuple row;
+  ASSERT_TRUE(exec->Next(&row));
+  EXPECT_EQ(row.GetValue(exec->GetSchema(), 0)->ToString(), "n42");
+  EXPECT_FALSE(exec->Next(&row));
+  EXPECT_EQ(Execute("EXECUTE q2(7);"), 1);
+  EXPECT_EQ(cache.GetMissCount(), misses);
+
+  Execute("CREATE INDEX idx_id ON t(id);");
+  EXPECT_EQ(Execute("EXECUTE q(42);"), 1);
+  EXPECT_EQ(cache.GetMissCount(), misses + 1);
+  ASSERT_NE(index(), nullptr);
+  EXPECT_EQ(index()->index_name, "idx_id");
+  EXPECT_EQ(Execute("EXECUTE q2(300);"), 0);
+  EXPECT_EQ(cache.GetMissCount(), misses + 1);
+}
@@ -0,0 +1,79 @@
+#include "storage/buffer_pool.h"
+#include "storage/disk_manager.h"
+#include "storage/spill_file.h"
+#include "storage/tuple.h"
+#include <filesystem>
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+
+using namespace mini;
+
+class SpillFileTest : public ::testing::Test {
+protected:
+  std::filesystem::path db_file_{"test_spill_file.db"};
+  std::unique_ptr<DiskManager> dm_;
+  std::unique_ptr<BufferPool> bp_;
+
+  void SetUp() override {
+    std::filesystem::remove(db_file_);
+    dm_ = std::make_unique<DiskManager>(db_file_.string());
+    bp_ = std::make_unique<BufferPool>(4, dm_.get());
+  }
+
+  void TearDown() override {
+    bp_.reset();
+    dm_.reset();
+    std::filesystem::remove(db_file_);
+  }
+};
+
+// 写满好几页再按写入顺序读回来，缓冲池只有 4 帧也够用
+TEST_F(SpillFileTest, ReadsBackInOrder) {
+  SpillFile file(bp_.get());
+  for (int i = 0; i < 3000; ++i) {
+    std::string s = "row-" + std::to_string(i);
+    file.Append(Tuple(s.data(), s.size()));
+  }
+  EXPECT_EQ(file.GetTupleCount(), 3000);
+  file.Rewind();
+  EXPECT_GT(file.GetPageCount(), 4);
+
+  Tuple t;
+  for (int i = 0; i < 3000; ++i) {
+    ASSERT_TRUE(file.Next(&t));
+    EXPECT_EQ(std::string(t.Data(), t.Size()), "row-" + std::to_string(i));
+  }
+  EXPECT_FALSE(file.Next(&t));
+
+  // 可以从头再读一遍
+  file.Rewind();
+  ASSERT_TRUE(file.Next(&t));
+  EXPECT_EQ(std::string(t.Data(), t.Size()), "row-0");
+}
+
+// 析构时临时页还给缓冲池，之后分配的页复用这些页号
+TEST_F(SpillFileTest, PagesAreReused) {
+  page_id_t end;
+  {
+    SpillFile file(bp_.get());
+    std::string s(1000, 'x');
+    for (int i = 0; i < 20; ++i) {
+      file.Append(Tuple(s.data(), s.size()));
+    }
+    file.Rewind();
+    Page *page = bp_->NewPage(&end);
+    ASSERT_NE(page, nullptr);
+    bp_->UnpinPage(end, false);
+  }
+  for (int i = 0; i < 5; ++i) {
+    page_id_t pid;
+    ASSERT_NE(bp_->NewPage(&pid), nullptr);
+    EXPECT_LT(pid, end);
+    bp_->UnpinPage(pid, false);
+  }
+  page_id_t pid;
+  ASSERT_NE(bp_->NewPage(&pid), nullptr);
+  EXPECT_GT(pid, end);
+  bp_->UnpinPage(pid, false);
+}
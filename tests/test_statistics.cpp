@@ -0,0 +1,124 @@
+#include "catalog/schema.h"
+#include "catalog/statistics.h"
+#include "storage/buffer_pool.h"
+#include "storage/disk_manager.h"
+#include "storage/table_heap.h"
+#include <cstring>
+#include <filesystem>
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+
+using namespace mini;
+
+class StatisticsTest : public ::testing::Test {
+protected:
+  std::filesystem::path db_file_{"test_statistics.db"};
+  std::unique_ptr<DiskManager> dm_;
+  std::unique_ptr<BufferPool> bp_;
+  std::unique_ptr<TableHeap> heap_;
+  Schema schema_;
+
+  void SetUp() override {
+    std::filesystem::remove(db_file_);
+    dm_ = std::make_unique<DiskManager>(db_file_.string());
+    bp_ = std::make_unique<BufferPool>(64, dm_.get());
+    heap_ = std::make_unique<TableHeap>(bp_.get());
+    schema_.AddColumn("id", DataType::INTEGER);
+    schema_.AddColumn("name", DataType::VARCHAR, 8);
+  }
+
+  void TearDown() override {
+    heap_.reset();
+    bp_.reset();
+    dm_.reset();
+    std::filesystem::remove(db_file_);
+  }
+
+  Tuple Row(int32_t id, const std::string &name) {
+    Tuple tuple;
+    char *buf = tuple.Resize(schema_.GetTupleLength());
+    memset(buf, 0, schema_.GetTupleLength());
+    memcpy(buf, &id, sizeof(int32_t));
+    memcpy(buf + sizeof(int32_t), name.data(), name.size());
+    return tuple;
+  }
+};
+
+// 重复加同一批值不改变估计，几十万个不同的值误差在几个百分点以内
+TEST_F(StatisticsTest, HyperLogLogEstimate) {
+  HyperLogLog hll;
+  for (int round = 0; round < 3; ++round) {
+    for (int32_t i = 0; i < 100; ++i) {
+      hll.Add(HyperLogLog::Hash(reinterpret_cast<const char *>(&i),
+                                sizeof(i)));
+    }
+  }
+  EXPECT_NEAR(hll.Estimate(), 100, 5);
+
+  HyperLogLog large;
+  for (int32_t i = 0; i < 300000; ++i) {
+    large.Add(HyperLogLog::Hash(reinterpret_cast<const char *>(&i),
+                                sizeof(i)));
+  }
+  EXPECT_NEAR(large.Estimate(), 300000, 300000 * 0.1);
+}
+
+// 行数、不同值个数、最小最大值看每一行；直方图从样本里看出频繁的值
+TEST_F(StatisticsTest, CollectAndRecordInserts) {
+  // 4 万行超过样本大小：id 前 3 万行各不相同，后 1 万行都是 7
+  for (int32_t i = 0; i < 40000; ++i) {
+    int32_t id = i < 30000 ? i + 100 : 7;
+    heap_->InsertTuple(Row(id, "n" + std::to_string(i % 50)));
+  }
+  auto stats = TableStatistics::Collect(heap_.get(), schema_, nullptr);
+  EXPECT_EQ(stats->RowCount(), 40000);
+  EXPECT_EQ(stats->PageCount(), heap_->GetPageCount());
+  EXPECT_NEAR(stats->Distinct(0), 30001, 30001 * 0.1);
+  EXPECT_NEAR(stats->Distinct(1), 50, 3);
+  int32_t min, max;
+  ASSERT_TRUE(stats->Range(0, &min, &max));
+  EXPECT_EQ(min, 7);
+  EXPECT_EQ(max, 30099);
+  EXPECT_FALSE(stats->Range(1, &min, &max));
+
+  EXPECT_NEAR(stats->EqualSelectivity(0, 7), 0.25, 0.05);
+  EXPECT_NEAR(stats->EqualSelectivity(0, 500), 1.0 / 30001, 1e-5);
+  EXPECT_EQ(stats->EqualSelectivity(0, 5), 0);
+  EXPECT_EQ(stats->EqualSelectivity(0, 40000), 0);
+
+  // 之后插入的行直接记进来
+  std::vector<Tuple> rows;
+  for (int32_t i = 0; i < 1000; ++i) {
+    rows.push_back(Row(50000 + i, "x"));
+  }
+  stats->RecordInsert(schema_, rows);
+  EXPECT_EQ(stats->RowCount(), 41000);
+  EXPECT_EQ(stats->InsertCount(), 1000);
+  EXPECT_NEAR(stats->Distinct(0), 31001, 31001 * 0.1);
+  EXPECT_NEAR(stats->Distinct(1), 51, 3);
+  ASSERT_TRUE(stats->Range(0, &min, &max));
+  EXPECT_EQ(max, 50999);
+  EXPECT_GT(stats->EqualSelectivity(0, 50500), 0);
+}
+
+// 页数超过 SAMPLE_PAGES 时只读抽到的页，行数和不同值个数按样本推算
+TEST_F(StatisticsTest, CollectSamplesPages) {
+  // id 各不相同，name 只有 50 种
+  for (int32_t i = 0; i < 150000; ++i) {
+    heap_->InsertTuple(Row(i, "n" + std::to_string(i % 50)));
+  }
+  ASSERT_GT(heap_->GetPageCount(), TableStatistics::SAMPLE_PAGES * 3);
+  size_t before = bp_->GetFetchCount();
+  auto stats = TableStatistics::Collect(heap_.get(), schema_, nullptr);
+  EXPECT_LE(bp_->GetFetchCount() - before, TableStatistics::SAMPLE_PAGES);
+  EXPECT_EQ(stats->PageCount(), heap_->GetPageCount());
+  EXPECT_NEAR(stats->RowCount(), 150000, 150000 * 0.02);
+  EXPECT_NEAR(stats->Distinct(0), 150000, 150000 * 0.1);
+  EXPECT_NEAR(stats->Distinct(1), 50, 3);
+  int32_t min, max;
+  ASSERT_TRUE(stats->Range(0, &min, &max));
+  EXPECT_GE(min, 0);
+  EXPECT_LE(max, 149999);
+  EXPECT_NEAR(stats->EqualSelectivity(0, 500), 1.0 / 150000, 1e-6);
+}